@@ -30,6 +30,45 @@ using namespace Magnum::Math::Literals;
 using namespace osp;
 using namespace osp::draw;
 
+void adera::shader::bind_phong(
+        ViewProjMatrix const&       viewProj,
+        EntityToDraw::UserData_t    userData) noexcept
+{
+    void* const pShader = std::get<1>(userData);
+    assert(pShader != nullptr);
+
+    auto &rShader = *reinterpret_cast<PhongGL*>(pShader);
+
+    // Lights with w=0.0f are directional lights
+    // Directonal lights are camera-relative, so we need 'viewProj.m_view *'
+    auto const lightPositions =
+    {
+        viewProj.m_view * Vector4{ Vector3{0.2f, 0.6f, 0.5f}.normalized(), 0.0f},
+        viewProj.m_view * Vector4{-Vector3{0.0f, 0.0f, 1.0f}, 0.0f}
+    };
+
+    auto const lightColors =
+    {
+        0xddd4Cd_rgbf,
+        0x32354e_rgbf
+    };
+
+    auto const lightSpecColors =
+    {
+        0xfff5ed_rgbf,
+        0x000000_rgbf
+    };
+
+    // TODO: find a better way to deal with lights instead of hard-coding it
+    rShader
+        .setAmbientColor(0x1a1e29ff_rgbaf)
+        .setSpecularColor(0xffffff00_rgbaf)
+        .setLightColors(lightColors)
+        .setLightSpecularColors(lightSpecColors)
+        .setLightPositions(lightPositions)
+        .setProjectionMatrix(viewProj.m_proj);
+}
+
 void adera::shader::draw_ent_phong(
         DrawEnt                     ent,
         ViewProjMatrix const&       viewProj,
@@ -50,12 +89,6 @@ void adera::shader::draw_ent_phong(
 
     Magnum::Matrix4 entRelative = viewProj.m_view * drawTf;
 
-    /* 4th component indicates light type. A value of 0.0f indicates that the
-     * light is a direction light coming from the specified direction relative
-     * to the camera.
-     */
-    //Vector4 light = ;
-
     if (rShader.flags() & Flag::DiffuseTexture)
     {
         TexGlId const texGlId = (*rData.pDiffuseTexId)[ent].m_glId;
@@ -76,38 +109,9 @@ void adera::shader::draw_ent_phong(
     MeshGlId const      meshId = (*rData.pMeshId)[ent].m_glId;
     Magnum::GL::Mesh    &rMesh = rData.pMeshGl->get(meshId);
 
-    Matrix3 a{viewProj.m_view};
-
-
-    // Lights with w=0.0f are directional lights
-    // Directonal lights are camera-relative, so we need 'viewProj.m_view *'
-    auto const lightPositions =
-    {
-        viewProj.m_view * Vector4{ Vector3{0.2f, 0.6f, 0.5f}.normalized(), 0.0f},
-        viewProj.m_view * Vector4{-Vector3{0.0f, 0.0f, 1.0f}, 0.0f}
-    };
-
-    auto const lightColors =
-    {
-        0xddd4Cd_rgbf,
-        0x32354e_rgbf
-    };
-
-    auto const lightSpecColors =
-    {
-        0xfff5ed_rgbf,
-        0x000000_rgbf
-    };
-
-    // TODO: find a better way to deal with lights instead of hard-coding it
+    // Lights and projection are set by bind_phong
     rShader
-        .setAmbientColor(0x1a1e29ff_rgbaf)
-        .setSpecularColor(0xffffff00_rgbaf)
-        .setLightColors(lightColors)
-        .setLightSpecularColors(lightSpecColors)
-        .setLightPositions(lightPositions)
         .setTransformationMatrix(entRelative)
-        .setProjectionMatrix(viewProj.m_proj)
         .setNormalMatrix(entRelative.normalMatrix())
         .draw(rMesh);
 }
@@ -64,6 +64,10 @@ struct ACtxDrawPhong
     }
 };
 
+void bind_phong(
+        osp::draw::ViewProjMatrix const&     viewProj,
+        osp::draw::EntityToDraw::UserData_t  userData) noexcept;
+
 void draw_ent_phong(
         osp::draw::DrawEnt                   ent,
         osp::draw::ViewProjMatrix const&     viewProj,
@@ -94,7 +98,7 @@ inline void sync_drawent_phong(osp::draw::DrawEnt ent, ArgsForSyncDrawEntPhong c
     if (args.pStorageTransparent != nullptr)
     {
         auto value = (hasMaterial && args.transparent.test(entInt))
-                   ? std::make_optional(osp::draw::EntityToDraw{&draw_ent_phong, {&args.rData, pShader}})
+                   ? std::make_optional(osp::draw::EntityToDraw{&draw_ent_phong, {&args.rData, pShader}, &bind_phong})
                    : std::nullopt;
 
         osp::storage_assign(*args.pStorageTransparent, ent, std::move(value));
@@ -103,7 +107,7 @@ inline void sync_drawent_phong(osp::draw::DrawEnt ent, ArgsForSyncDrawEntPhong c
     if (args.pStorageOpaque != nullptr)
     {
         auto value = (hasMaterial && args.opaque.test(entInt))
-                   ? std::make_optional(osp::draw::EntityToDraw{&draw_ent_phong, {&args.rData, pShader}})
+                   ? std::make_optional(osp::draw::EntityToDraw{&draw_ent_phong, {&args.rData, pShader}, &bind_phong})
                    : std::nullopt;
 
         osp::storage_assign(*args.pStorageOpaque, ent, std::move(value));
@@ -34,6 +34,19 @@ using namespace Magnum::Math::Literals;
 using namespace osp;
 using namespace osp::draw;
 
+void adera::shader::bind_visualizer(
+        ViewProjMatrix const&       viewProj,
+        EntityToDraw::UserData_t    userData) noexcept
+{
+    void* const pData = std::get<0>(userData);
+    assert(pData != nullptr);
+    auto &rData = *reinterpret_cast<ACtxDrawMeshVisualizer*>(pData);
+
+    rData.m_shader
+        .setViewportSize(Vector2{Magnum::GL::defaultFramebuffer.viewport().size()})
+        .setProjectionMatrix(viewProj.m_proj);
+}
+
 void adera::shader::draw_ent_visualizer(
         DrawEnt                     ent,
         ViewProjMatrix const&       viewProj,
@@ -64,10 +77,9 @@ void adera::shader::draw_ent_visualizer(
     MeshGlId const      meshId = (*rData.m_pMeshId)[ent].m_glId;
     Magnum::GL::Mesh    &rMesh = rData.m_pMeshGl->get(meshId);
 
+    // Viewport size and projection are set by bind_visualizer
     rShader
-        .setViewportSize(Vector2{Magnum::GL::defaultFramebuffer.viewport().size()})
         .setTransformationMatrix(entRelative)
-        .setProjectionMatrix(viewProj.m_proj)
         .draw(rMesh);
 
     if (rData.m_wireframeOnly)
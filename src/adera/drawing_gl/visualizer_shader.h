@@ -55,6 +55,10 @@ constexpr void assign_pointers(osp::draw::ACtxSceneRender&      rScnRender,
     }
 };
 
+void bind_visualizer(
+        osp::draw::ViewProjMatrix const&    viewProj,
+        osp::draw::EntityToDraw::UserData_t userData) noexcept;
+
 void draw_ent_visualizer(
         osp::draw::DrawEnt                  ent,
         osp::draw::ViewProjMatrix const&    viewProj,
@@ -71,7 +75,7 @@ inline void sync_drawent_visualizer(
     {
         if ( ! alreadyAdded)
         {
-            rStorage.emplace( ent, osp::draw::EntityToDraw{&draw_ent_visualizer, {&rData} } );
+            rStorage.emplace( ent, osp::draw::EntityToDraw{&draw_ent_visualizer, {&rData}, &bind_visualizer} );
         }
     }
     else
@@ -27,7 +27,9 @@
 #include "active_ent.h"
 
 #include "../core/bitvector.h"
+#include "../core/id_remap.h"
 #include "../core/keyed_vector.h"
+#include "../core/math_mat4.h"
 #include "../core/math_types.h"
 #include "../core/storage.h"
 
@@ -42,6 +44,9 @@ namespace osp::active
 using ActiveEntVec_t = std::vector<ActiveEnt>;
 using ActiveEntSet_t = BitVector_t;
 
+/// New IDs for existing entities after compact_active_ents, see IdRemap
+using ActiveEntRemap = IdRemap<ActiveEnt>;
+
 /**
  * @brief Component for transformation (in meters)
  */
@@ -50,6 +55,61 @@ struct ACompTransform
     osp::Matrix4 m_transform;
 };
 
+/**
+ * @brief Compact local transforms, stored as separate translation, rotation, and scale arrays
+ *
+ * Alternative to ACompTransform using 40 bytes per entity instead of 64. Matrices are only
+ * composed where they're needed, such as when calculating draw transforms (see
+ * SysRender::ArgsForUpdDrawTransform::pTRS).
+ */
+struct ACtxTransformTRS
+{
+    void resize(std::size_t const ents)
+    {
+        m_translation   .resize(ents);
+        m_rotation      .resize(ents);
+        m_scale         .resize(ents, Vector3{1.0f});
+        bitvector_resize(m_ents, ents);
+    }
+
+    void remap(ActiveEntRemap const& idRemap)
+    {
+        id_remap_keys(idRemap, m_translation);
+        id_remap_keys(idRemap, m_rotation);
+        id_remap_keys(idRemap, m_scale, Vector3{1.0f});
+        id_remap_keys(idRemap, m_ents);
+    }
+
+    /**
+     * @brief Set an entity's transform from a matrix, see math::decompose_trs
+     */
+    void set_matrix(ActiveEnt const ent, Matrix4 const& transform) noexcept
+    {
+        math::decompose_trs(transform, m_translation[ent], m_rotation[ent], m_scale[ent]);
+        m_ents.set(ent.value);
+    }
+
+    /**
+     * @brief Remove an entity's transform, such as when it's deleted
+     */
+    void remove(ActiveEnt const ent) noexcept
+    {
+        m_ents.reset(ent.value);
+    }
+
+    [[nodiscard]] Matrix4 matrix(ActiveEnt const ent) const noexcept
+    {
+        return math::compose_trs(m_translation[ent], m_rotation[ent], m_scale[ent]);
+    }
+
+    osp::KeyedVec<ActiveEnt, Vector3>       m_translation;
+    osp::KeyedVec<ActiveEnt, Quaternion>    m_rotation;
+    osp::KeyedVec<ActiveEnt, Vector3>       m_scale;
+
+    /// Entities with a transform set, see set_matrix
+    ActiveEntSet_t                          m_ents;
+};
+
 /**
  * @brief Simple name component
  */
@@ -74,6 +134,10 @@ struct ACtxSceneGraph
 
     std::vector<TreePos_t>  m_delete;
 
+    // Incremented by SysSceneGraph functions that add, remove, or move entities. Anything
+    // cached by tree position is out of date once this changes.
+    uint32_t                m_version{0};
+
     void resize(std::size_t ents)
     {
         m_treeToEnt         .reserve(ents);
@@ -94,8 +158,28 @@ struct ACtxBasic
 
     ACtxSceneGraph                      m_scnGraph;
     ACompTransformStorage_t             m_transform;
+
+    // Entities with a modified m_transform, see mark_transform_dirty. Consumers clear bits once
+    // they've handled them. Transforms of newly added entities don't need to be marked, as
+    // adding them to m_scnGraph already changes ACtxSceneGraph::m_version.
+    ActiveEntSet_t                      m_transformDirty;
 };
 
+/**
+ * @brief Flag that an entity's ACompTransform was modified
+ *
+ * Call this after writing to an existing ACompTransform, so systems that only look at changed
+ * transforms (eg. SysRender::update_draw_transforms_dirty) pick it up.
+ */
+inline void mark_transform_dirty(ActiveEntSet_t &rTransformDirty, ActiveEnt const ent)
+{
+    if (rTransformDirty.size() <= ent.value)
+    {
+        bitvector_resize(rTransformDirty, std::size_t(ent.value) + 1);
+    }
+    rTransformDirty.set(ent.value);
+}
+
 template<typename IT_T>
 void update_delete_basic(ACtxBasic &rCtxBasic, IT_T first, IT_T const& last)
 {
@@ -109,6 +193,11 @@ void update_delete_basic(ACtxBasic &rCtxBasic, IT_T first, IT_T const& last)
 
         }
 
+        if (ent.value < rCtxBasic.m_transformDirty.size())
+        {
+            rCtxBasic.m_transformDirty      .reset(ent.value);
+        }
+
         std::advance(first, 1);
     }
 }
@@ -68,6 +68,8 @@ SubtreeBuilder SysSceneGraph::add_descendants(ACtxSceneGraph& rScnGraph, uint32_
 
     SubtreeBuilder out(rScnGraph, root, subFirst, subLast);
 
+    ++ rScnGraph.m_version;
+
     if (subFirst != treeOldSize)
     {
         // Right-shift tree vectors from subFirst and onwards to make
@@ -101,6 +103,99 @@ SubtreeBuilder SysSceneGraph::add_descendants(ACtxSceneGraph& rScnGraph, uint32_
     return out;
 }
 
+std::vector<SubtreeBuilder> SysSceneGraph::add_descendants_batch(ACtxSceneGraph& rScnGraph, ArrayView<SubtreeInsert const> inserts)
+{
+    auto const parent_pos = [&rScnGraph] (ActiveEnt const parent) -> TreePos_t
+    {
+        return (parent == lgrn::id_null<ActiveEnt>()) ? 0 : rScnGraph.m_entToTreePos[parent];
+    };
+
+    // Each subtree is inserted at the end of its parent's existing descendants. Sort by this
+    // position. A parent's last descendant can end at the same position as its ancestors, so
+    // subtrees of deeper parents go first. Otherwise, keep the given order.
+
+    std::vector<uint32_t>   order(inserts.size());
+    std::vector<TreePos_t>  insertPos(inserts.size());
+    std::vector<TreePos_t>  parentPos(inserts.size());
+    uint32_t addTotal = 0;
+
+    for (uint32_t i = 0; i < inserts.size(); ++i)
+    {
+        order[i]        = i;
+        parentPos[i]    = parent_pos(inserts[i].parent);
+        insertPos[i]    = parentPos[i] + 1 + rScnGraph.m_treeDescendants[parentPos[i]];
+        addTotal        += inserts[i].descendantCount;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&insertPos, &parentPos] (uint32_t const lhs, uint32_t const rhs)
+    {
+        return (insertPos[lhs] != insertPos[rhs])
+             ? (insertPos[lhs] < insertPos[rhs])
+             : (parentPos[lhs] > parentPos[rhs]);
+    });
+
+    TreePos_t const treeOldSize = rScnGraph.m_treeDescendants[0] + 1;
+    TreePos_t const treeNewSize = treeOldSize + addTotal;
+
+    rScnGraph.m_treeToEnt.resize(treeNewSize);
+    rScnGraph.m_treeDescendants.resize(treeNewSize);
+
+    ++ rScnGraph.m_version;
+
+    // Right-to-left merge: move each span of existing tree data directly to its final position,
+    // leaving a gap for each subtree. Every element moves at most once.
+
+    auto const itTreeEntsFirst  = rScnGraph.m_treeToEnt.begin();
+    auto const itTreeDescFirst  = rScnGraph.m_treeDescendants.begin();
+
+    std::vector<TreePos_t> subFirst(inserts.size());
+    TreePos_t src = treeOldSize;
+    TreePos_t dst = treeNewSize;
+
+    for (auto itOrder = order.rbegin(); itOrder != order.rend(); ++itOrder)
+    {
+        TreePos_t const keepFirst = insertPos[*itOrder];
+        TreePos_t const shift     = dst - src;
+
+        if (shift != 0)
+        {
+            std::for_each(itTreeEntsFirst + keepFirst, itTreeEntsFirst + src, [&rScnGraph, shift] (ActiveEnt const ent)
+            {
+                rScnGraph.m_entToTreePos[ent] += shift;
+            });
+            std::move_backward(itTreeEntsFirst + keepFirst, itTreeEntsFirst + src, itTreeEntsFirst + dst);
+            std::move_backward(itTreeDescFirst + keepFirst, itTreeDescFirst + src, itTreeDescFirst + dst);
+        }
+
+        dst -= (src - keepFirst) + inserts[*itOrder].descendantCount;
+        src = keepFirst;
+        subFirst[*itOrder] = dst;
+    }
+
+    // Update descendant counts of parents and ancestors, now that tree positions are final
+    for (SubtreeInsert const& insert : inserts)
+    {
+        ActiveEnt parent = insert.parent;
+        bool parentNotNull = true;
+        while (parentNotNull)
+        {
+            parentNotNull = (parent != lgrn::id_null<ActiveEnt>());
+            rScnGraph.m_treeDescendants[parent_pos(parent)] += insert.descendantCount;
+            parent = parentNotNull ? rScnGraph.m_entParent[parent] : parent;
+        }
+    }
+
+    // Reserved up front, as SubtreeBuilders assert on destruction if moved before being filled
+    std::vector<SubtreeBuilder> out;
+    out.reserve(inserts.size());
+    for (uint32_t i = 0; i < inserts.size(); ++i)
+    {
+        out.emplace_back(rScnGraph, inserts[i].parent, subFirst[i], subFirst[i] + inserts[i].descendantCount);
+    }
+
+    return out;
+}
+
 ArrayView<ActiveEnt const> SysSceneGraph::descendants(ACtxSceneGraph const& rScnGraph, ActiveEnt root)
 {
     TreePos_t const rootPos = rScnGraph.m_entToTreePos[root];
@@ -133,6 +228,103 @@ ChildRange_t SysSceneGraph::children(ACtxSceneGraph const& rScnGraph, ActiveEnt
                         ChildIterator{&rScnGraph, childLast}};
 }
 
+void SysSceneGraph::reparent(ACtxSceneGraph& rScnGraph, ActiveEnt const subtreeRoot, ActiveEnt const newParent)
+{
+    auto const parent_pos = [&rScnGraph] (ActiveEnt const parent) -> TreePos_t
+    {
+        return (parent == lgrn::id_null<ActiveEnt>()) ? 0 : rScnGraph.m_entToTreePos[parent];
+    };
+
+    TreePos_t const rootPos     = rScnGraph.m_entToTreePos[subtreeRoot];
+    uint32_t const  moveTotal   = 1 + rScnGraph.m_treeDescendants[rootPos];
+    TreePos_t const rootLast    = rootPos + moveTotal;
+
+    TreePos_t const newParentPos = parent_pos(newParent);
+    // Can't move an entity under itself or its own descendants
+    assert(newParentPos < rootPos || newParentPos >= rootLast);
+
+    if (rScnGraph.m_entParent[subtreeRoot] == newParent)
+    {
+        return; // Already a child. Reordering children is not supported.
+    }
+
+    ++ rScnGraph.m_version;
+
+    // Subtree is placed at the end of newParent's existing descendants
+    TreePos_t const insertPos = newParentPos + 1 + rScnGraph.m_treeDescendants[newParentPos];
+
+    // Remove from descendant counts of old ancestors, while tree positions are still valid
+    for (ActiveEnt parent = rScnGraph.m_entParent[subtreeRoot];
+         ;
+         parent = rScnGraph.m_entParent[parent])
+    {
+        rScnGraph.m_treeDescendants[parent_pos(parent)] -= moveTotal;
+        if (parent == lgrn::id_null<ActiveEnt>())
+        {
+            break;
+        }
+    }
+
+    // Rotate [subtree][in-between] to [in-between][subtree], or the reverse if moving left
+    TreePos_t const rangeFirst  = std::min(rootPos, insertPos);
+    TreePos_t const rangeLast   = std::max(rootLast, insertPos);
+    TreePos_t const middle      = (insertPos > rootPos) ? rootLast : rootPos;
+
+    auto const itTreeEntsFirst  = rScnGraph.m_treeToEnt.begin();
+    auto const itTreeDescFirst  = rScnGraph.m_treeDescendants.begin();
+
+    std::rotate(itTreeEntsFirst + rangeFirst, itTreeEntsFirst + middle, itTreeEntsFirst + rangeLast);
+    std::rotate(itTreeDescFirst + rangeFirst, itTreeDescFirst + middle, itTreeDescFirst + rangeLast);
+
+    for (TreePos_t pos = rangeFirst; pos != rangeLast; ++pos)
+    {
+        rScnGraph.m_entToTreePos[rScnGraph.m_treeToEnt[pos]] = pos;
+    }
+
+    // Add to descendant counts of new ancestors
+    rScnGraph.m_entParent[subtreeRoot] = newParent;
+    for (ActiveEnt parent = newParent;
+         ;
+         parent = rScnGraph.m_entParent[parent])
+    {
+        rScnGraph.m_treeDescendants[parent_pos(parent)] += moveTotal;
+        if (parent == lgrn::id_null<ActiveEnt>())
+        {
+            break;
+        }
+    }
+}
+
+void SysSceneGraph::reparent(ACtxBasic& rBasic, ActiveEnt const subtreeRoot, ActiveEnt const newParent, EKeepTransform const keep)
+{
+    if (keep == EKeepTransform::World && rBasic.m_transform.contains(subtreeRoot))
+    {
+        Matrix4 const rootWorldTf   = world_transform(rBasic.m_scnGraph, rBasic.m_transform, subtreeRoot);
+        Matrix4 const parentWorldTf = (newParent == lgrn::id_null<ActiveEnt>())
+                                    ? Matrix4{}
+                                    : world_transform(rBasic.m_scnGraph, rBasic.m_transform, newParent);
+
+        rBasic.m_transform.get(subtreeRoot).m_transform = parentWorldTf.inverted() * rootWorldTf;
+        mark_transform_dirty(rBasic.m_transformDirty, subtreeRoot);
+    }
+
+    reparent(rBasic.m_scnGraph, subtreeRoot, newParent);
+}
+
+Matrix4 SysSceneGraph::world_transform(ACtxSceneGraph const& scnGraph, ACompTransformStorage_t const& transforms, ActiveEnt ent)
+{
+    Matrix4 out;
+    while (ent != lgrn::id_null<ActiveEnt>())
+    {
+        if (transforms.contains(ent))
+        {
+            out = transforms.get(ent).m_transform * out;
+        }
+        ent = scnGraph.m_entParent[ent];
+    }
+    return out;
+}
+
 void SysSceneGraph::do_delete(ACtxSceneGraph& rScnGraph)
 {
     // Delete subtrees by carefully shifting elements left
@@ -209,4 +401,54 @@ void SysSceneGraph::do_delete(ACtxSceneGraph& rScnGraph)
     rScnGraph.m_treeDescendants.resize(done);
 
     rScnGraph.m_delete.clear();
+
+    ++ rScnGraph.m_version;
+}
+
+ActiveEntRemap osp::active::compact_active_ents(ACtxBasic &rBasic)
+{
+    ACtxSceneGraph &rScnGraph = rBasic.m_scnGraph;
+
+    ActiveEntRemap remap;
+    remap.oldToNew.resize(rBasic.m_activeIds.capacity(), lgrn::id_null<ActiveEnt>());
+
+    uint32_t count = 0;
+
+    // Scene graph order first. Position 0 is the null root.
+    for (ActiveEnt const ent : arrayView(rScnGraph.m_treeToEnt).exceptPrefix(1))
+    {
+        assert(rBasic.m_activeIds.exists(ent));
+        remap.oldToNew[ent] = ActiveEnt(count);
+        ++ count;
+    }
+
+    for (std::size_t const entInt : rBasic.m_activeIds.bitview().zeros())
+    {
+        ActiveEnt &rNewId = remap.oldToNew[ActiveEnt(entInt)];
+        if (rNewId == lgrn::id_null<ActiveEnt>())
+        {
+            rNewId = ActiveEnt(count);
+            ++ count;
+        }
+    }
+
+    // New registry hands out IDs lowest first
+    rBasic.m_activeIds = {};
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        [[maybe_unused]] ActiveEnt const ent = rBasic.m_activeIds.create();
+        assert(ent == ActiveEnt(i));
+    }
+    remap.newCapacity = rBasic.m_activeIds.capacity();
+
+    id_remap_values (remap, rScnGraph.m_treeToEnt);
+    id_remap_keys   (remap, rScnGraph.m_entParent, lgrn::id_null<ActiveEnt>());
+    id_remap_values (remap, rScnGraph.m_entParent);
+    id_remap_keys   (remap, rScnGraph.m_entToTreePos, lgrn::id_null<TreePos_t>());
+    ++ rScnGraph.m_version;
+
+    id_remap_keys   (remap, rBasic.m_transform);
+    id_remap_keys   (remap, rBasic.m_transformDirty);
+
+    return remap;
 }
@@ -31,6 +31,7 @@
 
 #include <algorithm>
 #include <compare>
+#include <vector>
 
 namespace osp::active
 {
@@ -80,6 +81,24 @@ private:
 
 }; // class SubtreeBuilder
 
+/**
+ * @brief A subtree to add to an ACtxSceneGraph, see SysSceneGraph::add_descendants_batch
+ */
+struct SubtreeInsert
+{
+    ActiveEnt   parent;             ///< Existing entity to add under, or null for root
+    uint32_t    descendantCount;    ///< Total number of entities in the new subtree
+};
+
+/**
+ * @brief Which transform to preserve when moving an entity to a new parent
+ */
+enum class EKeepTransform : uint8_t
+{
+    Local,  ///< Keep transform relative to parent; entity follows its new parent
+    World   ///< Recalculate transform relative to the new parent; entity stays in place
+};
+
 /**
  * @brief Iterates entity children in an ACtxSceneGraph
  */
@@ -135,6 +154,16 @@ public:
      */
     [[nodiscard]] static SubtreeBuilder add_descendants(ACtxSceneGraph& rScnGraph, uint32_t descendantCount, ActiveEnt root = lgrn::id_null<ActiveEnt>());
 
+    /**
+     * @brief Add many subtrees to a scene graph at once using SubtreeBuilders
+     *
+     * Same result as calling add_descendants for each insert in order, but existing tree data is
+     * moved in a single pass instead of once per insert. Parents must already be in the tree.
+     *
+     * @return SubtreeBuilders in the same order as inserts
+     */
+    [[nodiscard]] static std::vector<SubtreeBuilder> add_descendants_batch(ACtxSceneGraph& rScnGraph, ArrayView<SubtreeInsert const> inserts);
+
     /**
      * @return Iterable range of an entity's descendants
      */
@@ -151,6 +180,32 @@ public:
      */
     static ChildRange_t children(ACtxSceneGraph const& rScnGraph, ActiveEnt parent = lgrn::id_null<ActiveEnt>());
 
+    /**
+     * @brief Move an entity and its descendants to a new parent
+     *
+     * Entity IDs are kept. Tree data is moved in place with a single rotate over the range
+     * between the old and new positions.
+     *
+     * @param newParent [in] Entity to move under, or null for root. Must not be subtreeRoot or
+     *                       any of its descendants.
+     */
+    static void reparent(ACtxSceneGraph& rScnGraph, ActiveEnt subtreeRoot, ActiveEnt newParent);
+
+    /**
+     * @copybrief reparent
+     *
+     * @param keep [in] If EKeepTransform::World, subtreeRoot's transform is recalculated relative
+     *                  to newParent. Descendant transforms are relative to subtreeRoot and stay
+     *                  the same either way.
+     */
+    static void reparent(ACtxBasic& rBasic, ActiveEnt subtreeRoot, ActiveEnt newParent, EKeepTransform keep);
+
+    /**
+     * @return Transform of an entity relative to the scene root, by multiplying transforms of
+     *         all of its ancestors. Entities without a transform are treated as identity.
+     */
+    static Matrix4 world_transform(ACtxSceneGraph const& scnGraph, ACompTransformStorage_t const& transforms, ActiveEnt ent);
+
     /**
      * @brief Remove multiple entities from a scene graph
      *
@@ -173,6 +228,20 @@ private:
 
 }; // class SysSceneGraph
 
+/**
+ * @brief Give all existing entities new IDs packed into the range [0, count)
+ *
+ * Entities are numbered in scene graph order, followed by any entities that aren't in the scene
+ * graph. Per-entity data is then laid out in the same order the scene graph is walked.
+ *
+ * ACtxBasic is remapped here. Every other container indexed by or holding ActiveEnts must be
+ * rewritten using the returned table before it's used again, see IdRemap and the update_remap
+ * functions of each system.
+ *
+ * @return Remap table from old to new IDs
+ */
+[[nodiscard]] ActiveEntRemap compact_active_ents(ACtxBasic &rBasic);
+
 template<typename ITA_T, typename ITB_T>
 void SysSceneGraph::cut(ACtxSceneGraph& rScnGraph, ITA_T first, ITB_T const& last)
 {
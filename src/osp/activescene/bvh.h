@@ -0,0 +1,94 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "active_ent.h"
+#include "basic.h"
+
+#include "../core/keyed_vector.h"
+#include "../core/math_types.h"
+#include "../core/strong_id.h"
+
+#include <longeron/id_management/null.hpp>
+#include <longeron/id_management/registry_stl.hpp> // for lgrn::IdRegistryStl
+
+namespace osp::active
+{
+
+using BvhNodeId = StrongId<std::uint32_t, struct DummyForBvhNodeId>;
+
+/**
+ * @brief Node of a bounding volume hierarchy, either a leaf for an entity or an internal node
+ *        with two children
+ */
+struct BvhNode
+{
+    /// Union of children for internal nodes, or the entity's padded bounds for leaves
+    Range3D     bounds;
+
+    BvhNodeId   parent      { lgrn::id_null<BvhNodeId>() };
+    BvhNodeId   childA      { lgrn::id_null<BvhNodeId>() };
+    BvhNodeId   childB      { lgrn::id_null<BvhNodeId>() };
+
+    /// Entity of a leaf, null for internal nodes
+    ActiveEnt   ent         { lgrn::id_null<ActiveEnt>() };
+
+    /// Longest path to a leaf, 0 for leaves
+    int         height      { 0 };
+};
+
+/**
+ * @brief Dynamic AABB tree for finding ActiveEnts by where they are in space
+ *
+ * Leaves store bounds padded by m_margin, so entities that move a small distance don't change
+ * the tree. Queries are exact against the unpadded bounds in m_entBounds.
+ *
+ * See SysBvh
+ */
+struct ACtxBvh
+{
+    void resize_active(std::size_t const size)
+    {
+        m_entToLeaf     .resize(size, lgrn::id_null<BvhNodeId>());
+        m_entBounds     .resize(size);
+        m_localBounds   .resize(size);
+        bitvector_resize(m_hasLocalBounds, size);
+    }
+
+    lgrn::IdRegistryStl<BvhNodeId>      m_nodeIds;
+    KeyedVec<BvhNodeId, BvhNode>        m_nodes;
+    BvhNodeId                           m_root      { lgrn::id_null<BvhNodeId>() };
+
+    KeyedVec<ActiveEnt, BvhNodeId>      m_entToLeaf;
+    KeyedVec<ActiveEnt, Range3D>        m_entBounds;
+
+    /// Bounds relative to the entity, such as from its mesh. Used by SysBvh::update_transform
+    KeyedVec<ActiveEnt, Range3D>        m_localBounds;
+    ActiveEntSet_t                      m_hasLocalBounds;
+
+    float                               m_margin    { 0.1f };
+};
+
+} // namespace osp::active
@@ -0,0 +1,346 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "bvh_fn.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace osp;
+using namespace osp::active;
+
+namespace
+{
+
+BvhNodeId create_node(ACtxBvh& rBvh)
+{
+    BvhNodeId const node = rBvh.m_nodeIds.create();
+    rBvh.m_nodes.resize(rBvh.m_nodeIds.capacity());
+    rBvh.m_nodes[node] = {};
+    return node;
+}
+
+void replace_child(ACtxBvh& rBvh, BvhNodeId const parent, BvhNodeId const oldChild, BvhNodeId const newChild)
+{
+    if (parent == lgrn::id_null<BvhNodeId>())
+    {
+        rBvh.m_root = newChild;
+        return;
+    }
+
+    BvhNode &rParent = rBvh.m_nodes[parent];
+    if (rParent.childA == oldChild)
+    {
+        rParent.childA = newChild;
+    }
+    else
+    {
+        assert(rParent.childB == oldChild);
+        rParent.childB = newChild;
+    }
+}
+
+} // namespace
+
+void SysBvh::insert(ACtxBvh& rBvh, ActiveEnt const ent, Range3D const& bounds)
+{
+    assert(ent.value < rBvh.m_entToLeaf.size());
+    assert( ! contains(rBvh, ent) );
+
+    BvhNodeId const leaf = create_node(rBvh);
+    BvhNode &rLeaf = rBvh.m_nodes[leaf];
+    rLeaf.bounds    = bounds.padded(Vector3{rBvh.m_margin});
+    rLeaf.ent       = ent;
+
+    rBvh.m_entToLeaf[ent] = leaf;
+    rBvh.m_entBounds[ent] = bounds;
+
+    insert_leaf(rBvh, leaf);
+}
+
+void SysBvh::remove(ACtxBvh& rBvh, ActiveEnt const ent)
+{
+    if ( ! contains(rBvh, ent) )
+    {
+        return;
+    }
+
+    BvhNodeId const leaf = std::exchange(rBvh.m_entToLeaf[ent], lgrn::id_null<BvhNodeId>());
+
+    remove_leaf(rBvh, leaf);
+
+    rBvh.m_nodeIds.remove(leaf);
+    rBvh.m_nodes[leaf] = {};
+}
+
+bool SysBvh::update(ACtxBvh& rBvh, ActiveEnt const ent, Range3D const& bounds)
+{
+    assert(contains(rBvh, ent));
+
+    BvhNodeId const leaf = rBvh.m_entToLeaf[ent];
+    rBvh.m_entBounds[ent] = bounds;
+
+    if (rBvh.m_nodes[leaf].bounds.contains(bounds))
+    {
+        return false;
+    }
+
+    remove_leaf(rBvh, leaf);
+    rBvh.m_nodes[leaf].bounds = bounds.padded(Vector3{rBvh.m_margin});
+    insert_leaf(rBvh, leaf);
+
+    return true;
+}
+
+void SysBvh::update_transform(ACtxBvh& rBvh, Matrix4 const& worldTf, ActiveEnt const ent)
+{
+    if (ent.value >= rBvh.m_hasLocalBounds.size() || ! rBvh.m_hasLocalBounds.test(ent.value))
+    {
+        return;
+    }
+
+    Range3D const bounds = math::transform_range(worldTf, rBvh.m_localBounds[ent]);
+
+    if (contains(rBvh, ent))
+    {
+        update(rBvh, ent, bounds);
+    }
+    else
+    {
+        insert(rBvh, ent, bounds);
+    }
+}
+
+void SysBvh::update_remap(ACtxBvh& rBvh, ActiveEntRemap const& remap)
+{
+    for (std::size_t const nodeInt : rBvh.m_nodeIds.bitview().zeros())
+    {
+        BvhNode &rNode = rBvh.m_nodes[BvhNodeId(nodeInt)];
+        if (rNode.ent != lgrn::id_null<ActiveEnt>())
+        {
+            rNode.ent = remap(rNode.ent);
+            assert(rNode.ent != lgrn::id_null<ActiveEnt>());
+        }
+    }
+
+    id_remap_keys(remap, rBvh.m_entToLeaf, lgrn::id_null<BvhNodeId>());
+    id_remap_keys(remap, rBvh.m_entBounds);
+    id_remap_keys(remap, rBvh.m_localBounds);
+    id_remap_keys(remap, rBvh.m_hasLocalBounds);
+}
+
+void SysBvh::insert_leaf(ACtxBvh& rBvh, BvhNodeId const leaf)
+{
+    if (rBvh.m_root == lgrn::id_null<BvhNodeId>())
+    {
+        rBvh.m_root = leaf;
+        rBvh.m_nodes[leaf].parent = lgrn::id_null<BvhNodeId>();
+        return;
+    }
+
+    Range3D const leafBounds = rBvh.m_nodes[leaf].bounds;
+
+    // Walk down to find the best sibling by surface area heuristic. At each node, compare the
+    // cost of making a new parent here against the cheapest cost of descending into a child.
+    BvhNodeId sibling = rBvh.m_root;
+    while (rBvh.m_nodes[sibling].ent == lgrn::id_null<ActiveEnt>())
+    {
+        BvhNode const& node = rBvh.m_nodes[sibling];
+
+        float const area            = math::range_surface_area(node.bounds);
+        float const combinedArea    = math::range_surface_area(Magnum::Math::join(node.bounds, leafBounds));
+
+        // Cost of a new parent for this node and the leaf
+        float const cost            = 2.0f * combinedArea;
+
+        // Minimum cost of pushing the leaf further down, paid by this node growing
+        float const inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto const child_cost = [&rBvh, &leafBounds, inheritanceCost] (BvhNodeId const child)
+        {
+            BvhNode const& childNode = rBvh.m_nodes[child];
+            float const joined = math::range_surface_area(Magnum::Math::join(childNode.bounds, leafBounds));
+            return inheritanceCost + ((childNode.ent != lgrn::id_null<ActiveEnt>())
+                                      ? joined
+                                      : joined - math::range_surface_area(childNode.bounds));
+        };
+
+        float const costA = child_cost(node.childA);
+        float const costB = child_cost(node.childB);
+
+        if (cost < costA && cost < costB)
+        {
+            break;
+        }
+
+        sibling = (costA < costB) ? node.childA : node.childB;
+    }
+
+    BvhNodeId const newParent = create_node(rBvh);
+    BvhNode &rSibling   = rBvh.m_nodes[sibling];
+    BvhNode &rNewParent = rBvh.m_nodes[newParent];
+    BvhNodeId const oldParent = rSibling.parent;
+
+    rNewParent.parent   = oldParent;
+    rNewParent.bounds   = Magnum::Math::join(rSibling.bounds, leafBounds);
+    rNewParent.height   = rSibling.height + 1;
+    rNewParent.childA   = sibling;
+    rNewParent.childB   = leaf;
+
+    replace_child(rBvh, oldParent, sibling, newParent);
+
+    rSibling.parent             = newParent;
+    rBvh.m_nodes[leaf].parent   = newParent;
+
+    refit_ancestors(rBvh, oldParent);
+}
+
+void SysBvh::remove_leaf(ACtxBvh& rBvh, BvhNodeId const leaf)
+{
+    if (leaf == rBvh.m_root)
+    {
+        rBvh.m_root = lgrn::id_null<BvhNodeId>();
+        return;
+    }
+
+    BvhNodeId const parent      = rBvh.m_nodes[leaf].parent;
+    BvhNode const&  rParent     = rBvh.m_nodes[parent];
+    BvhNodeId const grandParent = rParent.parent;
+    BvhNodeId const sibling     = (rParent.childA == leaf) ? rParent.childB : rParent.childA;
+
+    // Sibling takes the parent's place
+    replace_child(rBvh, grandParent, parent, sibling);
+    rBvh.m_nodes[sibling].parent    = grandParent;
+    rBvh.m_nodes[leaf].parent       = lgrn::id_null<BvhNodeId>();
+
+    rBvh.m_nodeIds.remove(parent);
+    rBvh.m_nodes[parent] = {};
+
+    refit_ancestors(rBvh, grandParent);
+}
+
+void SysBvh::refit_ancestors(ACtxBvh& rBvh, BvhNodeId node)
+{
+    while (node != lgrn::id_null<BvhNodeId>())
+    {
+        node = balance(rBvh, node);
+
+        BvhNode &rNode          = rBvh.m_nodes[node];
+        BvhNode const& childA   = rBvh.m_nodes[rNode.childA];
+        BvhNode const& childB   = rBvh.m_nodes[rNode.childB];
+
+        rNode.height = 1 + std::max(childA.height, childB.height);
+        rNode.bounds = Magnum::Math::join(childA.bounds, childB.bounds);
+
+        node = rNode.parent;
+    }
+}
+
+BvhNodeId SysBvh::balance(ACtxBvh& rBvh, BvhNodeId const iA)
+{
+    // Same rotations as an AVL tree. For node A with children B and C, the taller child is
+    // swapped with A, then A takes the shorter of that child's two children.
+    //
+    //        A               C
+    //       / \             / \
+    //      B   C    ->     A   F
+    //         / \         / \
+    //        F   G       B   G      (if F is taller than G)
+
+    BvhNode &rA = rBvh.m_nodes[iA];
+
+    if (rA.ent != lgrn::id_null<ActiveEnt>() || rA.height < 2)
+    {
+        return iA;
+    }
+
+    BvhNodeId const iB  = rA.childA;
+    BvhNodeId const iC  = rA.childB;
+    BvhNode &rB         = rBvh.m_nodes[iB];
+    BvhNode &rC         = rBvh.m_nodes[iC];
+
+    int const balance = rC.height - rB.height;
+
+    if (balance > 1)
+    {
+        // Rotate C up
+        BvhNodeId const iF  = rC.childA;
+        BvhNodeId const iG  = rC.childB;
+        BvhNode &rF         = rBvh.m_nodes[iF];
+        BvhNode &rG         = rBvh.m_nodes[iG];
+
+        rC.childA   = iA;
+        rC.parent   = rA.parent;
+        rA.parent   = iC;
+        replace_child(rBvh, rC.parent, iA, iC);
+
+        BvhNodeId const iTall   = (rF.height > rG.height) ? iF : iG;
+        BvhNodeId const iShort  = (rF.height > rG.height) ? iG : iF;
+        BvhNode &rTall          = rBvh.m_nodes[iTall];
+        BvhNode &rShort         = rBvh.m_nodes[iShort];
+
+        rC.childB       = iTall;
+        rA.childB       = iShort;
+        rShort.parent   = iA;
+
+        rA.bounds = Magnum::Math::join(rB.bounds, rShort.bounds);
+        rC.bounds = Magnum::Math::join(rA.bounds, rTall.bounds);
+        rA.height = 1 + std::max(rB.height, rShort.height);
+        rC.height = 1 + std::max(rA.height, rTall.height);
+
+        return iC;
+    }
+
+    if (balance < -1)
+    {
+        // Rotate B up, mirror of above
+        BvhNodeId const iD  = rB.childA;
+        BvhNodeId const iE  = rB.childB;
+        BvhNode &rD         = rBvh.m_nodes[iD];
+        BvhNode &rE         = rBvh.m_nodes[iE];
+
+        rB.childA   = iA;
+        rB.parent   = rA.parent;
+        rA.parent   = iB;
+        replace_child(rBvh, rB.parent, iA, iB);
+
+        BvhNodeId const iTall   = (rD.height > rE.height) ? iD : iE;
+        BvhNodeId const iShort  = (rD.height > rE.height) ? iE : iD;
+        BvhNode &rTall          = rBvh.m_nodes[iTall];
+        BvhNode &rShort         = rBvh.m_nodes[iShort];
+
+        rB.childB       = iTall;
+        rA.childA       = iShort;
+        rShort.parent   = iA;
+
+        rA.bounds = Magnum::Math::join(rC.bounds, rShort.bounds);
+        rB.bounds = Magnum::Math::join(rA.bounds, rTall.bounds);
+        rA.height = 1 + std::max(rC.height, rShort.height);
+        rB.height = 1 + std::max(rA.height, rTall.height);
+
+        return iB;
+    }
+
+    return iA;
+}
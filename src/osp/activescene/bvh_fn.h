@@ -0,0 +1,269 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "bvh.h"
+
+#include "../core/math_bounds.h"
+
+#include <array>
+#include <iterator>
+#include <vector>
+
+namespace osp::active
+{
+
+class SysBvh
+{
+public:
+
+    /**
+     * @brief Add an entity to the tree
+     *
+     * @param bounds [in] World-space bounds of the entity
+     */
+    static void insert(ACtxBvh& rBvh, ActiveEnt ent, Range3D const& bounds);
+
+    /**
+     * @brief Remove an entity from the tree, does nothing if it's not in the tree
+     */
+    static void remove(ACtxBvh& rBvh, ActiveEnt ent);
+
+    /**
+     * @brief Update the bounds of an entity already in the tree
+     *
+     * If the new bounds still fit in the leaf's padded bounds, the tree isn't changed. Otherwise,
+     * the leaf is removed and inserted again, and its old ancestors are refit and rebalanced.
+     *
+     * @return True if the tree was changed
+     */
+    static bool update(ACtxBvh& rBvh, ActiveEnt ent, Range3D const& bounds);
+
+    /**
+     * @brief Insert or update an entity from its world transform and ACtxBvh::m_localBounds
+     *
+     * Signature fits the function called for each calculated draw transform, so the tree can be
+     * kept in sync by SysRender::update_draw_transforms_dirty. Entities without local bounds are
+     * ignored.
+     */
+    static void update_transform(ACtxBvh& rBvh, Matrix4 const& worldTf, ActiveEnt ent);
+
+    [[nodiscard]] static bool contains(ACtxBvh const& bvh, ActiveEnt ent) noexcept
+    {
+        return ent.value < bvh.m_entToLeaf.size()
+            && bvh.m_entToLeaf[ent] != lgrn::id_null<BvhNodeId>();
+    }
+
+    /**
+     * @brief Call func(ActiveEnt) for each entity with bounds that overlap a box
+     */
+    template<typename FUNC_T>
+    static void query_box(ACtxBvh const& bvh, Range3D const& box, FUNC_T&& func);
+
+    /**
+     * @brief Call func(ActiveEnt) for each entity with bounds that overlap a sphere
+     */
+    template<typename FUNC_T>
+    static void query_sphere(ACtxBvh const& bvh, Vector3 const& center, float radius, FUNC_T&& func);
+
+    /**
+     * @brief Call func(ActiveEnt, float distance) for each entity with bounds hit by a ray
+     *
+     * Entities are not sorted by distance.
+     *
+     * @param maxDistance [in] Ignore hits further than this, in units of direction length
+     */
+    template<typename FUNC_T>
+    static void query_ray(ACtxBvh const& bvh, Vector3 const& origin, Vector3 const& direction, float maxDistance, FUNC_T&& func);
+
+    /**
+     * @brief Call func(ActiveEnt) for each entity with bounds inside or overlapping a frustum
+     *
+     * Conservative like math::range_frustum.
+     */
+    template<typename FUNC_T>
+    static void query_frustum(ACtxBvh const& bvh, Frustum const& frustum, FUNC_T&& func);
+
+    /**
+     * @brief Call func(ActiveEnt) for each entity where test(Range3D) is true for its bounds and
+     *        the bounds of all of its ancestors
+     */
+    template<typename TEST_T, typename FUNC_T>
+    static void query(ACtxBvh const& bvh, TEST_T&& test, FUNC_T&& func);
+
+    /**
+     * @brief Remove deleted entities from the tree and forget their local bounds
+     */
+    template<typename IT_T>
+    static void update_delete(ACtxBvh& rBvh, IT_T first, IT_T const& last)
+    {
+        while (first != last)
+        {
+            ActiveEnt const ent = *first;
+            remove(rBvh, ent);
+            if (ent.value < rBvh.m_hasLocalBounds.size())
+            {
+                rBvh.m_hasLocalBounds.reset(ent.value);
+            }
+            std::advance(first, 1);
+        }
+    }
+
+    /**
+     * @brief Move per-ActiveEnt data to new IDs after compact_active_ents. Tree shape is kept.
+     */
+    static void update_remap(ACtxBvh& rBvh, ActiveEntRemap const& remap);
+
+private:
+
+    static void insert_leaf(ACtxBvh& rBvh, BvhNodeId leaf);
+
+    static void remove_leaf(ACtxBvh& rBvh, BvhNodeId leaf);
+
+    /**
+     * @brief Recalculate bounds and heights of a node and all of its ancestors, rebalancing
+     *        along the way
+     */
+    static void refit_ancestors(ACtxBvh& rBvh, BvhNodeId node);
+
+    /**
+     * @brief Rotate a node's taller grandchild up if its children's heights differ by more than 1
+     *
+     * @return Node that now sits at node's old position in the tree
+     */
+    static BvhNodeId balance(ACtxBvh& rBvh, BvhNodeId node);
+
+}; // class SysBvh
+
+template<typename TEST_T, typename FUNC_T>
+void SysBvh::query(ACtxBvh const& bvh, TEST_T&& test, FUNC_T&& func)
+{
+    if (bvh.m_root == lgrn::id_null<BvhNodeId>())
+    {
+        return;
+    }
+
+    // Height of a balanced tree is about 1.44 * log2(leaf count), so the array fits billions of
+    // leaves. Nodes past it spill over to the heap, in case the tree is ever less balanced.
+    std::array<BvhNodeId, 64>   stack;
+    std::vector<BvhNodeId>      overflow;
+    std::size_t                 stackSize = 0;
+
+    auto const push = [&stack, &overflow, &stackSize] (BvhNodeId const node)
+    {
+        if (stackSize != stack.size())
+        {
+            stack[stackSize ++] = node;
+        }
+        else
+        {
+            overflow.push_back(node);
+        }
+    };
+
+    push(bvh.m_root);
+
+    // Overflow is only used while the array is full, so it's always the top of the stack
+    while (stackSize != 0)
+    {
+        BvhNodeId nodeId;
+        if (overflow.empty())
+        {
+            nodeId = stack[-- stackSize];
+        }
+        else
+        {
+            nodeId = overflow.back();
+            overflow.pop_back();
+        }
+
+        BvhNode const& node = bvh.m_nodes[nodeId];
+
+        if ( ! test(node.bounds) )
+        {
+            continue;
+        }
+
+        if (node.ent != lgrn::id_null<ActiveEnt>())
+        {
+            // Leaf; bounds tested so far are padded, test exact bounds too
+            if (test(bvh.m_entBounds[node.ent]))
+            {
+                func(node.ent);
+            }
+        }
+        else
+        {
+            push(node.childA);
+            push(node.childB);
+        }
+    }
+}
+
+template<typename FUNC_T>
+void SysBvh::query_box(ACtxBvh const& bvh, Range3D const& box, FUNC_T&& func)
+{
+    query(bvh, [&box] (Range3D const& bounds) noexcept
+    {
+        return Magnum::Math::intersects(bounds, box);
+    }, func);
+}
+
+template<typename FUNC_T>
+void SysBvh::query_sphere(ACtxBvh const& bvh, Vector3 const& center, float const radius, FUNC_T&& func)
+{
+    query(bvh, [&center, radius] (Range3D const& bounds) noexcept
+    {
+        return math::range_sphere(bounds, center, radius);
+    }, func);
+}
+
+template<typename FUNC_T>
+void SysBvh::query_ray(ACtxBvh const& bvh, Vector3 const& origin, Vector3 const& direction, float const maxDistance, FUNC_T&& func)
+{
+    Vector3 const invDirection{1.0f / direction.x(), 1.0f / direction.y(), 1.0f / direction.z()};
+    float distance = 0.0f;
+
+    query(bvh, [&origin, &invDirection, maxDistance, &distance] (Range3D const& bounds) noexcept
+    {
+        return math::range_ray(bounds, origin, invDirection, maxDistance, distance);
+    },
+    [&func, &distance] (ActiveEnt const ent)
+    {
+        // distance is from the last test, which was for this leaf's exact bounds
+        func(ent, distance);
+    });
+}
+
+template<typename FUNC_T>
+void SysBvh::query_frustum(ACtxBvh const& bvh, Frustum const& frustum, FUNC_T&& func)
+{
+    query(bvh, [&frustum] (Range3D const& bounds) noexcept
+    {
+        return math::range_frustum(bounds, frustum);
+    }, func);
+}
+
+} // namespace osp::active
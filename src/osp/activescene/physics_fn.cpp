@@ -94,3 +94,16 @@ void SysPhysics::calculate_subtree_mass_inertia(
         }
     }
 }
+
+void SysPhysics::update_remap_phys(ACtxPhysics& rCtxPhys, ActiveEntRemap const& remap)
+{
+    id_remap_keys   (remap, rCtxPhys.m_shape, EShape::None);
+    id_remap_keys   (remap, rCtxPhys.m_hasColliders);
+    id_remap_keys   (remap, rCtxPhys.m_mass);
+    id_remap_values (remap, rCtxPhys.m_colliderDirty);
+
+    for (std::pair<ActiveEnt, Vector3> &rSetVelocity : rCtxPhys.m_setVelocity)
+    {
+        rSetVelocity.first = remap(rSetVelocity.first);
+    }
+}
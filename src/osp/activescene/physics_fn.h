@@ -56,6 +56,11 @@ public:
     template<typename IT_T, typename ITB_T>
     static void update_delete_phys(ACtxPhysics& rCtxPhys, IT_T const& first, ITB_T const& last);
 
+    /**
+     * @brief Move per-ActiveEnt data to new IDs after compact_active_ents
+     */
+    static void update_remap_phys(ACtxPhysics& rCtxPhys, ActiveEntRemap const& remap);
+
 };
 
 template<typename IT_T, typename ITB_T>
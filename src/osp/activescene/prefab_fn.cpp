@@ -266,5 +266,14 @@ void SysPrefabInit::init_physics(
     }
 }
 
+void SysPrefabInit::update_remap_prefabs(
+        ACtxPrefabs&                rPrefabs,
+        ActiveEntRemap const&       remap) noexcept
+{
+    // spawnedEntsOffset views into newEnts, which is remapped in place
+    id_remap_values (remap, rPrefabs.newEnts);
+    id_remap_keys   (remap, rPrefabs.roots);
+    id_remap_keys   (remap, rPrefabs.instanceInfo, PrefabInstanceInfo{});
+}
 
 } // namespace osp::active
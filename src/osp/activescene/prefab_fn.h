@@ -99,6 +99,13 @@ public:
             Resources const&            rResources,
             ACtxPhysics&                rCtxPhys) noexcept;
 
+    /**
+     * @brief Move per-ActiveEnt data to new IDs after compact_active_ents
+     */
+    static void update_remap_prefabs(
+            ACtxPrefabs&                rPrefabs,
+            ActiveEntRemap const&       remap) noexcept;
+
 };
 
 
@@ -25,6 +25,7 @@
 #pragma once
 
 #include "active_ent.h"
+#include "basic.h"
 
 #include "../core/array_view.h"
 #include "../core/keyed_vector.h"
@@ -70,6 +71,16 @@ struct ACtxParts
     KeyedVec<WeldId, ActiveEnt>                     weldToActive;
 };
 
+/**
+ * @brief Move per-ActiveEnt data to new IDs after compact_active_ents
+ */
+inline void update_remap_parts(ACtxParts &rScnParts, ActiveEntRemap const& remap)
+{
+    id_remap_keys   (remap, rScnParts.activeToPart, lgrn::id_null<PartId>());
+    id_remap_values (remap, rScnParts.partToActive);
+    id_remap_values (remap, rScnParts.weldToActive);
+}
+
 
 using SpVehicleId = StrongId<uint32_t, struct DummyForSpVehicleId>;
 using SpPartId    = StrongId<uint32_t, struct DummyForSpPartId>;
@@ -0,0 +1,77 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <algorithm>
+
+namespace osp
+{
+
+/**
+ * @brief Steps an update at a fixed rate, independent of the render rate
+ *
+ * Frame time is accumulated and spent in whole steps; a frame may run several steps or none.
+ * Leftover time is used to interpolate draw transforms between the last two steps.
+ */
+struct FixedTimestep
+{
+    /**
+     * @brief Add time passed since the previous frame
+     *
+     * @return Number of updates to run this frame
+     */
+    int accumulate(float const frameDelta) noexcept
+    {
+        if ( ! m_enabled )
+        {
+            return 1;
+        }
+
+        m_accumulator += frameDelta;
+
+        int const steps = std::min(int(m_accumulator / m_stepDelta), m_maxSteps);
+        m_accumulator -= float(steps) * m_stepDelta;
+
+        // Drop time that can't be caught up with, instead of falling further behind each frame
+        m_accumulator = std::min(m_accumulator, m_stepDelta);
+
+        return steps;
+    }
+
+    /**
+     * @return Fraction of a step left in the accumulator, 0.0 to 1.0
+     */
+    [[nodiscard]] float alpha() const noexcept
+    {
+        return m_enabled ? (m_accumulator / m_stepDelta) : 1.0f;
+    }
+
+    float   m_stepDelta     { 1.0f / 60.0f };   ///< Seconds simulated by each update
+    float   m_accumulator   { 0.0f };
+    int     m_maxSteps      { 4 };              ///< Max updates per frame
+    bool    m_enabled       { true };           ///< If false, update exactly once per frame
+};
+
+} // namespace osp
@@ -0,0 +1,114 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+namespace osp
+{
+
+static constexpr std::size_t gc_blockAlignment = alignof(std::max_align_t);
+
+FrameArena::FrameArena(std::size_t const initialCapacity, std::pmr::memory_resource *pUpstream)
+ : m_pUpstream{pUpstream}
+ , m_capacity{initialCapacity}
+{
+    if (m_capacity != 0)
+    {
+        m_pBlock = static_cast<std::byte*>(m_pUpstream->allocate(m_capacity, gc_blockAlignment));
+    }
+}
+
+FrameArena::~FrameArena()
+{
+    reset();
+
+    if (m_pBlock != nullptr)
+    {
+        m_pUpstream->deallocate(m_pBlock, m_capacity, gc_blockAlignment);
+    }
+}
+
+void FrameArena::reset()
+{
+    for (Overflow const& overflow : m_overflow)
+    {
+        m_pUpstream->deallocate(overflow.ptr, overflow.bytes, overflow.alignment);
+    }
+    m_overflow.clear();
+
+    if (m_overflowBytes != 0)
+    {
+        // Grow to fit everything from this time around in the block next time
+        std::size_t const needed = std::bit_ceil(m_offsetPeak + m_overflowBytes);
+
+        if (m_pBlock != nullptr)
+        {
+            m_pUpstream->deallocate(m_pBlock, m_capacity, gc_blockAlignment);
+        }
+        m_pBlock    = static_cast<std::byte*>(m_pUpstream->allocate(needed, gc_blockAlignment));
+        m_capacity  = needed;
+    }
+
+    m_offset        = 0;
+    m_offsetPeak    = 0;
+    m_overflowBytes = 0;
+}
+
+void* FrameArena::do_allocate(std::size_t const bytes, std::size_t const alignment)
+{
+    if (m_pBlock != nullptr)
+    {
+        auto const          blockAddr   = reinterpret_cast<std::uintptr_t>(m_pBlock);
+        auto const          alignedAddr = (blockAddr + m_offset + alignment - 1) & ~(std::uintptr_t(alignment) - 1);
+        std::size_t const   begin       = alignedAddr - blockAddr;
+
+        if (begin + bytes <= m_capacity)
+        {
+            m_offset        = begin + bytes;
+            m_offsetPeak    = std::max(m_offsetPeak, m_offset);
+            return m_pBlock + begin;
+        }
+    }
+
+    void *const ptr = m_pUpstream->allocate(bytes, alignment);
+    m_overflow.push_back({ptr, bytes, alignment});
+    m_overflowBytes += bytes + alignment; // Worst case padding once moved into the block
+    return ptr;
+}
+
+void FrameArena::do_deallocate(void *const ptr, std::size_t const bytes, [[maybe_unused]] std::size_t const alignment)
+{
+    // Rewind if this was the latest allocation from the block, common for growing vectors.
+    // Anything else is freed on reset()
+    if (m_pBlock != nullptr && bytes <= m_offset && ptr == m_pBlock + (m_offset - bytes))
+    {
+        m_offset -= bytes;
+    }
+}
+
+} // namespace osp
@@ -0,0 +1,99 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief Bump allocator for short-lived temporaries that are all freed together, such as once
+ *        per frame
+ *
+ * Allocations are carved out of a single block. If the block runs out, then the rest are taken
+ * from the upstream resource until reset(), which grows the block to fit everything allocated
+ * so far. After a few frames, frames with similar workloads never touch the upstream resource.
+ *
+ * Not thread-safe; each thread needs its own, see WorkerContext::m_pFrameMem.
+ */
+class FrameArena final : public std::pmr::memory_resource
+{
+public:
+
+    explicit FrameArena(std::size_t initialCapacity = 0,
+                        std::pmr::memory_resource *pUpstream = std::pmr::new_delete_resource());
+    ~FrameArena() override;
+
+    FrameArena(FrameArena const& copy) = delete;
+    FrameArena(FrameArena&& move) = delete;
+    FrameArena& operator=(FrameArena const& copy) = delete;
+    FrameArena& operator=(FrameArena&& move) = delete;
+
+    /**
+     * @brief Free everything allocated so far. Nothing allocated may still be in use
+     */
+    void reset();
+
+    /// Size of the block allocations are carved from
+    std::size_t capacity() const noexcept { return m_capacity; }
+
+    /// Bytes allocated since the last reset, including ones that didn't fit in the block
+    std::size_t used() const noexcept { return m_offset + m_overflowBytes; }
+
+private:
+
+    struct Overflow
+    {
+        void        *ptr;
+        std::size_t bytes;
+        std::size_t alignment;
+    };
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+    void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) override;
+
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource   *m_pUpstream;
+
+    std::byte                   *m_pBlock       {nullptr};
+    std::size_t                 m_capacity      {0};
+    std::size_t                 m_offset        {0};
+
+    /// Highest m_offset since the last reset, as deallocating the latest allocation rewinds it
+    std::size_t                 m_offsetPeak    {0};
+
+    std::vector<Overflow>       m_overflow;
+    std::size_t                 m_overflowBytes {0};
+};
+
+} // namespace osp
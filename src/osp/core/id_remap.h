@@ -0,0 +1,156 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "bitvector.h"
+#include "keyed_vector.h"
+#include "storage.h"
+
+#include <longeron/id_management/null.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace osp
+{
+
+/**
+ * @brief Table of new IDs for old IDs, for when IDs are reassigned to pack them together
+ *
+ * Containers indexed by the old IDs are rewritten with id_remap_keys, and containers that hold
+ * IDs as values are rewritten with id_remap_values.
+ */
+template <typename ID_T>
+struct IdRemap
+{
+    /// New ID for each old ID. Null for old IDs that didn't exist.
+    KeyedVec<ID_T, ID_T>    oldToNew;
+
+    /// Size that containers indexed by the new IDs should be resized to
+    std::size_t             newCapacity{0};
+
+    /**
+     * @return New ID for an old ID, or null if it didn't exist or is null
+     */
+    [[nodiscard]] ID_T operator()(ID_T const old) const noexcept
+    {
+        return (std::size_t(old) < oldToNew.size()) ? oldToNew[old] : lgrn::id_null<ID_T>();
+    }
+};
+
+/**
+ * @brief Move values of a KeyedVec to the positions of their new IDs
+ *
+ * Empty containers are left empty. Values of old IDs that didn't exist are discarded.
+ *
+ * @param fill [in] Value for positions that don't get a value
+ */
+template <typename ID_T, typename DATA_T, typename ALLOC_T>
+void id_remap_keys(IdRemap<ID_T> const& remap, KeyedVec<ID_T, DATA_T, ALLOC_T> &rVec, DATA_T const& fill = {})
+{
+    if (rVec.empty())
+    {
+        return;
+    }
+
+    KeyedVec<ID_T, DATA_T, ALLOC_T> remapped{
+            std::vector<DATA_T, ALLOC_T>(remap.newCapacity, fill, rVec.get_allocator())};
+
+    std::size_t const count = std::min(rVec.size(), remap.oldToNew.size());
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        ID_T const newId = remap.oldToNew[ID_T(i)];
+        if (newId != lgrn::id_null<ID_T>())
+        {
+            remapped[newId] = std::move(rVec[ID_T(i)]);
+        }
+    }
+
+    rVec = std::move(remapped);
+}
+
+/**
+ * @brief Move set bits to the positions of their new IDs
+ */
+template <typename ID_T>
+void id_remap_keys(IdRemap<ID_T> const& remap, BitVector_t &rBits)
+{
+    if (rBits.size() == 0)
+    {
+        return;
+    }
+
+    BitVector_t remapped;
+    bitvector_resize(remapped, remap.newCapacity);
+
+    for (std::size_t const i : rBits.ones())
+    {
+        ID_T const newId = remap(ID_T(i));
+        if (newId != lgrn::id_null<ID_T>())
+        {
+            remapped.set(std::size_t(newId));
+        }
+    }
+
+    rBits = std::move(remapped);
+}
+
+/**
+ * @brief Move components of an entt::basic_storage to their new IDs
+ */
+template <typename ID_T, typename COMP_T>
+void id_remap_keys(IdRemap<ID_T> const& remap, Storage_t<ID_T, COMP_T> &rStorage)
+{
+    Storage_t<ID_T, COMP_T> remapped;
+    remapped.reserve(rStorage.size());
+
+    for (std::size_t i = 0; i < remap.oldToNew.size(); ++i)
+    {
+        ID_T const oldId = ID_T(i);
+        ID_T const newId = remap.oldToNew[oldId];
+        if (newId != lgrn::id_null<ID_T>() && rStorage.contains(oldId))
+        {
+            remapped.emplace(newId, std::move(rStorage.get(oldId)));
+        }
+    }
+
+    rStorage = std::move(remapped);
+}
+
+/**
+ * @brief Replace IDs held as values with their new IDs
+ *
+ * @param rRange [ref] Any range of ID_T, such as a std::vector or KeyedVec
+ */
+template <typename ID_T, typename RANGE_T>
+void id_remap_values(IdRemap<ID_T> const& remap, RANGE_T &rRange)
+{
+    for (ID_T &rId : rRange)
+    {
+        rId = remap(rId);
+    }
+}
+
+} // namespace osp
@@ -24,6 +24,7 @@
  */
 #pragma once
 
+#include <memory_resource>
 #include <vector>
 
 #include <longeron/utility/enum_traits.hpp>
@@ -77,6 +78,22 @@ public:
 
 }; // class KeyedVec
 
+namespace pmr
+{
+
+/**
+ * @brief KeyedVec that allocates from a std::pmr::memory_resource, such as a FrameArena
+ */
+template <typename ID_T, typename DATA_T>
+using KeyedVec = osp::KeyedVec<ID_T, DATA_T, std::pmr::polymorphic_allocator<DATA_T>>;
+
+} // namespace pmr
+
+template <typename ID_T, typename DATA_T>
+pmr::KeyedVec<ID_T, DATA_T> make_pmr_keyed_vec(std::pmr::memory_resource *pResource)
+{
+    return { std::pmr::vector<DATA_T>{pResource} };
+}
 
 
 } // namespace osp
@@ -0,0 +1,126 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "math_types.h"
+
+#include <Magnum/Math/Functions.h>
+
+namespace osp::math
+{
+
+/**
+ * @brief Axis-aligned bounds of a box after being transformed
+ *
+ * Each axis of the transform contributes either its min or max corner to the output, whichever
+ * is smaller or larger. Tighter than transforming all 8 corners, and much cheaper.
+ */
+inline Range3D transform_range(Matrix4 const& transform, Range3D const& range) noexcept
+{
+    Vector3 outMin = transform.translation();
+    Vector3 outMax = outMin;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        Vector3 const column = transform[axis].xyz();
+        Vector3 const a      = column * range.min()[axis];
+        Vector3 const b      = column * range.max()[axis];
+
+        outMin += Magnum::Math::min(a, b);
+        outMax += Magnum::Math::max(a, b);
+    }
+
+    return {outMin, outMax};
+}
+
+/**
+ * @return Surface area of a box, used as the cost heuristic for bounding volume hierarchies
+ */
+inline float range_surface_area(Range3D const& range) noexcept
+{
+    Vector3 const size = range.size();
+    return 2.0f * (size.x() * size.y() + size.y() * size.z() + size.z() * size.x());
+}
+
+/**
+ * @return True if a box overlaps or is inside a frustum
+ *
+ * Conservative; boxes near the frustum's corners may pass despite being outside.
+ */
+inline bool range_frustum(Range3D const& range, Frustum const& frustum) noexcept
+{
+    for (Vector4 const& plane : frustum)
+    {
+        // Corner furthest along the plane's normal
+        Vector3 const corner{plane.x() >= 0.0f ? range.max().x() : range.min().x(),
+                             plane.y() >= 0.0f ? range.max().y() : range.min().y(),
+                             plane.z() >= 0.0f ? range.max().z() : range.min().z()};
+
+        if (Magnum::Math::dot(plane.xyz(), corner) + plane.w() < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @return True if a sphere overlaps a box
+ */
+inline bool range_sphere(Range3D const& range, Vector3 const& center, float const radius) noexcept
+{
+    Vector3 const closest = Magnum::Math::max(range.min(), Magnum::Math::min(center, range.max()));
+    return (closest - center).dot() <= radius * radius;
+}
+
+/**
+ * @brief Ray and box intersection, using the slab method
+ *
+ * @param origin        [in] Ray origin
+ * @param invDirection  [in] 1 / ray direction, per component. Infinities are fine.
+ * @param maxDistance   [in] Ignore hits further than this, in units of ray direction length
+ * @param rDistance     [out] Distance to where the ray enters the box, or 0 if it starts inside
+ *
+ * @return True if the ray hits the box
+ */
+inline bool range_ray(Range3D const& range, Vector3 const& origin, Vector3 const& invDirection, float const maxDistance, float &rDistance) noexcept
+{
+    float near = 0.0f;
+    float far  = maxDistance;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float const t0 = (range.min()[axis] - origin[axis]) * invDirection[axis];
+        float const t1 = (range.max()[axis] - origin[axis]) * invDirection[axis];
+
+        near = Magnum::Math::max(near, Magnum::Math::min(t0, t1));
+        far  = Magnum::Math::min(far,  Magnum::Math::max(t0, t1));
+    }
+
+    rDistance = near;
+    return near <= far;
+}
+
+} // namespace osp::math
@@ -0,0 +1,99 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "math_types.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #define OSP_MATH_SSE 1
+    #include <xmmintrin.h>
+#endif
+
+namespace osp::math
+{
+
+/**
+ * @brief Multiply two 4x4 matrices, rOut = a * b
+ *
+ * Uses SSE if available. Safe for rOut to alias either a or b.
+ */
+inline void mul_mat4(Matrix4 const& a, Matrix4 const& b, Matrix4 &rOut) noexcept
+{
+#if defined(OSP_MATH_SSE)
+    // Matrix4 is column-major. Each column of the result is a linear combination of a's columns,
+    // weighted by the components of the same column of b.
+    float const *pA = a.data();
+    float const *pB = b.data();
+    float       *pOut = rOut.data();
+
+    __m128 const a0 = _mm_loadu_ps(pA);
+    __m128 const a1 = _mm_loadu_ps(pA + 4);
+    __m128 const a2 = _mm_loadu_ps(pA + 8);
+    __m128 const a3 = _mm_loadu_ps(pA + 12);
+
+    for (int col = 0; col < 4; ++col)
+    {
+        float const *pBCol = pB + col * 4;
+        __m128 const sum = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(pBCol[0])),
+                           _mm_mul_ps(a1, _mm_set1_ps(pBCol[1]))),
+                _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(pBCol[2])),
+                           _mm_mul_ps(a3, _mm_set1_ps(pBCol[3]))));
+        _mm_storeu_ps(pOut + col * 4, sum);
+    }
+#else
+    rOut = a * b;
+#endif
+}
+
+/**
+ * @brief Compose a transform from translation, rotation, and scale
+ *
+ * Same as Matrix4::from(rotation.toMatrix(), translation) * Matrix4::scaling(scale), without
+ * the full matrix multiply.
+ */
+inline Matrix4 compose_trs(Vector3 const& translation, Quaternion const& rotation, Vector3 const& scale) noexcept
+{
+    auto const rot = rotation.toMatrix();
+    return { {rot[0] * scale.x(), 0.0f},
+             {rot[1] * scale.y(), 0.0f},
+             {rot[2] * scale.z(), 0.0f},
+             {translation,        1.0f} };
+}
+
+/**
+ * @brief Split a transform into translation, rotation, and scale
+ *
+ * Inverse of compose_trs. Shear and negative scale are not supported, as they can't be
+ * represented by a rotation and per-axis scale.
+ */
+inline void decompose_trs(Matrix4 const& transform, Vector3 &rTranslation, Quaternion &rRotation, Vector3 &rScale) noexcept
+{
+    rTranslation    = transform.translation();
+    rScale          = transform.scaling();
+    rRotation       = Quaternion::fromMatrix(transform.rotation());
+}
+
+} // namespace osp::math
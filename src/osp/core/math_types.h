@@ -37,6 +37,9 @@
 #include <Magnum/Math/Vector4.h>
 
 #include <Magnum/Math/Quaternion.h>
+
+#include <Magnum/Math/Frustum.h>
+#include <Magnum/Math/Range.h>
 // IWYU pragma: end_exports
 
 namespace osp
@@ -62,4 +65,7 @@ using Rad           = Magnum::Math::Rad<Magnum::Float>;
 using Radd          = Magnum::Math::Rad<Magnum::Double>;
 using Deg           = Magnum::Math::Deg<Magnum::Float>;
 
+using Range3D       = Magnum::Math::Range3D<Magnum::Float>;
+using Frustum       = Magnum::Math::Frustum<Magnum::Float>;
+
 } // namespace osp
@@ -0,0 +1,184 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "draw_ent.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace osp::draw
+{
+
+/**
+ * @brief Key to sort draws by, so draws that share GPU state end up next to each other
+ *
+ * Fields from most to least significant, for opaque draws:
+ *
+ * | Bits   | Field           |
+ * |--------|-----------------|
+ * | 63..61 | pass            |
+ * | 60     | transparent (0) |
+ * | 59..52 | shader          |
+ * | 51..44 | material        |
+ * | 43..32 | texture         |
+ * | 31..16 | mesh            |
+ * | 15..0  | depth           |
+ *
+ * and for transparent draws:
+ *
+ * | Bits   | Field           |
+ * |--------|-----------------|
+ * | 63..61 | pass            |
+ * | 60     | transparent (1) |
+ * | 59..44 | depth           |
+ * | 43..36 | shader          |
+ * | 35..28 | material        |
+ * | 27..16 | texture         |
+ * | 15..0  | mesh            |
+ *
+ * Transparent draws are sorted by depth before anything else, as they must be blended in order
+ * regardless of what state they use. Within a pass, opaque draws come before transparent ones.
+ *
+ * Values too large for their field are truncated. This only makes sorting less effective, as
+ * draws still use their DrawEnt's actual data.
+ */
+struct DrawKey
+{
+    /// Bit offset of each field
+    struct Layout
+    {
+        int shader;
+        int material;
+        int texture;
+        int mesh;
+        int depth;
+    };
+
+    static constexpr int    sc_passShift        = 61;
+    static constexpr int    sc_transparentShift = 60;
+
+    static constexpr Layout sc_opaqueLayout      { .shader = 52, .material = 44, .texture = 32, .mesh = 16, .depth = 0  };
+    static constexpr Layout sc_transparentLayout { .shader = 36, .material = 28, .texture = 16, .mesh = 0,  .depth = 44 };
+
+    static constexpr uint64_t sc_passMask       = 0x7;
+    static constexpr uint64_t sc_shaderMask     = 0xFF;
+    static constexpr uint64_t sc_materialMask   = 0xFF;
+    static constexpr uint64_t sc_textureMask    = 0xFFF;
+    static constexpr uint64_t sc_meshMask       = 0xFFFF;
+    static constexpr uint64_t sc_depthMask      = 0xFFFF;
+
+    [[nodiscard]] constexpr uint64_t pack() const noexcept
+    {
+        Layout const& layout = transparent ? sc_transparentLayout : sc_opaqueLayout;
+
+        return    ((pass        & sc_passMask)      << sc_passShift)
+                | (uint64_t(transparent)            << sc_transparentShift)
+                | ((shader      & sc_shaderMask)    << layout.shader)
+                | ((material    & sc_materialMask)  << layout.material)
+                | ((texture     & sc_textureMask)   << layout.texture)
+                | ((mesh        & sc_meshMask)      << layout.mesh)
+                | ((depth       & sc_depthMask)     << layout.depth);
+    }
+
+    [[nodiscard]] static constexpr DrawKey unpack(uint64_t const key) noexcept
+    {
+        bool const      isTransparent   = ((key >> sc_transparentShift) & 1) != 0;
+        Layout const&   layout          = isTransparent ? sc_transparentLayout : sc_opaqueLayout;
+
+        return {
+            .pass           = uint32_t((key >> sc_passShift)     & sc_passMask),
+            .shader         = uint32_t((key >> layout.shader)    & sc_shaderMask),
+            .material       = uint32_t((key >> layout.material)  & sc_materialMask),
+            .texture        = uint32_t((key >> layout.texture)   & sc_textureMask),
+            .mesh           = uint32_t((key >> layout.mesh)      & sc_meshMask),
+            .depth          = uint32_t((key >> layout.depth)     & sc_depthMask),
+            .transparent    = isTransparent };
+    }
+
+    /**
+     * @brief Quantize a view space distance to a depth field value
+     *
+     * @param distance  [in] Distance in front of the camera
+     * @param maxDepth  [in] Distance mapped to the largest value, such as the far plane
+     * @param reverse   [in] Farthest first instead of nearest first, for transparent draws
+     */
+    [[nodiscard]] static constexpr uint32_t quantize_depth(float const distance, float const maxDepth, bool const reverse) noexcept
+    {
+        float const clamped = (distance <= 0.0f) ? 0.0f : (distance >= maxDepth) ? 1.0f : distance / maxDepth;
+        auto  const value   = uint32_t(clamped * float(sc_depthMask));
+        return reverse ? uint32_t(sc_depthMask) - value : value;
+    }
+
+    uint32_t pass           {0};
+    uint32_t shader         {0};
+    uint32_t material       {0};
+    uint32_t texture        {0};
+    uint32_t mesh           {0};
+    uint32_t depth          {0};
+
+    /// Use the transparent layout, sorting by depth before the other fields
+    bool     transparent    {false};
+};
+
+/**
+ * @brief A single draw in a DrawCommandList
+ */
+struct DrawCommand
+{
+    uint64_t    key;
+    DrawEnt     ent;
+};
+
+/**
+ * @brief Draws for a frame, sorted by key. See SysRender::sort_draw_commands
+ */
+struct DrawCommandList
+{
+    std::vector<DrawCommand>    m_commands;
+
+    /// Scratch space for sorting
+    std::vector<DrawCommand>    m_sortBuffer;
+};
+
+/**
+ * @brief Number of times each part of the draw state changes over a list of draw commands
+ *
+ * Counted by comparing DrawKey fields of consecutive commands, see
+ * SysRender::count_state_changes. The first command counts as a change for every field.
+ */
+struct DrawStateChanges
+{
+    uint32_t draws      {0};
+    uint32_t passes     {0};
+    uint32_t shaders    {0};
+    uint32_t materials  {0};
+    uint32_t textures   {0};
+    uint32_t meshes     {0};
+
+    constexpr bool operator==(DrawStateChanges const& rhs) const noexcept = default;
+};
+
+} // namespace osp::draw
@@ -35,6 +35,7 @@
 #include "../core/storage.h"
 
 #include "../activescene/active_ent.h"
+#include "../activescene/basic.h"
 
 #include <Magnum/Magnum.h>
 #include <Magnum/Math/Color.h>
@@ -42,6 +43,9 @@
 #include <longeron/id_management/refcount.hpp>
 #include <longeron/id_management/registry_stl.hpp> // for lgrn::IdRegistryStl
 
+#include <optional>
+#include <vector>
+
 namespace osp::draw
 {
 
@@ -84,6 +88,11 @@ struct ACtxDrawing
     lgrn::IdRegistryStl<MeshId>             m_meshIds;
     MeshRefCount_t                          m_meshRefCounts;
 
+    // Mesh bounds in the mesh's own space, see SysRender::set_mesh_bounds. Meshes without
+    // bounds are never culled.
+    KeyedVec<MeshId, Range3D>               m_meshBounds;
+    BitVector_t                             m_meshHasBounds;
+
     // Scene-space Textures
     lgrn::IdRegistryStl<TexId>              m_texIds;
     TexRefCount_t                           m_texRefCounts;
@@ -113,6 +122,68 @@ using DrawEntColors_t = KeyedVec<DrawEnt, Magnum::Color4>;
 using DrawEntTextures_t = KeyedVec<DrawEnt, TexIdOwner_t>;
 using DrawTransforms_t = KeyedVec<DrawEnt, Matrix4>;
 
+/**
+ * @brief Local transforms from the two most recent scene updates
+ *
+ * When the scene updates at a fixed rate independent of rendering, draw transforms are
+ * interpolated between the previous and current state to avoid stutter.
+ * See SysRender::save_interp_transforms
+ */
+struct DrawTfInterp
+{
+    void resize(std::size_t const size)
+    {
+        bitvector_resize(m_hasPrev,  size);
+        bitvector_resize(m_hasLast,  size);
+        bitvector_resize(m_moving,   size);
+        bitvector_resize(m_settling, size);
+        m_prev.resize(size);
+        m_last.resize(size);
+    }
+
+    KeyedVec<active::ActiveEnt, Matrix4>    m_prev;
+    KeyedVec<active::ActiveEnt, Matrix4>    m_last;
+    BitVector_t                             m_hasPrev;
+    BitVector_t                             m_hasLast;
+
+    /// Entities where m_prev != m_last; their draw transforms change every frame
+    BitVector_t                             m_moving;
+    /// Entities moving as of the save before; drawn partway last frame, need a final update
+    BitVector_t                             m_settling;
+};
+
+/**
+ * @brief Scene graph subtree that entities after it in the tree are inside of, see
+ *        SysRender::update_draw_transforms_range
+ */
+struct DrawTfAncestor
+{
+    active::TreePos_t pos;
+    active::TreePos_t subtreeLast;
+};
+
+/**
+ * @brief World transforms kept between draw transform updates, so only changed subtrees need to
+ *        be recalculated
+ *
+ * See SysRender::update_draw_transforms_dirty
+ */
+struct DrawTfCache
+{
+    /// World transforms by scene graph tree position
+    KeyedVec<active::TreePos_t, Matrix4>    m_treeWorldTf;
+
+    /// ACtxSceneGraph::m_version that m_treeWorldTf is for. Reset to recalculate everything
+    std::optional<uint32_t>                 m_scnGraphVersion;
+
+    /// Copy of ACtxSceneRender::m_needDrawTf that m_treeWorldTf is for
+    active::ActiveEntSet_t                  m_needDrawTf;
+
+    // Scratch space kept to not allocate each call
+    std::vector<active::TreePos_t>          m_dirtyPos;
+    std::vector<DrawTfAncestor>             m_ancestors;
+};
+
 struct ACtxSceneRender
 {
     ACtxSceneRender() = default;
@@ -125,6 +196,7 @@ struct ACtxSceneRender
         bitvector_resize(m_opaque,      size);
         bitvector_resize(m_transparent, size);
         bitvector_resize(m_visible,     size);
+        bitvector_resize(m_inView,      size);
 
         m_drawTransform .resize(size);
         m_color         .resize(size, {1.0f, 1.0f, 1.0f, 1.0f}); // Default white
@@ -140,8 +212,11 @@ struct ACtxSceneRender
     void resize_active(std::size_t const size)
     {
         bitvector_resize(m_needDrawTf, size);
+        bitvector_resize(m_transformDirty, size);
+        bitvector_resize(m_transformDirtyTaken, size);
         m_activeToDraw      .resize(size, lgrn::id_null<DrawEnt>());
         drawTfObserverEnable.resize(size, 0);
+        m_tfInterp          .resize(size);
     }
 
     lgrn::IdRegistryStl<DrawEnt>            m_drawIds;
@@ -149,6 +224,8 @@ struct ACtxSceneRender
     DrawEntSet_t                            m_opaque;
     DrawEntSet_t                            m_transparent;
     DrawEntSet_t                            m_visible;
+    // Visible DrawEnts in view of the camera, see SysRender::cull_frustum
+    DrawEntSet_t                            m_inView;
     DrawEntColors_t                         m_color;
 
     DrawEntSet_t                            m_needDrawTf;
@@ -156,6 +233,16 @@ struct ACtxSceneRender
 
     KeyedVec<active::ActiveEnt, uint16_t>   drawTfObserverEnable;
     DrawTransforms_t                        m_drawTransform;
+    DrawTfInterp                            m_tfInterp;
+
+    DrawTfCache                             m_drawTfCache;
+    // DrawEnts given a new draw transform by the last SysRender::update_draw_transforms_dirty
+    DrawEntVec_t                            m_drawTfChanged;
+
+    // Entities with modified transforms not yet drawn, see SysRender::take_transform_dirty
+    active::ActiveEntSet_t                  m_transformDirty;
+    // Entities of ACtxBasic::m_transformDirty already added to m_transformDirty
+    active::ActiveEntSet_t                  m_transformDirtyTaken;
 
     // Meshes and textures assigned to DrawEnts
     KeyedVec<DrawEnt, TexIdOwner_t>         m_diffuseTex;
@@ -26,6 +26,17 @@
 #include "own_restypes.h"
 
 #include "../core/Resources.h"
+#include "../core/math_mat4.h"
+
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Trade/MeshData.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <utility>
 
 using namespace osp;
 using namespace osp::active;
@@ -40,11 +51,44 @@ MeshId SysRender::own_mesh_resource(ACtxDrawing& rCtxDrawing, ACtxDrawingRes& rC
         MeshId const meshId = rCtxDrawing.m_meshIds.create();
         rCtxDrawingRes.m_meshToRes.emplace(meshId, std::move(owner));
         it->second = meshId;
+
+        using Magnum::Trade::MeshAttribute;
+        using Magnum::Trade::MeshData;
+        auto const *pMeshData = rResources.data_try_get<MeshData>(restypes::gc_mesh, resId);
+        if (pMeshData != nullptr && pMeshData->hasAttribute(MeshAttribute::Position))
+        {
+            auto const positions = pMeshData->positions3DAsArray();
+            if ( ! positions.isEmpty() )
+            {
+                Vector3 min{positions[0]};
+                Vector3 max{positions[0]};
+                for (Vector3 const& pos : positions)
+                {
+                    min = Magnum::Math::min(min, pos);
+                    max = Magnum::Math::max(max, pos);
+                }
+                set_mesh_bounds(rCtxDrawing, meshId, {min, max});
+            }
+        }
+
         return meshId;
     }
     return it->second;
 };
 
+void SysRender::set_mesh_bounds(ACtxDrawing& rCtxDrawing, MeshId const mesh, Range3D const& bounds)
+{
+    std::size_t const capacity = rCtxDrawing.m_meshIds.capacity();
+    if (rCtxDrawing.m_meshBounds.size() < capacity)
+    {
+        rCtxDrawing.m_meshBounds.resize(capacity);
+        bitvector_resize(rCtxDrawing.m_meshHasBounds, capacity);
+    }
+
+    rCtxDrawing.m_meshBounds[mesh] = bounds;
+    rCtxDrawing.m_meshHasBounds.set(std::size_t(mesh));
+}
+
 TexId SysRender::own_texture_resource(ACtxDrawing& rCtxDrawing, ACtxDrawingRes& rCtxDrawingRes, Resources &rResources, ResId const resId)
 {
     auto const& [it, success] = rCtxDrawingRes.m_resToTex.try_emplace(resId);
@@ -59,6 +103,331 @@ TexId SysRender::own_texture_resource(ACtxDrawing& rCtxDrawing, ACtxDrawingRes&
     return it->second;
 };
 
+void SysRender::save_interp_transforms(
+        ACompTransformStorage_t const&  transforms,
+        DrawTfInterp&                   rInterp,
+        ACtxTransformTRS const*         pTRS)
+{
+    std::swap(rInterp.m_prev,       rInterp.m_last);
+    std::swap(rInterp.m_hasPrev,    rInterp.m_hasLast);
+    std::swap(rInterp.m_settling,   rInterp.m_moving);
+
+    rInterp.m_hasLast.reset();
+    rInterp.m_moving.reset();
+
+    auto const save = [&rInterp] (ActiveEnt const ent, Matrix4 const& transform)
+    {
+        rInterp.m_last[ent] = transform;
+        rInterp.m_hasLast.set(ent.value);
+
+        if (rInterp.m_hasPrev.test(ent.value) && rInterp.m_prev[ent] != rInterp.m_last[ent])
+        {
+            rInterp.m_moving.set(ent.value);
+        }
+    };
+
+    // Same as local_transform, so saved transforms compare equal to what's drawn
+    if (pTRS == nullptr)
+    {
+        for (auto const& [ent, tf] : transforms.each())
+        {
+            save(ent, tf.m_transform);
+        }
+    }
+    else
+    {
+        for (std::size_t const entInt : pTRS->m_ents.ones())
+        {
+            save(ActiveEnt(entInt), pTRS->matrix(ActiveEnt(entInt)));
+        }
+    }
+}
+
+Matrix4 SysRender::interpolate_transform(Matrix4 const& a, Matrix4 const& b, float const alpha) noexcept
+{
+    Quaternion const rotA = Quaternion::fromMatrix(a.rotation());
+    Quaternion const rotB = Quaternion::fromMatrix(b.rotation());
+
+    return Matrix4::from(Magnum::Math::slerpShortestPath(rotA, rotB, alpha).toMatrix(),
+                         Magnum::Math::lerp(a.translation(), b.translation(), alpha))
+         * Matrix4::scaling(Magnum::Math::lerp(a.scaling(), b.scaling(), alpha));
+}
+
+Range3D const* SysRender::find_mesh_bounds(ACtxSceneRender const& scnRender, ACtxDrawing const& drawing, DrawEnt const drawEnt) noexcept
+{
+    if (std::size_t(drawEnt) >= scnRender.m_mesh.size())
+    {
+        return nullptr;
+    }
+
+    MeshIdOwner_t const& mesh = scnRender.m_mesh[drawEnt];
+    if (   ! mesh.has_value()
+        || std::size_t(mesh.value()) >= drawing.m_meshHasBounds.size()
+        || ! drawing.m_meshHasBounds.test(std::size_t(mesh.value())) )
+    {
+        return nullptr;
+    }
+
+    return &drawing.m_meshBounds[mesh.value()];
+}
+
+void SysRender::cull_frustum(
+        ACtxSceneRender const&                  scnRender,
+        ACtxDrawing const&                      drawing,
+        DrawEntSet_t const&                     visible,
+        ViewProjMatrix const&                   viewProj,
+        DrawEntSet_t&                           rInViewOut)
+{
+    constexpr std::size_t batchSize = 64;
+    static_assert(sizeof(bitint_t) * 8 == batchSize);
+
+    // Normalize planes so distances from them can be compared with sphere radii
+    Frustum const frustum = Frustum::fromMatrix(viewProj.m_viewProj);
+    std::array<Vector4, 6> planes;
+    for (std::size_t i = 0; i < planes.size(); ++i)
+    {
+        planes[i] = frustum[i] / frustum[i].xyz().length();
+    }
+
+#if defined(OSP_MATH_SSE)
+    std::array<__m128, 6> planeX;
+    std::array<__m128, 6> planeY;
+    std::array<__m128, 6> planeZ;
+    std::array<__m128, 6> planeW;
+    for (std::size_t i = 0; i < planes.size(); ++i)
+    {
+        planeX[i] = _mm_set1_ps(planes[i].x());
+        planeY[i] = _mm_set1_ps(planes[i].y());
+        planeZ[i] = _mm_set1_ps(planes[i].z());
+        planeW[i] = _mm_set1_ps(planes[i].w());
+    }
+#endif
+
+    std::vector<bitint_t> const& visibleInts = visible.ints();
+    std::vector<bitint_t>      & rInViewInts = rInViewOut.ints();
+    rInViewInts.assign(visibleInts.size(), 0);
+
+    std::array<float, batchSize>    centerX;
+    std::array<float, batchSize>    centerY;
+    std::array<float, batchSize>    centerZ;
+    std::array<float, batchSize>    radius;
+    std::array<float, batchSize>    minDistance;
+    std::array<uint8_t, batchSize>  bitPos;
+
+    for (std::size_t intPos = 0; intPos < visibleInts.size(); ++intPos)
+    {
+        bitint_t    bits        = visibleInts[intPos];
+        bitint_t    inView      = 0;
+        std::size_t count       = 0;
+
+        // Gather world space bounding spheres
+        while (bits != 0)
+        {
+            int const bit = std::countr_zero(bits);
+            bits &= bits - 1;
+
+            DrawEnt const drawEnt = DrawEnt(intPos * batchSize + bit);
+
+            Range3D const* pBounds = find_mesh_bounds(scnRender, drawing, drawEnt);
+            if (pBounds == nullptr)
+            {
+                inView |= bitint_t(1) << bit;
+                continue;
+            }
+
+            Range3D const& bounds   = *pBounds;
+            Matrix4 const& drawTf   = scnRender.m_drawTransform[drawEnt];
+            Vector3 const center    = drawTf.transformPoint(bounds.center());
+
+            // Largest axis scale keeps the sphere conservative for non-uniform scales
+            float const scaleSqr = std::max({drawTf[0].xyz().dot(),
+                                             drawTf[1].xyz().dot(),
+                                             drawTf[2].xyz().dot()});
+
+            centerX[count]  = center.x();
+            centerY[count]  = center.y();
+            centerZ[count]  = center.z();
+            radius[count]   = 0.5f * bounds.size().length() * std::sqrt(scaleSqr);
+            bitPos[count]   = uint8_t(bit);
+            ++ count;
+        }
+
+        // Signed distance to the nearest plane, negative if fully outside of any plane
+#if defined(OSP_MATH_SSE)
+        // Four spheres at a time. Lanes past count are zeroed and ignored afterwards
+        std::size_t const countPadded = (count + 3) & ~std::size_t(3);
+        for (std::size_t i = count; i < countPadded; ++i)
+        {
+            centerX[i] = centerY[i] = centerZ[i] = radius[i] = 0.0f;
+        }
+
+        for (std::size_t i = 0; i < countPadded; i += 4)
+        {
+            __m128 const x = _mm_loadu_ps(&centerX[i]);
+            __m128 const y = _mm_loadu_ps(&centerY[i]);
+            __m128 const z = _mm_loadu_ps(&centerZ[i]);
+            __m128 const r = _mm_loadu_ps(&radius[i]);
+
+            __m128 minDist = _mm_set1_ps(std::numeric_limits<float>::max());
+            for (std::size_t p = 0; p < planes.size(); ++p)
+            {
+                // Same order of operations as the scalar version below, for the same results
+                __m128 distance = _mm_mul_ps(planeX[p], x);
+                distance = _mm_add_ps(distance, _mm_mul_ps(planeY[p], y));
+                distance = _mm_add_ps(distance, _mm_mul_ps(planeZ[p], z));
+                distance = _mm_add_ps(distance, planeW[p]);
+                distance = _mm_add_ps(distance, r);
+                minDist  = _mm_min_ps(minDist, distance);
+            }
+            _mm_storeu_ps(&minDistance[i], minDist);
+        }
+#else
+        minDistance.fill(std::numeric_limits<float>::max());
+        for (Vector4 const& plane : planes)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                float const distance =   plane.x() * centerX[i] + plane.y() * centerY[i]
+                                       + plane.z() * centerZ[i] + plane.w() + radius[i];
+                minDistance[i] = (distance < minDistance[i]) ? distance : minDistance[i];
+            }
+        }
+#endif
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (minDistance[i] >= 0.0f)
+            {
+                inView |= bitint_t(1) << bitPos[i];
+            }
+        }
+
+        rInViewInts[intPos] = inView;
+    }
+}
+
+void SysRender::take_transform_dirty(active::ActiveEntSet_t const& tfDirty, ACtxSceneRender& rScnRender) noexcept
+{
+    std::vector<bitint_t>       &rDirtyInts = rScnRender.m_transformDirty.ints();
+    std::vector<bitint_t>       &rTakenInts = rScnRender.m_transformDirtyTaken.ints();
+    std::vector<bitint_t> const &sceneInts  = tfDirty.ints();
+
+    std::size_t const count = std::min({rDirtyInts.size(), rTakenInts.size(), sceneInts.size()});
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        rDirtyInts[i] |= sceneInts[i] & ~rTakenInts[i];
+        rTakenInts[i] |= sceneInts[i];
+    }
+}
+
+void SysRender::clear_transform_dirty(active::ActiveEntSet_t& rTfDirty, ACtxSceneRender& rScnRender) noexcept
+{
+    take_transform_dirty(rTfDirty, rScnRender);
+    rTfDirty.reset();
+    rScnRender.m_transformDirtyTaken.reset();
+}
+
+void SysRender::sort_draw_commands(DrawCommandList& rList)
+{
+    std::vector<DrawCommand> &rCommands = rList.m_commands;
+    std::vector<DrawCommand> &rBuffer   = rList.m_sortBuffer;
+
+    if (rCommands.size() < 2)
+    {
+        return;
+    }
+
+    constexpr int digitBits = 8;
+    constexpr int digits    = 64 / digitBits;
+    constexpr int buckets   = 1 << digitBits;
+
+    // Count all digits in a single read over the keys
+    std::array<std::array<uint32_t, buckets>, digits> counts{};
+    for (DrawCommand const& cmd : rCommands)
+    {
+        for (int digit = 0; digit < digits; ++digit)
+        {
+            ++ counts[digit][(cmd.key >> (digit * digitBits)) & (buckets - 1)];
+        }
+    }
+
+    rBuffer.resize(rCommands.size());
+
+    for (int digit = 0; digit < digits; ++digit)
+    {
+        int const shift = digit * digitBits;
+        std::array<uint32_t, buckets> &rOffsets = counts[digit];
+
+        // Every key has the same value for this digit, nothing to move
+        if (rOffsets[(rCommands.front().key >> shift) & (buckets - 1)] == rCommands.size())
+        {
+            continue;
+        }
+
+        uint32_t total = 0;
+        for (uint32_t &rOffset : rOffsets)
+        {
+            total += std::exchange(rOffset, total);
+        }
+
+        for (DrawCommand const& cmd : rCommands)
+        {
+            rBuffer[rOffsets[(cmd.key >> shift) & (buckets - 1)] ++] = cmd;
+        }
+
+        rCommands.swap(rBuffer);
+    }
+}
+
+DrawStateChanges SysRender::count_state_changes(ArrayView<DrawCommand const> commands) noexcept
+{
+    DrawStateChanges out;
+
+    if (commands.isEmpty())
+    {
+        return out;
+    }
+
+    DrawKey prev = DrawKey::unpack(commands[0].key);
+    out = {.draws = 1, .passes = 1, .shaders = 1, .materials = 1, .textures = 1, .meshes = 1};
+
+    for (DrawCommand const& cmd : commands.exceptPrefix(1))
+    {
+        DrawKey const key = DrawKey::unpack(cmd.key);
+
+        ++ out.draws;
+        out.passes      += (key.pass     != prev.pass);
+        out.shaders     += (key.shader   != prev.shader);
+        out.materials   += (key.material != prev.material);
+        out.textures    += (key.texture  != prev.texture);
+        out.meshes      += (key.mesh     != prev.mesh);
+
+        prev = key;
+    }
+
+    return out;
+}
+
+void SysRender::update_remap_drawing(ACtxSceneRender& rCtxScnRdr, active::ActiveEntRemap const& remap)
+{
+    id_remap_keys(remap, rCtxScnRdr.m_needDrawTf);
+    id_remap_keys(remap, rCtxScnRdr.m_transformDirty);
+    id_remap_keys(remap, rCtxScnRdr.m_transformDirtyTaken);
+    id_remap_keys(remap, rCtxScnRdr.m_activeToDraw, lgrn::id_null<DrawEnt>());
+    id_remap_keys(remap, rCtxScnRdr.drawTfObserverEnable);
+
+    DrawTfInterp &rInterp = rCtxScnRdr.m_tfInterp;
+    id_remap_keys(remap, rInterp.m_prev);
+    id_remap_keys(remap, rInterp.m_last);
+    id_remap_keys(remap, rInterp.m_hasPrev);
+    id_remap_keys(remap, rInterp.m_hasLast);
+    id_remap_keys(remap, rInterp.m_moving);
+    id_remap_keys(remap, rInterp.m_settling);
+
+    rCtxScnRdr.m_drawTfCache.m_scnGraphVersion.reset();
+    rCtxScnRdr.m_drawTfCache.m_needDrawTf = {};
+}
+
 void SysRender::clear_owners(ACtxSceneRender& rCtxScnRdr, ACtxDrawing& rCtxDrawing)
 {
     for (TexIdOwner_t &rOwner : std::exchange(rCtxScnRdr.m_diffuseTex, {}))
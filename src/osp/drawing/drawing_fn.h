@@ -24,10 +24,15 @@
  */
 #pragma once
 
+#include "draw_commands.h"
 #include "drawing.h"
 
 #include "../activescene/basic.h"
 #include "../activescene/basic_fn.h"
+#include "../core/math_mat4.h"
+
+#include <algorithm>
+#include <vector>
 
 namespace osp::draw
 {
@@ -39,8 +44,9 @@ namespace osp::draw
  * These matrices are not always stored in memory since they're slightly expensive. By default,
  * they are only saved for DrawEnts associated with an ActiveEnt in ACtxSceneRender::activeToDraw.
  *
- * Draw transforms can be calculated by SysRender::update_draw_transforms, or potentially by a
- * future system that takes physics engine interpolation or animations into account.
+ * Draw transforms can be calculated by SysRender::update_draw_transforms, optionally interpolated
+ * between scene updates (see DrawTfInterp), or potentially by a future system that takes
+ * animations into account.
  * DrawTfObservers provides a way to tap into this procedure to call custom functions for other
  * systems.
  *
@@ -95,11 +101,24 @@ struct EntityToDraw
     using ShaderDrawFnc_t = void (*)(
             DrawEnt, ViewProjMatrix const&, UserData_t) noexcept;
 
+    /**
+     * @brief A function pointer to set a Shader's uniforms that are the same for all entities
+     *
+     * Called once before consecutive entities that share the same bind function and user
+     * data are drawn, leaving draw() to set only what differs between entities. Optional.
+     *
+     * @param ViewProjMatrix    [in] View and projection matrix
+     * @param UserData_t        [in] Non-owning user data
+     */
+    using ShaderBindFnc_t = void (*)(ViewProjMatrix const&, UserData_t) noexcept;
+
     ShaderDrawFnc_t draw;
 
     // Non-owning user data passed to draw function, such as the shader
     UserData_t data;
 
+    ShaderBindFnc_t bind{nullptr};
+
 }; // struct EntityToDraw
 
 /**
@@ -135,6 +154,8 @@ public:
      * @param rResources        [ref] Application Resources containing meshes
      * @param resId             [in] Mesh Resource Id
      *
+     * New meshes get bounds from the resource's MeshData positions, if there are any.
+     *
      * @return Id of new mesh, existing mesh Id if it already exists.
      */
     static MeshId own_mesh_resource(
@@ -143,6 +164,17 @@ public:
             Resources& rResources,
             ResId resId);
 
+    /**
+     * @brief Set the bounds of a mesh in its own space, used for culling
+     */
+    static void set_mesh_bounds(ACtxDrawing& rCtxDrawing, MeshId mesh, Range3D const& bounds);
+
+    /**
+     * @return Bounds of a DrawEnt's mesh in its own space, or nullptr if it has no mesh or the
+     *         mesh has no bounds
+     */
+    [[nodiscard]] static Range3D const* find_mesh_bounds(ACtxSceneRender const& scnRender, ACtxDrawing const& drawing, DrawEnt drawEnt) noexcept;
+
     static TexId own_texture_resource(
             ACtxDrawing& rCtxDrawing,
             ACtxDrawingRes& rCtxDrawingRes,
@@ -176,6 +208,13 @@ public:
         KeyedVec<active::ActiveEnt, DrawEnt> const& activeToDraw;
         active::ActiveEntSet_t const&               needDrawTf;
         DrawTransforms_t&                           rDrawTf;
+
+        /// Previous scene update's transforms to interpolate from, or nullptr to not interpolate
+        DrawTfInterp const*                         pInterp     {nullptr};
+        float                                       interpAlpha {1.0f};
+
+        /// Read local transforms from here instead of transforms if not nullptr
+        active::ACtxTransformTRS const*             pTRS        {nullptr};
     };
 
     template<typename IT_T, typename ITB_T, typename FUNC_T = UpdDrawTransformNoOp>
@@ -185,16 +224,189 @@ public:
             ITB_T const&                last,
             FUNC_T                      func = {});
 
+    /**
+     * @brief Calculate draw transforms for the whole scene graph in a single non-recursive pass
+     *
+     * Same results as update_draw_transforms over all root children. ACtxSceneGraph::m_treeToEnt
+     * is already in depth-first order, so it's walked front to back while keeping a stack of
+     * ancestors. World transforms are written to rTreeWorldTf in the same order, so a parent's
+     * transform is always already calculated and nearby in memory.
+     *
+     * @param rTreeWorldTf  [out] World transforms by tree position. Entries for entities that
+     *                            don't need draw transforms are left unchanged.
+     */
+    template<typename FUNC_T = UpdDrawTransformNoOp>
+    static void update_draw_transforms_linear(
+            ArgsForUpdDrawTransform                     args,
+            KeyedVec<active::TreePos_t, Matrix4>&       rTreeWorldTf,
+            FUNC_T                                      func = {});
+
+    /**
+     * @brief Add a scene's modified transforms to ACtxSceneRender::m_transformDirty
+     *
+     * Called by the renderer right before updating draw transforms. Entities already added
+     * since the scene last cleared tfDirty are skipped, so they're only drawn once.
+     *
+     * @param tfDirty   [in] ACtxBasic::m_transformDirty, which is only written by the scene
+     */
+    static void take_transform_dirty(active::ActiveEntSet_t const& tfDirty, ACtxSceneRender& rScnRender) noexcept;
+
+    /**
+     * @brief Clear a scene's modified transforms, keeping ones not yet drawn for the renderer
+     *
+     * Called by the scene instead of clearing ACtxBasic::m_transformDirty directly, so changes
+     * from scene updates that were never drawn aren't lost.
+     */
+    static void clear_transform_dirty(active::ActiveEntSet_t& rTfDirty, ACtxSceneRender& rScnRender) noexcept;
+
+    /**
+     * @brief Recalculate draw transforms only for subtrees that changed since the previous call
+     *
+     * Subtrees under entities in tfDirty are recalculated the same way as
+     * update_draw_transforms_linear, starting from their parent's world transform cached in
+     * rCache. Entities moving or settling in args.pInterp are treated as dirty too. Everything is
+     * recalculated if the scene graph's structure or args.needDrawTf changed.
+     *
+     * Callers should clear tfDirty afterwards.
+     *
+     * @param tfDirty   [in] Entities with modified local transforms, such as
+     *                       ACtxSceneRender::m_transformDirty
+     * @param rCache    [ref] World transforms from the previous call
+     * @param rChanged  [out] DrawEnts given a new draw transform are appended to this
+     */
+    template<typename FUNC_T = UpdDrawTransformNoOp>
+    static void update_draw_transforms_dirty(
+            ArgsForUpdDrawTransform                     args,
+            active::ActiveEntSet_t const&               tfDirty,
+            DrawTfCache&                                rCache,
+            DrawEntVec_t&                               rChanged,
+            FUNC_T                                      func = {});
+
+    /**
+     * @brief Record the scene's current local transforms, to be interpolated from once the scene
+     *        updates again
+     *
+     * Call once after each scene update. Transforms recorded by the previous call become the
+     * 'previous' state used by update_draw_transforms.
+     *
+     * @param pTRS  [in] Read local transforms of ACtxTransformTRS::m_ents from here instead of
+     *                   transforms if not nullptr. Must match ArgsForUpdDrawTransform::pTRS.
+     */
+    static void save_interp_transforms(
+            active::ACompTransformStorage_t const&  transforms,
+            DrawTfInterp&                           rInterp,
+            active::ACtxTransformTRS const*         pTRS = nullptr);
+
+    /**
+     * @brief Interpolate between two TRS transforms
+     *
+     * Translation and scale are lerped, rotation is slerped along the shortest path.
+     *
+     * @param alpha [in] 0.0 returns a, 1.0 returns b
+     */
+    static Matrix4 interpolate_transform(Matrix4 const& a, Matrix4 const& b, float alpha) noexcept;
+
+    /**
+     * @brief Find which DrawEnts are inside a camera's view frustum
+     *
+     * Mesh bounds are turned into bounding spheres using each DrawEnt's draw transform, then
+     * tested against the frustum planes. DrawEnts are processed in batches of 64, one bit
+     * integer of visible at a time. Sphere data is gathered into separate arrays, and tested
+     * against the planes four spheres at a time if SSE is available (see OSP_MATH_SSE).
+     *
+     * DrawEnts without a mesh or without mesh bounds are always in view.
+     *
+     * @param visible       [in] DrawEnts to test, usually ACtxSceneRender::m_visible
+     * @param rInViewOut    [out] Visible DrawEnts that are in view. Resized to match visible.
+     */
+    static void cull_frustum(
+            ACtxSceneRender const&                  scnRender,
+            ACtxDrawing const&                      drawing,
+            DrawEntSet_t const&                     visible,
+            ViewProjMatrix const&                   viewProj,
+            DrawEntSet_t&                           rInViewOut);
+
+    /**
+     * @brief Add a draw command for each visible entity in a RenderGroup
+     *
+     * @param makeKey   [in] Returns a DrawKey for each entity, called as
+     *                       makeKey(DrawEnt, EntityToDraw const&)
+     */
+    template<typename FUNC_T>
+    static void build_draw_commands(
+            RenderGroup const&                      group,
+            DrawEntSet_t const&                     visible,
+            DrawCommandList&                        rList,
+            FUNC_T&&                                makeKey);
+
+    /**
+     * @brief Sort draw commands by key
+     *
+     * LSD radix sort, one byte per pass. Bytes that are the same for every key (eg. only one
+     * pass or shader in use) are skipped. Commands with equal keys keep their order.
+     */
+    static void sort_draw_commands(DrawCommandList& rList);
+
+    /**
+     * @brief Count how often draw state changes between consecutive commands
+     *
+     * Headless stand-in for a renderer, for checking how well a list of commands is sorted.
+     */
+    [[nodiscard]] static DrawStateChanges count_state_changes(ArrayView<DrawCommand const> commands) noexcept;
+
     template<typename IT_T>
     static void update_delete_drawing(
             ACtxSceneRender& rCtxScnRdr, ACtxDrawing& rCtxDrawing, IT_T const& first, IT_T const& last);
 
+    /**
+     * @brief Move per-ActiveEnt data to new IDs after active::compact_active_ents
+     *
+     * DrawEnts are unaffected. Cached world transforms are recalculated on the next update.
+     */
+    static void update_remap_drawing(ACtxSceneRender& rCtxScnRdr, active::ActiveEntRemap const& remap);
+
     static MeshIdOwner_t add_drawable_mesh(ACtxDrawing& rDrawing, ACtxDrawingRes& rDrawingRes, Resources& rResources, PkgId const pkg, std::string_view const name);
 
     static constexpr decltype(auto) gen_drawable_mesh_adder(ACtxDrawing& rDrawing, ACtxDrawingRes& rDrawingRes, Resources& rResources, PkgId const pkg);
 
 private:
 
+    /**
+     * @return Local transform of an entity, from either args.transforms or args.pTRS. rTemp is
+     *         used to hold composed TRS matrices.
+     */
+    static Matrix4 const& local_transform(ArgsForUpdDrawTransform const& args, active::ActiveEnt const ent, Matrix4 &rTemp) noexcept
+    {
+        if (args.pTRS == nullptr)
+        {
+            return args.transforms.get(ent).m_transform;
+        }
+        rTemp = args.pTRS->matrix(ent);
+        return rTemp;
+    }
+
+    /**
+     * @brief Calculate draw transforms of a range of the scene graph array
+     *
+     * @param first     [in] Tree position of a subtree root, or 1 for the whole tree
+     * @param last      [in] One past the last tree position to calculate
+     * @param pParentTf [in] World transform of first's parent, or nullptr if it's the scene root
+     * @param depth     [in] Depth of first, 1 for root children
+     * @param pChanged  [out] Optional, DrawEnts given a new draw transform are appended to this
+     * @param rAncestors [ref] Scratch space, cleared before use
+     */
+    template<typename FUNC_T>
+    static void update_draw_transforms_range(
+            ArgsForUpdDrawTransform                 args,
+            KeyedVec<active::TreePos_t, Matrix4>&   rTreeWorldTf,
+            active::TreePos_t                       first,
+            active::TreePos_t                       last,
+            Matrix4 const*                          pParentTf,
+            int                                     depth,
+            DrawEntVec_t*                           pChanged,
+            std::vector<DrawTfAncestor>&            rAncestors,
+            FUNC_T&                                 func);
+
     template<typename FUNC_T>
     static void update_draw_transforms_recurse(
             ArgsForUpdDrawTransform     args,
@@ -243,6 +455,181 @@ void SysRender::update_draw_transforms(
     }
 }
 
+template<typename FUNC_T>
+void SysRender::update_draw_transforms_linear(
+        ArgsForUpdDrawTransform                 args,
+        KeyedVec<active::TreePos_t, Matrix4>&   rTreeWorldTf,
+        FUNC_T                                  func)
+{
+    active::TreePos_t const treeLast = 1 + args.scnGraph.m_treeDescendants[0];
+
+    rTreeWorldTf.resize(treeLast);
+
+    std::vector<DrawTfAncestor> ancestors;
+    ancestors.reserve(16);
+
+    update_draw_transforms_range(args, rTreeWorldTf, 1, treeLast, nullptr, 1, nullptr, ancestors, func);
+}
+
+template<typename FUNC_T>
+void SysRender::update_draw_transforms_dirty(
+        ArgsForUpdDrawTransform                 args,
+        active::ActiveEntSet_t const&           tfDirty,
+        DrawTfCache&                            rCache,
+        DrawEntVec_t&                           rChanged,
+        FUNC_T                                  func)
+{
+    using namespace osp::active;
+
+    ACtxSceneGraph const&   scnGraph = args.scnGraph;
+    TreePos_t const         treeLast = 1 + scnGraph.m_treeDescendants[0];
+
+    if (   rCache.m_scnGraphVersion != scnGraph.m_version
+        || rCache.m_needDrawTf.ints() != args.needDrawTf.ints() )
+    {
+        // Tree positions moved or different entities are drawn; nothing cached can be reused
+        rCache.m_treeWorldTf.resize(treeLast);
+        update_draw_transforms_range(args, rCache.m_treeWorldTf, 1, treeLast, nullptr, 1, &rChanged, rCache.m_ancestors, func);
+
+        rCache.m_scnGraphVersion = scnGraph.m_version;
+        rCache.m_needDrawTf      = args.needDrawTf;
+        return;
+    }
+
+    std::vector<TreePos_t> &rDirtyPos = rCache.m_dirtyPos;
+    rDirtyPos.clear();
+
+    auto const add_dirty = [&args, &scnGraph, &rDirtyPos] (ActiveEntSet_t const& ents)
+    {
+        for (std::size_t const entInt : ents.ones())
+        {
+            if (entInt < args.needDrawTf.size() && args.needDrawTf.test(entInt))
+            {
+                TreePos_t const pos = scnGraph.m_entToTreePos[ActiveEnt(entInt)];
+                if (pos != lgrn::id_null<TreePos_t>())
+                {
+                    rDirtyPos.push_back(pos);
+                }
+            }
+        }
+    };
+
+    add_dirty(tfDirty);
+    if (args.pInterp != nullptr)
+    {
+        add_dirty(args.pInterp->m_moving);
+        add_dirty(args.pInterp->m_settling);
+    }
+
+    std::sort(rDirtyPos.begin(), rDirtyPos.end());
+
+    TreePos_t doneLast = 0;
+    for (TreePos_t const pos : rDirtyPos)
+    {
+        if (pos < doneLast)
+        {
+            continue; // Already recalculated as part of a dirty ancestor's subtree
+        }
+
+        ActiveEnt const ent     = scnGraph.m_treeToEnt[pos];
+        ActiveEnt const parent  = scnGraph.m_entParent[ent];
+
+        int depth = 1;
+        for (ActiveEnt ancestor = parent;
+             ancestor != lgrn::id_null<ActiveEnt>();
+             ancestor = scnGraph.m_entParent[ancestor])
+        {
+            ++ depth;
+        }
+
+        // Parent is clean, so its world transform from previous calls is still correct
+        Matrix4 const* pParentTf = (parent == lgrn::id_null<ActiveEnt>())
+                                 ? nullptr
+                                 : &rCache.m_treeWorldTf[scnGraph.m_entToTreePos[parent]];
+
+        doneLast = pos + 1 + scnGraph.m_treeDescendants[pos];
+
+        update_draw_transforms_range(args, rCache.m_treeWorldTf, pos, doneLast, pParentTf, depth, &rChanged, rCache.m_ancestors, func);
+    }
+}
+
+template<typename FUNC_T>
+void SysRender::update_draw_transforms_range(
+        ArgsForUpdDrawTransform                 args,
+        KeyedVec<active::TreePos_t, Matrix4>&   rTreeWorldTf,
+        active::TreePos_t const                 first,
+        active::TreePos_t const                 last,
+        Matrix4 const* const                    pParentTf,
+        int const                               depth,
+        DrawEntVec_t* const                     pChanged,
+        std::vector<DrawTfAncestor>&            rAncestors,
+        FUNC_T&                                 func)
+{
+    using namespace osp::active;
+
+    ACtxSceneGraph const& scnGraph = args.scnGraph;
+
+    rAncestors.clear();
+
+    Matrix4 entTfTRS;
+
+    TreePos_t pos = first;
+    while (pos != last)
+    {
+        ActiveEnt const ent         = scnGraph.m_treeToEnt[pos];
+        uint32_t const  descendants = scnGraph.m_treeDescendants[pos];
+
+        while ( ! rAncestors.empty() && rAncestors.back().subtreeLast <= pos )
+        {
+            rAncestors.pop_back();
+        }
+
+        if ( ! args.needDrawTf.test(ent.value) )
+        {
+            pos += 1 + descendants; // Skip entire subtree
+            continue;
+        }
+
+        Matrix4 const& entTfCurr    = local_transform(args, ent, entTfTRS);
+        Matrix4 const& entTf        = (   args.pInterp != nullptr
+                                       && args.interpAlpha < 1.0f
+                                       && args.pInterp->m_hasPrev.test(ent.value)
+                                       && args.pInterp->m_prev[ent] != entTfCurr)
+                                    ? interpolate_transform(args.pInterp->m_prev[ent], entTfCurr, args.interpAlpha)
+                                    : entTfCurr;
+        Matrix4 &rEntDrawTf         = rTreeWorldTf[pos];
+        Matrix4 const* pEntParentTf = rAncestors.empty() ? pParentTf : &rTreeWorldTf[rAncestors.back().pos];
+
+        if (pEntParentTf == nullptr)
+        {
+            rEntDrawTf = entTf;
+        }
+        else
+        {
+            math::mul_mat4(*pEntParentTf, entTf, rEntDrawTf);
+        }
+
+        func(rEntDrawTf, ent, int(rAncestors.size()) + depth);
+
+        DrawEnt const drawEnt = args.activeToDraw[ent];
+        if (drawEnt != lgrn::id_null<DrawEnt>())
+        {
+            args.rDrawTf[drawEnt] = rEntDrawTf;
+            if (pChanged != nullptr)
+            {
+                pChanged->push_back(drawEnt);
+            }
+        }
+
+        if (descendants != 0)
+        {
+            rAncestors.push_back({pos, pos + 1 + descendants});
+        }
+
+        ++ pos;
+    }
+}
+
 template<typename FUNC_T>
 void SysRender::update_draw_transforms_recurse(
         ArgsForUpdDrawTransform     args,
@@ -253,7 +640,13 @@ void SysRender::update_draw_transforms_recurse(
 {
     using namespace osp::active;
 
-    Matrix4 const& entTf        = args.transforms.get(ent).m_transform;
+    Matrix4 entTfTRS;
+    Matrix4 const& entTfCurr    = local_transform(args, ent, entTfTRS);
+    Matrix4 const& entTf        = (   args.pInterp != nullptr
+                                   && args.pInterp->m_hasPrev.test(ent.value)
+                                   && args.pInterp->m_prev[ent] != entTfCurr)
+                                ? interpolate_transform(args.pInterp->m_prev[ent], entTfCurr, args.interpAlpha)
+                                : entTfCurr;
     Matrix4 const& entDrawTf    = (depth == 0) ? (entTf) : (parentTf * entTf);
 
     func(entDrawTf, ent, depth);
@@ -298,6 +691,25 @@ void SysRender::update_delete_drawing(
     }
 }
 
+template<typename FUNC_T>
+void SysRender::build_draw_commands(
+        RenderGroup const&                      group,
+        DrawEntSet_t const&                     visible,
+        DrawCommandList&                        rList,
+        FUNC_T&&                                makeKey)
+{
+    rList.m_commands.reserve(rList.m_commands.size() + group.entities.size());
+
+    for (auto const& [drawEnt, toDraw] : entt::basic_view{group.entities}.each())
+    {
+        if (visible.test(std::size_t(drawEnt)))
+        {
+            DrawKey const key = makeKey(drawEnt, toDraw);
+            rList.m_commands.push_back({key.pack(), drawEnt});
+        }
+    }
+}
+
 constexpr decltype(auto) SysRender::gen_drawable_mesh_adder(ACtxDrawing& rDrawing, ACtxDrawingRes& rDrawingRes, Resources& rResources, PkgId const pkg)
 {
     return [&rDrawing, &rDrawingRes, &rResources, pkg] (std::string_view const name) -> MeshIdOwner_t
@@ -47,6 +47,9 @@
 #include <Magnum/Mesh.h>
 #include <Magnum/MeshTools/Compile.h>
 
+#include <algorithm>
+#include <utility>
+
 using Magnum::Trade::MeshData;
 using Magnum::Trade::TextureData;
 using Magnum::Trade::ImageData2D;
@@ -342,10 +345,7 @@ void SysRenderGL::clear_resource_owners(RenderGL& rRenderGl, Resources& rResourc
     rRenderGl.m_resToMesh.clear();
 }
 
-void SysRenderGL::render_opaque(
-        RenderGroup const& group,
-        DrawEntSet_t const& visible,
-        ViewProjMatrix const& viewProj)
+static void set_state_opaque()
 {
     using Magnum::GL::Renderer;
 
@@ -353,14 +353,9 @@ void SysRenderGL::render_opaque(
     Renderer::enable(Renderer::Feature::FaceCulling);
     Renderer::disable(Renderer::Feature::Blending);
     Renderer::setDepthMask(GL_TRUE);
-
-    draw_group(group, visible, viewProj);
 }
 
-void SysRenderGL::render_transparent(
-        RenderGroup const& group,
-        DrawEntSet_t const& visible,
-        ViewProjMatrix const& viewProj)
+static void set_state_transparent()
 {
     using Magnum::GL::Renderer;
 
@@ -374,20 +369,163 @@ void SysRenderGL::render_transparent(
     // temporary: disabled depth writing makes the plumes look nice, but
     //            can mess up other transparent objects once added
     //Renderer::setDepthMask(GL_FALSE);
+}
 
+/**
+ * @brief Call an EntityToDraw's bind function if the last entity drawn used a different one
+ */
+static void bind_if_changed(
+        EntityToDraw const&     toDraw,
+        EntityToDraw const*&    rpLastBound,
+        ViewProjMatrix const&   viewProj)
+{
+    bool const changed =    rpLastBound == nullptr
+                         || rpLastBound->bind != toDraw.bind
+                         || rpLastBound->data != toDraw.data;
+    if (changed)
+    {
+        if (toDraw.bind != nullptr)
+        {
+            toDraw.bind(viewProj, toDraw.data);
+        }
+        rpLastBound = &toDraw;
+    }
+}
+
+void SysRenderGL::render_opaque(
+        RenderGroup const& group,
+        DrawEntSet_t const& visible,
+        ViewProjMatrix const& viewProj)
+{
+    set_state_opaque();
     draw_group(group, visible, viewProj);
 }
 
+void SysRenderGL::render_transparent(
+        RenderGroup const& group,
+        DrawEntSet_t const& visible,
+        ViewProjMatrix const& viewProj)
+{
+    set_state_transparent();
+    draw_group(group, visible, viewProj);
+}
+
+void SysRenderGL::render_opaque(
+        RenderGroup const& group,
+        ArrayView<DrawCommand const> commands,
+        ViewProjMatrix const& viewProj)
+{
+    set_state_opaque();
+    draw_commands(group, commands, viewProj);
+}
+
+void SysRenderGL::render_transparent(
+        RenderGroup const& group,
+        ArrayView<DrawCommand const> commands,
+        ViewProjMatrix const& viewProj)
+{
+    set_state_transparent();
+    draw_commands(group, commands, viewProj);
+}
+
 void SysRenderGL::draw_group(
         RenderGroup const& group,
         DrawEntSet_t const& visible,
         ViewProjMatrix const& viewProj)
 {
+    EntityToDraw const *pLastBound = nullptr;
+
     for (auto const& [ent, toDraw] : entt::basic_view{group.entities}.each())
     {
         if (visible.test(std::size_t(ent)))
         {
+            bind_if_changed(toDraw, pLastBound, viewProj);
             toDraw.draw(ent, viewProj, toDraw.data);
         }
     }
 }
+
+void SysRenderGL::build_draw_commands(
+        RenderGroup const&          group,
+        DrawEntSet_t const&         visible,
+        ACtxSceneRender const&      scnRender,
+        ACtxSceneRenderGL const&    scnRenderGl,
+        ViewProjMatrix const&       viewProj,
+        uint32_t const              pass,
+        bool const                  transparent,
+        float const                 maxDepth,
+        DrawCommandList&            rList)
+{
+    using ShaderKey_t = std::pair<EntityToDraw::ShaderDrawFnc_t, void const*>;
+
+    // Few shaders are used at once, so a linear search is fine
+    std::vector<ShaderKey_t> shaders;
+    auto const shader_of = [&shaders] (ShaderKey_t const& value) -> uint32_t
+    {
+        auto const it = std::find(shaders.begin(), shaders.end(), value);
+        if (it != shaders.end())
+        {
+            return uint32_t(std::distance(shaders.begin(), it));
+        }
+        shaders.push_back(value);
+        return uint32_t(shaders.size() - 1);
+    };
+
+    // First material each DrawEnt belongs to, 0 for none, others start from 1
+    std::vector<uint32_t> entMaterial(scnRender.m_drawIds.capacity(), 0);
+    for (uint32_t const matInt : scnRender.m_materialIds.bitview().zeros())
+    {
+        for (std::size_t const drawEntInt : scnRender.m_materials[MaterialId(matInt)].m_ents.ones())
+        {
+            if (drawEntInt < entMaterial.size() && entMaterial[drawEntInt] == 0)
+            {
+                entMaterial[drawEntInt] = matInt + 1;
+            }
+        }
+    }
+
+    // Null GL IDs become 0, others start from 1
+    auto const gl_id_key = [] <typename ID_T> (ID_T const id) -> uint32_t
+    {
+        return (id == lgrn::id_null<ID_T>()) ? 0 : uint32_t(id) + 1;
+    };
+
+    SysRender::build_draw_commands(group, visible, rList,
+            [&] (DrawEnt const drawEnt, EntityToDraw const& toDraw) -> DrawKey
+    {
+        Vector3 const viewPos = viewProj.m_view.transformPoint(scnRender.m_drawTransform[drawEnt].translation());
+
+        DrawKey key;
+        key.pass        = pass;
+        key.transparent = transparent;
+        key.shader      = shader_of({toDraw.draw, toDraw.data[1]});
+        key.material    = entMaterial[std::size_t(drawEnt)];
+        key.depth       = DrawKey::quantize_depth(-viewPos.z(), maxDepth, transparent);
+
+        if (std::size_t(drawEnt) < scnRenderGl.m_diffuseTexId.size())
+        {
+            key.texture = gl_id_key(scnRenderGl.m_diffuseTexId[drawEnt].m_glId);
+        }
+        if (std::size_t(drawEnt) < scnRenderGl.m_meshId.size())
+        {
+            key.mesh    = gl_id_key(scnRenderGl.m_meshId[drawEnt].m_glId);
+        }
+
+        return key;
+    });
+}
+
+void SysRenderGL::draw_commands(
+        RenderGroup const& group,
+        ArrayView<DrawCommand const> commands,
+        ViewProjMatrix const& viewProj)
+{
+    EntityToDraw const *pLastBound = nullptr;
+
+    for (DrawCommand const& cmd : commands)
+    {
+        EntityToDraw const& toDraw = group.entities.get(cmd.ent);
+        bind_if_changed(toDraw, pLastBound, viewProj);
+        toDraw.draw(cmd.ent, viewProj, toDraw.data);
+    }
+}
@@ -104,6 +104,9 @@ struct ACtxSceneRenderGL
 {
     MeshGlEntStorage_t      m_meshId;
     TexGlEntStorage_t       m_diffuseTexId;
+
+    // Sorted draws for the forward render group, rebuilt each frame
+    DrawCommandList         m_fwdCommands;
 };
 
 /**
@@ -251,6 +254,60 @@ public:
             DrawEntSet_t const& visible,
             ViewProjMatrix const& viewProj);
 
+    /**
+     * @brief Add draw commands for visible entities of a RenderGroup, keyed by the GL state
+     *        they use
+     *
+     * Shaders are told apart by draw function and the second element of EntityToDraw::data,
+     * matching how adera shaders fill in EntityToDraw, and are numbered in the order they're
+     * first seen. The material is the first of ACtxSceneRender::m_materials the entity is in.
+     *
+     * @param pass          [in] Pass number, passes are drawn in increasing order
+     * @param transparent   [in] Sort by depth farthest first, before any other state. See DrawKey
+     * @param maxDepth      [in] View distance mapped to the largest depth value
+     * @param rList         [out] Commands are added to DrawCommandList::m_commands
+     */
+    static void build_draw_commands(
+            RenderGroup const&          group,
+            DrawEntSet_t const&         visible,
+            ACtxSceneRender const&      scnRender,
+            ACtxSceneRenderGL const&    scnRenderGl,
+            ViewProjMatrix const&       viewProj,
+            uint32_t                    pass,
+            bool                        transparent,
+            float                       maxDepth,
+            DrawCommandList&            rList);
+
+    /**
+     * @copybrief render_opaque
+     *
+     * Entities are drawn in the order of commands, usually sorted by
+     * SysRender::sort_draw_commands. EntityToDraw::bind is only called when it or the user
+     * data differs from the previous command, so per-shader uniforms are set once per run of
+     * entities sharing a shader. Consecutive draws that share a texture or mesh skip binding
+     * it again, as GL state already bound is tracked by Magnum.
+     */
+    static void render_opaque(
+            RenderGroup const& group,
+            ArrayView<DrawCommand const> commands,
+            ViewProjMatrix const& viewProj);
+
+    /**
+     * @copybrief render_transparent
+     *
+     * Entities are drawn in the order of commands, see render_opaque. Commands built with
+     * build_draw_commands as transparent and sorted are drawn back-to-front.
+     */
+    static void render_transparent(
+            RenderGroup const& group,
+            ArrayView<DrawCommand const> commands,
+            ViewProjMatrix const& viewProj);
+
+    static void draw_commands(
+            RenderGroup const& group,
+            ArrayView<DrawCommand const> commands,
+            ViewProjMatrix const& viewProj);
+
 };
 
 } // namespace osp::draw
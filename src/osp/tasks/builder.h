@@ -60,6 +60,10 @@ struct TaskBuilderBase
 
         std::size_t const capacity = m_rTasks.m_taskIds.capacity();
 
+        // IDs of removed tasks are reused, don't keep their priority
+        m_rTasks.m_taskPriority.resize(capacity, 0);
+        m_rTasks.m_taskPriority[taskId] = 0;
+
         return task(taskId);
     };
 
@@ -138,6 +142,21 @@ struct TaskBuilderBase
         return out;
     }
 
+    /**
+     * @brief Create a semaphore that limits how many units can be acquired by running tasks
+     *
+     * @param limit [in] Total units available, see TaskRefBase::acquire
+     */
+    SemaphoreId create_semaphore(unsigned int const limit)
+    {
+        SemaphoreId const sema = m_rTasks.m_semaIds.create();
+
+        m_rTasks.m_semaLimits.resize(m_rTasks.m_semaIds.capacity(), 0);
+        m_rTasks.m_semaLimits[sema] = limit;
+
+        return sema;
+    }
+
     Tasks       & m_rTasks;
     TaskEdges   & m_rEdges;
 
@@ -186,6 +205,17 @@ struct TaskRefBase
         return run_on(tpl);
     }
 
+    /**
+     * @brief Run before other ready tasks with lower priorities, default is 0
+     *
+     * Only affects which task is taken first when several are ready at once; see exec_pop_ready.
+     */
+    TaskRef_t& priority(int16_t const value) noexcept
+    {
+        m_rBuilder.m_rTasks.m_taskPriority[m_taskId] = value;
+        return static_cast<TaskRef_t&>(*this);
+    }
+
     TaskRef_t& sync_with(ArrayView<TplPipelineStage const> const specs) noexcept
     {
         return add_edges(m_rBuilder.m_rEdges.m_syncWith, specs);
@@ -196,6 +226,22 @@ struct TaskRefBase
         return add_edges(m_rBuilder.m_rEdges.m_syncWith, specs);
     }
 
+    /**
+     * @brief Acquire units of a semaphore while the task runs
+     *
+     * The task is kept blocked until all of its semaphores have enough units available, even if
+     * its stage requirements are satisfied. Units are released once the task completes.
+     */
+    TaskRef_t& acquire(SemaphoreId const semaphore, unsigned int const units = 1)
+    {
+        m_rBuilder.m_rEdges.m_semaphoreEdges.push_back({
+            .task      = m_taskId,
+            .semaphore = semaphore,
+            .units     = units
+        });
+        return static_cast<TaskRef_t&>(*this);
+    }
+
     TaskId          m_taskId;
     Builder_t       & m_rBuilder;
 
@@ -0,0 +1,180 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "exec_log.h"
+
+#include <algorithm>
+#include <bit>
+#include <type_traits>
+
+namespace osp
+{
+
+template <typename VARIANT_T, typename T, std::size_t I = 0>
+static constexpr std::size_t variant_index() noexcept
+{
+    if constexpr (std::is_same_v<std::variant_alternative_t<I, VARIANT_T>, T>)
+    {
+        return I;
+    }
+    else
+    {
+        return variant_index<VARIANT_T, T, I + 1>();
+    }
+}
+
+template <typename VARIANT_T, typename T>
+static constexpr std::size_t variant_index_v = variant_index<VARIANT_T, T>();
+
+static_assert(std::variant_size_v<ExecLog::LogMsg_t> <= 256, "ExecLogRecord::type is 8 bits");
+
+void exec_log_ring_alloc(ExecLogRing &rRing, uint32_t const capacity)
+{
+    LGRN_ASSERTMV(capacity != 0 && capacity <= (1u << 31), "Invalid ExecLog capacity", capacity);
+
+    rRing.capacity = std::bit_ceil(capacity);
+    rRing.mask     = rRing.capacity - 1;
+    rRing.records  = std::make_unique<ExecLogRecord[]>(rRing.capacity);
+    rRing.writePos.store(0, std::memory_order_relaxed);
+    rRing.readPos .store(0, std::memory_order_relaxed);
+    rRing.dropped .store(0, std::memory_order_relaxed);
+}
+
+std::size_t exec_log_ring_drain(ExecLogRing &rRing, std::vector<ExecLogRecord> &rOut)
+{
+    uint64_t const read  = rRing.readPos .load(std::memory_order_relaxed);
+    uint64_t const write = rRing.writePos.load(std::memory_order_acquire);
+    auto const     count = std::size_t(write - read);
+
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    // Copy in up to two contiguous runs, as the records may wrap around the end of the ring
+    std::size_t const first     = std::size_t(read & rRing.mask);
+    std::size_t const firstRun  = std::min<std::size_t>(count, rRing.capacity - first);
+
+    rOut.insert(rOut.end(), &rRing.records[first], &rRing.records[first] + firstRun);
+    rOut.insert(rOut.end(), &rRing.records[0],     &rRing.records[0] + (count - firstRun));
+
+    rRing.readPos.store(write, std::memory_order_release);
+
+    return count;
+}
+
+ExecLogRecord exec_log_encode(ExecLog::LogMsg_t const& msg) noexcept
+{
+    ExecLogRecord out{};
+    out.type = uint8_t(msg.index());
+
+    std::visit([&out] (auto const& msg)
+    {
+        using MSG_T = std::decay_t<decltype(msg)>;
+
+        if constexpr (std::is_same_v<MSG_T, ExecLog::PipelineRun>
+                   || std::is_same_v<MSG_T, ExecLog::PipelineFinish>
+                   || std::is_same_v<MSG_T, ExecLog::PipelineLoop>
+                   || std::is_same_v<MSG_T, ExecLog::PipelineLoopFinish>
+                   || std::is_same_v<MSG_T, ExecLog::ExternalRunRequest>)
+        {
+            out.pipeline    = PipelineInt(msg.pipeline);
+        }
+        else if constexpr (std::is_same_v<MSG_T, ExecLog::PipelineCancel>)
+        {
+            out.pipeline    = PipelineInt(msg.pipeline);
+            out.stageA      = StageInt(msg.stage);
+        }
+        else if constexpr (std::is_same_v<MSG_T, ExecLog::StageChange>)
+        {
+            out.pipeline    = PipelineInt(msg.pipeline);
+            out.stageA      = StageInt(msg.stageOld);
+            out.stageB      = StageInt(msg.stageNew);
+        }
+        else if constexpr (std::is_same_v<MSG_T, ExecLog::EnqueueTask>)
+        {
+            out.pipeline    = PipelineInt(msg.pipeline);
+            out.stageA      = StageInt(msg.stage);
+            out.task        = TaskInt(msg.task);
+            out.flag        = msg.blocked;
+        }
+        else if constexpr (std::is_same_v<MSG_T, ExecLog::EnqueueTaskReq>)
+        {
+            out.pipeline    = PipelineInt(msg.pipeline);
+            out.stageA      = StageInt(msg.stage);
+            out.flag        = msg.satisfied;
+        }
+        else if constexpr (std::is_same_v<MSG_T, ExecLog::UnblockTask>)
+        {
+            out.task        = TaskInt(msg.task);
+        }
+        else if constexpr (std::is_same_v<MSG_T, ExecLog::CompleteTask>)
+        {
+            out.task        = TaskInt(msg.task);
+            out.flag        = uint8_t(TaskActions::UnderlyingType(msg.actions));
+        }
+        else if constexpr (std::is_same_v<MSG_T, ExecLog::ExternalSignal>)
+        {
+            out.pipeline    = PipelineInt(msg.pipeline);
+            out.flag        = msg.ignored;
+        }
+    }, msg);
+
+    return out;
+}
+
+ExecLog::LogMsg_t exec_log_decode(ExecLogRecord const& record) noexcept
+{
+    auto const pipeline = PipelineId(record.pipeline);
+    auto const task     = TaskId(record.task);
+    auto const stageA   = StageId(record.stageA);
+    auto const stageB   = StageId(record.stageB);
+    bool const flag     = record.flag != 0;
+
+    using Msg_t = ExecLog::LogMsg_t;
+
+    switch (record.type)
+    {
+    case variant_index_v<Msg_t, ExecLog::UpdateStart>:          return ExecLog::UpdateStart{};
+    case variant_index_v<Msg_t, ExecLog::UpdateCycle>:          return ExecLog::UpdateCycle{};
+    case variant_index_v<Msg_t, ExecLog::UpdateEnd>:            return ExecLog::UpdateEnd{};
+    case variant_index_v<Msg_t, ExecLog::PipelineRun>:          return ExecLog::PipelineRun{pipeline};
+    case variant_index_v<Msg_t, ExecLog::PipelineFinish>:       return ExecLog::PipelineFinish{pipeline};
+    case variant_index_v<Msg_t, ExecLog::PipelineCancel>:       return ExecLog::PipelineCancel{pipeline, stageA};
+    case variant_index_v<Msg_t, ExecLog::PipelineLoop>:         return ExecLog::PipelineLoop{pipeline};
+    case variant_index_v<Msg_t, ExecLog::PipelineLoopFinish>:   return ExecLog::PipelineLoopFinish{pipeline};
+    case variant_index_v<Msg_t, ExecLog::StageChange>:          return ExecLog::StageChange{pipeline, stageA, stageB};
+    case variant_index_v<Msg_t, ExecLog::EnqueueTask>:          return ExecLog::EnqueueTask{pipeline, stageA, task, flag};
+    case variant_index_v<Msg_t, ExecLog::EnqueueTaskReq>:       return ExecLog::EnqueueTaskReq{pipeline, stageA, flag};
+    case variant_index_v<Msg_t, ExecLog::UnblockTask>:          return ExecLog::UnblockTask{task};
+    case variant_index_v<Msg_t, ExecLog::CompleteTask>:         return ExecLog::CompleteTask{task, TaskActions{TaskAction(record.flag)}};
+    case variant_index_v<Msg_t, ExecLog::ExternalRunRequest>:   return ExecLog::ExternalRunRequest{pipeline};
+    case variant_index_v<Msg_t, ExecLog::ExternalSignal>:       return ExecLog::ExternalSignal{pipeline, flag};
+    default:
+        LGRN_ASSERTMV(false, "Invalid ExecLogRecord type", record.type);
+        return ExecLog::UpdateStart{};
+    }
+}
+
+} // namespace osp
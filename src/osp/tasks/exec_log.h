@@ -0,0 +1,213 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "tasks.h"
+#include "worker.h"
+
+#include "../core/array_view.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <variant>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief ExecLog message packed into a fixed-size plain-old-data record
+ *
+ * Which fields are used depends on the message type. See exec_log_encode and exec_log_decode.
+ */
+struct ExecLogRecord
+{
+    uint8_t         type;       ///< Index of the message type in ExecLog::LogMsg_t
+    StageInt        stageA;
+    StageInt        stageB;
+    uint8_t         flag;
+    PipelineInt     pipeline;
+    TaskInt         task;
+};
+
+static_assert(sizeof(ExecLogRecord) == 12);
+
+/**
+ * @brief Fixed-capacity lock-free ring buffer of ExecLogRecords
+ *
+ * Single-producer single-consumer. Only the thread that owns the ExecContext (the one calling
+ * exec_update, complete_task, etc...) may push, and only one other thread at a time may drain.
+ * New records are dropped if the ring is full, and counted in 'dropped'. Nothing is allocated
+ * after exec_log_ring_alloc.
+ */
+struct ExecLogRing
+{
+    std::unique_ptr<ExecLogRecord[]>    records;
+    uint32_t                            capacity    {0}; ///< Power of two
+    uint32_t                            mask        {0};
+
+    alignas(64) std::atomic<uint64_t>   writePos    {0};
+    alignas(64) std::atomic<uint64_t>   readPos     {0};
+    std::atomic<uint64_t>               dropped     {0};
+};
+
+constexpr uint32_t gc_execLogDefaultCapacity = 1u << 14;
+
+/**
+ * @brief Allocate space for records, discarding any already in the ring
+ *
+ * @param capacity [in] Rounded up to a power of two
+ */
+void exec_log_ring_alloc(ExecLogRing &rRing, uint32_t capacity);
+
+inline bool exec_log_ring_push(ExecLogRing &rRing, ExecLogRecord const& record) noexcept
+{
+    uint64_t const write = rRing.writePos.load(std::memory_order_relaxed);
+    uint64_t const read  = rRing.readPos .load(std::memory_order_acquire);
+
+    if (write - read >= rRing.capacity)
+    {
+        rRing.dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    rRing.records[write & rRing.mask] = record;
+    rRing.writePos.store(write + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Move all records currently in the ring to the end of rOut
+ *
+ * @return Number of records added to rOut
+ */
+std::size_t exec_log_ring_drain(ExecLogRing &rRing, std::vector<ExecLogRecord> &rOut);
+
+/**
+ * @brief Log of ExecContext state changes, stored as packed records in a ring buffer
+ */
+struct ExecLog
+{
+    struct UpdateStart { };
+    struct UpdateCycle { };
+    struct UpdateEnd { };
+
+    struct PipelineRun
+    {
+        PipelineId  pipeline;
+    };
+
+    struct PipelineFinish
+    {
+        PipelineId  pipeline;
+    };
+
+    struct PipelineCancel
+    {
+        PipelineId  pipeline;
+        StageId     stage;
+    };
+
+    struct PipelineLoop
+    {
+        PipelineId  pipeline;
+    };
+
+    struct PipelineLoopFinish
+    {
+        PipelineId  pipeline;
+    };
+
+    struct StageChange
+    {
+        PipelineId  pipeline;
+        StageId     stageOld;
+        StageId     stageNew;
+    };
+
+    struct EnqueueTask
+    {
+        PipelineId  pipeline;
+        StageId     stage;
+        TaskId      task;
+        bool        blocked;
+    };
+
+    struct EnqueueTaskReq
+    {
+        PipelineId  pipeline;
+        StageId     stage;
+        bool        satisfied;
+    };
+
+    struct UnblockTask
+    {
+        TaskId      task;
+    };
+
+    struct CompleteTask
+    {
+        TaskId      task;
+        TaskActions actions;
+    };
+
+    struct ExternalRunRequest
+    {
+        PipelineId  pipeline;
+    };
+
+    struct ExternalSignal
+    {
+        PipelineId  pipeline;
+        bool        ignored;
+    };
+
+    using LogMsg_t = std::variant<
+            UpdateStart,
+            UpdateCycle,
+            UpdateEnd,
+            PipelineRun,
+            PipelineFinish,
+            PipelineCancel,
+            PipelineLoop,
+            PipelineLoopFinish,
+            StageChange,
+            EnqueueTask,
+            EnqueueTaskReq,
+            UnblockTask,
+            CompleteTask,
+            ExternalRunRequest,
+            ExternalSignal>;
+
+    ExecLogRing                     logRing;
+    bool                            doLogging{true};
+}; // struct ExecLog
+
+ExecLogRecord exec_log_encode(ExecLog::LogMsg_t const& msg) noexcept;
+
+ExecLog::LogMsg_t exec_log_decode(ExecLogRecord const& record) noexcept;
+
+} // namespace osp
@@ -0,0 +1,202 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "exec_schedule.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <variant>
+
+namespace osp
+{
+
+bool exec_is_idle(ExecContext const& exec) noexcept
+{
+    return exec.pipelinesRunning == 0
+        && exec.tasksQueuedRun.empty()
+        && exec.tasksQueuedBlocked.empty()
+        && exec.requestLoop.empty()
+        && ! exec.hasPlAdvanceOrLoop;
+}
+
+bool exec_is_settled(ExecContext const& exec) noexcept
+{
+    return exec.tasksQueuedRun.empty()
+        && exec.requestLoop.empty();
+}
+
+static void schedule_state_save(ExecContext const& exec, ExecScheduleState &rOut)
+{
+    rOut.plData                 = exec.plData;
+    rOut.plAdvance              = exec.plAdvance;
+    rOut.plAdvanceNext          = exec.plAdvanceNext;
+    rOut.plRequestRun           = exec.plRequestRun;
+    rOut.pipelinesRunning       = exec.pipelinesRunning;
+    rOut.hasPlAdvanceOrLoop     = exec.hasPlAdvanceOrLoop;
+    rOut.hasRequestRun          = exec.hasRequestRun;
+
+    // Sorted, as storage order depends on the order tasks were queued and unblocked
+    rOut.tasksQueuedBlocked.clear();
+    for (auto const [task, block] : exec.tasksQueuedBlocked.each())
+    {
+        rOut.tasksQueuedBlocked.emplace_back(task, block);
+    }
+    std::sort(rOut.tasksQueuedBlocked.begin(), rOut.tasksQueuedBlocked.end(),
+              [] (auto const& lhs, auto const& rhs) { return lhs.first < rhs.first; });
+}
+
+static bool schedule_state_matches(ExecContext const& exec, ExecScheduleState const& state) noexcept
+{
+    if (   exec.pipelinesRunning                    != state.pipelinesRunning
+        || exec.hasPlAdvanceOrLoop                  != state.hasPlAdvanceOrLoop
+        || exec.hasRequestRun                       != state.hasRequestRun
+        || exec.tasksQueuedBlocked.size()           != state.tasksQueuedBlocked.size()
+        || exec.plAdvance.ints()                    != state.plAdvance.ints()
+        || exec.plAdvanceNext.ints()                != state.plAdvanceNext.ints()
+        || exec.plRequestRun.ints()                 != state.plRequestRun.ints()
+        || exec.plData                              != state.plData)
+    {
+        return false;
+    }
+
+    return std::all_of(state.tasksQueuedBlocked.begin(), state.tasksQueuedBlocked.end(),
+                       [&exec] (auto const& blocked)
+    {
+        return    exec.tasksQueuedBlocked.contains(blocked.first)
+               && exec.tasksQueuedBlocked.get(blocked.first) == blocked.second;
+    });
+}
+
+static void schedule_state_load(ExecContext &rExec, ExecScheduleState const& state)
+{
+    rExec.plData                = state.plData;
+    rExec.plAdvance             = state.plAdvance;
+    rExec.plAdvanceNext         = state.plAdvanceNext;
+    rExec.plRequestRun          = state.plRequestRun;
+    rExec.pipelinesRunning      = state.pipelinesRunning;
+    rExec.hasPlAdvanceOrLoop    = state.hasPlAdvanceOrLoop;
+    rExec.hasRequestRun         = state.hasRequestRun;
+
+    rExec.tasksQueuedBlocked.clear();
+    for (auto const& [task, block] : state.tasksQueuedBlocked)
+    {
+        rExec.tasksQueuedBlocked.emplace(task, block);
+    }
+
+    // Nothing is queued to run while settled, so anything left in the heap was never taken
+    rExec.readyHeap.clear();
+    rExec.taskInReadyHeap.reset();
+}
+
+void exec_schedule_record_start(ExecContext const& exec, ExecSchedule &rSched)
+{
+    LGRN_ASSERTM(exec_is_settled(exec), "Recording must start from a settled ExecContext");
+    LGRN_ASSERTM(exec.doLogging, "Completed tasks are recorded from the ExecLog");
+
+    schedule_state_save(exec, rSched.start);
+    rSched.tasks.clear();
+    rSched.actions.clear();
+    rSched.logDroppedStart      = exec.logRing.dropped.load(std::memory_order_relaxed);
+    rSched.recording            = true;
+    rSched.diverged             = false;
+    rSched.valid                = false;
+}
+
+void exec_schedule_record(ExecSchedule &rSched, ArrayView<ExecLogRecord const> const records)
+{
+    if ( ! rSched.recording )
+    {
+        return;
+    }
+
+    for (ExecLogRecord const& record : records)
+    {
+        std::visit([&rSched] (auto const& msg)
+        {
+            using MSG_T = std::decay_t<decltype(msg)>;
+
+            if constexpr (std::is_same_v<MSG_T, ExecLog::CompleteTask>)
+            {
+                rSched.tasks  .push_back(msg.task);
+                rSched.actions.push_back(msg.actions);
+            }
+            else if constexpr (   std::is_same_v<MSG_T, ExecLog::ExternalSignal>
+                               || std::is_same_v<MSG_T, ExecLog::ExternalRunRequest>)
+            {
+                // Depends on things other than the start state and what tasks returned
+                rSched.diverged = true;
+            }
+        }, exec_log_decode(record));
+    }
+}
+
+void exec_schedule_record_finish(ExecContext const& exec, ExecSchedule &rSched)
+{
+    if ( ! rSched.recording )
+    {
+        return;
+    }
+
+    rSched.recording = false;
+    rSched.valid     =    ! rSched.diverged
+                       && ! rSched.tasks.empty()
+                       && exec_is_settled(exec)
+                       && exec.logRing.dropped.load(std::memory_order_relaxed) == rSched.logDroppedStart;
+
+    if (rSched.valid)
+    {
+        schedule_state_save(exec, rSched.end);
+    }
+}
+
+bool exec_schedule_matches(ExecContext const& exec, ExecSchedule const& sched) noexcept
+{
+    return sched.valid
+        && exec_is_settled(exec)
+        && schedule_state_matches(exec, sched.start);
+}
+
+void exec_schedule_replay_done(ExecContext &rExec, ExecSchedule const& sched) noexcept
+{
+    schedule_state_load(rExec, sched.end);
+}
+
+void exec_schedule_catch_up(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, ExecSchedule const& sched, std::size_t const count) noexcept
+{
+    LGRN_ASSERT(count <= sched.tasks.size());
+
+    // Same sequence of calls as top_run_blocking
+    exec_update(tasks, graph, rExec);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        TaskId const task = sched.tasks[i];
+        LGRN_ASSERTMV(rExec.tasksQueuedRun.contains(task), "Schedule does not match ExecContext", TaskInt(task));
+
+        complete_task(tasks, graph, rExec, task, sched.actions[i]);
+        exec_update(tasks, graph, rExec);
+    }
+}
+
+} // namespace osp
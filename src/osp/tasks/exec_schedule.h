@@ -0,0 +1,137 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "exec_log.h"
+#include "execute.h"
+#include "tasks.h"
+
+#include <utility>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief Copy of the parts of an ExecContext that decide how the next run goes
+ *
+ * Only taken while no tasks are ready to run, see exec_is_settled.
+ */
+struct ExecScheduleState
+{
+    KeyedVec<PipelineId, ExecPipeline>          plData;
+    std::vector< std::pair<TaskId, BlockedTask> > tasksQueuedBlocked;
+    BitVector_t                                 plAdvance;
+    BitVector_t                                 plAdvanceNext;
+    BitVector_t                                 plRequestRun;
+    int                                         pipelinesRunning    {0};
+    bool                                        hasPlAdvanceOrLoop  {false};
+    bool                                        hasRequestRun       {false};
+};
+
+/**
+ * @brief Order that tasks completed in during a recorded run, to replay without exec_update
+ *
+ * A run is everything an exec_update and top_run_blocking do from a settled ExecContext (see
+ * exec_is_settled) until it's settled again. Pipelines may still be running before and after,
+ * such as a main loop waiting for its next signal. Runs that start out exactly the same and
+ * have each task return the same TaskActions go through the same tasks in the same order. A
+ * recording can then be replayed by calling each task in order instead of going through
+ * exec_update and complete_task.
+ *
+ * Cancels and loops only follow from what tasks return, so they can be recorded. Runs that
+ * signal or request pipelines partway through can't.
+ */
+struct ExecSchedule
+{
+    ExecScheduleState                   start;
+    ExecScheduleState                   end;
+
+    /// Tasks in the order they completed
+    std::vector<TaskId>                 tasks;
+
+    /// What each task in 'tasks' returned
+    std::vector<TaskActions>            actions;
+
+    /// ExecLogRing::dropped at the start, as a recording that missed records is incomplete
+    uint64_t                            logDroppedStart {0};
+
+    bool                                recording       {false};
+    bool                                diverged        {false};
+    bool                                valid           {false};
+};
+
+/**
+ * @brief Check if no pipelines are running nor any tasks queued
+ */
+bool exec_is_idle(ExecContext const& exec) noexcept;
+
+/**
+ * @brief Check if no tasks are ready to run, but pipelines may be running or waiting on signals
+ *
+ * Runs are recorded and replayed between settled states.
+ */
+bool exec_is_settled(ExecContext const& exec) noexcept;
+
+/**
+ * @brief Start recording a run, call right before the first exec_update of the run
+ *
+ * Requires exec_is_settled, and ExecLog::doLogging as completed tasks are read from the log.
+ */
+void exec_schedule_record_start(ExecContext const& exec, ExecSchedule &rSched);
+
+/**
+ * @brief Record completed tasks from ExecLog records, call with all records during the run
+ */
+void exec_schedule_record(ExecSchedule &rSched, ArrayView<ExecLogRecord const> records);
+
+/**
+ * @brief Stop recording, and keep the recording only if it can be replayed
+ */
+void exec_schedule_record_finish(ExecContext const& exec, ExecSchedule &rSched);
+
+/**
+ * @brief Check if a recorded schedule can be replayed for the current ExecContext state
+ */
+bool exec_schedule_matches(ExecContext const& exec, ExecSchedule const& sched) noexcept;
+
+/**
+ * @brief Set ExecContext to the end state of a fully replayed schedule
+ */
+void exec_schedule_replay_done(ExecContext &rExec, ExecSchedule const& sched) noexcept;
+
+/**
+ * @brief Bring ExecContext to where it would be after running the first few tasks of a schedule
+ *
+ * For when a replay diverges from the recording. Runs exec_update and complete_task for tasks
+ * that already ran during the replay, as if run dynamically and returning the same as recorded.
+ * Afterwards, the diverging task can be completed with complete_task, and the rest of the run
+ * continued with exec_update.
+ *
+ * @param count [in] Number of tasks from the start of the schedule that already ran
+ */
+void exec_schedule_catch_up(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, ExecSchedule const& sched, std::size_t count) noexcept;
+
+} // namespace osp
@@ -27,11 +27,16 @@
 
 #include <Corrade/Containers/ArrayViewStl.h>
 
+#include <algorithm>
+#include <limits>
+
 namespace osp
 {
 
 static void exec_log(ExecContext &rExec, ExecContext::LogMsg_t msg) noexcept;
 
+static void exec_run_requested(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec) noexcept;
+
 static void pipeline_run_root(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, PipelineId pipeline) noexcept;
 
 static int pipeline_run(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, bool rerunLoop, PipelineId pipeline, PipelineTreePos_t treePos, uint32_t descendents, bool isLoopScope, bool insideLoopScope);
@@ -48,6 +53,14 @@ static void pipeline_try_advance(ExecContext &rExec, ExecPipeline &rExecPl, Pipe
 
 static void pipeline_cancel(Tasks const& tasks, TaskGraph const& graph, ExecContext& rExec, ExecPipeline& rExecPl, PipelineId pipeline) noexcept;
 
+static bool task_try_acquire(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, TaskId task) noexcept;
+
+static void task_release(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, TaskId task) noexcept;
+
+static void task_unblock(ExecContext &rExec, TaskId task) noexcept;
+
+static bool pipeline_can_run_root(Tasks const& tasks, TaskGraph const& graph, ExecContext const& exec, PipelineId pipeline) noexcept;
+
 struct ArgsForIsPipelineInLoop
 {
     PipelineId viewedFrom;
@@ -75,21 +88,9 @@ void exec_update(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec)
 
     if (rExec.hasRequestRun)
     {
-        for (ExecPipeline const& rExecPl : rExec.plData)
-        {
-            LGRN_ASSERTM( ! rExecPl.running, "Running new pipelines while already running is not yet supported ROFL! "
-                                             "Make sure all pipelines are finished running.");
-        }
-
-        for (PipelineInt const plInt : rExec.plRequestRun.ones())
-        {
-            pipeline_run_root(tasks, graph, rExec, PipelineId(plInt));
-        }
-        rExec.plRequestRun.reset();
-        rExec.hasRequestRun = false;
+        exec_run_requested(tasks, graph, rExec);
     }
 
-
     while (rExec.hasPlAdvanceOrLoop)
     {
         exec_log(rExec, ExecContext::UpdateCycle{});
@@ -123,6 +124,12 @@ void exec_update(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec)
                   rExec.plAdvanceNext.ints().end(),
                   rExec.plAdvance    .ints().begin());
         rExec.plAdvanceNext.reset();
+
+        if (rExec.hasRequestRun)
+        {
+            // Deferred requests may be able to run now that some pipelines finished
+            exec_run_requested(tasks, graph, rExec);
+        }
     }
 
     exec_log(rExec, ExecContext::UpdateEnd{});
@@ -133,7 +140,9 @@ void complete_task(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExe
     LGRN_ASSERT(rExec.tasksQueuedRun.contains(task));
     rExec.tasksQueuedRun.erase(task);
 
-    exec_log(rExec, ExecContext::CompleteTask{task});
+    exec_log(rExec, ExecContext::CompleteTask{task, actions});
+
+    task_release(tasks, graph, rExec, task);
 
     auto const [pipeline, stage] = tasks.m_taskRunOn[task];
     ExecPipeline &rExecPl = rExec.plData[pipeline];
@@ -211,10 +220,112 @@ void exec_signal(ExecContext &rExec, PipelineId pipeline) noexcept
     }
 }
 
+/**
+ * @brief Orders ExecContext::readyHeap, equal priorities pop lowest ID first
+ */
+struct ReadyHeapLess
+{
+    bool operator()(TaskId const lhs, TaskId const rhs) const noexcept
+    {
+        uint64_t const lhsPriority = (std::size_t(lhs) < priority.size()) ? priority[lhs] : 0;
+        uint64_t const rhsPriority = (std::size_t(rhs) < priority.size()) ? priority[rhs] : 0;
+
+        return (lhsPriority != rhsPriority) ? (lhsPriority < rhsPriority) : (lhs > rhs);
+    }
+
+    KeyedVec<TaskId, uint64_t> const& priority;
+};
+
+TaskId exec_pop_ready(ExecContext &rExec) noexcept
+{
+    while ( ! rExec.readyHeap.empty() )
+    {
+        std::pop_heap(rExec.readyHeap.begin(), rExec.readyHeap.end(), ReadyHeapLess{rExec.taskPriority});
+
+        TaskId const task = rExec.readyHeap.back();
+        rExec.readyHeap.pop_back();
+        rExec.taskInReadyHeap.reset(std::size_t(task));
+
+        if (rExec.tasksQueuedRun.contains(task))
+        {
+            return task;
+        }
+        // else: Completed without being taken
+    }
+
+    return lgrn::id_null<TaskId>();
+}
+
+void exec_push_ready(ExecContext &rExec, TaskId const task) noexcept
+{
+    if (rExec.taskInReadyHeap.test(std::size_t(task)))
+    {
+        return; // Left in from a previous time the task was queued and never taken
+    }
+
+    rExec.taskInReadyHeap.set(std::size_t(task));
+    rExec.readyHeap.push_back(task);
+    std::push_heap(rExec.readyHeap.begin(), rExec.readyHeap.end(), ReadyHeapLess{rExec.taskPriority});
+}
+
+void exec_set_priorities(Tasks const& tasks, ArrayView<uint64_t const> const critPathNs, ExecContext &rExec)
+{
+    // Explicit priority in the top 16 bits, then critical path capped to ~78 hours
+    constexpr uint64_t critPathMaxNs = (uint64_t(1) << 48) - 1;
+
+    rExec.taskPriority.assign(tasks.m_taskIds.capacity(), 0);
+
+    for (TaskInt const taskInt : tasks.m_taskIds.bitview().zeros())
+    {
+        auto const      task        = TaskId(taskInt);
+        int const       explicitPri = (taskInt < tasks.m_taskPriority.size()) ? tasks.m_taskPriority[task] : 0;
+        uint64_t const  critPath    = (taskInt < critPathNs.size()) ? std::min(critPathNs[taskInt], critPathMaxNs) : 0;
+
+        rExec.taskPriority[task] = (uint64_t(explicitPri - std::numeric_limits<int16_t>::min()) << 48) | critPath;
+    }
+
+    std::make_heap(rExec.readyHeap.begin(), rExec.readyHeap.end(), ReadyHeapLess{rExec.taskPriority});
+}
+
 //-----------------------------------------------------------------------------
 
 // Major steps
 
+static void exec_run_requested(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec) noexcept
+{
+    // Decide which requests can run before running any of them. Pipelines requested together
+    // may depend on each other, and are allowed to start together.
+    rExec.plRequestRunNow.reset();
+    bool anyRunNow   = false;
+    bool anyDeferred = false;
+
+    for (PipelineInt const plInt : rExec.plRequestRun.ones())
+    {
+        if (pipeline_can_run_root(tasks, graph, rExec, PipelineId(plInt)))
+        {
+            rExec.plRequestRunNow.set(plInt);
+            anyRunNow = true;
+        }
+        else
+        {
+            anyDeferred = true;
+        }
+    }
+
+    rExec.hasRequestRun = anyDeferred;
+
+    if ( ! anyRunNow )
+    {
+        return;
+    }
+
+    for (PipelineInt const plInt : rExec.plRequestRunNow.ones())
+    {
+        rExec.plRequestRun.reset(plInt);
+        pipeline_run_root(tasks, graph, rExec, PipelineId(plInt));
+    }
+}
+
 static void pipeline_run_root(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, PipelineId const pipeline) noexcept
 {
     exec_log(rExec, ExecLog::ExternalRunRequest{pipeline});
@@ -347,13 +458,14 @@ static void loop_scope_done(Tasks const& tasks, TaskGraph const& graph, ExecCont
             return; // Loop is in the root
         }
 
-        PipelineTreePos_t const parentScopeTreePos = graph.pipelineToLoopScope[parentPl];
-        if (parentScopeTreePos == lgrn::id_null<PipelineTreePos_t>())
+        LoopScopeRange const& parentScope = graph.pipelineToLoopScopeRange[parentPl];
+        if (parentScope.first == lgrn::id_null<PipelineTreePos_t>())
         {
             return; // Parent does not loop
         }
 
-        PipelineId const parentScopePl = graph.pltreeToPipeline[parentScopeTreePos];
+        PipelineTreePos_t const parentScopeTreePos  = parentScope.first;
+        PipelineId const        parentScopePl       = parentScope.pipeline;
         ExecPipeline &rParentScopeExecPl = rExec.plData[parentScopePl];
 
         LGRN_ASSERT(rParentScopeExecPl.loopChildrenLeft != 0);
@@ -370,8 +482,9 @@ static void loop_done(Tasks const& tasks, TaskGraph const& graph, ExecContext &r
 {
     rExecPl.stage = lgrn::id_null<StageId>();
 
-    PipelineTreePos_t scopeTreePos  = graph.pipelineToLoopScope[pipeline];
-    PipelineId        scopePl       = graph.pltreeToPipeline[scopeTreePos];
+    LoopScopeRange const& scope     = graph.pipelineToLoopScopeRange[pipeline];
+    PipelineTreePos_t scopeTreePos  = scope.first;
+    PipelineId        scopePl       = scope.pipeline;
     ExecPipeline      &rScopeExecPl = rExec.plData[scopePl];
 
     if (scopePl != pipeline) // if not a loopscope itself
@@ -459,14 +572,9 @@ static void pipeline_advance_reqs(Tasks const& tasks, TaskGraph const& graph, Ex
             // Unblock tasks that are alredy queued
             BlockedTask &rBlocked = rExec.tasksQueuedBlocked.get(task);
             -- rBlocked.reqStagesLeft;
-            if (rBlocked.reqStagesLeft == 0)
+            if (rBlocked.reqStagesLeft == 0 && task_try_acquire(tasks, graph, rExec, task))
             {
-                exec_log(rExec, ExecContext::UnblockTask{task});
-                ExecPipeline &rTaskPlExec = rExec.plData[rBlocked.pipeline];
-                -- rTaskPlExec.tasksQueuedBlocked;
-                ++ rTaskPlExec.tasksQueuedRun;
-                rExec.tasksQueuedRun.push(task);
-                rExec.tasksQueuedBlocked.erase(task);
+                task_unblock(rExec, task);
             }
         }
         else
@@ -575,7 +683,8 @@ static void pipeline_advance_run(Tasks const& tasks, TaskGraph const& graph, Exe
                 }
             }
 
-            bool const blocked = reqStagesLeft != 0;
+            // Only acquire semaphores if the task is otherwise allowed to run
+            bool const blocked = reqStagesLeft != 0 || ! task_try_acquire(tasks, graph, rExec, task);
 
             if (blocked)
             {
@@ -585,6 +694,7 @@ static void pipeline_advance_run(Tasks const& tasks, TaskGraph const& graph, Exe
             else
             {
                 rExec.tasksQueuedRun.push(task);
+                exec_push_ready(rExec, task);
                 ++ rExecPl.tasksQueuedRun;
             }
 
@@ -775,6 +885,68 @@ static void pipeline_try_advance(ExecContext &rExec, ExecPipeline &rExecPl, Pipe
 
 //-----------------------------------------------------------------------------
 
+// Task utility
+
+static bool task_try_acquire(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, TaskId const task) noexcept
+{
+    auto const acquires = fanout_view(graph.taskToFirstAcquire, graph.taskAcquire, task);
+
+    // All or nothing. Holding on to some units while waiting for others can deadlock.
+    for (TaskAcquire const& acquire : acquires)
+    {
+        if (rExec.semaUnitsUsed[acquire.semaphore] + acquire.units > tasks.m_semaLimits[acquire.semaphore])
+        {
+            return false;
+        }
+    }
+
+    for (TaskAcquire const& acquire : acquires)
+    {
+        rExec.semaUnitsUsed[acquire.semaphore] += acquire.units;
+    }
+
+    return true;
+}
+
+static void task_release(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, TaskId const task) noexcept
+{
+    auto const acquires = fanout_view(graph.taskToFirstAcquire, graph.taskAcquire, task);
+
+    for (TaskAcquire const& acquire : acquires)
+    {
+        LGRN_ASSERT(rExec.semaUnitsUsed[acquire.semaphore] >= acquire.units);
+        rExec.semaUnitsUsed[acquire.semaphore] -= acquire.units;
+    }
+
+    // Unblock tasks that were only waiting for units
+    for (TaskAcquire const& acquire : acquires)
+    {
+        for (TaskId const waiting : fanout_view(graph.semaToFirstAcquiredBy, graph.semaAcquiredBy, acquire.semaphore))
+        {
+            if (   rExec.tasksQueuedBlocked.contains(waiting)
+                && rExec.tasksQueuedBlocked.get(waiting).reqStagesLeft == 0
+                && task_try_acquire(tasks, graph, rExec, waiting) )
+            {
+                task_unblock(rExec, waiting);
+            }
+        }
+    }
+}
+
+static void task_unblock(ExecContext &rExec, TaskId const task) noexcept
+{
+    exec_log(rExec, ExecContext::UnblockTask{task});
+
+    ExecPipeline &rTaskPlExec = rExec.plData[rExec.tasksQueuedBlocked.get(task).pipeline];
+    -- rTaskPlExec.tasksQueuedBlocked;
+    ++ rTaskPlExec.tasksQueuedRun;
+    rExec.tasksQueuedRun.push(task);
+    exec_push_ready(rExec, task);
+    rExec.tasksQueuedBlocked.erase(task);
+}
+
+//-----------------------------------------------------------------------------
+
 // Read-only checks
 
 static constexpr bool pipeline_can_advance(ExecPipeline &rExecPl) noexcept
@@ -807,81 +979,137 @@ static constexpr bool pipeline_can_advance(ExecPipeline &rExecPl) noexcept
 }
 
 /**
- * @brief Check if a pipeline 'sees' another pipeline is enclosed within a non-cancelled loop
+ * @brief Check if a requested pipeline and its descendants can start running right now
+ *
+ * Requests are deferred if any pipeline in the requested subtree or any of its ancestors are
+ * still running, or if any pipeline in the subtree syncs with a running pipeline. Dependency
+ * counts are evaluated assuming a pipeline that isn't running is either finished or won't run,
+ * so a pipeline must not start partway through the run of another pipeline it syncs with.
  */
-static bool is_pipeline_in_loop(Tasks const& tasks, TaskGraph const& graph, ExecContext const& exec, ArgsForIsPipelineInLoop const args) noexcept
+static bool pipeline_can_run_root(Tasks const& tasks, TaskGraph const& graph, ExecContext const& exec, PipelineId const pipeline) noexcept
 {
-    PipelineTreePos_t const insideLoopScopePos = graph.pipelineToLoopScope[args.insideLoop];
-
-    if (insideLoopScopePos == lgrn::id_null<PipelineTreePos_t>())
+    auto const is_running = [&exec] (PipelineId const other) noexcept -> bool
     {
-        return false; // insideLoop is in the root, not inside a loop lol
-    }
-
-    PipelineTreePos_t const viewedFromScopePos = graph.pipelineToLoopScope[args.viewedFrom];
+        return exec.plData[other].running;
+    };
 
-    if (insideLoopScopePos == viewedFromScopePos)
+    for (PipelineId parent = tasks.m_pipelineParents[pipeline];
+         parent != lgrn::id_null<PipelineId>();
+         parent = tasks.m_pipelineParents[parent])
     {
-        return false; // Both pipelines are in the same loop scope
-    }
-    else if (viewedFromScopePos == lgrn::id_null<PipelineTreePos_t>())
-    {
-        // viewedFrom is in the root, and insideLoop is enclosed in a loop.
-
-        if (exec.plData[args.insideLoop].canceled)
-        {
-            // NOLINTBEGIN(readability-simplify-boolean-expr)
-            if (exec.plData[graph.pltreeToPipeline[insideLoopScopePos]].canceled)
-            {
-                return false; // insideLoop is canceled and will not loop again
-            }
-            else
-            {
-                return true; // insideLoop itself is canceled, but is parented to a non-canceled
-                             // loop scope. It will loop more times.
-            }
-            // NOLINTEND(readability-simplify-boolean-expr)
-        }
-        else // insideLoop is canceled
+        if (is_running(parent))
         {
-            return true; // insideLoop is not canceled and will loop more
+            return false;
         }
     }
-    else
+
+    // True if subPl is running or syncs with a running pipeline
+    auto const is_busy = [&tasks, &graph, &is_running] (PipelineId const subPl) noexcept -> bool
     {
-        // Check tree if insideLoopScopePos is a descendent of viewedFromScopePos
-        PipelineTreePos_t const ancestor            = viewedFromScopePos;
-        PipelineTreePos_t const ancestorLastChild   = viewedFromScopePos + 1 + graph.pltreeDescendantCounts[viewedFromScopePos];
-        PipelineTreePos_t const descendent          = insideLoopScopePos;
+        if (is_running(subPl))
+        {
+            return true;
+        }
 
-        bool const isDescendent = (ancestor < descendent) && (descendent < ancestorLastChild);
+        auto const stageCount  = fanout_size(graph.pipelineToFirstAnystg, subPl);
+        auto const anystgFirst = uint32_t(anystg_from(graph, subPl, StageId(0)));
 
-        if (isDescendent)
+        for (auto anystgInt = anystgFirst; anystgInt < anystgFirst + stageCount; ++anystgInt)
         {
-            if (exec.plData[args.insideLoop].canceled)
+            auto const anystg = AnyStageId(anystgInt);
+
+            for (StageRequiresTask const& stgreqtask : fanout_view(graph.anystgToFirstStgreqtask, graph.stgreqtaskData, anystg))
             {
-                // NOLINTBEGIN(readability-simplify-boolean-expr)
-                if (exec.plData[graph.pltreeToPipeline[insideLoopScopePos]].canceled)
+                if (is_running(stgreqtask.reqPipeline))
                 {
-                    return false; // insideLoop is canceled and will not loop again
+                    return true;
                 }
-                else
+            }
+
+            for (TaskId const task : fanout_view(graph.anystgToFirstRevTaskreqstg, graph.revTaskreqstgToTask, anystg))
+            {
+                if (is_running(tasks.m_taskRunOn[task].pipeline))
                 {
-                    return true; // insideLoop is in a nested loop and is canceled, but is parented
-                                 // to a non-canceled loop scope. It will loop more times.
+                    return true;
                 }
-                // NOLINTEND(readability-simplify-boolean-expr)
             }
-            else
+
+            for (TaskId const task : fanout_view(graph.anystgToFirstRuntask, graph.runtaskToTask, anystg))
             {
-                return true; // insideLoop is in a nested loop and is not canceled
+                for (TaskRequiresStage const& req : fanout_view(graph.taskToFirstTaskreqstg, graph.taskreqstgData, task))
+                {
+                    if (is_running(req.reqPipeline))
+                    {
+                        return true;
+                    }
+                }
+
+                for (AnyStageId const reqTaskAnystg : fanout_view(graph.taskToFirstRevStgreqtask, graph.revStgreqtaskToStage, task))
+                {
+                    if (is_running(graph.anystgToPipeline[reqTaskAnystg]))
+                    {
+                        return true;
+                    }
+                }
             }
         }
-        else
+
+        return false;
+    };
+
+    PipelineTreePos_t const treePos = graph.pipelineToPltree[pipeline];
+    if (treePos == lgrn::id_null<PipelineTreePos_t>())
+    {
+        return ! is_busy(pipeline); // Not part of a tree, no descendants
+    }
+
+    uint32_t const          descendants = graph.pltreeDescendantCounts[treePos];
+    PipelineTreePos_t const lastPos     = treePos + 1 + descendants;
+
+    for (PipelineTreePos_t pos = treePos; pos < lastPos; ++pos)
+    {
+        if (is_busy(graph.pltreeToPipeline[pos]))
         {
-            return false; // viewedFrom and insideLoop are unrelated
+            return false;
         }
     }
+
+    return true;
+}
+
+/**
+ * @brief Check if a pipeline 'sees' another pipeline is enclosed within a non-cancelled loop
+ */
+static bool is_pipeline_in_loop(Tasks const& tasks, TaskGraph const& graph, ExecContext const& exec, ArgsForIsPipelineInLoop const args) noexcept
+{
+    LoopScopeRange const& insideLoopScope = graph.pipelineToLoopScopeRange[args.insideLoop];
+
+    if (insideLoopScope.first == lgrn::id_null<PipelineTreePos_t>())
+    {
+        return false; // insideLoop is in the root, not inside a loop lol
+    }
+
+    LoopScopeRange const& viewedFromScope = graph.pipelineToLoopScopeRange[args.viewedFrom];
+
+    if (insideLoopScope.first == viewedFromScope.first)
+    {
+        return false; // Both pipelines are in the same loop scope
+    }
+
+    // viewedFrom sees insideLoop's loop scope if viewedFrom is in the root, or if insideLoop's
+    // loop scope is nested in viewedFrom's loop scope.
+    bool const isEnclosed =    viewedFromScope.first == lgrn::id_null<PipelineTreePos_t>()
+                            || (   viewedFromScope.first < insideLoopScope.first
+                                && insideLoopScope.first < viewedFromScope.last);
+    if ( ! isEnclosed )
+    {
+        return false; // viewedFrom and insideLoop are unrelated
+    }
+
+    // If insideLoop itself is canceled, it will still loop more times unless its loop scope is
+    // canceled too.
+    return    ! exec.plData[args.insideLoop].canceled
+           || ! exec.plData[insideLoopScope.pipeline].canceled;
 }
 
 //-----------------------------------------------------------------------------
@@ -895,23 +1123,32 @@ void exec_conform(Tasks const& tasks, ExecContext &rOut)
 
     rOut.tasksQueuedRun    .reserve(maxTasks);
     rOut.tasksQueuedBlocked.reserve(maxTasks);
+    rOut.readyHeap         .reserve(maxTasks);
+    bitvector_resize(rOut.taskInReadyHeap, maxTasks);
     rOut.plData.resize(maxPipeline);
     bitvector_resize(rOut.plAdvance,     maxPipeline);
     bitvector_resize(rOut.plAdvanceNext, maxPipeline);
     bitvector_resize(rOut.plRequestRun,  maxPipeline);
+    bitvector_resize(rOut.plRequestRunNow, maxPipeline);
+    rOut.semaUnitsUsed.resize(tasks.m_semaIds.capacity(), 0);
 
     for (PipelineInt const pipelineInt : tasks.m_pipelineIds.bitview().zeros())
     {
         auto const pipeline = PipelineId(pipelineInt);
         rOut.plData[pipeline].waitStage = tasks.m_pipelineControl[pipeline].waitStage;
     }
+
+    if (rOut.logRing.capacity == 0)
+    {
+        exec_log_ring_alloc(rOut.logRing, gc_execLogDefaultCapacity);
+    }
 }
 
 static void exec_log(ExecContext &rExec, ExecContext::LogMsg_t msg) noexcept
 {
     if (rExec.doLogging)
     {
-        rExec.logMsg.push_back(msg);
+        exec_log_ring_push(rExec.logRing, exec_log_encode(msg));
     }
 }
 
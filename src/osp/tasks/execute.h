@@ -24,6 +24,7 @@
  */
 #pragma once
 
+#include "exec_log.h"
 #include "tasks.h"
 #include "worker.h"
 
@@ -32,7 +33,6 @@
 #include <entt/entity/storage.hpp>
 
 #include <cassert>
-#include <variant>
 #include <vector>
 
 namespace osp
@@ -78,12 +78,21 @@ struct ExecPipeline
     bool            loop                    { false };
     bool            running                 { false };
     bool            canceled                { false };
+
+    constexpr bool operator==(ExecPipeline const& rhs) const noexcept = default;
 };
 
+/**
+ * @brief A queued task that is not yet allowed to run
+ *
+ * If reqStagesLeft is zero, then the task is only waiting for semaphore units to be available.
+ */
 struct BlockedTask
 {
     int             reqStagesLeft;
     PipelineId      pipeline;
+
+    constexpr bool operator==(BlockedTask const& rhs) const noexcept = default;
 };
 
 struct LoopRequestRun
@@ -93,105 +102,6 @@ struct LoopRequestRun
 };
 
 
-/**
- * @brief Fast plain-old-data log for ExecContext state changes
- */
-struct ExecLog
-{
-    struct UpdateStart { };
-    struct UpdateCycle { };
-    struct UpdateEnd { };
-
-    struct PipelineRun
-    {
-        PipelineId  pipeline;
-    };
-
-    struct PipelineFinish
-    {
-        PipelineId  pipeline;
-    };
-
-    struct PipelineCancel
-    {
-        PipelineId  pipeline;
-        StageId     stage;
-    };
-
-    struct PipelineLoop
-    {
-        PipelineId  pipeline;
-    };
-
-    struct PipelineLoopFinish
-    {
-        PipelineId  pipeline;
-    };
-
-    struct StageChange
-    {
-        PipelineId  pipeline;
-        StageId     stageOld;
-        StageId     stageNew;
-    };
-
-    struct EnqueueTask
-    {
-        PipelineId  pipeline;
-        StageId     stage;
-        TaskId      task;
-        bool        blocked;
-    };
-
-    struct EnqueueTaskReq
-    {
-        PipelineId  pipeline;
-        StageId     stage;
-        bool        satisfied;
-    };
-
-    struct UnblockTask
-    {
-        TaskId      task;
-    };
-
-    struct CompleteTask
-    {
-        TaskId      task;
-    };
-
-    struct ExternalRunRequest
-    {
-        PipelineId  pipeline;
-    };
-
-    struct ExternalSignal
-    {
-        PipelineId  pipeline;
-        bool        ignored;
-    };
-
-    using LogMsg_t = std::variant<
-            UpdateStart,
-            UpdateCycle,
-            UpdateEnd,
-            PipelineRun,
-            PipelineFinish,
-            PipelineCancel,
-            PipelineLoop,
-            PipelineLoopFinish,
-            StageChange,
-            EnqueueTask,
-            EnqueueTaskReq,
-            UnblockTask,
-            CompleteTask,
-            ExternalRunRequest,
-            ExternalSignal>;
-
-    std::vector<LogMsg_t>           logMsg;
-    bool                            doLogging{true};
-}; // struct ExecLog
-
 /**
  * @brief State for executing Tasks and TaskGraph
  */
@@ -202,29 +112,45 @@ struct ExecContext : public ExecLog
     entt::basic_sparse_set<TaskId>              tasksQueuedRun;
     entt::basic_storage<BlockedTask, TaskId>    tasksQueuedBlocked;
 
+    /// Tasks in tasksQueuedRun not yet taken by exec_pop_ready, as a max-heap by taskPriority.
+    /// Tasks completed without being taken are left in, and skipped once popped.
+    std::vector<TaskId>                 readyHeap;
+    BitVector_t                         taskInReadyHeap;
+
+    /// Order tasks are taken by exec_pop_ready, highest first. See exec_set_priorities
+    KeyedVec<TaskId, uint64_t>          taskPriority;
+
     BitVector_t                         plAdvance;
     BitVector_t                         plAdvanceNext;
     bool                                hasPlAdvanceOrLoop  {false};
 
+    /// Pipelines requested to run. Requests for pipelines that can't start yet (see
+    /// exec_request_run) stay set until they can.
     BitVector_t                         plRequestRun;
+    BitVector_t                         plRequestRunNow;
     std::vector<LoopRequestRun>         requestLoop;
     bool                                hasRequestRun {false};
 
     int                                 pipelinesRunning {0};
 
-    // TODO: Consider multithreading. something something work stealing...
-    //  * Allow multiple threads to search for and execute tasks. Atomic access
-    //    for ExecContext? Might be messy to implement.
-    //  * Only allow one thread to search for tasks, assign tasks to other
-    //    threads if they're available before running own task. Another thread
-    //    can take over once it completes its task. May be faster as only one
-    //    thread is modifying ExecContext, and easier to implement.
-    //  * Plug into an existing work queue library?
+    /// Units of each semaphore held by tasks in tasksQueuedRun
+    KeyedVec<SemaphoreId, unsigned int> semaUnitsUsed;
+
+    // ExecContext is not thread-safe. Multithreaded executors must only call exec_update and
+    // complete_task from a single scheduler thread, and hand off tasks in tasksQueuedRun to
+    // other threads to run. See testapp::ThreadPoolExecutor.
 
 }; // struct ExecContext
 
 void exec_conform(Tasks const& tasks, ExecContext &rOut);
 
+/**
+ * @brief Request to run a pipeline and all of its descendants, starting on the next exec_update
+ *
+ * This can be called while other pipelines are running. The request is deferred until the
+ * pipeline, its ancestors, its descendants, and any pipelines they sync with are done running.
+ * Requesting a pipeline that is already running will run it again once it finishes.
+ */
 inline void exec_request_run(ExecContext &rExec, PipelineId pipeline) noexcept
 {
     rExec.plRequestRun.set(std::size_t(pipeline));
@@ -237,6 +163,30 @@ void exec_update(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec)
 
 void complete_task(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, TaskId task, TaskActions actions) noexcept;
 
+/**
+ * @brief Take the highest priority task in tasksQueuedRun that isn't already taken
+ *
+ * Tasks stay in tasksQueuedRun until they're completed with complete_task. Without priorities
+ * (see exec_set_priorities), tasks are taken lowest ID first.
+ *
+ * @return Null TaskId if all tasks in tasksQueuedRun are already taken
+ */
+TaskId exec_pop_ready(ExecContext &rExec) noexcept;
+
+/**
+ * @brief Give back a task taken by exec_pop_ready that can't run yet
+ */
+void exec_push_ready(ExecContext &rExec, TaskId task) noexcept;
+
+/**
+ * @brief Set the order that exec_pop_ready takes tasks in
+ *
+ * Tasks are ordered by Tasks::m_taskPriority, then by critical path.
+ *
+ * @param critPathNs [in] Critical path of each task, see task_critical_paths. Can be empty
+ */
+void exec_set_priorities(Tasks const& tasks, ArrayView<uint64_t const> critPathNs, ExecContext &rExec);
+
 
 
 } // namespace osp
@@ -0,0 +1,177 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "profiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <type_traits>
+#include <variant>
+
+namespace osp
+{
+
+void histogram_add(RollingHistogram &rHist, uint64_t const durationNs) noexcept
+{
+    auto const bucket_of = [] (uint64_t const ns) noexcept -> std::size_t
+    {
+        return std::min<std::size_t>(std::bit_width(ns), RollingHistogram::smc_buckets - 1);
+    };
+
+    if (rHist.count == RollingHistogram::smc_window)
+    {
+        // Window is full, evict the oldest sample
+        uint64_t const oldest = rHist.samplesNs[rHist.next];
+        -- rHist.buckets[bucket_of(oldest)];
+        rHist.sumNs -= oldest;
+    }
+    else
+    {
+        ++ rHist.count;
+    }
+
+    rHist.samplesNs[rHist.next] = durationNs;
+    ++ rHist.buckets[bucket_of(durationNs)];
+    rHist.sumNs += durationNs;
+
+    rHist.next = (rHist.next + 1) % RollingHistogram::smc_window;
+}
+
+uint64_t histogram_percentile_ns(RollingHistogram const& hist, float const fraction) noexcept
+{
+    if (hist.count == 0)
+    {
+        return 0;
+    }
+
+    auto const target = std::max<uint32_t>(1, uint32_t(float(hist.count) * std::clamp(fraction, 0.0f, 1.0f) + 0.5f));
+
+    uint32_t total = 0;
+    for (std::size_t i = 0; i < RollingHistogram::smc_buckets; ++i)
+    {
+        total += hist.buckets[i];
+        if (total >= target)
+        {
+            return (i == 0) ? 0 : (uint64_t(1) << i);
+        }
+    }
+
+    return uint64_t(1) << (RollingHistogram::smc_buckets - 1);
+}
+
+void profiler_start_capture(Tasks const& tasks, TaskProfiler &rProf)
+{
+    std::size_t const maxPipelines = tasks.m_pipelineIds.capacity();
+
+    rProf.taskTimes     .resize(tasks.m_taskIds.capacity());
+    rProf.plStage       .assign(maxPipelines, lgrn::id_null<StageId>());
+    rProf.plStageStart  .assign(maxPipelines, {});
+    rProf.taskRuns      .clear();
+    rProf.stageRuns     .clear();
+    rProf.captureStart  = ProfileClock_t::now();
+    rProf.capturing     = true;
+}
+
+void profiler_stop_capture(TaskProfiler &rProf)
+{
+    ProfileClock_t::time_point const now = ProfileClock_t::now();
+
+    // Close stages that are still running
+    for (std::size_t plInt = 0; plInt < rProf.plStage.size(); ++plInt)
+    {
+        auto const  pipeline    = PipelineId(plInt);
+        StageId     &rStage     = rProf.plStage[pipeline];
+        if (rStage != lgrn::id_null<StageId>())
+        {
+            rProf.stageRuns.push_back({pipeline, rStage, rProf.plStageStart[pipeline], now});
+            rStage = lgrn::id_null<StageId>();
+        }
+    }
+
+    rProf.capturing = false;
+}
+
+void profiler_record_task(TaskProfiler &rProf, TaskId const task, uint32_t const worker, ProfileClock_t::time_point const start, ProfileClock_t::time_point const end)
+{
+    if (std::size_t(task) >= rProf.taskTimes.size())
+    {
+        rProf.taskTimes.resize(std::size_t(task) + 1);
+    }
+
+    auto const durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    histogram_add(rProf.taskTimes[task], uint64_t(std::max<decltype(durationNs)>(durationNs, 0)));
+
+    if (rProf.capturing)
+    {
+        rProf.taskRuns.push_back({task, worker, start, end});
+    }
+}
+
+void profiler_read_log(TaskProfiler &rProf, ArrayView<ExecLogRecord const> const records, ProfileClock_t::time_point const now)
+{
+    if ( ! rProf.capturing )
+    {
+        return;
+    }
+
+    auto const end_stage = [&rProf, now] (PipelineId const pipeline)
+    {
+        if (std::size_t(pipeline) >= rProf.plStage.size())
+        {
+            // Pipeline created after capture started
+            rProf.plStage       .resize(std::size_t(pipeline) + 1, lgrn::id_null<StageId>());
+            rProf.plStageStart  .resize(std::size_t(pipeline) + 1);
+        }
+
+        StageId &rStage = rProf.plStage[pipeline];
+        if (rStage != lgrn::id_null<StageId>())
+        {
+            rProf.stageRuns.push_back({pipeline, rStage, rProf.plStageStart[pipeline], now});
+            rStage = lgrn::id_null<StageId>();
+        }
+    };
+
+    for (ExecLogRecord const& record : records)
+    {
+        std::visit([&rProf, &end_stage, now] (auto const& msg)
+        {
+            using MSG_T = std::decay_t<decltype(msg)>;
+
+            if constexpr (std::is_same_v<MSG_T, ExecLog::StageChange>)
+            {
+                // Loops restart without a StageChange to null, so don't rely on msg.stageOld
+                end_stage(msg.pipeline);
+                rProf.plStage[msg.pipeline]      = msg.stageNew;
+                rProf.plStageStart[msg.pipeline] = now;
+            }
+            else if constexpr (   std::is_same_v<MSG_T, ExecLog::PipelineFinish>
+                               || std::is_same_v<MSG_T, ExecLog::PipelineLoopFinish>)
+            {
+                end_stage(msg.pipeline);
+            }
+        }, exec_log_decode(record));
+    }
+}
+
+} // namespace osp
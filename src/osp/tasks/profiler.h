@@ -0,0 +1,139 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "exec_log.h"
+#include "tasks.h"
+
+#include "../core/keyed_vector.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace osp
+{
+
+using ProfileClock_t = std::chrono::steady_clock;
+
+/**
+ * @brief Durations of the most recent runs of something, bucketed by powers of two
+ *
+ * Bucket i counts durations of [2^(i-1), 2^i) nanoseconds, where bucket 0 is exactly zero.
+ */
+struct RollingHistogram
+{
+    static constexpr std::size_t smc_window     = 128;
+    static constexpr std::size_t smc_buckets    = 40;
+
+    std::array<uint64_t, smc_window>    samplesNs   {};
+    std::array<uint32_t, smc_buckets>   buckets     {};
+    uint64_t                            sumNs       {0};
+    uint32_t                            next        {0};
+    uint32_t                            count       {0};
+};
+
+void histogram_add(RollingHistogram &rHist, uint64_t durationNs) noexcept;
+
+inline uint64_t histogram_mean_ns(RollingHistogram const& hist) noexcept
+{
+    return (hist.count != 0) ? (hist.sumNs / hist.count) : 0;
+}
+
+/**
+ * @brief Estimate a percentile of recent durations
+ *
+ * @param fraction [in] 0.5 for median, 0.95 for 95th percentile, etc...
+ *
+ * @return Upper bound of the bucket the percentile falls in
+ */
+uint64_t histogram_percentile_ns(RollingHistogram const& hist, float fraction) noexcept;
+
+/**
+ * @brief Records task run times and pipeline stage changes, for finding what takes up time
+ *
+ * Not thread-safe. Executors are expected to time tasks on whichever thread they run on, but only
+ * call profiler_* functions from the thread that owns the ExecContext.
+ */
+struct TaskProfiler
+{
+    struct TaskRun
+    {
+        TaskId                      task;
+        uint32_t                    worker;
+        ProfileClock_t::time_point  start;
+        ProfileClock_t::time_point  end;
+    };
+
+    struct StageRun
+    {
+        PipelineId                  pipeline;
+        StageId                     stage;
+        ProfileClock_t::time_point  start;
+        ProfileClock_t::time_point  end;
+    };
+
+    /// Recent run times of each task, kept between captures
+    KeyedVec<TaskId, RollingHistogram>              taskTimes;
+
+    // Timelines, only recorded while capturing
+    std::vector<TaskRun>                            taskRuns;
+    std::vector<StageRun>                           stageRuns;
+
+    // Stage each pipeline is currently on, as seen through ExecLog
+    KeyedVec<PipelineId, StageId>                   plStage;
+    KeyedVec<PipelineId, ProfileClock_t::time_point> plStageStart;
+
+    ProfileClock_t::time_point                      captureStart;
+
+    bool                                            capturing   {false};
+};
+
+/**
+ * @brief Clear previous timelines and start recording new ones
+ *
+ * Also requires ExecLog::doLogging to be enabled, as stage changes are read from the log.
+ */
+void profiler_start_capture(Tasks const& tasks, TaskProfiler &rProf);
+
+void profiler_stop_capture(TaskProfiler &rProf);
+
+/**
+ * @brief Record that a task ran from start to end
+ *
+ * @param worker [in] Index of the thread the task ran on, see WorkerContext::m_workerIndex
+ */
+void profiler_record_task(TaskProfiler &rProf, TaskId task, uint32_t worker, ProfileClock_t::time_point start, ProfileClock_t::time_point end);
+
+/**
+ * @brief Read stage changes from ExecLog records, call after each exec_update
+ *
+ * @param records [in] Records drained from ExecLog::logRing since the last call
+ * @param now     [in] Time to assign to stage changes, usually right after exec_update returns
+ */
+void profiler_read_log(TaskProfiler &rProf, ArrayView<ExecLogRecord const> records, ProfileClock_t::time_point now);
+
+} // namespace osp
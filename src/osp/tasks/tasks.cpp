@@ -26,7 +26,9 @@
 
 #include "../core/bitvector.h"
 
+#include <algorithm>
 #include <array>
+#include <vector>
 
 namespace osp
 {
@@ -35,6 +37,7 @@ struct TaskCounts
 {
     uint16_t requiresStages     {0};
     uint16_t requiredByStages   {0};
+    uint16_t acquires           {0};
 };
 
 struct StageCounts
@@ -49,11 +52,173 @@ struct PipelineCounts
     std::array<StageCounts, gc_maxStages> stageCounts;
 
     uint8_t  stages             { 0 };
+};
 
+struct PipelineTreeLinks
+{
     PipelineId firstChild       { lgrn::id_null<PipelineId>() };
     PipelineId sibling          { lgrn::id_null<PipelineId>() };
 };
 
+/**
+ * @brief Build the pipeline tree and loop scopes of a TaskGraph from Tasks::m_pipelineParents
+ *
+ * Only depends on pipelines and their parents, so this is shared by make_exec_graph and
+ * update_exec_graph.
+ */
+static void make_pipeline_tree(Tasks const& tasks, TaskGraph &rOut)
+{
+    std::size_t const maxPipelines = tasks.m_pipelineIds.capacity();
+
+    KeyedVec<PipelineId, PipelineTreeLinks> plLinks;
+    BitVector_t                             plInTree;
+
+    plLinks.resize(maxPipelines);
+    bitvector_resize(plInTree, maxPipelines);
+
+    // Map out children and siblings in tree
+
+    for (PipelineInt const childPlInt : tasks.m_pipelineIds.bitview().zeros())
+    {
+        PipelineId const child  = PipelineId(childPlInt);
+        PipelineId const parent = tasks.m_pipelineParents[child];
+
+        if (parent != lgrn::id_null<PipelineId>())
+        {
+            plInTree.set(std::size_t(parent));
+            plInTree.set(std::size_t(child));
+
+            PipelineTreeLinks &rChildLinks  = plLinks[child];
+            PipelineTreeLinks &rParentLinks = plLinks[parent];
+
+            if (rParentLinks.firstChild != lgrn::id_null<PipelineId>())
+            {
+                rChildLinks.sibling = rParentLinks.firstChild;
+            }
+
+            rParentLinks.firstChild = child;
+        }
+    }
+
+    std::size_t const treeSize = plInTree.count();
+
+    rOut.pltreeDescendantCounts  .assign(treeSize,      0);
+    rOut.pltreeToPipeline        .assign(treeSize,      lgrn::id_null<PipelineId>());
+    rOut.pipelineToPltree        .assign(maxPipelines,  lgrn::id_null<PipelineTreePos_t>());
+    rOut.pipelineToLoopScope     .assign(maxPipelines,  lgrn::id_null<PipelineTreePos_t>());
+    rOut.pipelineToLoopScopeRange.assign(maxPipelines,  {});
+
+    // Build Pipeline Tree
+
+    auto const add_subtree = [&] (auto const& self, PipelineId const root, PipelineId const firstChild, PipelineTreePos_t const loopScope, PipelineTreePos_t const pos) -> uint32_t
+    {
+        bool const        rootLoops    = tasks.m_pipelineControl[root].isLoopScope;
+        PipelineTreePos_t newLoopScope = rootLoops ? pos : loopScope;
+
+        rOut.pltreeToPipeline[pos]     = root;
+        rOut.pipelineToPltree[root]    = pos;
+        rOut.pipelineToLoopScope[root] = newLoopScope;
+
+        uint32_t descendantCount = 0;
+
+        PipelineId child = firstChild;
+
+        PipelineTreePos_t childPos = pos + 1;
+
+        while (child != lgrn::id_null<PipelineId>())
+        {
+            PipelineTreeLinks const& rChildLinks = plLinks[child];
+
+            uint32_t const childDescendantCount = self(self, child, rChildLinks.firstChild, newLoopScope, childPos);
+            descendantCount += 1 + childDescendantCount;
+
+            child = rChildLinks.sibling;
+            childPos += 1 + childDescendantCount;
+        }
+
+        rOut.pltreeDescendantCounts[pos] = descendantCount;
+
+        return descendantCount;
+    };
+
+    PipelineTreePos_t rootPos = 0;
+
+    for (PipelineInt const pipelineInt : tasks.m_pipelineIds.bitview().zeros())
+    {
+        auto const pipeline = PipelineId(pipelineInt);
+        if ( ! plInTree.test(pipelineInt) || tasks.m_pipelineParents[pipeline] != lgrn::id_null<PipelineId>())
+        {
+            continue; // Not in tree or not a root
+        }
+
+        // For each root pipeline
+
+        uint32_t const rootDescendantCount = add_subtree(add_subtree, pipeline, plLinks[pipeline].firstChild, lgrn::id_null<PipelineTreePos_t>(), rootPos);
+
+        rootPos += 1 + rootDescendantCount;
+    }
+
+    // Loop scope ranges, requires descendant counts from the completed tree
+
+    for (PipelineTreePos_t pos = 0; pos < rootPos; ++pos)
+    {
+        PipelineId const        pipeline    = rOut.pltreeToPipeline[pos];
+        PipelineTreePos_t const scopePos    = rOut.pipelineToLoopScope[pipeline];
+
+        if (scopePos != lgrn::id_null<PipelineTreePos_t>())
+        {
+            rOut.pipelineToLoopScopeRange[pipeline] = {
+                .first      = scopePos,
+                .last       = scopePos + 1 + rOut.pltreeDescendantCounts[scopePos],
+                .pipeline   = rOut.pltreeToPipeline[scopePos] };
+        }
+    }
+}
+
+
+/**
+ * @brief Rebuild a one-to-many fanout from entries given by a callback
+ *
+ * for_each_entry(emit) is called twice, once to count and once to push, and must call
+ * emit(key, value) for the same entries both times. The previous contents of rFirst and rData
+ * are only replaced at the end, so for_each_entry can still read from them.
+ */
+template <typename KEY_T, typename VALUE_T, typename DATA_T, typename FOREACH_T>
+static void fanout_rebuild(KeyedVec<KEY_T, VALUE_T> &rFirst, KeyedVec<VALUE_T, DATA_T> &rData, std::size_t const keyCount, FOREACH_T &&for_each_entry)
+{
+    using value_int_t = lgrn::underlying_int_type_t<VALUE_T>;
+
+    KeyedVec<KEY_T, value_int_t>    counts;
+    KeyedVec<KEY_T, VALUE_T>        first;
+    KeyedVec<VALUE_T, DATA_T>       data;
+
+    counts.resize(keyCount+1, 0);
+    first .resize(keyCount+1);
+
+    std::size_t total = 0;
+
+    for_each_entry([&counts, &total] (KEY_T const key, DATA_T const&)
+    {
+        ++ counts[key];
+        ++ total;
+    });
+
+    data.resize(total);
+
+    fanout_partition(
+        first,
+        [&counts] (KEY_T key) { return counts[key]; },
+        [] (KEY_T, VALUE_T) { });
+
+    for_each_entry([&counts, &first, &data] (KEY_T const key, DATA_T const& value)
+    {
+        data[id_from_count(first, key, counts[key])] = value;
+        -- counts[key];
+    });
+
+    rFirst = std::move(first);
+    rData  = std::move(data);
+}
 
 TaskGraph make_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const> const data)
 {
@@ -61,18 +226,20 @@ TaskGraph make_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const>
 
     std::size_t const maxPipelines  = tasks.m_pipelineIds.capacity();
     std::size_t const maxTasks      = tasks.m_taskIds.capacity();
+    std::size_t const maxSemas      = tasks.m_semaIds.capacity();
 
     KeyedVec<PipelineId, PipelineCounts>    plCounts;
     KeyedVec<TaskId, TaskCounts>            taskCounts;
-    BitVector_t                             plInTree;
+    KeyedVec<SemaphoreId, uint32_t>         semaCounts;
 
     out.pipelineToFirstAnystg .resize(maxPipelines);
-    bitvector_resize(plInTree, maxPipelines);
     plCounts        .resize(maxPipelines+1);
     taskCounts      .resize(maxTasks+1);
+    semaCounts      .resize(maxSemas+1);
 
     std::size_t totalTasksReqStage  = 0;
     std::size_t totalStageReqTasks  = 0;
+    std::size_t totalAcquires       = 0;
     std::size_t totalRunTasks       = 0;
     std::size_t totalStages         = 0;
 
@@ -139,32 +306,22 @@ TaskGraph make_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const>
         totalStageReqTasks += pEdges->m_syncWith.size();
     }
 
-    // 3. Map out children and siblings in tree
+    // 3. Count semaphore acquires
 
-    for (PipelineInt const childPlInt : tasks.m_pipelineIds.bitview().zeros())
+    for (TaskEdges const* pEdges : data)
     {
-        PipelineId const child  = PipelineId(childPlInt);
-        PipelineId const parent = tasks.m_pipelineParents[child];
-
-        if (parent != lgrn::id_null<PipelineId>())
+        for (auto const [task, semaphore, units] : pEdges->m_semaphoreEdges)
         {
-            plInTree.set(std::size_t(parent));
-            plInTree.set(std::size_t(child));
-
-            PipelineCounts &rChildCounts  = plCounts[child];
-            PipelineCounts &rParentCounts = plCounts[parent];
+            LGRN_ASSERTMV(units != 0 && units <= tasks.m_semaLimits[semaphore],
+                          "Tasks must acquire between 1 and the semaphore's limit, or it would never run",
+                          TaskInt(task), SemaphoreInt(semaphore), units, tasks.m_semaLimits[semaphore]);
 
-            if (rParentCounts.firstChild != lgrn::id_null<PipelineId>())
-            {
-                rChildCounts.sibling = rParentCounts.firstChild;
-            }
-
-            rParentCounts.firstChild = child;
+            ++ taskCounts[task].acquires;
+            ++ semaCounts[semaphore];
         }
+        totalAcquires += pEdges->m_semaphoreEdges.size();
     }
 
-    std::size_t const treeSize = plInTree.count();
-
     // 4. Allocate
 
     // The +1 is needed for 1-to-many connections to store the total number of other elements they
@@ -182,10 +339,10 @@ TaskGraph make_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const>
     out.taskreqstgData              .resize(totalTasksReqStage, {});
     out.anystgToFirstRevTaskreqstg  .resize(totalStages+1,      lgrn::id_null<ReverseTaskReqStageId>());
     out.revTaskreqstgToTask         .resize(totalTasksReqStage, lgrn::id_null<TaskId>());
-    out.pltreeDescendantCounts      .resize(treeSize,           0);
-    out.pltreeToPipeline            .resize(treeSize,           lgrn::id_null<PipelineId>());
-    out.pipelineToPltree            .resize(maxPipelines,       lgrn::id_null<PipelineTreePos_t>());
-    out.pipelineToLoopScope         .resize(maxPipelines,       lgrn::id_null<PipelineTreePos_t>());
+    out.taskToFirstAcquire          .resize(maxTasks+1,         lgrn::id_null<TaskAcquireId>());
+    out.taskAcquire                 .resize(totalAcquires,      {});
+    out.semaToFirstAcquiredBy       .resize(maxSemas+1,         lgrn::id_null<SemaAcquiredById>());
+    out.semaAcquiredBy              .resize(totalAcquires,      lgrn::id_null<TaskId>());
 
     // 5. Calculate one-to-many partitions
 
@@ -244,6 +401,15 @@ TaskGraph make_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const>
         },
         [&out] (AnyStageId, ReverseTaskReqStageId) { });
 
+    fanout_partition(
+        out.taskToFirstAcquire,
+        [&taskCounts] (TaskId task)                     { return taskCounts[task].acquires; },
+        [] (TaskId, TaskAcquireId) { });
+    fanout_partition(
+        out.semaToFirstAcquiredBy,
+        [&semaCounts] (SemaphoreId sema)                { return semaCounts[sema]; },
+        [] (SemaphoreId, SemaAcquiredById) { });
+
     // 6. Push
 
     for (TaskInt const taskInt : tasks.m_taskIds.bitview().zeros())
@@ -302,11 +468,28 @@ TaskGraph make_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const>
         }
     }
 
+    for (TaskEdges const* pEdges : data)
+    {
+        for (auto const [task, semaphore, units] : pEdges->m_semaphoreEdges)
+        {
+            TaskAcquireId const     acquireId   = id_from_count(out.taskToFirstAcquire, task, taskCounts[task].acquires);
+            SemaAcquiredById const  acqById     = id_from_count(out.semaToFirstAcquiredBy, semaphore, semaCounts[semaphore]);
+
+            out.taskAcquire[acquireId]  = { .semaphore = semaphore, .units = units };
+            out.semaAcquiredBy[acqById] = task;
+
+            -- taskCounts[task].acquires;
+            -- semaCounts[semaphore];
+            -- totalAcquires;
+        }
+    }
+
     // NOLINTBEGIN(readability-use-anyofallof)
     [[maybe_unused]] auto const all_counts_zero = [&] ()
     {
         if (   totalStageReqTasks   != 0
-            || totalTasksReqStage   != 0 )
+            || totalTasksReqStage   != 0
+            || totalAcquires        != 0 )
         {
             return false;
         }
@@ -324,7 +507,15 @@ TaskGraph make_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const>
         for (TaskCounts const& taskCount : taskCounts)
         {
             if (   taskCount.requiredByStages != 0
-                || taskCount.requiresStages != 0 )
+                || taskCount.requiresStages != 0
+                || taskCount.acquires != 0 )
+            {
+                return false;
+            }
+        }
+        for (uint32_t const semaCount : semaCounts)
+        {
+            if (semaCount != 0)
             {
                 return false;
             }
@@ -339,58 +530,543 @@ TaskGraph make_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const>
 
     // 7. Build Pipeline Tree
 
-    auto const add_subtree = [&] (auto const& self, PipelineId const root, PipelineId const firstChild, PipelineTreePos_t const loopScope, PipelineTreePos_t const pos) -> uint32_t
+    make_pipeline_tree(tasks, out);
+
+    return out;
+}
+
+void update_exec_graph(Tasks const& tasks, TaskGraph &rGraph, ArrayView<TaskEdges const* const> const added)
+{
+    std::size_t const maxPipelines  = tasks.m_pipelineIds.capacity();
+    std::size_t const maxTasks      = tasks.m_taskIds.capacity();
+    std::size_t const maxSemas      = tasks.m_semaIds.capacity();
+
+    // Key counts of the previous graph. All of its arrays are empty if it was default constructed
+    auto const prev_key_count = [] (auto const& firstVec) -> std::size_t
     {
-        bool const        rootLoops    = tasks.m_pipelineControl[root].isLoopScope;
-        PipelineTreePos_t newLoopScope = rootLoops ? pos : loopScope;
+        return firstVec.empty() ? 0 : firstVec.size() - 1;
+    };
+    std::size_t const prevPipelines = prev_key_count(rGraph.pipelineToFirstAnystg);
+    std::size_t const prevStages    = prev_key_count(rGraph.anystgToPipeline);
+    std::size_t const prevTasks     = prev_key_count(rGraph.taskToFirstTaskreqstg);
+    std::size_t const prevSemas     = prev_key_count(rGraph.semaToFirstAcquiredBy);
 
-        out.pltreeToPipeline[pos]     = root;
-        out.pipelineToPltree[root]    = pos;
-        out.pipelineToLoopScope[root] = newLoopScope;
+    LGRN_ASSERTMV(prevPipelines <= maxPipelines && prevTasks <= maxTasks && prevSemas <= maxSemas,
+                  "ID registries never shrink, so the graph can't have more IDs than the Tasks",
+                  prevPipelines, maxPipelines, prevTasks, maxTasks, prevSemas, maxSemas);
 
-        uint32_t descendantCount = 0;
+    auto const task_exists = [&tasks] (TaskId const task) noexcept
+    {
+        return tasks.m_taskIds.exists(task);
+    };
+    auto const pipeline_exists = [&tasks] (PipelineId const pipeline) noexcept
+    {
+        return tasks.m_pipelineIds.exists(pipeline);
+    };
+    auto const sema_exists = [&tasks] (SemaphoreId const semaphore) noexcept
+    {
+        return tasks.m_semaIds.exists(semaphore);
+    };
 
-        PipelineId child = firstChild;
+    // 1. Find tasks that aren't in the graph yet
 
-        PipelineTreePos_t childPos = pos + 1;
+    BitVector_t tasksInGraph;
+    bitvector_resize(tasksInGraph, maxTasks);
 
-        while (child != lgrn::id_null<PipelineId>())
+    for (TaskId const task : rGraph.runtaskToTask)
+    {
+        tasksInGraph.set(std::size_t(task));
+    }
+
+    // 2. Count stages. Remaining stages of existing pipelines may shrink if their last stages are
+    //    no longer used by any task, same as if the graph was made from scratch.
+
+    KeyedVec<PipelineId, uint8_t> plStages;
+    plStages.resize(maxPipelines+1, 0);
+
+    auto const count_stage = [&plStages] (PipelineId const pipeline, StageId const stage)
+    {
+        uint8_t &rStageCount = plStages[pipeline];
+        rStageCount = std::max(rStageCount, uint8_t(uint8_t(stage) + 1));
+    };
+
+    for (PipelineInt const plInt : tasks.m_pipelineIds.bitview().zeros())
+    {
+        plStages[PipelineId(plInt)] = 1;
+    }
+
+    for (uint32_t stgInt = 0; stgInt < prevStages; ++stgInt)
+    {
+        auto const          anystg      = AnyStageId(stgInt);
+        PipelineId const    pipeline    = rGraph.anystgToPipeline[anystg];
+
+        if ( ! pipeline_exists(pipeline) )
         {
-            PipelineCounts const&   rChildCounts    = plCounts[child];
+            continue;
+        }
 
-            uint32_t const childDescendantCount = self(self, child, rChildCounts.firstChild, newLoopScope, childPos);
-            descendantCount += 1 + childDescendantCount;
+        auto const runTasks = fanout_view(rGraph.anystgToFirstRuntask,    rGraph.runtaskToTask,  anystg);
+        auto const reqTasks = fanout_view(rGraph.anystgToFirstStgreqtask, rGraph.stgreqtaskData, anystg);
 
-            child = rChildCounts.sibling;
-            childPos += 1 + childDescendantCount;
+        bool const used =    std::any_of(runTasks.begin(), runTasks.end(), task_exists)
+                          || std::any_of(reqTasks.begin(), reqTasks.end(),
+                                         [&task_exists] (StageRequiresTask const& req) { return task_exists(req.reqTask); });
+        if (used)
+        {
+            count_stage(pipeline, stage_from(rGraph, pipeline, anystg));
         }
+    }
 
-        out.pltreeDescendantCounts[pos] = descendantCount;
+    for (TaskInt const taskInt : tasks.m_taskIds.bitview().zeros())
+    {
+        if ( ! tasksInGraph.test(taskInt) )
+        {
+            auto const [runPipeline, runStage] = tasks.m_taskRunOn[TaskId(taskInt)];
+            count_stage(runPipeline, runStage);
+        }
+    }
 
-        return descendantCount;
+    for (TaskEdges const* pEdges : added)
+    {
+        for (auto const [task, pipeline, stage] : pEdges->m_syncWith)
+        {
+            count_stage(pipeline, stage);
+        }
+    }
+
+    // 3. Partition stages, and map AnyStageIds of the previous graph to the new ones
+
+    KeyedVec<PipelineId, AnyStageId>    plFirstAnystg;
+    KeyedVec<AnyStageId, PipelineId>    anystgToPipeline;
+    KeyedVec<AnyStageId, AnyStageId>    prevToNewAnystg;
+
+    std::size_t totalStages = 0;
+    for (uint8_t const stageCount : plStages)
+    {
+        totalStages += stageCount;
+    }
+
+    plFirstAnystg   .resize(maxPipelines+1,  lgrn::id_null<AnyStageId>());
+    anystgToPipeline.resize(totalStages+1,   lgrn::id_null<PipelineId>());
+    prevToNewAnystg .resize(prevStages,      lgrn::id_null<AnyStageId>());
+
+    fanout_partition(
+        plFirstAnystg,
+        [&plStages] (PipelineId pl)                             { return plStages[pl]; },
+        [&anystgToPipeline] (PipelineId pl, AnyStageId claimed) { anystgToPipeline[claimed] = pl; });
+
+    auto const new_anystg = [&plFirstAnystg] (PipelineId const pipeline, StageId const stage) noexcept
+    {
+        return AnyStageId(uint32_t(plFirstAnystg[pipeline]) + uint32_t(stage));
     };
 
-    PipelineTreePos_t rootPos = 0;
+    for (uint32_t stgInt = 0; stgInt < prevStages; ++stgInt)
+    {
+        auto const          anystg      = AnyStageId(stgInt);
+        PipelineId const    pipeline    = rGraph.anystgToPipeline[anystg];
 
-    for (PipelineInt const pipelineInt : tasks.m_pipelineIds.bitview().zeros())
+        if (pipeline_exists(pipeline))
+        {
+            StageId const stage = stage_from(rGraph, pipeline, anystg);
+            if (uint8_t(stage) < plStages[pipeline])
+            {
+                prevToNewAnystg[anystg] = new_anystg(pipeline, stage);
+            }
+        }
+    }
+
+    // 4. Rebuild each one-to-many connection from entries that are kept, then entries added
+
+    auto const for_each_kept_stage = [&prevToNewAnystg, prevStages] (auto const& firstVec, auto const& dataVec, auto&& func)
     {
-        auto const pipeline = PipelineId(pipelineInt);
-        if ( ! plInTree.test(pipelineInt) || tasks.m_pipelineParents[pipeline] != lgrn::id_null<PipelineId>())
+        for (uint32_t stgInt = 0; stgInt < prevStages; ++stgInt)
         {
-            continue; // Not in tree or not a root
+            AnyStageId const newStg = prevToNewAnystg[AnyStageId(stgInt)];
+            if (newStg != lgrn::id_null<AnyStageId>())
+            {
+                for (auto const& value : fanout_view(firstVec, dataVec, AnyStageId(stgInt)))
+                {
+                    func(newStg, value);
+                }
+            }
         }
+    };
 
-        // For each root pipeline
+    auto const for_each_kept_task = [&task_exists, prevTasks] (auto const& firstVec, auto const& dataVec, auto&& func)
+    {
+        for (TaskInt taskInt = 0; taskInt < prevTasks; ++taskInt)
+        {
+            if (task_exists(TaskId(taskInt)))
+            {
+                for (auto const& value : fanout_view(firstVec, dataVec, TaskId(taskInt)))
+                {
+                    func(TaskId(taskInt), value);
+                }
+            }
+        }
+    };
+
+    fanout_rebuild(rGraph.anystgToFirstRuntask, rGraph.runtaskToTask, totalStages, [&] (auto const& emit)
+    {
+        for_each_kept_stage(rGraph.anystgToFirstRuntask, rGraph.runtaskToTask, [&] (AnyStageId const stg, TaskId const task)
+        {
+            if (task_exists(task))
+            {
+                emit(stg, task);
+            }
+        });
+        for (TaskInt const taskInt : tasks.m_taskIds.bitview().zeros())
+        {
+            if ( ! tasksInGraph.test(taskInt) )
+            {
+                auto const [runPipeline, runStage] = tasks.m_taskRunOn[TaskId(taskInt)];
+                emit(new_anystg(runPipeline, runStage), TaskId(taskInt));
+            }
+        }
+    });
 
-        PipelineCounts const& rRootCounts = plCounts[pipeline];
+    fanout_rebuild(rGraph.anystgToFirstStgreqtask, rGraph.stgreqtaskData, totalStages, [&] (auto const& emit)
+    {
+        for_each_kept_stage(rGraph.anystgToFirstStgreqtask, rGraph.stgreqtaskData, [&] (AnyStageId const stg, StageRequiresTask req)
+        {
+            if (task_exists(req.reqTask))
+            {
+                req.ownStage = stg;
+                emit(stg, req);
+            }
+        });
+        for (TaskEdges const* pEdges : added)
+        {
+            for (auto const [task, pipeline, stage] : pEdges->m_syncWith)
+            {
+                auto const [taskPipeline, taskStage] = tasks.m_taskRunOn[task];
+                AnyStageId const anystg = new_anystg(pipeline, stage);
 
-        uint32_t const rootDescendantCount = add_subtree(add_subtree, pipeline, rRootCounts.firstChild, lgrn::id_null<PipelineTreePos_t>(), rootPos);
+                emit(anystg, StageRequiresTask{ .ownStage    = anystg,
+                                                .reqTask     = task,
+                                                .reqPipeline = taskPipeline,
+                                                .reqStage    = taskStage });
+            }
+        }
+    });
 
-        rootPos += 1 + rootDescendantCount;
+    fanout_rebuild(rGraph.taskToFirstRevStgreqtask, rGraph.revStgreqtaskToStage, maxTasks, [&] (auto const& emit)
+    {
+        for_each_kept_task(rGraph.taskToFirstRevStgreqtask, rGraph.revStgreqtaskToStage, [&] (TaskId const task, AnyStageId const stg)
+        {
+            AnyStageId const newStg = prevToNewAnystg[stg];
+            if (newStg != lgrn::id_null<AnyStageId>())
+            {
+                emit(task, newStg);
+            }
+        });
+        for (TaskEdges const* pEdges : added)
+        {
+            for (auto const [task, pipeline, stage] : pEdges->m_syncWith)
+            {
+                emit(task, new_anystg(pipeline, stage));
+            }
+        }
+    });
+
+    fanout_rebuild(rGraph.taskToFirstTaskreqstg, rGraph.taskreqstgData, maxTasks, [&] (auto const& emit)
+    {
+        for_each_kept_task(rGraph.taskToFirstTaskreqstg, rGraph.taskreqstgData, [&] (TaskId const task, TaskRequiresStage const& req)
+        {
+            if (pipeline_exists(req.reqPipeline))
+            {
+                emit(task, req);
+            }
+        });
+        for (TaskEdges const* pEdges : added)
+        {
+            for (auto const [task, pipeline, stage] : pEdges->m_syncWith)
+            {
+                emit(task, TaskRequiresStage{ .ownTask     = task,
+                                              .reqPipeline = pipeline,
+                                              .reqStage    = stage });
+            }
+        }
+    });
+
+    fanout_rebuild(rGraph.anystgToFirstRevTaskreqstg, rGraph.revTaskreqstgToTask, totalStages, [&] (auto const& emit)
+    {
+        for_each_kept_stage(rGraph.anystgToFirstRevTaskreqstg, rGraph.revTaskreqstgToTask, [&] (AnyStageId const stg, TaskId const task)
+        {
+            if (task_exists(task))
+            {
+                emit(stg, task);
+            }
+        });
+        for (TaskEdges const* pEdges : added)
+        {
+            for (auto const [task, pipeline, stage] : pEdges->m_syncWith)
+            {
+                emit(new_anystg(pipeline, stage), task);
+            }
+        }
+    });
+
+    fanout_rebuild(rGraph.taskToFirstAcquire, rGraph.taskAcquire, maxTasks, [&] (auto const& emit)
+    {
+        for_each_kept_task(rGraph.taskToFirstAcquire, rGraph.taskAcquire, [&] (TaskId const task, TaskAcquire const& acquire)
+        {
+            if (sema_exists(acquire.semaphore))
+            {
+                emit(task, acquire);
+            }
+        });
+        for (TaskEdges const* pEdges : added)
+        {
+            for (auto const [task, semaphore, units] : pEdges->m_semaphoreEdges)
+            {
+                LGRN_ASSERTMV(units != 0 && units <= tasks.m_semaLimits[semaphore],
+                              "Tasks must acquire between 1 and the semaphore's limit, or it would never run",
+                              TaskInt(task), SemaphoreInt(semaphore), units, tasks.m_semaLimits[semaphore]);
+
+                emit(task, TaskAcquire{ .semaphore = semaphore, .units = units });
+            }
+        }
+    });
+
+    fanout_rebuild(rGraph.semaToFirstAcquiredBy, rGraph.semaAcquiredBy, maxSemas, [&] (auto const& emit)
+    {
+        for (SemaphoreInt semaInt = 0; semaInt < prevSemas; ++semaInt)
+        {
+            if (sema_exists(SemaphoreId(semaInt)))
+            {
+                for (TaskId const task : fanout_view(rGraph.semaToFirstAcquiredBy, rGraph.semaAcquiredBy, SemaphoreId(semaInt)))
+                {
+                    if (task_exists(task))
+                    {
+                        emit(SemaphoreId(semaInt), task);
+                    }
+                }
+            }
+        }
+        for (TaskEdges const* pEdges : added)
+        {
+            for (auto const [task, semaphore, units] : pEdges->m_semaphoreEdges)
+            {
+                emit(semaphore, task);
+            }
+        }
+    });
+
+    rGraph.pipelineToFirstAnystg = std::move(plFirstAnystg);
+    rGraph.anystgToPipeline      = std::move(anystgToPipeline);
+
+    // 5. Pipeline tree only depends on pipeline parents, and is cheap to make from scratch
+
+    make_pipeline_tree(tasks, rGraph);
+}
+
+void find_tasks_after(Tasks const& tasks, TaskGraph const& graph, TaskId const task, BitVector_t &rTasksAfterOut)
+{
+    bitvector_resize(rTasksAfterOut, tasks.m_taskIds.capacity());
+    rTasksAfterOut.reset();
+
+    // Stages that can only end after 'task' completes
+    BitVector_t stagesAfter;
+    bitvector_resize(stagesAfter, graph.anystgToPipeline.size());
+
+    std::vector<AnyStageId> stageStack;
+
+    auto const add_stage = [&stagesAfter, &stageStack] (AnyStageId const anystg)
+    {
+        if ( ! stagesAfter.test(std::size_t(anystg)) )
+        {
+            stagesAfter.set(std::size_t(anystg));
+            stageStack.push_back(anystg);
+        }
+    };
+
+    // Stages that a task runs on or syncs with can't end until the task completes
+    auto const add_task_stages = [&tasks, &graph, &add_stage] (TaskId const visit)
+    {
+        auto const [runPipeline, runStage] = tasks.m_taskRunOn[visit];
+        add_stage(anystg_from(graph, runPipeline, runStage));
+
+        for (TaskRequiresStage const& req : fanout_view(graph.taskToFirstTaskreqstg, graph.taskreqstgData, visit))
+        {
+            add_stage(anystg_from(graph, req.reqPipeline, req.reqStage));
+        }
+    };
+
+    auto const add_task = [&rTasksAfterOut, &add_task_stages] (TaskId const visit)
+    {
+        if ( ! rTasksAfterOut.test(std::size_t(visit)) )
+        {
+            rTasksAfterOut.set(std::size_t(visit));
+            add_task_stages(visit);
+        }
+    };
+
+    add_task_stages(task);
+
+    while ( ! stageStack.empty() )
+    {
+        AnyStageId const ended = stageStack.back();
+        stageStack.pop_back();
+
+        PipelineId const pipeline   = graph.anystgToPipeline[ended];
+        auto const       stageCount = fanout_size(graph.pipelineToFirstAnystg, pipeline);
+
+        if (uint32_t(stage_from(graph, pipeline, ended)) + 1 >= stageCount)
+        {
+            continue; // Last stage. Pipeline finishes or loops back to the start
+        }
+
+        // Next stage starts after this one ends, along with all tasks that require it
+        auto const next = AnyStageId(uint32_t(ended) + 1);
+
+        add_stage(next);
+
+        for (TaskId const runTask : fanout_view(graph.anystgToFirstRuntask, graph.runtaskToTask, next))
+        {
+            add_task(runTask);
+        }
+
+        for (TaskId const syncTask : fanout_view(graph.anystgToFirstRevTaskreqstg, graph.revTaskreqstgToTask, next))
+        {
+            add_task(syncTask);
+        }
     }
 
-    return out;
+    // Only reachable through a dependency cycle, which would deadlock if ever run
+    rTasksAfterOut.reset(std::size_t(task));
 }
 
-} // namespace osp
+void task_critical_paths(Tasks const& tasks, TaskGraph const& graph, ArrayView<uint64_t const> const durationsNs, KeyedVec<TaskId, uint64_t> &rCritPathNsOut)
+{
+    // A task's critical path is its own duration, plus the longest path from any of the stages it
+    // runs on or syncs with. These stages can't end until the task completes, and the path from a
+    // stage is the longest of the next stage's path and its tasks' critical paths.
+    //
+    // Tasks and stages are visited depth-first with an explicit stack, and each is calculated
+    // after everything it depends on (reverse topological order). Pipeline trees can be very
+    // deep, so this doesn't recurse.
+
+    enum class EVisit : uint8_t { New, Visiting, Done };
+
+    std::size_t const maxTasks  = tasks.m_taskIds.capacity();
+    std::size_t const stages    = graph.anystgToPipeline.size();
+
+    // Tasks and stages share one index space: tasks first, then stages
+    using NodeInt_t = uint32_t;
+    auto const task_node  = [] (TaskId const task) -> NodeInt_t { return NodeInt_t(task); };
+    auto const stage_node = [maxTasks] (AnyStageId const anystg) -> NodeInt_t { return NodeInt_t(maxTasks + std::size_t(anystg)); };
+
+    std::vector<EVisit>     visit   (maxTasks + stages, EVisit::New);
+    std::vector<uint64_t>   pathNs  (maxTasks + stages, 0);
+
+    // Calls func(NodeInt_t) for each task or stage that a node's path is calculated from
+    auto const for_each_after = [&] (NodeInt_t const node, auto&& func)
+    {
+        if (node < maxTasks)
+        {
+            auto const task = TaskId(node);
+            auto const [runPipeline, runStage] = tasks.m_taskRunOn[task];
+
+            func(stage_node(anystg_from(graph, runPipeline, runStage)));
 
+            for (TaskRequiresStage const& req : fanout_view(graph.taskToFirstTaskreqstg, graph.taskreqstgData, task))
+            {
+                func(stage_node(anystg_from(graph, req.reqPipeline, req.reqStage)));
+            }
+            return;
+        }
+
+        auto const       anystg     = AnyStageId(node - maxTasks);
+        PipelineId const pipeline   = graph.anystgToPipeline[anystg];
+        auto const       stageCount = fanout_size(graph.pipelineToFirstAnystg, pipeline);
+
+        // Last stage has nothing after it within a single run
+        if (uint32_t(stage_from(graph, pipeline, anystg)) + 1 >= stageCount)
+        {
+            return;
+        }
+
+        auto const next = AnyStageId(uint32_t(anystg) + 1);
+
+        func(stage_node(next));
+
+        for (TaskId const runTask : fanout_view(graph.anystgToFirstRuntask, graph.runtaskToTask, next))
+        {
+            func(task_node(runTask));
+        }
+
+        for (TaskId const syncTask : fanout_view(graph.anystgToFirstRevTaskreqstg, graph.revTaskreqstgToTask, next))
+        {
+            func(task_node(syncTask));
+        }
+    };
+
+    // Each node is pushed once to expand it, then again to calculate it once everything pushed
+    // above it is done
+    struct StackItem
+    {
+        NodeInt_t   node;
+        bool        expanded;
+    };
+    std::vector<StackItem> stack;
+
+    for (TaskInt const taskInt : tasks.m_taskIds.bitview().zeros())
+    {
+        stack.push_back({task_node(TaskId(taskInt)), false});
+
+        while ( ! stack.empty() )
+        {
+            StackItem const item = stack.back();
+            stack.pop_back();
+
+            if ( ! item.expanded )
+            {
+                if (visit[item.node] != EVisit::New)
+                {
+                    continue; // Already reached through another path
+                }
+
+                visit[item.node] = EVisit::Visiting;
+                stack.push_back({item.node, true});
+
+                for_each_after(item.node, [&] (NodeInt_t const after)
+                {
+                    if (visit[after] == EVisit::New)
+                    {
+                        stack.push_back({after, false});
+                    }
+                });
+                continue;
+            }
+
+            // Dependency cycles would deadlock if ever run. Nodes still being visited are along a
+            // cycle, and count as 0
+            uint64_t afterNs = 0;
+            for_each_after(item.node, [&] (NodeInt_t const after)
+            {
+                if (visit[after] == EVisit::Done)
+                {
+                    afterNs = std::max(afterNs, pathNs[after]);
+                }
+            });
+
+            if (item.node < maxTasks)
+            {
+                uint64_t const durationNs = (item.node < durationsNs.size()) ? durationsNs[item.node] : 1;
+                afterNs += durationNs;
+            }
+
+            pathNs[item.node] = afterNs;
+            visit[item.node]  = EVisit::Done;
+        }
+    }
+
+    rCritPathNsOut.assign(maxTasks, 0);
+    for (std::size_t taskInt = 0; taskInt < maxTasks; ++taskInt)
+    {
+        rCritPathNsOut[TaskId(taskInt)] = pathNs[taskInt];
+    }
+}
+
+} // namespace osp
@@ -25,6 +25,7 @@
 #pragma once
 
 #include "../core/array_view.h"
+#include "../core/bitvector.h"
 #include "../core/keyed_vector.h"
 
 #include <longeron/id_management/registry_stl.hpp>
@@ -117,8 +118,9 @@ struct TplPipelineStage
 
 struct TplTaskSemaphore
 {
-    TaskId      task;
-    SemaphoreId semaphore;
+    TaskId          task;
+    SemaphoreId     semaphore;
+    unsigned int    units;
 };
 
 //-----------------------------------------------------------------------------
@@ -129,6 +131,7 @@ struct Tasks
     lgrn::IdRegistryStl<PipelineId>                 m_pipelineIds;
     lgrn::IdRegistryStl<SemaphoreId>                m_semaIds;
 
+    /// Max number of units of each semaphore that can be held at once by running tasks
     KeyedVec<SemaphoreId, unsigned int>             m_semaLimits;
 
     KeyedVec<PipelineId, PipelineInfo>              m_pipelineInfo;
@@ -136,13 +139,18 @@ struct Tasks
     KeyedVec<PipelineId, PipelineControl>           m_pipelineControl;
 
     KeyedVec<TaskId, TplPipelineStage>              m_taskRunOn;
+
+    /// When more tasks are ready than can run at once, higher priorities are taken first.
+    /// See exec_pop_ready. Defaults to 0
+    KeyedVec<TaskId, int16_t>                       m_taskPriority;
 };
 
 struct TaskEdges
 {
     std::vector<TplTaskPipelineStage>   m_syncWith;
 
-    //std::vector<TplTaskSemaphore>       m_semaphoreEdges;
+    /// Tasks must acquire units of semaphores before they're allowed to run
+    std::vector<TplTaskSemaphore>       m_semaphoreEdges;
 };
 
 using PipelineTreePos_t = uint32_t;
@@ -158,6 +166,9 @@ enum class ReverseStageReqTaskId    : uint32_t { };
 enum class TaskReqStageId           : uint32_t { };
 enum class ReverseTaskReqStageId    : uint32_t { };
 
+enum class TaskAcquireId            : uint32_t { };
+enum class SemaAcquiredById         : uint32_t { };
+
 struct StageRequiresTask
 {
     AnyStageId  ownStage    { lgrn::id_null<AnyStageId>() };
@@ -179,6 +190,24 @@ struct TaskRequiresStage
     StageId     reqStage    { lgrn::id_null<StageId>() };
 };
 
+/**
+ * @brief Pipeline tree range of the loop scope that a pipeline is in
+ *
+ * A loop scope at position 'first' encloses all pipelines positioned in (first, last).
+ */
+struct LoopScopeRange
+{
+    PipelineTreePos_t   first       { lgrn::id_null<PipelineTreePos_t>() };
+    PipelineTreePos_t   last        { lgrn::id_null<PipelineTreePos_t>() }; ///< One past the loop scope's last descendant
+    PipelineId          pipeline    { lgrn::id_null<PipelineId>() };        ///< The loop scope pipeline itself
+};
+
+struct TaskAcquire
+{
+    SemaphoreId     semaphore   { lgrn::id_null<SemaphoreId>() };
+    unsigned int    units       { 0 };
+};
+
 struct TaskGraph
 {
     // Each pipeline has multiple stages.
@@ -217,10 +246,18 @@ struct TaskGraph
     KeyedVec<PipelineTreePos_t, PipelineId>         pltreeToPipeline;
     KeyedVec<PipelineId, PipelineTreePos_t>         pipelineToPltree;
     KeyedVec<PipelineId, PipelineTreePos_t>         pipelineToLoopScope;
-
-    // not yet used
-    //lgrn::IntArrayMultiMap<TaskInt, SemaphoreId>    taskAcquire;      /// Tasks acquire (n) Semaphores
-    //lgrn::IntArrayMultiMap<SemaphoreInt, TaskId>    semaAcquiredBy;   /// Semaphores are acquired by (n) Tasks
+    // Same as pipelineToLoopScope, but precomputed with the loop scope's subtree range and
+    // pipeline, so checking if one pipeline is enclosed by another's loop scope is O(1)
+    KeyedVec<PipelineId, LoopScopeRange>            pipelineToLoopScopeRange;
+
+    // Tasks acquire units of Semaphores while they run
+    // TaskId --> TaskAcquireId --> many TaskAcquire
+    KeyedVec<TaskId, TaskAcquireId>                 taskToFirstAcquire;
+    KeyedVec<TaskAcquireId, TaskAcquire>            taskAcquire;
+    // Semaphores need to know which tasks may be waiting for them
+    // SemaphoreId --> SemaAcquiredById --> many TaskId
+    KeyedVec<SemaphoreId, SemaAcquiredById>         semaToFirstAcquiredBy;
+    KeyedVec<SemaAcquiredById, TaskId>              semaAcquiredBy;
 
 }; // struct TaskGraph
 
@@ -232,6 +269,53 @@ inline TaskGraph make_exec_graph(Tasks const& tasks, std::initializer_list<TaskE
     return make_exec_graph(tasks, arrayView(data));
 }
 
+/**
+ * @brief Update a TaskGraph after tasks, pipelines, or semaphores were added or removed
+ *
+ * Gives the same graph as make_exec_graph with all edges (up to the order of items connected to
+ * each ID), but only needs edges that were added since the graph was last made or updated.
+ * Anything referring to a removed task, pipeline, or semaphore is dropped, and tasks that aren't
+ * in the graph yet are added.
+ *
+ * ID registries reuse removed IDs, so call this after removing anything and before creating
+ * anything new. ie: once after closing sessions, then again with only the new edges once new
+ * sessions are opened.
+ *
+ * @param added [in] Edges added since the graph was last made or updated
+ */
+void update_exec_graph(Tasks const& tasks, TaskGraph &rGraph, ArrayView<TaskEdges const* const> added);
+
+inline void update_exec_graph(Tasks const& tasks, TaskGraph &rGraph, std::initializer_list<TaskEdges const* const> added)
+{
+    update_exec_graph(tasks, rGraph, arrayView(added));
+}
+
+/**
+ * @brief Find tasks that can only start after a certain task completes, within a single run
+ *
+ * A task can only run while the stages it runs on or syncs with are selected, and these stages
+ * can't end until the task completes. Tasks on later stages of the same pipelines are therefore
+ * ordered after it, as are tasks that depend on those stages, and so on.
+ *
+ * Tasks that are not ordered relative to each other in either direction may run at the same time.
+ *
+ * @param task              [in] Task to search from. Not included in the output
+ * @param rTasksAfterOut    [out] Set bits for each task ordered after task. Resized to fit
+ */
+void find_tasks_after(Tasks const& tasks, TaskGraph const& graph, TaskId task, BitVector_t &rTasksAfterOut);
+
+/**
+ * @brief Estimate how long it takes to run each task and the longest chain of tasks after it
+ *
+ * Follows the same ordering as find_tasks_after. Starting tasks with longer critical paths first
+ * shortens a run when there are more ready tasks than threads to run them.
+ *
+ * @param durationsNs       [in] Expected duration of each task, eg: from TaskProfiler::taskTimes.
+ *                               Tasks without one count as 1ns, so only the chain length matters
+ * @param rCritPathNsOut    [out] Critical path of each task in nanoseconds. Resized to fit
+ */
+void task_critical_paths(Tasks const& tasks, TaskGraph const& graph, ArrayView<uint64_t const> durationsNs, KeyedVec<TaskId, uint64_t> &rCritPathNsOut);
+
 template <typename KEY_T, typename VALUE_T, typename GETSIZE_T, typename CLAIM_T>
 inline void fanout_partition(KeyedVec<KEY_T, VALUE_T>& rVec, GETSIZE_T&& get_size, CLAIM_T&& claim) noexcept
 {
@@ -0,0 +1,372 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "execute.h"
+#include "tasks.h"
+#include "top_worker.h"
+#include "worker.h"
+
+#include "../core/bitvector.h"
+#include "../core/keyed_vector.h"
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief When a suspended TaskCoroutine continues
+ */
+enum class ECoroutineResume : uint8_t
+{
+    NextFrame,  ///< On the executor's next wait()
+    AnyWorker   ///< As soon as a worker is free, after other ready tasks had a chance to start
+};
+
+/**
+ * @brief Return type for TopTask functions that can suspend and continue later
+ *
+ * Write task functions as C++20 coroutines that return TaskCoroutine and `co_return` TaskActions.
+ * They can `co_await next_frame()`, `co_await any_worker()`, or `co_await budget.yield()` (see
+ * TaskTimeBudget) to spread heavy work across frames.
+ *
+ * A suspended task is not complete, so its pipeline's stage stays open until the coroutine
+ * returns. Only suspend in pipelines that the frame doesn't wait on, or the frame will stall.
+ *
+ * Arguments are bound when the task first runs. TopData references stay valid until sessions
+ * are opened or closed, but a WorkerContext argument is only valid until the first co_await.
+ * The task may continue on a different worker after that; use `co_await current_worker()` to
+ * get the WorkerContext of the worker currently running it.
+ */
+struct TaskCoroutine
+{
+    struct promise_type
+    {
+        // Takes the coroutine's arguments, to start with the WorkerContext of the first run
+        template <typename ... ARGS_T>
+        explicit promise_type(ARGS_T const& ... args) noexcept
+        {
+            (take_worker(args), ...);
+        }
+
+        template <typename T>
+        void take_worker(T const& arg) noexcept
+        {
+            if constexpr (std::is_same_v<T, WorkerContext>)
+            {
+                m_worker = arg;
+            }
+        }
+
+        TaskCoroutine get_return_object() noexcept
+        {
+            return TaskCoroutine{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        // Start right away, running until the first co_await
+        std::suspend_never  initial_suspend() noexcept { return {}; }
+
+        // Keep the frame alive to read the result, TaskCoroutine destroys it
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        void return_value(TaskActions const actions) noexcept { m_result = actions; }
+
+        // Tasks are noexcept
+        void unhandled_exception() noexcept { std::terminate(); }
+
+        TaskActions         m_result;
+        ECoroutineResume    m_resume    { ECoroutineResume::AnyWorker };
+
+        /// Worker currently running the coroutine, see current_worker
+        WorkerContext       m_worker;
+    };
+
+    using Handle_t = std::coroutine_handle<promise_type>;
+
+    TaskCoroutine() = default;
+    explicit TaskCoroutine(Handle_t handle) noexcept : m_handle{handle} { }
+    TaskCoroutine(TaskCoroutine const& copy) = delete;
+    TaskCoroutine(TaskCoroutine&& move) noexcept : m_handle{std::exchange(move.m_handle, nullptr)} { }
+    ~TaskCoroutine() { reset(); }
+
+    TaskCoroutine& operator=(TaskCoroutine const& copy) = delete;
+    TaskCoroutine& operator=(TaskCoroutine&& move) noexcept
+    {
+        reset();
+        m_handle = std::exchange(move.m_handle, nullptr);
+        return *this;
+    }
+
+    /// Started but hasn't returned yet
+    bool suspended() const noexcept { return m_handle && ! m_handle.done(); }
+
+    ECoroutineResume resume_on() const noexcept { return m_handle.promise().m_resume; }
+
+    /**
+     * @brief Continue running a suspended coroutine on the given worker
+     */
+    void resume(WorkerContext const& worker) const
+    {
+        m_handle.promise().m_worker = worker;
+        m_handle.resume();
+    }
+
+    /**
+     * @brief Get the returned TaskActions of a finished coroutine, and destroy it
+     */
+    TaskActions take_result() noexcept
+    {
+        LGRN_ASSERTM(m_handle && m_handle.done(), "Coroutine hasn't returned yet");
+        TaskActions const out = m_handle.promise().m_result;
+        reset();
+        return out;
+    }
+
+    void reset() noexcept
+    {
+        if (m_handle)
+        {
+            m_handle.destroy();
+            m_handle = nullptr;
+        }
+    }
+
+    Handle_t m_handle;
+};
+
+/**
+ * @brief Awaitable that suspends a TaskCoroutine, see next_frame and any_worker
+ */
+struct TaskCoroutineSuspend
+{
+    constexpr bool await_ready() const noexcept { return false; }
+
+    void await_suspend(TaskCoroutine::Handle_t handle) const noexcept
+    {
+        handle.promise().m_resume = resume;
+    }
+
+    constexpr void await_resume() const noexcept { }
+
+    ECoroutineResume resume;
+};
+
+/**
+ * @brief Awaitable that gives the WorkerContext of the worker running a TaskCoroutine
+ */
+struct TaskCoroutineWorker
+{
+    constexpr bool await_ready() const noexcept { return false; }
+
+    // Doesn't suspend, only reads the promise
+    bool await_suspend(TaskCoroutine::Handle_t handle) noexcept
+    {
+        m_pWorker = &handle.promise().m_worker;
+        return false;
+    }
+
+    WorkerContext const& await_resume() const noexcept { return *m_pWorker; }
+
+    WorkerContext const *m_pWorker { nullptr };
+};
+
+/**
+ * @brief co_await to get the WorkerContext of the worker running the task
+ *
+ * The returned reference stays valid for the whole task, and is updated each time the task
+ * continues, possibly on a different worker.
+ */
+constexpr TaskCoroutineWorker current_worker() noexcept
+{
+    return {};
+}
+
+/**
+ * @brief co_await to continue on the executor's next wait()
+ */
+constexpr TaskCoroutineSuspend next_frame() noexcept
+{
+    return { ECoroutineResume::NextFrame };
+}
+
+/**
+ * @brief co_await to hand the rest of the task back to the worker pool
+ *
+ * Lets other ready tasks start first, and the rest of the task may continue on a different
+ * worker (within TopTask::m_affinity).
+ */
+constexpr TaskCoroutineSuspend any_worker() noexcept
+{
+    return { ECoroutineResume::AnyWorker };
+}
+
+/**
+ * @brief Limits how long a TaskCoroutine runs each frame
+ *
+ * @code{.cpp}
+ * TaskTimeBudget budget{std::chrono::milliseconds{2}};
+ * for (Chunk &rChunk : chunks)
+ * {
+ *     generate(rChunk);
+ *     co_await budget.yield();
+ * }
+ * @endcode
+ */
+class TaskTimeBudget
+{
+    using Clock_t = std::chrono::steady_clock;
+
+public:
+
+    struct Awaiter
+    {
+        bool await_ready() const noexcept { return ! rBudget.exceeded(); }
+
+        void await_suspend(TaskCoroutine::Handle_t handle) const noexcept
+        {
+            handle.promise().m_resume = ECoroutineResume::NextFrame;
+        }
+
+        void await_resume() const noexcept { rBudget.restart(); }
+
+        TaskTimeBudget &rBudget;
+    };
+
+    explicit TaskTimeBudget(std::chrono::nanoseconds const budget) noexcept
+     : m_budget{budget}
+     , m_start{Clock_t::now()}
+    { }
+
+    bool exceeded() const noexcept { return Clock_t::now() - m_start >= m_budget; }
+
+    void restart() noexcept { m_start = Clock_t::now(); }
+
+    /**
+     * @brief co_await to continue on the next frame if over budget, which restarts the budget
+     */
+    Awaiter yield() noexcept { return {*this}; }
+
+private:
+    std::chrono::nanoseconds    m_budget;
+    Clock_t::time_point         m_start;
+};
+
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Per-executor state of suspended TaskCoroutines
+ */
+struct TopCoroutines
+{
+    /// Coroutine of each task. Only touched by the worker running the task
+    KeyedVec<TaskId, TaskCoroutine> running;
+
+    /// Tasks waiting for top_coroutines_next_frame
+    std::vector<TaskId>             nextFrame;
+    BitVector_t                     inNextFrame;
+};
+
+/**
+ * @brief Resize to fit tasks, and destroy coroutines of tasks that no longer exist
+ */
+inline void top_coroutines_conform(Tasks const& tasks, TopCoroutines &rCoroutines)
+{
+    std::size_t const maxTasks = tasks.m_taskIds.capacity();
+
+    rCoroutines.running.resize(maxTasks);
+    bitvector_resize(rCoroutines.inNextFrame, maxTasks);
+
+    for (std::size_t taskInt = 0; taskInt < maxTasks; ++taskInt)
+    {
+        if ( ! tasks.m_taskIds.exists(TaskId(taskInt)) )
+        {
+            rCoroutines.running[TaskId(taskInt)].reset();
+            rCoroutines.inNextFrame.reset(taskInt);
+        }
+    }
+
+    std::erase_if(rCoroutines.nextFrame, [&tasks] (TaskId const task)
+    {
+        return ! tasks.m_taskIds.exists(task);
+    });
+}
+
+/**
+ * @brief Check if a task that just ran suspended, and requeue it to run again later
+ *
+ * Call after running a task from tasksQueuedRun. If this returns true, the task isn't done and
+ * complete_task must not be called for it yet.
+ */
+inline bool top_coroutine_park(TopCoroutines &rCoroutines, ExecContext &rExec, TaskId const task) noexcept
+{
+    TaskCoroutine const &rCoro = rCoroutines.running[task];
+
+    if ( ! rCoro.suspended() )
+    {
+        return false;
+    }
+
+    switch (rCoro.resume_on())
+    {
+    case ECoroutineResume::NextFrame:
+        rCoroutines.nextFrame.push_back(task);
+        rCoroutines.inNextFrame.set(std::size_t(task));
+        break;
+    case ECoroutineResume::AnyWorker:
+        exec_push_ready(rExec, task);
+        break;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Check if a task taken by exec_pop_ready is waiting for the next frame, and can't run
+ */
+inline bool top_coroutine_waiting(TopCoroutines const& coroutines, TaskId const task) noexcept
+{
+    return coroutines.inNextFrame.test(std::size_t(task));
+}
+
+/**
+ * @brief Make tasks suspended with next_frame ready to run again. Call at the start of a frame
+ */
+inline void top_coroutines_next_frame(TopCoroutines &rCoroutines, ExecContext &rExec) noexcept
+{
+    for (TaskId const task : rCoroutines.nextFrame)
+    {
+        rCoroutines.inNextFrame.reset(std::size_t(task));
+        exec_push_ready(rExec, task);
+    }
+    rCoroutines.nextFrame.clear();
+}
+
+} // namespace osp
@@ -31,40 +31,117 @@
 #include <entt/core/any.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <iomanip>
+#include <string>
 #include <vector>
 
 namespace osp
 {
 
-void top_run_blocking(Tasks const& tasks, TaskGraph const& graph, TopTaskDataVec_t& rTaskData, ArrayView<entt::any> topData, ExecContext& rExec, WorkerContext worker)
+void top_bind_args(Tasks const& tasks, TopTaskDataVec_t const& taskData, ArrayView<entt::any> topData, TopTaskArgBinding &rOut)
 {
-    std::vector<entt::any> topDataRefs;
+    std::size_t const maxTasks = tasks.m_taskIds.capacity();
+
+    auto const has_data = [&tasks, &taskData] (TaskId const task) -> bool
+    {
+        return tasks.m_taskIds.exists(task) && std::size_t(task) < taskData.size();
+    };
+
+    std::size_t totalArgs = 0;
+    for (std::size_t taskInt = 0; taskInt < maxTasks; ++taskInt)
+    {
+        auto const task = TaskId(taskInt);
+        totalArgs += has_data(task) ? taskData[task].m_dataUsed.size() : 0;
+    }
+
+    rOut.taskToFirstArg .assign(maxTasks + 1, TopArgId(0));
+    rOut.taskFunc       .assign(maxTasks, nullptr);
+    rOut.args           .clear();
+    rOut.args           .reserve(totalArgs);
+
+    for (std::size_t taskInt = 0; taskInt < maxTasks; ++taskInt)
+    {
+        auto const task = TaskId(taskInt);
+
+        rOut.taskToFirstArg[task] = TopArgId(rOut.args.size());
+
+        if ( ! has_data(task) )
+        {
+            continue;
+        }
+
+        TopTask const &rTopTask = taskData[task];
+
+        rOut.taskFunc[task] = rTopTask.m_func;
+
+        for (std::size_t i = 0; i < rTopTask.m_dataUsed.size(); ++i)
+        {
+            TopDataId const dataId = rTopTask.m_dataUsed[i];
+
+            if (dataId == lgrn::id_null<TopDataId>())
+            {
+                rOut.args.push_back(nullptr);
+                continue;
+            }
+
+            entt::any &rData = topData[dataId];
+
+            [[maybe_unused]] entt::type_info const* pExpected
+                    = (i < rTopTask.m_dataTypes.size()) ? rTopTask.m_dataTypes[i] : nullptr;
+
+            LGRN_ASSERTMV(pExpected == nullptr || rData.type() == *pExpected,
+                          "TopData type does not match task argument",
+                          rTopTask.m_debugName, dataId, rData.type().name(), pExpected->name());
+
+            rOut.args.push_back(rData.data());
+        }
+    }
+
+    rOut.taskToFirstArg[TaskId(maxTasks)] = TopArgId(rOut.args.size());
+}
+
+static TaskActions run_task(TopTaskArgBinding const& binding, TaskId const task, WorkerContext const worker, TopCoroutines *pCoroutines)
+{
+    return (pCoroutines != nullptr) ? top_run_task(binding, task, worker, *pCoroutines)
+                                    : top_run_task(binding, task, worker);
+}
+
+void top_run_blocking(Tasks const& tasks, TaskGraph const& graph, TopTaskArgBinding const& binding, ExecContext& rExec, WorkerContext worker, TaskProfiler *pProfiler, std::vector<ExecLogRecord> *pLogOut, TopCoroutines *pCoroutines)
+{
+    // The profiler reads stage changes from the log, so records need to go somewhere
+    std::vector<ExecLogRecord> logFallback;
+    if (pProfiler != nullptr && pLogOut == nullptr)
+    {
+        pLogOut = &logFallback;
+    }
 
     // Run until there's no tasks left to run
     while (true)
     {
-        auto const runTasksLeft = rExec.tasksQueuedRun.size();
-        //auto const blockedTasksLeft = rExec.tasksQueuedBlocked.size();
+        // Highest priority first, see exec_set_priorities
+        TaskId const task = exec_pop_ready(rExec);
 
-        if (runTasksLeft != 0)
+        if (task != lgrn::id_null<TaskId>())
         {
-            TaskId const task = rExec.tasksQueuedRun[0];
-            TopTask &rTopTask = rTaskData[task];
-
-            topDataRefs.clear();
-            topDataRefs.reserve(rTopTask.m_dataUsed.size());
-            for (TopDataId const dataId : rTopTask.m_dataUsed)
+            if (pCoroutines != nullptr && top_coroutine_waiting(*pCoroutines, task))
             {
-                topDataRefs.push_back((dataId != lgrn::id_null<TopDataId>())
-                                       ? topData[dataId].as_ref()
-                                       : entt::any{});
+                continue; // Requeued by exec_schedule_catch_up, but suspended until next frame
             }
 
-            bool const shouldRun = (rTopTask.m_func != nullptr);
+            auto const start = (pProfiler != nullptr) ? ProfileClock_t::now() : ProfileClock_t::time_point{};
+
+            TaskActions const status = run_task(binding, task, worker, pCoroutines);
+
+            if (pProfiler != nullptr)
+            {
+                profiler_record_task(*pProfiler, task, worker.m_workerIndex, start, ProfileClock_t::now());
+            }
 
-            // Task function is called here
-            TaskActions const status = shouldRun ? rTopTask.m_func(worker, topDataRefs) : TaskActions{};
+            if (pCoroutines != nullptr && top_coroutine_park(*pCoroutines, rExec, task))
+            {
+                continue; // Not done yet, nothing to update
+            }
 
             complete_task(tasks, graph, rExec, task, status);
         }
@@ -74,7 +151,127 @@ void top_run_blocking(Tasks const& tasks, TaskGraph const& graph, TopTaskDataVec
         }
 
         exec_update(tasks, graph, rExec);
+
+        if (pLogOut != nullptr)
+        {
+            std::size_t const first = pLogOut->size();
+            exec_log_ring_drain(rExec.logRing, *pLogOut);
+
+            if (pProfiler != nullptr)
+            {
+                profiler_read_log(*pProfiler, arrayView(*pLogOut).slice(first, pLogOut->size()), ProfileClock_t::now());
+            }
+        }
+    }
+}
+
+bool top_run_schedule(Tasks const& tasks, TaskGraph const& graph, TopTaskArgBinding const& binding, ExecContext& rExec, ExecSchedule const& sched, WorkerContext worker, TopCoroutines *pCoroutines)
+{
+    LGRN_ASSERTM(exec_schedule_matches(rExec, sched), "Schedule can't be replayed from current state");
+
+    for (std::size_t i = 0; i < sched.tasks.size(); ++i)
+    {
+        TaskId const        task        = sched.tasks[i];
+        TaskActions const   status      = run_task(binding, task, worker, pCoroutines);
+        bool const          suspended   =    pCoroutines != nullptr
+                                          && pCoroutines->running[task].suspended();
+
+        if (status != sched.actions[i] || suspended)
+        {
+            // Diverged from the recording, where no tasks suspended. Continue
+            // dynamically from the same state as if everything ran dynamically from the start.
+            exec_schedule_catch_up(tasks, graph, rExec, sched, i);
+            if ( ! suspended || ! top_coroutine_park(*pCoroutines, rExec, task) )
+            {
+                complete_task(tasks, graph, rExec, task, status);
+            }
+            exec_update(tasks, graph, rExec);
+            top_run_blocking(tasks, graph, binding, rExec, worker, nullptr, nullptr, pCoroutines);
+            return false;
+        }
+    }
+
+    exec_schedule_replay_done(rExec, sched);
+    return true;
+}
+
+std::vector<TopDataConflict> top_find_data_conflicts(Tasks const& tasks, TaskGraph const& graph, TopTaskDataVec_t const& taskData)
+{
+    struct DataUser
+    {
+        TaskId      task;
+        DataAccess  access;
+    };
+
+    std::vector<TopDataConflict> out;
+
+    // Group tasks by the TopData they use
+    std::vector< std::vector<DataUser> > dataUsers;
+
+    for (TaskInt const taskInt : tasks.m_taskIds.bitview().zeros())
+    {
+        auto const task = TaskId(taskInt);
+        if (std::size_t(task) >= taskData.size())
+        {
+            continue;
+        }
+
+        TopTask const &rTopTask = taskData[task];
+        for (std::size_t i = 0; i < rTopTask.m_dataUsed.size(); ++i)
+        {
+            TopDataId const data = rTopTask.m_dataUsed[i];
+            if (data == lgrn::id_null<TopDataId>())
+            {
+                continue;
+            }
+
+            dataUsers.resize(std::max<std::size_t>(dataUsers.size(), data + 1));
+            dataUsers[data].push_back({task, top_data_access(rTopTask, i)});
+        }
+    }
+
+    // Tasks ordered after each task, calculated only when needed
+    KeyedVec<TaskId, BitVector_t> tasksAfter;
+    BitVector_t                   tasksAfterFound;
+    tasksAfter.resize(tasks.m_taskIds.capacity());
+    bitvector_resize(tasksAfterFound, tasks.m_taskIds.capacity());
+
+    auto const is_after = [&] (TaskId const first, TaskId const second) -> bool
+    {
+        if ( ! tasksAfterFound.test(std::size_t(first)) )
+        {
+            tasksAfterFound.set(std::size_t(first));
+            find_tasks_after(tasks, graph, first, tasksAfter[first]);
+        }
+        return tasksAfter[first].test(std::size_t(second));
+    };
+
+    for (std::size_t data = 0; data < dataUsers.size(); ++data)
+    {
+        std::vector<DataUser> const &rUsers = dataUsers[data];
+
+        for (std::size_t a = 0; a < rUsers.size(); ++a)
+        {
+            for (std::size_t b = a + 1; b < rUsers.size(); ++b)
+            {
+                DataUser const &rA = rUsers[a];
+                DataUser const &rB = rUsers[b];
+
+                if (   rA.task == rB.task
+                    || (rA.access == DataAccess::Read && rB.access == DataAccess::Read))
+                {
+                    continue;
+                }
+
+                if ( ! is_after(rA.task, rB.task) && ! is_after(rB.task, rA.task) )
+                {
+                    out.push_back({rA.task, rB.task, TopDataId(data)});
+                }
+            }
+        }
     }
+
+    return out;
 }
 
 static void write_task_requirements(std::ostream &rStream, Tasks const& tasks, TaskGraph const& graph, ExecContext const& exec, TaskId const task)
@@ -209,7 +406,7 @@ std::ostream& operator<<(std::ostream& rStream, TopExecWriteState const& write)
 
 std::ostream& operator<<(std::ostream& rStream, TopExecWriteLog const& write)
 {
-    auto const& [tasks, taskData, graph, exec] = write;
+    auto const& [tasks, taskData, graph, records] = write;
 
     auto const stage_name = [&tasks=tasks] (PipelineId pl, StageId stg) -> std::string_view
     {
@@ -285,23 +482,192 @@ std::ostream& operator<<(std::ostream& rStream, TopExecWriteLog const& write)
         }
         else if constexpr (std::is_same_v<MSG_T, ExecContext::CompleteTask>)
         {
-            rStream << "Complete TASK" << TaskInt(msg.task) << " - " << taskData[msg.task].m_debugName << "\n";
+            rStream << "Complete TASK" << TaskInt(msg.task) << " - " << taskData[msg.task].m_debugName
+                    << ((msg.actions & TaskAction::Cancel) ? " CANCEL" : "") << "\n";
         }
         else if constexpr (std::is_same_v<MSG_T, ExecContext::ExternalRunRequest>)
         {
             rStream << "ExternalRunRequest PL" << std::setw(3) << std::left << PipelineInt(msg.pipeline) << "\n";
         }
-        else if constexpr (std::is_same_v<MSG_T, ExecContext::ExternalRunRequest>)
+        else if constexpr (std::is_same_v<MSG_T, ExecContext::ExternalSignal>)
         {
             rStream << "ExternalSignal PL" << std::setw(3) << std::left << PipelineInt(msg.pipeline) << (msg.ignored ? " IGNORED!" : " ") << "\n";
         }
     };
 
-    for (ExecContext::LogMsg_t const& msg : exec.logMsg)
+    for (ExecLogRecord const& record : records)
+    {
+        std::visit(visitMsg, exec_log_decode(record));
+    }
+
+    return rStream;
+}
+
+static std::string_view debug_task_name(TopTaskDataVec_t const& taskData, TaskId const task)
+{
+    return (std::size_t(task) < taskData.size()) ? std::string_view{taskData[task].m_debugName} : std::string_view{};
+}
+
+static std::string_view debug_stage_name(Tasks const& tasks, PipelineId const pipeline, StageId const stage)
+{
+    PipelineInfo const& info = tasks.m_pipelineInfo[pipeline];
+
+    if (   info.stageType == lgrn::id_null<PipelineInfo::stage_type_t>()
+        || std::size_t(info.stageType) >= PipelineInfo::sm_stageNames.size() )
+    {
+        return {};
+    }
+
+    auto const stageNames = ArrayView<std::string_view const>{PipelineInfo::sm_stageNames[info.stageType]};
+
+    return (std::size_t(stage) < stageNames.size()) ? stageNames[std::size_t(stage)] : std::string_view{};
+}
+
+static void write_json_string(std::ostream &rStream, std::string_view const str)
+{
+    rStream << '"';
+    for (char const c : str)
+    {
+        switch (c)
+        {
+        case '"':   rStream << "\\\"";  break;
+        case '\\':  rStream << "\\\\";  break;
+        case '\n':  rStream << "\\n";   break;
+        case '\t':  rStream << "\\t";   break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                rStream << "\\u00" << "0123456789abcdef"[(c >> 4) & 0xF] << "0123456789abcdef"[c & 0xF];
+            }
+            else
+            {
+                rStream << c;
+            }
+        }
+    }
+    rStream << '"';
+}
+
+std::ostream& operator<<(std::ostream& rStream, TopProfileWriteTrace const& write)
+{
+    auto const& [tasks, taskData, profiler] = write;
+
+    static constexpr int sc_pidTasks        = 1;
+    static constexpr int sc_pidPipelines    = 2;
+
+    // Microseconds since capture start, as Trace Event timestamps are in microseconds
+    auto const micros = [&profiler=profiler] (ProfileClock_t::time_point const time) -> double
+    {
+        return std::chrono::duration<double, std::micro>(time - profiler.captureStart).count();
+    };
+
+    bool first = true;
+    auto const begin_event = [&rStream, &first] ()
     {
-        std::visit(visitMsg, msg);
+        rStream << (first ? "\n" : ",\n");
+        first = false;
+    };
+
+    auto const write_meta = [&rStream, &begin_event] (std::string_view const what, int const pid, uint32_t const tid, std::string_view const name)
+    {
+        begin_event();
+        rStream << R"({"name":")" << what << R"(","ph":"M","pid":)" << pid << R"(,"tid":)" << tid << R"(,"args":{"name":)";
+        write_json_string(rStream, name);
+        rStream << "}}";
+    };
+
+    std::ios_base::fmtflags const oldFlags = rStream.flags();
+    rStream << std::fixed << std::setprecision(3);
+
+    rStream << R"({"displayTimeUnit":"ms","traceEvents":[)";
+
+    write_meta("process_name", sc_pidTasks,     0, "Tasks");
+    write_meta("process_name", sc_pidPipelines, 0, "Pipelines");
+
+    uint32_t workerCount = 0;
+    for (TaskProfiler::TaskRun const& run : profiler.taskRuns)
+    {
+        workerCount = std::max(workerCount, run.worker + 1);
+    }
+    for (uint32_t worker = 0; worker < workerCount; ++worker)
+    {
+        write_meta("thread_name", sc_pidTasks, worker, std::string("Worker ") + std::to_string(worker));
     }
 
+    for (PipelineInt const plInt : tasks.m_pipelineIds.bitview().zeros())
+    {
+        std::string_view const name = tasks.m_pipelineInfo[PipelineId(plInt)].name;
+        write_meta("thread_name", sc_pidPipelines, plInt, name.empty() ? std::string("PL") + std::to_string(plInt) : std::string(name));
+    }
+
+    for (TaskProfiler::TaskRun const& run : profiler.taskRuns)
+    {
+        begin_event();
+        rStream << R"({"name":)";
+        std::string_view const name = debug_task_name(taskData, run.task);
+        write_json_string(rStream, name.empty() ? std::string("TASK") + std::to_string(TaskInt(run.task)) : std::string(name));
+        rStream << R"(,"cat":"task","ph":"X","pid":)" << sc_pidTasks << R"(,"tid":)" << run.worker
+                << R"(,"ts":)" << micros(run.start) << R"(,"dur":)" << (micros(run.end) - micros(run.start))
+                << R"(,"args":{"task":)" << TaskInt(run.task) << "}}";
+    }
+
+    for (TaskProfiler::StageRun const& run : profiler.stageRuns)
+    {
+        begin_event();
+        rStream << R"({"name":)";
+        std::string_view const name = debug_stage_name(tasks, run.pipeline, run.stage);
+        write_json_string(rStream, name.empty() ? std::string("Stage ") + std::to_string(int(run.stage)) : std::string(name));
+        rStream << R"(,"cat":"stage","ph":"X","pid":)" << sc_pidPipelines << R"(,"tid":)" << PipelineInt(run.pipeline)
+                << R"(,"ts":)" << micros(run.start) << R"(,"dur":)" << (micros(run.end) - micros(run.start)) << "}";
+    }
+
+    rStream << "\n]}\n";
+
+    rStream.flags(oldFlags);
+
+    return rStream;
+}
+
+std::ostream& operator<<(std::ostream& rStream, TopProfileWriteSummary const& write)
+{
+    auto const& [tasks, taskData, profiler, maxRows] = write;
+
+    std::vector<TaskId> sorted;
+    for (std::size_t taskInt = 0; taskInt < profiler.taskTimes.size(); ++taskInt)
+    {
+        if (profiler.taskTimes[TaskId(taskInt)].count != 0)
+        {
+            sorted.push_back(TaskId(taskInt));
+        }
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [&profiler=profiler] (TaskId const lhs, TaskId const rhs)
+    {
+        return histogram_mean_ns(profiler.taskTimes[lhs]) > histogram_mean_ns(profiler.taskTimes[rhs]);
+    });
+
+    sorted.resize(std::min(sorted.size(), maxRows));
+
+    auto const us = [] (uint64_t const ns) { return double(ns) / 1000.0; };
+
+    std::ios_base::fmtflags const oldFlags = rStream.flags();
+
+    rStream << "  Mean(us)   P50(us)   P95(us)  Runs  Task\n";
+
+    for (TaskId const task : sorted)
+    {
+        RollingHistogram const &rHist = profiler.taskTimes[task];
+
+        rStream << std::fixed << std::setprecision(1) << std::right
+                << std::setw(10) << us(histogram_mean_ns(rHist))
+                << std::setw(10) << us(histogram_percentile_ns(rHist, 0.5f))
+                << std::setw(10) << us(histogram_percentile_ns(rHist, 0.95f))
+                << std::setw(6)  << rHist.count
+                << "  TASK" << TaskInt(task) << " - " << debug_task_name(taskData, task) << "\n";
+    }
+
+    rStream.flags(oldFlags);
+
     return rStream;
 }
 
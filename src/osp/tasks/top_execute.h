@@ -24,8 +24,11 @@
  */
 #pragma once
 
+#include "exec_schedule.h"
 #include "execute.h"
+#include "profiler.h"
 #include "tasks.h"
+#include "top_coroutine.h"
 #include "top_tasks.h"
 
 #include <vector>
@@ -33,7 +36,91 @@
 namespace osp
 {
 
-void top_run_blocking(Tasks const& tasks, TaskGraph const& graph, TopTaskDataVec_t& rTaskData, ArrayView<entt::any> topData, ExecContext& rExec, WorkerContext worker = {});
+enum class TopArgId : uint32_t { };
+
+/**
+ * @brief Task functions and arguments resolved ahead of time, for fast dispatch
+ *
+ * Pointers to TopData are only valid as long as the entt::anys they point into are not
+ * reassigned, emplaced, or moved. Rebind after opening or closing sessions.
+ */
+struct TopTaskArgBinding
+{
+    // Each task has multiple arguments
+    // TaskId --> TopArgId --> pointer to TopData
+    KeyedVec<TaskId, TopArgId>      taskToFirstArg;
+    KeyedVec<TopArgId, void*>       args;
+
+    KeyedVec<TaskId, TopTaskFunc_t> taskFunc;
+};
+
+/**
+ * @brief Resolve each task's arguments to pointers into TopData
+ *
+ * Argument types are checked here (if assertions are enabled) instead of each time a task runs.
+ */
+void top_bind_args(Tasks const& tasks, TopTaskDataVec_t const& taskData, ArrayView<entt::any> topData, TopTaskArgBinding &rOut);
+
+/**
+ * @brief Call a single task function with its bound arguments
+ *
+ * Safe to call from multiple threads at once.
+ */
+inline TaskActions top_run_task(TopTaskArgBinding const& binding, TaskId const task, WorkerContext const worker)
+{
+    TopTaskFunc_t const func = binding.taskFunc[task];
+
+    return (func != nullptr)
+         ? func(worker, fanout_view(binding.taskToFirstArg, binding.args, task))
+         : TaskActions{};
+}
+
+/**
+ * @brief Call a single task function, allowing it to be a TaskCoroutine
+ *
+ * Check top_coroutine_park afterwards before completing the task.
+ */
+inline TaskActions top_run_task(TopTaskArgBinding const& binding, TaskId const task, WorkerContext worker, TopCoroutines &rCoroutines)
+{
+    worker.m_pCoroutine = &rCoroutines.running[task];
+    return top_run_task(binding, task, worker);
+}
+
+/**
+ * @brief Run tasks on the calling thread until there's no tasks left to run
+ *
+ * @param pProfiler [in] Optional profiler to record task times and stage changes to
+ * @param pLogOut   [out] Optional, ExecLog records are drained and appended here after each exec_update
+ * @param pCoroutines [in,out] Optional, required to run TaskCoroutine tasks. Suspended tasks are
+ *                    left running; call top_coroutines_next_frame before the next run.
+ */
+void top_run_blocking(Tasks const& tasks, TaskGraph const& graph, TopTaskArgBinding const& binding, ExecContext& rExec, WorkerContext worker = {}, TaskProfiler *pProfiler = nullptr, std::vector<ExecLogRecord> *pLogOut = nullptr, TopCoroutines *pCoroutines = nullptr);
+
+/**
+ * @brief Run a recorded schedule's tasks in order on the calling thread, without exec_update
+ *
+ * Requires exec_schedule_matches. If a task returns something different from the recording or
+ * suspends, then the rest of the run falls back to top_run_blocking.
+ *
+ * @return true if the whole schedule was replayed, false if it diverged
+ */
+bool top_run_schedule(Tasks const& tasks, TaskGraph const& graph, TopTaskArgBinding const& binding, ExecContext& rExec, ExecSchedule const& sched, WorkerContext worker = {}, TopCoroutines *pCoroutines = nullptr);
+
+struct TopDataConflict
+{
+    TaskId      taskA;
+    TaskId      taskB;
+    TopDataId   data;
+};
+
+/**
+ * @brief Find pairs of tasks that access the same TopData in a way that is unsafe to run in
+ *        parallel, but aren't ordered relative to each other by the TaskGraph
+ *
+ * Accesses are unsafe if either task writes to the data. See TopTask::m_dataAccess and
+ * find_tasks_after.
+ */
+std::vector<TopDataConflict> top_find_data_conflicts(Tasks const& tasks, TaskGraph const& graph, TopTaskDataVec_t const& taskData);
 
 struct TopExecWriteState
 {
@@ -43,16 +130,49 @@ struct TopExecWriteState
     ExecContext const       &exec;
 };
 
+/**
+ * @brief Decode and write ExecLog records as human-readable text
+ *
+ * Records can be taken from ExecLog::logRing using exec_log_ring_drain.
+ */
 struct TopExecWriteLog
+{
+    Tasks const                     &tasks;
+    TopTaskDataVec_t const          &taskData;
+    TaskGraph const                 &graph;
+    ArrayView<ExecLogRecord const>  records;
+};
+
+/**
+ * @brief Write a TaskProfiler's capture as Chrome Trace Event JSON
+ *
+ * Open with chrome://tracing or https://ui.perfetto.dev. Tasks are shown per-worker, and stages
+ * are shown per-pipeline.
+ */
+struct TopProfileWriteTrace
 {
     Tasks const             &tasks;
     TopTaskDataVec_t const  &taskData;
-    TaskGraph const         &graph;
-    ExecContext const       &exec;
+    TaskProfiler const      &profiler;
+};
+
+/**
+ * @brief Write a table of the slowest tasks by average recent run time
+ */
+struct TopProfileWriteSummary
+{
+    Tasks const             &tasks;
+    TopTaskDataVec_t const  &taskData;
+    TaskProfiler const      &profiler;
+    std::size_t             maxRows;
 };
 
 std::ostream& operator<<(std::ostream& rStream, TopExecWriteState const& write);
 
 std::ostream& operator<<(std::ostream& rStream, TopExecWriteLog const& write);
 
+std::ostream& operator<<(std::ostream& rStream, TopProfileWriteTrace const& write);
+
+std::ostream& operator<<(std::ostream& rStream, TopProfileWriteSummary const& write);
+
 } // namespace testapp
@@ -117,14 +117,15 @@ struct Session
         return *pOut;
     }
 
-    std::vector<TopDataId>  m_data;
-    std::vector<PipelineId> m_pipelines;
-    std::vector<TaskId>     m_tasks;
+    std::vector<TopDataId>      m_data;
+    std::vector<PipelineId>     m_pipelines;
+    std::vector<TaskId>         m_tasks;
+    std::vector<SemaphoreId>    m_semaphores;
 
-    PipelineId              m_cleanup { lgrn::id_null<PipelineId>() };
+    PipelineId                  m_cleanup { lgrn::id_null<PipelineId>() };
 
-    std::size_t             m_structHash{0};
-    std::string             m_structName;
+    std::size_t                 m_structHash{0};
+    std::string                 m_structName;
 
 }; // struct Session
 
@@ -27,19 +27,79 @@
 #include "tasks.h"
 #include "top_worker.h"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
 namespace osp
 {
 
+/**
+ * @brief How a task accesses one of its TopData arguments
+ */
+enum class DataAccess : uint8_t
+{
+    Write,  ///< May modify. Assumed if unknown
+    Read    ///< Only reads; other readers can run at the same time
+};
+
+/**
+ * @brief Which thread a task is allowed to run on
+ *
+ * Needed for tasks that use thread-bound state, such as an OpenGL context.
+ */
+enum class ETaskAffinity : uint8_t
+{
+    Any,    ///< Runs on any worker
+    Main,   ///< Only runs on the thread that owns the executor, worker 0
+    Worker  ///< Only runs on the worker with index TopTask::m_affinityWorker
+};
+
 struct TopTask
 {
-    std::string             m_debugName;
-    std::vector<TopDataId>  m_dataUsed;
-    TopTaskFunc_t           m_func              { nullptr };
+    std::string                         m_debugName;
+    std::vector<TopDataId>              m_dataUsed;
+    std::vector<DataAccess>             m_dataAccess;   ///< Access of each m_dataUsed, may be shorter
+    std::vector<entt::type_info const*> m_dataTypes;    ///< Type of each m_dataUsed, for debug checks
+    TopTaskFunc_t                       m_func          { nullptr };
+    ETaskAffinity                       m_affinity      { ETaskAffinity::Any };
+    uint32_t                            m_affinityWorker{ 0 };  ///< For ETaskAffinity::Worker
 };
 
+/**
+ * @brief Get the index of the only worker allowed to run a task, see WorkerContext::m_workerIndex
+ *
+ * @return Null if the task can run on any worker
+ */
+inline uint32_t top_task_worker(TopTask const& task) noexcept
+{
+    switch (task.m_affinity)
+    {
+    case ETaskAffinity::Main:   return 0;
+    case ETaskAffinity::Worker: return task.m_affinityWorker;
+    default:                    return lgrn::id_null<uint32_t>();
+    }
+}
+
+/**
+ * @brief Get which of an executor's workers must run a task
+ *
+ * Worker indices past workerCount wrap around, so tasks bound to the same worker still share a
+ * thread.
+ *
+ * @return Null if the task can run on any worker
+ */
+inline uint32_t top_task_queue(TopTask const& task, uint32_t const workerCount) noexcept
+{
+    uint32_t const worker = top_task_worker(task);
+    return (worker == lgrn::id_null<uint32_t>()) ? worker : worker % workerCount;
+}
+
+inline DataAccess top_data_access(TopTask const& task, std::size_t const argIndex) noexcept
+{
+    return (argIndex < task.m_dataAccess.size()) ? task.m_dataAccess[argIndex] : DataAccess::Write;
+}
+
 using TopTaskDataVec_t = KeyedVec<TaskId, TopTask>;
 
 } // namespace osp
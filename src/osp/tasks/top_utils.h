@@ -26,13 +26,16 @@
 
 #include "tasks.h"
 #include "builder.h"
+#include "top_coroutine.h"
 #include "top_tasks.h"
 #include "top_worker.h"
 
 #include <entt/core/any.hpp>
+#include <entt/core/type_info.hpp>
 
 #include <Corrade/Containers/ArrayViewStl.h>
 
+#include <array>
 #include <cassert>
 #include <functional>
 #include <type_traits>
@@ -110,7 +113,7 @@ template<typename FUNCTOR_T>
 struct wrap_args_trait
 {
     template<typename T>
-    static constexpr decltype(auto) cast_arg(ArrayView<entt::any> topData, WorkerContext ctx, std::size_t const argIndex)
+    static constexpr decltype(auto) cast_arg(ArrayView<void* const> args, WorkerContext ctx, std::size_t const argIndex)
     {
         if constexpr (std::is_same_v<T, WorkerContext>)
         {
@@ -118,28 +121,46 @@ struct wrap_args_trait
         }
         else
         {
-            LGRN_ASSERTMV(topData.size() > argIndex, "Task function has more arguments than TopDataIds provided", topData.size(), argIndex);
-            return entt::any_cast<T&>(topData[argIndex]);
+            LGRN_ASSERTMV(args.size() > argIndex, "Task function has more arguments than TopDataIds provided", args.size(), argIndex);
+            return *static_cast<std::remove_reference_t<T>*>(args[argIndex]);
         }
     }
 
     template<typename ... ARGS_T, std::size_t ... INDEX_T>
-    static constexpr decltype(auto) cast_args(ArrayView<entt::any> topData, WorkerContext ctx, [[maybe_unused]] std::index_sequence<INDEX_T...> indices) noexcept
+    static constexpr decltype(auto) cast_args(ArrayView<void* const> args, WorkerContext ctx, [[maybe_unused]] std::index_sequence<INDEX_T...> indices) noexcept
     {
-        return FUNCTOR_T{}(cast_arg<ARGS_T>(topData, ctx, INDEX_T) ...);
+        return FUNCTOR_T{}(cast_arg<ARGS_T>(args, ctx, INDEX_T) ...);
     }
 
     template<typename RETURN_T, typename ... ARGS_T>
-    static TaskActions wrapped_task([[maybe_unused]] WorkerContext ctx, ArrayView<entt::any> topData) noexcept
+    static TaskActions wrapped_task([[maybe_unused]] WorkerContext ctx, ArrayView<void* const> args) noexcept
     {
         if constexpr (std::is_void_v<RETURN_T>)
         {
-            cast_args<ARGS_T ...>(topData, ctx, std::make_index_sequence<sizeof...(ARGS_T)>{});
+            cast_args<ARGS_T ...>(args, ctx, std::make_index_sequence<sizeof...(ARGS_T)>{});
             return {};
         }
         else if constexpr (std::is_same_v<RETURN_T, TaskActions>)
         {
-            return cast_args<ARGS_T ...>(topData, ctx, std::make_index_sequence<sizeof...(ARGS_T)>{});
+            return cast_args<ARGS_T ...>(args, ctx, std::make_index_sequence<sizeof...(ARGS_T)>{});
+        }
+        else if constexpr (std::is_same_v<RETURN_T, TaskCoroutine>)
+        {
+            LGRN_ASSERTM(ctx.m_pCoroutine != nullptr, "Executor does not support coroutine tasks");
+            TaskCoroutine &rCoro = *ctx.m_pCoroutine;
+
+            if (rCoro.suspended())
+            {
+                rCoro.resume(ctx);
+            }
+            else
+            {
+                // Runs until the first co_await
+                rCoro = cast_args<ARGS_T ...>(args, ctx, std::make_index_sequence<sizeof...(ARGS_T)>{});
+            }
+
+            // Executor checks rCoro if suspended, see top_coroutine_park
+            return rCoro.suspended() ? TaskActions{} : rCoro.take_result();
         }
     }
 
@@ -149,16 +170,59 @@ struct wrap_args_trait
     {
         return &wrapped_task<RETURN_T, ARGS_T ...>;
     }
+
+    template<typename T>
+    static constexpr DataAccess arg_access() noexcept
+    {
+        if constexpr (std::is_reference_v<T> && ! std::is_const_v<std::remove_reference_t<T>>)
+        {
+            return DataAccess::Write;
+        }
+        else
+        {
+            return DataAccess::Read; // Const reference or passed by value
+        }
+    }
+
+    // Extract argument access modes from function pointer
+    template<typename RETURN_T, typename ... ARGS_T>
+    static constexpr std::array<DataAccess, sizeof...(ARGS_T)> unpack_access([[maybe_unused]] RETURN_T(*func)(ARGS_T...))
+    {
+        return { arg_access<ARGS_T>() ... };
+    }
+
+    template<typename T>
+    static entt::type_info const* arg_type() noexcept
+    {
+        if constexpr (std::is_same_v<T, WorkerContext>)
+        {
+            return nullptr;
+        }
+        else
+        {
+            return &entt::type_id< std::remove_cvref_t<T> >();
+        }
+    }
+
+    // Extract argument types from function pointer
+    template<typename RETURN_T, typename ... ARGS_T>
+    static std::array<entt::type_info const*, sizeof...(ARGS_T)> unpack_types([[maybe_unused]] RETURN_T(*func)(ARGS_T...))
+    {
+        return { arg_type<ARGS_T>() ... };
+    }
 };
 
 /**
  * @brief Wrap a function with arbitrary arguments into a TopTaskFunc_t
  *
- * A regular TopTaskFunc_t accepts a ArrayView<entt::any> for passing data of
- * arbitrary types. This needs to be manually casted.
+ * A regular TopTaskFunc_t accepts an ArrayView<void* const> of pointers to
+ * TopData of arbitrary types. These need to be manually casted.
  *
  * wrap_args creates a wrapper function that will automatically cast the
- * entt::anys and call the underlying function.
+ * pointers and call the underlying function. Types are not checked here; see
+ * wrap_args_types and top_bind_args.
+ *
+ * The function can return void, TaskActions, or TaskCoroutine to suspend and continue later.
  *
  * @param a[in]
  *
@@ -179,6 +243,33 @@ constexpr TopTaskFunc_t wrap_args(FUNC_T funcArg)
     return wrap_args_trait<FUNC_T>::unpack(functionPtr);
 }
 
+/**
+ * @brief Get how each argument of a function is accessed, for use with wrap_args
+ *
+ * Non-const references are DataAccess::Write, while const references and values are
+ * DataAccess::Read.
+ */
+template<typename FUNC_T>
+constexpr auto wrap_args_access(FUNC_T funcArg)
+{
+    static_assert ( ! std::is_function_v<FUNC_T>, "Support for function pointers not yet implemented");
+
+    return wrap_args_trait<FUNC_T>::unpack_access(+funcArg);
+}
+
+/**
+ * @brief Get the TopData type expected for each argument of a function, for use with wrap_args
+ *
+ * WorkerContext arguments are nullptr.
+ */
+template<typename FUNC_T>
+auto wrap_args_types(FUNC_T funcArg)
+{
+    static_assert ( ! std::is_function_v<FUNC_T>, "Support for function pointers not yet implemented");
+
+    return wrap_args_trait<FUNC_T>::unpack_types(+funcArg);
+}
+
 //-----------------------------------------------------------------------------
 
 struct TopTaskBuilder;
@@ -222,6 +313,18 @@ struct TopTaskTaskRef : public TaskRefBase<TopTaskBuilderTraits>
 
     inline TopTaskTaskRef& important_deps_count(int value);
 
+    /**
+     * @brief Restrict which thread the task can run on, see ETaskAffinity
+     *
+     * @param worker [in] Worker index, only used for ETaskAffinity::Worker
+     */
+    inline TopTaskTaskRef& affinity(ETaskAffinity value, uint32_t worker = 0);
+
+    /**
+     * @brief Only run on the thread that owns the executor, e.g. for OpenGL calls
+     */
+    TopTaskTaskRef& main_thread() { return affinity(ETaskAffinity::Main); }
+
     template<typename CONTAINER_T>
     TopTaskTaskRef& push_to(CONTAINER_T& rContainer);
 };
@@ -244,7 +347,14 @@ template<typename FUNC_T>
 TopTaskTaskRef& TopTaskTaskRef::func(FUNC_T&& funcArg)
 {
     m_rBuilder.m_rData.resize(m_rBuilder.m_rTasks.m_taskIds.capacity());
-    m_rBuilder.m_rData[m_taskId].m_func = wrap_args(funcArg);
+    TopTask &rTask = m_rBuilder.m_rData[m_taskId];
+
+    auto const access = wrap_args_access(funcArg);
+    auto const types  = wrap_args_types(funcArg);
+
+    rTask.m_func = wrap_args(funcArg);
+    rTask.m_dataAccess.assign(access.begin(), access.end());
+    rTask.m_dataTypes .assign(types.begin(), types.end());
     return *this;
 }
 
@@ -252,6 +362,16 @@ TopTaskTaskRef& TopTaskTaskRef::func_raw(TopTaskFunc_t func)
 {
     m_rBuilder.m_rData.resize(m_rBuilder.m_rTasks.m_taskIds.capacity());
     m_rBuilder.m_rData[m_taskId].m_func = func;
+    m_rBuilder.m_rData[m_taskId].m_dataAccess.clear(); // Unknown, assume everything is written
+    m_rBuilder.m_rData[m_taskId].m_dataTypes.clear();
+    return *this;
+}
+
+TopTaskTaskRef& TopTaskTaskRef::affinity(ETaskAffinity const value, uint32_t const worker)
+{
+    m_rBuilder.m_rData.resize(m_rBuilder.m_rTasks.m_taskIds.capacity());
+    m_rBuilder.m_rData[m_taskId].m_affinity       = value;
+    m_rBuilder.m_rData[m_taskId].m_affinityWorker = worker;
     return *this;
 }
 
@@ -34,6 +34,7 @@
 
 #include <array>
 #include <cstdint>
+#include <memory_resource>
 
 namespace osp
 {
@@ -43,11 +44,33 @@ using TopDataIds_t  = std::initializer_list<TopDataId>;
 
 struct Reserved {};
 
+struct TaskCoroutine;
+
 struct WorkerContext
 {
+    /// Index of the worker running the task. 0 is the thread that owns the executor.
+    uint32_t m_workerIndex { 0 };
+
+    /// Where the task's coroutine is kept while suspended. Null if the executor doesn't
+    /// support coroutine tasks, see TopCoroutines
+    TaskCoroutine *m_pCoroutine { nullptr };
+
+    /// For temporaries only used within the task, such as std::pmr::vector. Freed all at once
+    /// at the start of the executor's next wait(); don't keep anything allocated past the task
+    /// returning or suspending. Executors set this to a per-worker osp::FrameArena, which is
+    /// not thread-safe. TaskCoroutines may continue on other workers, so they must get this
+    /// from current_worker() instead of their WorkerContext argument.
+    std::pmr::memory_resource *m_pFrameMem { std::pmr::new_delete_resource() };
+
     //DependOnDirty_t m_dependOnDirty;
 };
 
-using TopTaskFunc_t = TaskActions(*)(WorkerContext, ArrayView<entt::any>) noexcept;
+/**
+ * @brief Type-erased task function
+ *
+ * Each argument points to the TopData listed in TopTask::m_dataUsed, or is nullptr if the
+ * TopDataId is null. See wrap_args.
+ */
+using TopTaskFunc_t = TaskActions(*)(WorkerContext, ArrayView<void* const>) noexcept;
 
 } // namespace osp
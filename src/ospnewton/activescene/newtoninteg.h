@@ -103,6 +103,7 @@ struct ACtxNwtWorld
     ColliderStorage_t                               m_colliders;
 
     osp::active::ACompTransformStorage_t            *m_pTransform;
+    osp::active::ActiveEntSet_t                     *m_pTransformDirty;
 };
 
 
@@ -82,6 +82,7 @@ void SysNewton::cb_set_transform(
     ActiveEnt const ent = rWorldCtx.m_bodyToEnt[bodyId];
 
     NewtonBodyGetMatrix(pBody, rWorldCtx.m_pTransform->get(ent).m_transform.data());
+    osp::active::mark_transform_dirty(*rWorldCtx.m_pTransformDirty, ent);
 } // cb_set_transform()
 
 
@@ -173,7 +174,8 @@ void SysNewton::update_world(
         ACtxNwtWorld&               rCtxWorld,
         float                       timestep,
         ACtxSceneGraph const&       rScnGraph,
-        ACompTransformStorage_t&    rTf) noexcept
+        ACompTransformStorage_t&    rTf,
+        ActiveEntSet_t&             rTfDirty) noexcept
 {
     NewtonWorld const* pNwtWorld = rCtxWorld.m_world.get();
 
@@ -186,7 +188,8 @@ void SysNewton::update_world(
         NewtonBodySetVelocity(pBody, vel.data());
     }
 
-    rCtxWorld.m_pTransform = std::addressof(rTf);
+    rCtxWorld.m_pTransform      = std::addressof(rTf);
+    rCtxWorld.m_pTransformDirty = std::addressof(rTfDirty);
 
     // Update the world
     NewtonUpdate(pNwtWorld, timestep);
@@ -207,6 +210,23 @@ void SysNewton::remove_components(ACtxNwtWorld& rCtxWorld, ActiveEnt ent) noexce
     rCtxWorld.m_colliders.remove(ent);
 }
 
+void SysNewton::update_remap(ACtxNwtWorld& rCtxWorld, osp::active::ActiveEntRemap const& remap) noexcept
+{
+    osp::id_remap_values(remap, rCtxWorld.m_bodyToEnt);
+
+    rCtxWorld.m_entToBody.clear();
+    for (std::size_t bodyInt = 0; bodyInt < rCtxWorld.m_bodyToEnt.size(); ++bodyInt)
+    {
+        ActiveEnt const ent = rCtxWorld.m_bodyToEnt[bodyInt];
+        if (ent != lgrn::id_null<ActiveEnt>())
+        {
+            rCtxWorld.m_entToBody.emplace(ent, BodyId(bodyInt));
+        }
+    }
+
+    osp::id_remap_keys(remap, rCtxWorld.m_colliders);
+}
+
 
 void SysNewton::find_colliders_recurse(
         ACtxPhysics const&                      rCtxPhys,
@@ -47,6 +47,7 @@ class SysNewton
     using ACtxSceneGraph            = osp::active::ACtxSceneGraph;
     using ACompTransform            = osp::active::ACompTransform;
     using ACompTransformStorage_t   = osp::active::ACompTransformStorage_t;
+    using ActiveEntSet_t            = osp::active::ActiveEntSet_t;
 public:
 
     using NwtThreadIndex_t = int;
@@ -100,6 +101,7 @@ public:
      * @param inputs        [ref] Physics inputs (from different threads)
      * @param rHier         [in] Storage for Hierarchy components
      * @param rTf           [ref] Relative transforms used by rigid bodies
+     * @param rTfDirty      [ref] Set for rigid bodies moved by this update
      * @param rTfControlled [ref] Flags for controlled transforms
      * @param rTfMutable    [ref] Flags for mutable transforms
      */
@@ -108,7 +110,8 @@ public:
             ACtxNwtWorld&                           rCtxWorld,
             float                                   timestep,
             ACtxSceneGraph const&                   rScnGraph,
-            osp::active::ACompTransformStorage_t&   rTf) noexcept;
+            osp::active::ACompTransformStorage_t&   rTf,
+            osp::active::ActiveEntSet_t&            rTfDirty) noexcept;
 
     static void remove_components(
             ACtxNwtWorld& rCtxWorld, ActiveEnt ent) noexcept;
@@ -124,6 +127,14 @@ public:
         }
     }
 
+    /**
+     * @brief Move per-ActiveEnt data to new IDs after osp::active::compact_active_ents
+     *
+     * Newton bodies only store BodyIds, so they're left untouched.
+     */
+    static void update_remap(
+            ACtxNwtWorld &rCtxWorld, osp::active::ActiveEntRemap const& remap) noexcept;
+
     static ACtxNwtWorld& context_from_nwtbody(NewtonBody const* const pBody)
     {
         return *static_cast<ACtxNwtWorld*>(NewtonWorldGetUserData(NewtonBodyGetWorld(pBody)));
@@ -187,6 +187,7 @@ void update_test_scene(EngineTestScene& rScene, float const delta)
     osp::Matrix4 &rCubeTf = rScene.m_basic.m_transform.get(rScene.m_cube).m_transform;
 
     rCubeTf = Magnum::Matrix4::rotationZ(90.0_degf * delta) * rCubeTf;
+    osp::active::mark_transform_dirty(rScene.m_basic.m_transformDirty, rScene.m_cube);
 }
 
 //-----------------------------------------------------------------------------
@@ -159,13 +159,14 @@ struct PlScene
     PipelineDef<EStgOptn> update            {"update"};
 };
 
-#define TESTAPP_DATA_COMMON_SCENE 6, \
-    idBasic, idDrawing, idDrawingRes, idActiveEntDel, idDrawEntDel, idNMesh
+#define TESTAPP_DATA_COMMON_SCENE 7, \
+    idBasic, idDrawing, idDrawingRes, idActiveEntDel, idDrawEntDel, idNMesh, idActiveEntRemap
 struct PlCommonScene
 {
     PipelineDef<EStgCont> activeEnt         {"activeEnt         - ACtxBasic::m_activeIds"};
     PipelineDef<EStgOptn> activeEntResized  {"activeEntResized  - ACtxBasic::m_activeIds option to resize"};
     PipelineDef<EStgIntr> activeEntDelete   {"activeEntDelete   - idActiveEntDel, vector of ActiveEnts that need to be deleted"};
+    PipelineDef<EStgIntr> activeEntRemap    {"activeEntRemap    - idActiveEntRemap, new IDs of ActiveEnts after compaction"};
 
     PipelineDef<EStgCont> transform         {"transform         - ACtxBasic::m_transform"};
     PipelineDef<EStgCont> hierarchy         {"hierarchy         - ACtxBasic::m_scnGraph"};
@@ -349,8 +350,8 @@ struct PlWindowApp
 
 
 
-#define TESTAPP_DATA_SCENE_RENDERER 2, \
-    idScnRender, idDrawTfObservers
+#define TESTAPP_DATA_SCENE_RENDERER 3, \
+    idScnRender, idDrawTfObservers, idBvh
 struct PlSceneRenderer
 {
     PipelineDef<EStgOptn> render            {"render            - "};
@@ -366,6 +367,7 @@ struct PlSceneRenderer
     PipelineDef<EStgIntr> materialDirty     {"materialDirty"};
 
     PipelineDef<EStgIntr> drawTransforms    {"drawTransforms"};
+    PipelineDef<EStgIntr> inView            {"inView"};
 
     PipelineDef<EStgCont> group             {"group"};
     PipelineDef<EStgCont> groupEnts         {"groupEnts"};
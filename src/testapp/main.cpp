@@ -60,6 +60,8 @@
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string_view>
 
 #include <thread>
@@ -95,12 +97,23 @@ void load_a_bunch_of_stuff();
 void debug_print_help();
 void debug_print_resources();
 
+// called only from commands to start/stop recording task times
+void debug_profile_start();
+void debug_profile_stop();
+
 TestApp g_testApp;
 
+constexpr char const* gc_profileTracePath = "osp_profile.json";
+
 SingleThreadedExecutor g_executor;
+std::optional<ThreadPoolExecutor> g_threadPoolExecutor;
 
 std::thread g_magnumThread;
 
+// Scene sessions are kept in g_testApp.m_graph after the renderer closes, so reopening the
+// renderer only needs to add its own tasks and edges
+bool g_graphHasScene = false;
+
 // Loggers
 std::shared_ptr<spdlog::logger> g_logTestApp;
 std::shared_ptr<spdlog::logger> g_logExecutor;
@@ -119,6 +132,8 @@ int main(int argc, char** argv)
         .addOption("config")                .setHelp("config",      "path to configuration file to use")
         .addBooleanOption("norepl")         .setHelp("norepl",      "don't enter read, evaluate, print, loop.")
         .addBooleanOption("log-exec")       .setHelp("log-exec",    "Log Task/Pipeline Execution (Extremely chatty!)")
+        .addOption("threads", "1")          .setHelp("threads",     "Number of threads to run tasks on (Experimental above 1)")
+        .addBooleanOption("static-schedule").setHelp("static-schedule", "Replay recorded task order for repeated runs (single-threaded only)")
         // TODO .addBooleanOption('v', "verbose")   .setHelp("verbose",     "log verbosely")
         .setGlobalHelp("Helptext goes here.")
         .parse(argc, argv);
@@ -139,11 +154,27 @@ int main(int argc, char** argv)
     // Set thread-local logger used by OSP_LOG_* macros
     osp::set_thread_logger(g_logTestApp);
 
-    g_testApp.m_pExecutor = &g_executor;
+    if (int const threads = args.value<int>("threads");
+        threads > 1)
+    {
+        g_threadPoolExecutor.emplace(threads);
+        g_testApp.m_pExecutor = &*g_threadPoolExecutor;
 
-    if (args.isSet("log-exec"))
+        if (args.isSet("log-exec"))
+        {
+            g_threadPoolExecutor->m_log = g_logExecutor;
+        }
+    }
+    else
     {
-        g_executor.m_log = g_logExecutor;
+        g_testApp.m_pExecutor = &g_executor;
+
+        if (args.isSet("log-exec"))
+        {
+            g_executor.m_log = g_logExecutor;
+        }
+
+        g_executor.m_staticSchedule = args.isSet("static-schedule");
     }
 
     g_testApp.m_topData.resize(64);
@@ -214,7 +245,9 @@ void debug_cli_loop()
                     g_testApp.close_sessions(g_testApp.m_scene.m_sessions);
                     g_testApp.m_scene.m_sessions.clear();
                     g_testApp.m_scene.m_edges.m_syncWith.clear();
+                    g_testApp.m_scene.m_edges.m_semaphoreEdges.clear();
                 }
+                g_graphHasScene = false;
 
                 g_testApp.m_rendererSetup = it->second.m_setup(g_testApp);
                 start_magnum_async();
@@ -244,6 +277,20 @@ void debug_cli_loop()
         {
             debug_print_resources();
         }
+        else if (command == "compact_ents")
+        {
+            bool const enabled = ! g_testApp.m_compactActiveEnts.load();
+            g_testApp.m_compactActiveEnts.store(enabled);
+            std::cout << "ActiveEnt ID compaction " << (enabled ? "enabled" : "disabled") << "\n";
+        }
+        else if (command == "profile_start")
+        {
+            debug_profile_start();
+        }
+        else if (command == "profile_stop")
+        {
+            debug_profile_stop();
+        }
         else if (command == "exit")
         {
             if (magnumOpen)
@@ -287,8 +334,26 @@ void start_magnum_async()
 
         g_testApp.m_rendererSetup(g_testApp);
 
-        g_testApp.m_graph = osp::make_exec_graph(g_testApp.m_tasks, {&g_testApp.m_renderer.m_edges, &g_testApp.m_scene.m_edges});
-        g_executor.load(g_testApp);
+        if (g_graphHasScene)
+        {
+            osp::update_exec_graph(g_testApp.m_tasks, g_testApp.m_graph, {&g_testApp.m_renderer.m_edges});
+        }
+        else
+        {
+            osp::update_exec_graph(g_testApp.m_tasks, g_testApp.m_graph, {&g_testApp.m_renderer.m_edges, &g_testApp.m_scene.m_edges});
+            g_graphHasScene = true;
+        }
+        g_testApp.m_pExecutor->load(g_testApp);
+
+        if (g_threadPoolExecutor.has_value())
+        {
+            // The executor never runs these at the same time, but they limit parallelism
+            for (auto const [taskA, taskB, data] : osp::top_find_data_conflicts(g_testApp.m_tasks, g_testApp.m_graph, g_testApp.m_taskData))
+            {
+                OSP_LOG_INFO("Unordered tasks share TopData {}: \"{}\" and \"{}\"", data,
+                             g_testApp.m_taskData[taskA].m_debugName, g_testApp.m_taskData[taskB].m_debugName);
+            }
+        }
 
         // Starts the main loop. This function is blocking, and will only return
         // once the window is closed. See MagnumApplication::drawEvent
@@ -303,6 +368,7 @@ void start_magnum_async()
         g_testApp.close_sessions(g_testApp.m_renderer.m_sessions);
         g_testApp.m_renderer.m_sessions.clear();
         g_testApp.m_renderer.m_edges.m_syncWith.clear();
+        g_testApp.m_renderer.m_edges.m_semaphoreEdges.clear();
 
         g_testApp.close_session(g_testApp.m_magnum);
         g_testApp.close_session(g_testApp.m_windowApp);
@@ -343,6 +409,7 @@ void load_a_bunch_of_stuff()
         .func([] (MainLoopControl const& rMainLoopCtrl) noexcept -> osp::TaskActions
     {
         if (   ! rMainLoopCtrl.doUpdate
+            && ! rMainLoopCtrl.doInputs
             && ! rMainLoopCtrl.doSync
             && ! rMainLoopCtrl.doResync
             && ! rMainLoopCtrl.doRender)
@@ -433,10 +500,49 @@ void debug_print_help()
 
     std::cout
         << "Other commands:\n"
-        << "* list_pkg  - List Packages and Resources\n"
-        << "* help      - Show this again\n"
-        << "* reopen    - Re-open Magnum Application\n"
-        << "* exit      - Deallocate everything and return memory to OS\n";
+        << "* list_pkg      - List Packages and Resources\n"
+        << "* help          - Show this again\n"
+        << "* reopen        - Re-open Magnum Application\n"
+        << "* compact_ents  - Toggle compacting ActiveEnt IDs when most are unused, off by default\n"
+        << "* profile_start - Start recording task and pipeline stage times\n"
+        << "* profile_stop  - Stop recording, show slowest tasks, and write " << gc_profileTracePath << "\n"
+        << "* exit          - Deallocate everything and return memory to OS\n";
+}
+
+void debug_profile_start()
+{
+    std::lock_guard<std::mutex> lock{g_testApp.m_profilerMutex};
+
+    if (g_testApp.m_profiler.capturing)
+    {
+        std::cout << "Already profiling\n";
+        return;
+    }
+
+    osp::profiler_start_capture(g_testApp.m_tasks, g_testApp.m_profiler);
+    std::cout << "Profiling started\n";
+}
+
+void debug_profile_stop()
+{
+    std::lock_guard<std::mutex> lock{g_testApp.m_profilerMutex};
+
+    if ( ! g_testApp.m_profiler.capturing )
+    {
+        std::cout << "Not profiling, use profile_start first\n";
+        return;
+    }
+
+    osp::profiler_stop_capture(g_testApp.m_profiler);
+
+    std::cout << osp::TopProfileWriteSummary{g_testApp.m_tasks, g_testApp.m_taskData, g_testApp.m_profiler, 20};
+
+    std::ofstream file{gc_profileTracePath};
+    file << osp::TopProfileWriteTrace{g_testApp.m_tasks, g_testApp.m_taskData, g_testApp.m_profiler};
+
+    std::cout << "Wrote " << g_testApp.m_profiler.taskRuns.size() << " task runs and "
+              << g_testApp.m_profiler.stageRuns.size() << " stage changes to " << gc_profileTracePath
+              << ", open with chrome://tracing or https://ui.perfetto.dev\n";
 }
 
 void debug_print_resources()
@@ -399,10 +399,11 @@ struct MainLoopSignals
 class CommonMagnumApp : public IOspApplication
 {
 public:
-    CommonMagnumApp(TestApp &rTestApp, MainLoopControl &rMainLoopCtrl, MainLoopSignals signals) noexcept
+    CommonMagnumApp(TestApp &rTestApp, MainLoopControl &rMainLoopCtrl, MainLoopSignals signals, FixedTimestep fixedStep) noexcept
      : m_rTestApp       { rTestApp }
      , m_rMainLoopCtrl  { rMainLoopCtrl }
      , m_signals        { signals }
+     , m_fixedStep      { fixedStep }
     { }
 
     void run(MagnumApplication& rApp) override
@@ -416,6 +417,7 @@ public:
 
         m_rMainLoopCtrl = MainLoopControl{
             .doUpdate = false,
+            .doInputs = false,
             .doSync   = true,
             .doResync = true,
             .doRender = false,
@@ -430,11 +432,34 @@ public:
     {
         // Magnum Application's main loop calls this
 
+        // Update the scene in fixed steps, as many as needed to catch up with real time. The
+        // renderer is synced each step to account for any DrawEnts added or removed.
+        int const steps = m_fixedStep.accumulate(delta);
+        for (int i = 0; i < steps; ++i)
+        {
+            m_rMainLoopCtrl = MainLoopControl{
+                .doUpdate               = true,
+                .doInputs               = false,
+                .doSync                 = true,
+                .doResync               = false,
+                .doRender               = false,
+                .doCompactActiveEnts    = m_rTestApp.m_compactActiveEnts.load(),
+            };
+
+            signal_all();
+
+            m_rTestApp.m_pExecutor->wait(m_rTestApp);
+        }
+
+        // Read inputs and render once per frame, interpolated between the last two steps
+
         m_rMainLoopCtrl = MainLoopControl{
-            .doUpdate = true,
-            .doSync   = true,
-            .doResync = false,
-            .doRender = true,
+            .doUpdate    = false,
+            .doInputs    = true,
+            .doSync      = true,
+            .doResync    = false,
+            .doRender    = true,
+            .interpAlpha = m_fixedStep.alpha(),
         };
 
         signal_all();
@@ -446,6 +471,7 @@ public:
     {
         m_rMainLoopCtrl = MainLoopControl{
             .doUpdate = false,
+            .doInputs = false,
             .doSync   = false,
             .doResync = false,
             .doRender = false,
@@ -479,11 +505,13 @@ private:
     MainLoopControl &m_rMainLoopCtrl;
 
     MainLoopSignals m_signals;
+    FixedTimestep   m_fixedStep;
 };
 
 void setup_magnum_draw(TestApp& rTestApp, Session const& scene, Session const& sceneRenderer, Session const& magnumScene)
 {
     OSP_DECLARE_GET_DATA_IDS(rTestApp.m_application,    TESTAPP_DATA_APPLICATION);
+    OSP_DECLARE_GET_DATA_IDS(scene,                     TESTAPP_DATA_SCENE);
     OSP_DECLARE_GET_DATA_IDS(sceneRenderer,             TESTAPP_DATA_SCENE_RENDERER);
     OSP_DECLARE_GET_DATA_IDS(rTestApp.m_magnum,         TESTAPP_DATA_MAGNUM);
     OSP_DECLARE_GET_DATA_IDS(magnumScene,               TESTAPP_DATA_MAGNUM_SCENE);
@@ -504,7 +532,10 @@ void setup_magnum_draw(TestApp& rTestApp, Session const& scene, Session const& s
         .sceneRender  = sceneRenderer          .get_pipelines<PlSceneRenderer>() .render,
     };
 
-    rActiveApp.set_osp_app( std::make_unique<CommonMagnumApp>(rTestApp, rMainLoopCtrl, signals) );
+    // Step the scene at the rate its tasks already assume
+    FixedTimestep const fixedStep{ .m_stepDelta = top_get<float>(rTestApp.m_topData, idDeltaTimeIn) };
+
+    rActiveApp.set_osp_app( std::make_unique<CommonMagnumApp>(rTestApp, rMainLoopCtrl, signals, fixedStep) );
 }
 
 } // namespace testapp
@@ -31,6 +31,8 @@
 #include <osp/tasks/top_utils.h>
 // IWYU pragma: end_exports
 
+#include <osp/core/fixed_timestep.h>
+
 #include <unordered_map>
 
 namespace testapp
@@ -50,9 +52,16 @@ namespace scenes
 struct MainLoopControl
 {
     bool doUpdate;
+    bool doInputs;
     bool doSync;
     bool doResync;
     bool doRender;
+
+    /// Compact ActiveEnt IDs this update if most of them are unused, see TestApp::m_compactActiveEnts
+    bool doCompactActiveEnts { false };
+
+    /// How far rendering is between the scene's previous and latest update, see osp::FixedTimestep
+    float interpAlpha { 1.0f };
 };
 
 struct ScenarioOption
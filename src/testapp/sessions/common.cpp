@@ -27,6 +27,7 @@
 
 #include <adera/drawing/CameraController.h>
 #include <osp/activescene/basic_fn.h>
+#include <osp/activescene/bvh_fn.h>
 #include <osp/core/Resources.h>
 #include <osp/core/unpack.h>
 #include <osp/drawing/drawing_fn.h>
@@ -40,6 +41,9 @@ using namespace osp::draw;
 namespace testapp::scenes
 {
 
+/// ActiveEnt IDs are only compacted once there's at least this many of them
+constexpr std::size_t gc_activeEntCompactMinCapacity = 1024;
+
 Session setup_scene(
         TopTaskBuilder&             rBuilder,
         ArrayView<entt::any> const  topData,
@@ -93,6 +97,7 @@ Session setup_common_scene(
 
     /* unused */          top_emplace< ActiveEntVec_t > (topData, idActiveEntDel);
     /* unused */          top_emplace< DrawEntVec_t >   (topData, idDrawEntDel);
+    /* unused */          top_emplace< ActiveEntRemap > (topData, idActiveEntRemap);
     auto &rBasic        = top_emplace< ACtxBasic >      (topData, idBasic);
     auto &rDrawing      = top_emplace< ACtxDrawing >    (topData, idDrawing);
     auto &rDrawingRes   = top_emplace< ACtxDrawingRes > (topData, idDrawingRes);
@@ -101,6 +106,7 @@ Session setup_common_scene(
     rBuilder.pipeline(tgCS.activeEnt)           .parent(tgScn.update);
     rBuilder.pipeline(tgCS.activeEntResized)    .parent(tgScn.update);
     rBuilder.pipeline(tgCS.activeEntDelete)     .parent(tgScn.update);
+    rBuilder.pipeline(tgCS.activeEntRemap)      .parent(tgScn.update);
     rBuilder.pipeline(tgCS.transform)           .parent(tgScn.update);
     rBuilder.pipeline(tgCS.hierarchy)           .parent(tgScn.update);
 
@@ -154,6 +160,52 @@ Session setup_common_scene(
         idActiveEntDel.clear();
     });
 
+    // ActiveEnt compaction runs at the start of the scene update, before anything else touches
+    // ActiveEnts, and only if MainLoopControl::doCompactActiveEnts is set. Sessions that keep
+    // their own per-ActiveEnt data add a task to activeEntRemap(UseOrRun) that rewrites it with
+    // idActiveEntRemap. Tasks on Prev stages that read ActiveEnts should sync with
+    // activeEntRemap(Clear) to run after all the remaps.
+
+    rBuilder.task()
+        .name       ("Compact ActiveEnt IDs if enabled and most of them are unused")
+        .run_on     ({tgCS.activeEntRemap(Modify_)})
+        .sync_with  ({tgCS.activeEnt(Prev), tgCS.transform(Prev), tgCS.hierarchy(Prev), tgCS.activeEntDelete(Resize)})
+        .push_to    (out.m_tasks)
+        .args       ({      idBasic,                idActiveEntRemap,                 idMainLoopCtrl })
+        .func([] (ACtxBasic& rBasic, ActiveEntRemap& rActiveEntRemap, MainLoopControl const& rMainLoopCtrl) noexcept
+    {
+        if ( ! rMainLoopCtrl.doCompactActiveEnts )
+        {
+            return;
+        }
+
+        std::size_t const capacity = rBasic.m_activeIds.capacity();
+        if (capacity >= gc_activeEntCompactMinCapacity && rBasic.m_activeIds.size() * 4 < capacity)
+        {
+            rActiveEntRemap = compact_active_ents(rBasic);
+        }
+    });
+
+    rBuilder.task()
+        .name       ("Cancel ActiveEnt remap tasks if IDs weren't compacted")
+        .run_on     ({tgCS.activeEntRemap(Schedule_)})
+        .push_to    (out.m_tasks)
+        .args       ({                  idActiveEntRemap })
+        .func([] (ActiveEntRemap const& rActiveEntRemap) noexcept
+    {
+        return rActiveEntRemap.oldToNew.empty() ? TaskAction::Cancel : TaskActions{};
+    });
+
+    rBuilder.task()
+        .name       ("Clear ActiveEnt remap once we're done with it")
+        .run_on     ({tgCS.activeEntRemap(Clear)})
+        .push_to    (out.m_tasks)
+        .args       ({            idActiveEntRemap })
+        .func([] (ActiveEntRemap& rActiveEntRemap) noexcept
+    {
+        rActiveEntRemap = {};
+    });
+
 
     // Clean up tasks
 
@@ -220,6 +272,16 @@ Session setup_window_app(
 
     out.m_cleanup = tgWin.cleanup;
 
+    rBuilder.task()
+        .name       ("Schedule Inputs")
+        .schedules  ({tgWin.inputs(Schedule)})
+        .push_to    (out.m_tasks)
+        .args       ({                  idMainLoopCtrl})
+        .func([] (MainLoopControl const& rMainLoopCtrl) noexcept -> osp::TaskActions
+    {
+        return rMainLoopCtrl.doInputs ? osp::TaskActions{} : osp::TaskAction::Cancel;
+    });
+
     rBuilder.task()
         .name       ("Schedule Renderer Sync")
         .schedules  ({tgWin.sync(Schedule)})
@@ -253,6 +315,7 @@ Session setup_scene_renderer(
         Session const&                  windowApp,
         Session const&                  commonScene)
 {
+    OSP_DECLARE_GET_DATA_IDS(application, TESTAPP_DATA_APPLICATION);
     OSP_DECLARE_GET_DATA_IDS(windowApp,   TESTAPP_DATA_WINDOW_APP);
     OSP_DECLARE_GET_DATA_IDS(commonScene, TESTAPP_DATA_COMMON_SCENE);
     auto const tgApp    = application   .get_pipelines< PlApplication >();
@@ -274,6 +337,7 @@ Session setup_scene_renderer(
     rBuilder.pipeline(tgScnRdr.entTextureDirty) .parent(tgWin.sync);
     rBuilder.pipeline(tgScnRdr.entMeshDirty)    .parent(tgWin.sync);
     rBuilder.pipeline(tgScnRdr.drawTransforms)  .parent(tgScnRdr.render);
+    rBuilder.pipeline(tgScnRdr.inView)          .parent(tgScnRdr.render);
     rBuilder.pipeline(tgScnRdr.material)        .parent(tgWin.sync);
     rBuilder.pipeline(tgScnRdr.materialDirty)   .parent(tgWin.sync);
     rBuilder.pipeline(tgScnRdr.group)           .parent(tgWin.sync);
@@ -287,6 +351,7 @@ Session setup_scene_renderer(
 
     auto &rScnRender = osp::top_emplace<ACtxSceneRender>(topData, idScnRender);
     /* unused */       osp::top_emplace<DrawTfObservers>(topData, idDrawTfObservers);
+    /* unused */       osp::top_emplace<ACtxBvh>(topData, idBvh);
 
     rBuilder.task()
         .name       ("Resize ACtxSceneRender containers to fit all DrawEnts")
@@ -303,10 +368,11 @@ Session setup_scene_renderer(
         .name       ("Resize ACtxSceneRender to fit ActiveEnts")
         .run_on     ({tgCS.activeEntResized(Run)})
         .push_to    (out.m_tasks)
-        .args       ({               idBasic,                  idScnRender})
-        .func([]    (ACtxBasic const &rBasic,  ACtxSceneRender& rScnRender) noexcept
+        .args       ({               idBasic,                  idScnRender,          idBvh})
+        .func([]    (ACtxBasic const &rBasic,  ACtxSceneRender& rScnRender, ACtxBvh& rBvh) noexcept
     {
         rScnRender.resize_active(rBasic.m_activeIds.capacity());
+        rBvh      .resize_active(rBasic.m_activeIds.capacity());
     });
 
     // Duplicate task needed for resync to account for existing ActiveEnts when the renderer opens,
@@ -316,10 +382,11 @@ Session setup_scene_renderer(
         .run_on     ({tgWin.resync(Run)})
         .sync_with  ({tgCS.activeEntResized(Run)})
         .push_to    (out.m_tasks)
-        .args       ({               idBasic,                  idScnRender})
-        .func([]    (ACtxBasic const &rBasic,  ACtxSceneRender& rScnRender) noexcept
+        .args       ({               idBasic,                  idScnRender,          idBvh})
+        .func([]    (ACtxBasic const &rBasic,  ACtxSceneRender& rScnRender, ACtxBvh& rBvh) noexcept
     {
         rScnRender.resize_active(rBasic.m_activeIds.capacity());
+        rBvh      .resize_active(rBasic.m_activeIds.capacity());
     });
 
     rBuilder.task()
@@ -344,26 +411,68 @@ Session setup_scene_renderer(
         return rScnRender.m_meshDirty.empty() ? TaskAction::Cancel : TaskActions{};
     });
 
+    rBuilder.task()
+        .name       ("Schedule Scene render")
+        .schedules  ({tgScnRdr.render(Schedule)})
+        .push_to    (out.m_tasks)
+        .args       ({                  idMainLoopCtrl})
+        .func([] (MainLoopControl const& rMainLoopCtrl) noexcept -> osp::TaskActions
+    {
+        return rMainLoopCtrl.doRender ? osp::TaskActions{} : osp::TaskAction::Cancel;
+    });
+
+    rBuilder.task()
+        .name       ("Save transforms to interpolate draw transforms from")
+        .run_on     ({tgCS.transform(Ready)})
+        .sync_with  ({tgCS.activeEntResized(Done)})
+        .push_to    (out.m_tasks)
+        .args       ({            idBasic,                  idScnRender})
+        .func([] (ACtxBasic const& rBasic, ACtxSceneRender& rScnRender) noexcept
+    {
+        SysRender::save_interp_transforms(rBasic.m_transform, rScnRender.m_tfInterp);
+    });
+
+    rBuilder.task()
+        .name       ("Hand over modified transforms to the renderer")
+        .run_on     ({tgCS.transform(Prev)})
+        .sync_with  ({tgCS.activeEntResized(Done), tgCS.activeEntRemap(Clear)})
+        .push_to    (out.m_tasks)
+        .args       ({      idBasic,                  idScnRender})
+        .func([] (ACtxBasic& rBasic, ACtxSceneRender& rScnRender) noexcept
+    {
+        // Transforms modified by the previous scene update may not have been drawn yet
+        SysRender::clear_transform_dirty(rBasic.m_transformDirty, rScnRender);
+    });
+
     rBuilder.task()
         .name       ("Calculate draw transforms")
         .run_on     ({tgScnRdr.render(Run)})
         .sync_with  ({tgCS.hierarchy(Ready), tgCS.transform(Ready), tgCS.activeEnt(Ready), tgScnRdr.drawTransforms(Modify_), tgScnRdr.drawEnt(Ready), tgScnRdr.drawEntResized(Done), tgCS.activeEntResized(Done)})
         .push_to    (out.m_tasks)
-        .args       ({            idBasic,                   idDrawing,                 idScnRender,                 idDrawTfObservers })
-        .func([] (ACtxBasic const& rBasic, ACtxDrawing const& rDrawing, ACtxSceneRender& rScnRender, DrawTfObservers &rDrawTfObservers) noexcept
+        .args       ({            idBasic,                   idDrawing,                 idScnRender,                 idDrawTfObservers,          idBvh,                 idMainLoopCtrl })
+        .func([] (ACtxBasic const& rBasic, ACtxDrawing const& rDrawing, ACtxSceneRender& rScnRender, DrawTfObservers &rDrawTfObservers, ACtxBvh& rBvh, MainLoopControl const& rMainLoopCtrl) noexcept
     {
-        auto rootChildren = SysSceneGraph::children(rBasic.m_scnGraph);
-        SysRender::update_draw_transforms(
+        rScnRender.m_drawTfChanged.clear();
+
+        SysRender::take_transform_dirty(rBasic.m_transformDirty, rScnRender);
+
+        // Scene updates at a fixed rate, draw partway between its two most recent states.
+        // m_tfInterp is always passed so entities drawn partway last frame are still updated
+        // once interpolation stops.
+        SysRender::update_draw_transforms_dirty(
                 {
                     .scnGraph     = rBasic    .m_scnGraph,
                     .transforms   = rBasic    .m_transform,
                     .activeToDraw = rScnRender.m_activeToDraw,
                     .needDrawTf   = rScnRender.m_needDrawTf,
-                    .rDrawTf      = rScnRender.m_drawTransform
+                    .rDrawTf      = rScnRender.m_drawTransform,
+                    .pInterp      = &rScnRender.m_tfInterp,
+                    .interpAlpha  = rMainLoopCtrl.interpAlpha
                 },
-                rootChildren.begin(),
-                rootChildren.end(),
-                [&rDrawTfObservers, &rScnRender] (Matrix4 const& transform, active::ActiveEnt ent, int depth)
+                rScnRender.m_transformDirty,
+                rScnRender.m_drawTfCache,
+                rScnRender.m_drawTfChanged,
+                [&rDrawTfObservers, &rScnRender, &rDrawing, &rBvh] (Matrix4 const& transform, active::ActiveEnt ent, int depth)
         {
             auto const enableInt  = std::array{rScnRender.drawTfObserverEnable[ent]};
             auto const enableBits = lgrn::bit_view(enableInt);
@@ -373,7 +482,54 @@ Session setup_scene_renderer(
                 DrawTfObservers::Observer const &rObserver = rDrawTfObservers.observers[idx];
                 rObserver.func(rScnRender, transform, ent, depth, rObserver.data);
             }
+
+            // Keep the BVH in sync with entities drawn with a mesh
+            DrawEnt const drawEnt = rScnRender.m_activeToDraw[ent];
+            Range3D const* pBounds = (drawEnt != lgrn::id_null<DrawEnt>())
+                                   ? SysRender::find_mesh_bounds(rScnRender, rDrawing, drawEnt)
+                                   : nullptr;
+            if (pBounds != nullptr)
+            {
+                rBvh.m_localBounds[ent] = *pBounds;
+                rBvh.m_hasLocalBounds.set(ent.value);
+                SysBvh::update_transform(rBvh, transform, ent);
+            }
+            else if (SysBvh::contains(rBvh, ent))
+            {
+                // Lost its DrawEnt or mesh since it was inserted
+                SysBvh::remove(rBvh, ent);
+                rBvh.m_hasLocalBounds.reset(ent.value);
+            }
         });
+
+        rScnRender.m_transformDirty.reset();
+    });
+
+    rBuilder.task()
+        .name       ("Mark entities with changed meshes to update their BVH bounds")
+        .run_on     ({tgScnRdr.entMeshDirty(UseOrRun)})
+        .sync_with  ({tgScnRdr.entMesh(Ready), tgScnRdr.drawEntResized(Done), tgCS.activeEntResized(Done)})
+        .push_to    (out.m_tasks)
+        .args       ({            idScnRender })
+        .func([] (ACtxSceneRender& rScnRender) noexcept
+    {
+        // Mesh bounds are only read when draw transforms are calculated, so treat these as moved
+        // even if their transforms didn't change
+        DrawEntSet_t meshDirty;
+        bitvector_resize(meshDirty, rScnRender.m_drawIds.capacity());
+        for (DrawEnt const drawEnt : rScnRender.m_meshDirty)
+        {
+            meshDirty.set(std::size_t(drawEnt));
+        }
+
+        for (std::size_t const entInt : rScnRender.m_needDrawTf.ones())
+        {
+            DrawEnt const drawEnt = rScnRender.m_activeToDraw[ActiveEnt(entInt)];
+            if (drawEnt != lgrn::id_null<DrawEnt>() && meshDirty.test(std::size_t(drawEnt)))
+            {
+                rScnRender.m_transformDirty.set(entInt);
+            }
+        }
     });
 
     rBuilder.task()
@@ -390,6 +546,11 @@ Session setup_scene_renderer(
             {
                 continue;
             }
+            rScnRender.m_tfInterp.m_hasPrev.reset(ent.value);
+            rScnRender.m_tfInterp.m_hasLast.reset(ent.value);
+            rScnRender.m_transformDirty     .reset(ent.value);
+            rScnRender.m_transformDirtyTaken.reset(ent.value);
+
             DrawEnt const drawEnt = std::exchange(rScnRender.m_activeToDraw[ent], lgrn::id_null<DrawEnt>());
             if (drawEnt != lgrn::id_null<DrawEnt>())
             {
@@ -398,6 +559,27 @@ Session setup_scene_renderer(
         }
     });
 
+    rBuilder.task()
+        .name       ("Remap ACtxSceneRender and BVH to compacted ActiveEnt IDs")
+        .run_on     ({tgCS.activeEntRemap(UseOrRun)})
+        .push_to    (out.m_tasks)
+        .args       ({            idScnRender,          idBvh,                      idActiveEntRemap })
+        .func([] (ACtxSceneRender& rScnRender, ACtxBvh& rBvh, ActiveEntRemap const& rActiveEntRemap) noexcept
+    {
+        SysRender::update_remap_drawing(rScnRender, rActiveEntRemap);
+        SysBvh::update_remap(rBvh, rActiveEntRemap);
+    });
+
+    rBuilder.task()
+        .name       ("Remove deleted ActiveEnts from BVH")
+        .run_on     ({tgCS.activeEntDelete(UseOrRun)})
+        .push_to    (out.m_tasks)
+        .args       ({    idBvh,                      idActiveEntDel })
+        .func([] (ACtxBvh& rBvh, ActiveEntVec_t const& rActiveEntDel) noexcept
+    {
+        SysBvh::update_delete(rBvh, rActiveEntDel.cbegin(), rActiveEntDel.cend());
+    });
+
     rBuilder.task()
         .name       ("Delete drawing components")
         .run_on     ({tgScnRdr.drawEntDelete(UseOrRun)})
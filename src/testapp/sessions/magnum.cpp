@@ -30,6 +30,8 @@
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/Renderer.h>
 
+#include <Corrade/Containers/ArrayViewStl.h>
+
 #include <adera/drawing/CameraController.h>
 #include <adera/drawing_gl/flat_shader.h>
 #include <adera/drawing_gl/phong_shader.h>
@@ -94,6 +96,7 @@ Session setup_magnum(
         .name       ("Clean up Magnum renderer")
         .run_on     ({tgWin.cleanup(Run_)})
         .push_to    (out.m_tasks)
+        .main_thread()
         .args       ({      idResources,          idRenderGl})
         .func([] (Resources& rResources, RenderGL& rRenderGl) noexcept
     {
@@ -161,6 +164,7 @@ Session setup_magnum_scene(
         .run_on     ({tgScnRdr.meshResDirty(UseOrRun)})
         .sync_with  ({tgScnRdr.mesh(Ready), tgMgn.meshGL(New), tgScnRdr.entMeshDirty(UseOrRun)})
         .push_to    (out.m_tasks)
+        .main_thread()
         .args       ({                 idDrawingRes,                idResources,          idRenderGl })
         .func([] (ACtxDrawingRes const& rDrawingRes, osp::Resources& rResources, RenderGL& rRenderGl) noexcept
     {
@@ -172,6 +176,7 @@ Session setup_magnum_scene(
         .run_on     ({tgScnRdr.textureResDirty(UseOrRun)})
         .sync_with  ({tgScnRdr.texture(Ready), tgMgn.textureGL(New)})
         .push_to    (out.m_tasks)
+        .main_thread()
         .args       ({                 idDrawingRes,                idResources,          idRenderGl })
         .func([] (ACtxDrawingRes const& rDrawingRes, osp::Resources& rResources, RenderGL& rRenderGl) noexcept
     {
@@ -183,6 +188,7 @@ Session setup_magnum_scene(
         .run_on     ({tgScnRdr.entTextureDirty(UseOrRun)})
         .sync_with  ({tgScnRdr.texture(Ready), tgScnRdr.entTexture(Ready), tgMgn.textureGL(Ready), tgMgn.entTextureGL(Modify), tgScnRdr.drawEntResized(Done)})
         .push_to    (out.m_tasks)
+        .main_thread()
         .args       ({        idDrawing,                idDrawingRes,                 idScnRender,                   idScnRenderGl,          idRenderGl })
         .func([] (ACtxDrawing& rDrawing, ACtxDrawingRes& rDrawingRes, ACtxSceneRender& rScnRender, ACtxSceneRenderGL& rScnRenderGl, RenderGL& rRenderGl) noexcept
     {
@@ -200,6 +206,7 @@ Session setup_magnum_scene(
         .run_on     ({tgWin.resync(Run)})
         .sync_with  ({tgScnRdr.texture(Ready), tgMgn.textureGL(Ready), tgMgn.entTextureGL(Modify), tgScnRdr.drawEntResized(Done)})
         .push_to    (out.m_tasks)
+        .main_thread()
         .args       ({           idDrawingRes,                 idScnRender,                   idScnRenderGl,          idRenderGl })
         .func([] (ACtxDrawingRes& rDrawingRes, ACtxSceneRender& rScnRender, ACtxSceneRenderGL& rScnRenderGl, RenderGL& rRenderGl) noexcept
     {
@@ -219,6 +226,7 @@ Session setup_magnum_scene(
         .run_on     ({tgScnRdr.entMeshDirty(UseOrRun)})
         .sync_with  ({tgScnRdr.mesh(Ready), tgScnRdr.entMesh(Ready), tgMgn.meshGL(Ready), tgMgn.entMeshGL(Modify), tgScnRdr.drawEntResized(Done)})
         .push_to    (out.m_tasks)
+        .main_thread()
         .args       ({           idDrawingRes,                 idScnRender,                   idScnRenderGl,          idRenderGl })
         .func([] (ACtxDrawingRes& rDrawingRes, ACtxSceneRender& rScnRender, ACtxSceneRenderGL& rScnRenderGl, RenderGL& rRenderGl) noexcept
     {
@@ -236,6 +244,7 @@ Session setup_magnum_scene(
         .run_on     ({tgWin.resync(Run)})
         .sync_with  ({tgScnRdr.mesh(Ready), tgMgn.meshGL(Ready), tgMgn.entMeshGL(Modify), tgScnRdr.drawEntResized(Done)})
         .push_to    (out.m_tasks)
+        .main_thread()
         .args       ({           idDrawingRes,                 idScnRender,                   idScnRenderGl,          idRenderGl })
         .func([] (ACtxDrawingRes& rDrawingRes, ACtxSceneRender& rScnRender, ACtxSceneRenderGL& rScnRenderGl, RenderGL& rRenderGl) noexcept
     {
@@ -255,6 +264,7 @@ Session setup_magnum_scene(
         .run_on     ({tgScnRdr.render(Run)})
         .sync_with  ({tgMgnScn.fbo(EStgFBO::Bind)})
         .push_to    (out.m_tasks)
+        .main_thread()
         .args       ({              idDrawing,          idRenderGl,                   idGroupFwd,              idCamera })
         .func([] (ACtxDrawing const& rDrawing, RenderGL& rRenderGl, RenderGroup const& rGroupFwd, Camera const& rCamera) noexcept
     {
@@ -271,20 +281,40 @@ Session setup_magnum_scene(
                     | FramebufferClear::Stencil);
     });
 
+    // Culling doesn't touch OpenGL, so it runs on any worker ahead of the render task
+    rBuilder.task()
+        .name       ("Find DrawEnts in view of the camera")
+        .run_on     ({tgScnRdr.render(Run)})
+        .sync_with  ({tgMgnScn.camera(Ready), tgScnRdr.drawTransforms(UseOrRun), tgScnRdr.inView(Modify_), tgScnRdr.entMesh(Ready), tgScnRdr.drawEnt(Ready)})
+        .push_to    (out.m_tasks)
+        .args       ({            idScnRender,                    idDrawing,              idCamera })
+        .func([] (ACtxSceneRender& rScnRender, ACtxDrawing const& rDrawing, Camera const& rCamera) noexcept
+    {
+        ViewProjMatrix const viewProj{rCamera.m_transform.inverted(), rCamera.perspective()};
+        SysRender::cull_frustum(rScnRender, rDrawing, rScnRender.m_visible, viewProj, rScnRender.m_inView);
+    });
+
     rBuilder.task()
         .name       ("Render Entities")
         .run_on     ({tgScnRdr.render(Run)})
-        .sync_with  ({tgScnRdr.group(Ready), tgScnRdr.groupEnts(Ready), tgMgnScn.camera(Ready), tgScnRdr.drawTransforms(UseOrRun), tgScnRdr.entMesh(Ready), tgScnRdr.entTexture(Ready),
+        .sync_with  ({tgScnRdr.group(Ready), tgScnRdr.groupEnts(Ready), tgMgnScn.camera(Ready), tgScnRdr.drawTransforms(UseOrRun), tgScnRdr.inView(UseOrRun), tgScnRdr.entMesh(Ready), tgScnRdr.entTexture(Ready),
                       tgMgn.entMeshGL(Ready), tgMgn.entTextureGL(Ready),
                       tgScnRdr.drawEnt(Ready)})
         .push_to    (out.m_tasks)
-        .args       ({            idScnRender,          idRenderGl,                   idGroupFwd,              idCamera })
-        .func([] (ACtxSceneRender& rScnRender, RenderGL& rRenderGl, RenderGroup const& rGroupFwd, Camera const& rCamera, WorkerContext ctx) noexcept
+        .main_thread()
+        .args       ({            idScnRender,                    idDrawing,                 idScnRenderGl,          idRenderGl,                   idGroupFwd,              idCamera })
+        .func([] (ACtxSceneRender& rScnRender, ACtxDrawing const& rDrawing, ACtxSceneRenderGL& rScnRenderGl, RenderGL& rRenderGl, RenderGroup const& rGroupFwd, Camera const& rCamera, WorkerContext ctx) noexcept
     {
         ViewProjMatrix viewProj{rCamera.m_transform.inverted(), rCamera.perspective()};
 
+        DrawCommandList &rCommands = rScnRenderGl.m_fwdCommands;
+        rCommands.m_commands.clear();
+        SysRenderGL::build_draw_commands(rGroupFwd, rScnRender.m_inView, rScnRender, rScnRenderGl,
+                                         viewProj, 0, false, rCamera.m_far, rCommands);
+        SysRender::sort_draw_commands(rCommands);
+
         // Forward Render fwd_opaque group to FBO
-        SysRenderGL::render_opaque(rGroupFwd, rScnRender.m_visible, viewProj);
+        SysRenderGL::render_opaque(rGroupFwd, Corrade::Containers::arrayView(rCommands.m_commands), viewProj);
     });
 
     rBuilder.task()
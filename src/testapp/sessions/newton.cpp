@@ -86,15 +86,26 @@ Session setup_newton(
         SysNewton::update_delete (rNwt, rActiveEntDel.cbegin(), rActiveEntDel.cend());
     });
 
+    rBuilder.task()
+        .name       ("Remap Newton components to compacted ActiveEnt IDs")
+        .run_on     ({tgCS.activeEntRemap(UseOrRun)})
+        .sync_with  ({tgNwt.nwtBody(Prev)})
+        .push_to    (out.m_tasks)
+        .args({                idNwt,                      idActiveEntRemap })
+        .func([] (ACtxNwtWorld& rNwt, ActiveEntRemap const& rActiveEntRemap) noexcept
+    {
+        SysNewton::update_remap(rNwt, rActiveEntRemap);
+    });
+
     rBuilder.task()
         .name       ("Update Newton world")
         .run_on     ({tgScn.update(Run)})
-        .sync_with  ({tgNwt.nwtBody(Prev), tgCS.hierarchy(Prev), tgPhy.physBody(Prev), tgPhy.physUpdate(Run), tgCS.transform(Prev)})
+        .sync_with  ({tgNwt.nwtBody(Prev), tgCS.hierarchy(Prev), tgPhy.physBody(Prev), tgPhy.physUpdate(Run), tgCS.transform(Prev), tgCS.activeEntRemap(Clear)})
         .push_to    (out.m_tasks)
         .args({             idBasic,             idPhys,              idNwt,           idDeltaTimeIn })
         .func([] (ACtxBasic& rBasic, ACtxPhysics& rPhys, ACtxNwtWorld& rNwt, float const deltaTimeIn, WorkerContext ctx) noexcept
     {
-        SysNewton::update_world(rPhys, rNwt, deltaTimeIn, rBasic.m_scnGraph, rBasic.m_transform);
+        SysNewton::update_world(rPhys, rNwt, deltaTimeIn, rBasic.m_scnGraph, rBasic.m_transform, rBasic.m_transformDirty);
     });
 
     top_emplace< ACtxNwtWorld >(topData, idNwt, 2);
@@ -493,15 +504,15 @@ struct ACtxRocketsNwt
 };
 
 static void assign_rockets(
-        ACtxBasic const&            rBasic,
-        ACtxParts const&            rScnParts,
-        ACtxNwtWorld&               rNwt,
-        ACtxRocketsNwt&             rRocketsNwt,
-        Nodes const&                rFloatNodes,
-        PerMachType const&          machtypeRocket,
-        ForceFactors_t const&       rNwtFactors,
-        WeldId const                weld,
-        std::vector<BodyRocket>&    rTemp)
+        ACtxBasic const&                rBasic,
+        ACtxParts const&                rScnParts,
+        ACtxNwtWorld&                   rNwt,
+        ACtxRocketsNwt&                 rRocketsNwt,
+        Nodes const&                    rFloatNodes,
+        PerMachType const&              machtypeRocket,
+        ForceFactors_t const&           rNwtFactors,
+        WeldId const                    weld,
+        std::pmr::vector<BodyRocket>&   rTemp)
 {
     using adera::gc_mtMagicRocket;
     using adera::ports_magicrocket::gc_throttleIn;
@@ -669,7 +680,7 @@ Session setup_rocket_thrust_newton(
         .sync_with  ({tgParts.weldIds(Ready), tgNwt.nwtBody(Ready), tgParts.connect(Ready)})
         .push_to    (out.m_tasks)
         .args       ({      idBasic,             idPhys,              idNwt,                 idScnParts,                idRocketsNwt,                      idNwtFactors})
-        .func([] (ACtxBasic& rBasic, ACtxPhysics& rPhys, ACtxNwtWorld& rNwt, ACtxParts const& rScnParts, ACtxRocketsNwt& rRocketsNwt, ForceFactors_t const& rNwtFactors) noexcept
+        .func([] (ACtxBasic& rBasic, ACtxPhysics& rPhys, ACtxNwtWorld& rNwt, ACtxParts const& rScnParts, ACtxRocketsNwt& rRocketsNwt, ForceFactors_t const& rNwtFactors, WorkerContext ctx) noexcept
     {
         using adera::gc_mtMagicRocket;
 
@@ -679,7 +690,7 @@ Session setup_rocket_thrust_newton(
         rRocketsNwt.m_bodyRockets.ids_reserve(rNwt.m_bodyIds.size());
         rRocketsNwt.m_bodyRockets.data_reserve(rScnParts.machines.perType[gc_mtMagicRocket].localIds.capacity());
 
-        std::vector<BodyRocket> temp;
+        std::pmr::vector<BodyRocket> temp{ctx.m_pFrameMem};
 
         for (WeldId const weld : rScnParts.weldDirty)
         {
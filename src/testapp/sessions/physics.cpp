@@ -78,6 +78,17 @@ Session setup_physics(
         SysPhysics::update_delete_phys(rPhys, rActiveEntDel.cbegin(), rActiveEntDel.cend());
     });
 
+    rBuilder.task()
+        .name       ("Remap Physics components to compacted ActiveEnt IDs")
+        .run_on     ({tgCS.activeEntRemap(UseOrRun)})
+        .sync_with  ({tgPhy.physBody(Prev)})
+        .push_to    (out.m_tasks)
+        .args       ({        idPhys,                      idActiveEntRemap })
+        .func([] (ACtxPhysics& rPhys, ActiveEntRemap const& rActiveEntRemap) noexcept
+    {
+        SysPhysics::update_remap_phys(rPhys, rActiveEntRemap);
+    });
+
     return out;
 } // setup_physics
 
@@ -112,6 +123,17 @@ Session setup_prefabs(
 
     top_emplace< ACtxPrefabs > (topData, idPrefabs);
 
+    rBuilder.task()
+        .name       ("Remap Prefab instance info to compacted ActiveEnt IDs")
+        .run_on     ({tgCS.activeEntRemap(UseOrRun)})
+        .sync_with  ({tgPf.instanceInfo(Prev)})
+        .push_to    (out.m_tasks)
+        .args       ({        idPrefabs,                      idActiveEntRemap })
+        .func([] (ACtxPrefabs& rPrefabs, ActiveEntRemap const& rActiveEntRemap) noexcept
+    {
+        SysPrefabInit::update_remap_prefabs(rPrefabs, rActiveEntRemap);
+    });
+
     rBuilder.task()
         .name       ("Schedule Prefab spawn")
         .schedules  ({tgPf.spawnRequest(Schedule_)})
@@ -29,6 +29,7 @@
 
 #include <osp/activescene/basic.h>
 #include <osp/activescene/physics_fn.h>
+#include <osp/core/id_remap.h>
 #include <osp/drawing/drawing_fn.h>
 #include <osp/drawing/prefab_draw.h>
 
@@ -200,6 +201,17 @@ Session setup_phys_shapes(
         update_delete_basic(rBasic, rActiveEntDel.cbegin(), rActiveEntDel.cend());
     });
 
+    rBuilder.task()
+        .name       ("Remap owned shapes to compacted ActiveEnt IDs")
+        .run_on     ({tgCS.activeEntRemap(UseOrRun)})
+        .sync_with  ({tgCS.transform(Prev)})
+        .push_to    (out.m_tasks)
+        .args       ({           idPhysShapes,                      idActiveEntRemap })
+        .func([] (ACtxPhysShapes& rPhysShapes, ActiveEntRemap const& rActiveEntRemap) noexcept
+    {
+        osp::id_remap_keys(rActiveEntRemap, rPhysShapes.ownedEnts);
+    });
+
     rBuilder.task()
         .name       ("Clear Shape Spawning vector after use")
         .run_on     ({tgShSp.spawnRequest(Clear)})
@@ -588,6 +600,17 @@ Session setup_bounds(
         }
     });
 
+    rBuilder.task()
+        .name       ("Remap bounds to compacted ActiveEnt IDs")
+        .run_on     ({tgCS.activeEntRemap(UseOrRun)})
+        .sync_with  ({tgBnds.boundsSet(Prev)})
+        .push_to    (out.m_tasks)
+        .args       ({                 idActiveEntRemap,                idBounds })
+        .func([] (ActiveEntRemap const& rActiveEntRemap, ActiveEntSet_t& rBounds) noexcept
+    {
+        osp::id_remap_keys(rActiveEntRemap, rBounds);
+    });
+
     return out;
 } // setup_bounds
 
@@ -31,6 +31,7 @@
 #include <osp/activescene/basic.h>
 #include <osp/activescene/physics.h>
 #include <osp/activescene/prefab_fn.h>
+#include <osp/activescene/vehicles.h>
 #include <osp/core/Resources.h>
 #include <osp/drawing/drawing.h>
 #include <osp/util/UserInputHandler.h>
@@ -206,6 +207,7 @@ Session setup_vehicle_spawn_vb(
     OSP_DECLARE_GET_DATA_IDS(prefabs,       TESTAPP_DATA_PREFABS);
     OSP_DECLARE_GET_DATA_IDS(signalsFloat,  TESTAPP_DATA_SIGNALS_FLOAT);
     OSP_DECLARE_GET_DATA_IDS(vehicleSpawn,  TESTAPP_DATA_VEHICLE_SPAWN);
+    auto const tgCS     = commonScene   .get_pipelines<PlCommonScene>();
     auto const tgPf     = prefabs       .get_pipelines<PlPrefabs>();
     auto const tgScn    = scene         .get_pipelines<PlScene>();
     auto const tgParts  = parts         .get_pipelines<PlParts>();
@@ -481,6 +483,17 @@ Session setup_vehicle_spawn_vb(
         }
     });
 
+    rBuilder.task()
+        .name       ("Remap Part and Weld ActiveEnts to compacted ActiveEnt IDs")
+        .run_on     ({tgCS.activeEntRemap(UseOrRun)})
+        .sync_with  ({tgParts.mapPartActive(Prev), tgParts.mapWeldActive(Prev)})
+        .push_to    (out.m_tasks)
+        .args       ({      idScnParts,                      idActiveEntRemap })
+        .func([] (ACtxParts& rScnParts, ActiveEntRemap const& rActiveEntRemap) noexcept
+    {
+        update_remap_parts(rScnParts, rActiveEntRemap);
+    });
+
     rBuilder.task()
         .name       ("Copy float signal values from VehicleBuilder")
         .run_on     ({tgVhSp.spawnRequest(UseOrRun)})
@@ -213,6 +213,10 @@ Session setup_thrust_indicators(
             rScnRender.drawTfObserverEnable [partEnt] = 1;
 
             SysRender::needs_draw_transforms(rBasic.m_scnGraph, rScnRender.m_needDrawTf, partEnt);
+
+            // Indicator length follows throttle, not just the part's transform. Recalculate the
+            // part's draw transform every frame so the observer below runs.
+            mark_transform_dirty(rBasic.m_transformDirty, partEnt);
         }
     });
 
@@ -71,6 +71,8 @@ void TestApp::close_sessions(osp::ArrayView<osp::Session> const sessions)
             TopTask &rCurrTaskData = m_taskData[task];
             rCurrTaskData.m_debugName.clear();
             rCurrTaskData.m_dataUsed.clear();
+            rCurrTaskData.m_dataAccess.clear();
+            rCurrTaskData.m_dataTypes.clear();
             rCurrTaskData.m_func = nullptr;
         }
         rSession.m_tasks.clear();
@@ -83,7 +85,17 @@ void TestApp::close_sessions(osp::ArrayView<osp::Session> const sessions)
             m_tasks.m_pipelineControl[pipeline] = {};
         }
         rSession.m_pipelines.clear();
+
+        for (SemaphoreId const semaphore : rSession.m_semaphores)
+        {
+            m_tasks.m_semaIds.remove(semaphore);
+            m_tasks.m_semaLimits[semaphore] = 0;
+        }
+        rSession.m_semaphores.clear();
     }
+
+    // Drop the closed sessions from the graph before any of their IDs are reused
+    update_exec_graph(m_tasks, m_graph, {});
 }
 
 
@@ -155,10 +167,57 @@ void TestApp::clear_resource_owners()
 //-----------------------------------------------------------------------------
 
 
+/**
+ * @brief Move new ExecLog records out of the ring buffer, and pass them to the profiler if any
+ */
+static void drain_exec_log(osp::ExecContext &rExec, std::vector<osp::ExecLogRecord> &rRecords, osp::TaskProfiler *pProfiler)
+{
+    std::size_t const first = rRecords.size();
+    osp::exec_log_ring_drain(rExec.logRing, rRecords);
+
+    if (pProfiler != nullptr)
+    {
+        osp::profiler_read_log(*pProfiler, osp::arrayView(rRecords).slice(first, rRecords.size()), osp::ProfileClock_t::now());
+    }
+}
+
+/**
+ * @brief Prioritize tasks on the critical path, using run times measured by the profiler so far
+ *
+ * Lock TestAppTasks::m_profilerMutex before calling.
+ */
+static void update_task_priorities(TestAppTasks const& rAppTasks, osp::ExecContext &rExec)
+{
+    osp::KeyedVec<osp::TaskId, uint64_t> durationsNs;
+    osp::KeyedVec<osp::TaskId, uint64_t> critPathNs;
+
+    durationsNs.resize(rAppTasks.m_tasks.m_taskIds.capacity(), 1);
+
+    std::size_t const measured = std::min(durationsNs.size(), rAppTasks.m_profiler.taskTimes.size());
+    for (std::size_t i = 0; i < measured; ++i)
+    {
+        osp::RollingHistogram const& hist = rAppTasks.m_profiler.taskTimes[osp::TaskId(i)];
+        if (hist.count != 0)
+        {
+            durationsNs[osp::TaskId(i)] = std::max<uint64_t>(osp::histogram_mean_ns(hist), 1);
+        }
+    }
+
+    osp::task_critical_paths(rAppTasks.m_tasks, rAppTasks.m_graph, osp::arrayView(durationsNs.data(), durationsNs.size()), critPathNs);
+    osp::exec_set_priorities(rAppTasks.m_tasks, osp::arrayView(critPathNs.data(), critPathNs.size()), rExec);
+}
+
 void SingleThreadedExecutor::load(TestAppTasks& rAppTasks)
 {
     osp::exec_conform(rAppTasks.m_tasks, m_execContext);
+    osp::top_bind_args(rAppTasks.m_tasks, rAppTasks.m_taskData, rAppTasks.m_topData, m_argBinding);
     m_execContext.doLogging = m_log != nullptr;
+
+    osp::top_coroutines_conform(rAppTasks.m_tasks, m_coroutines);
+
+    // Order doesn't affect how long a run takes on a single thread, only use explicit priorities
+    osp::exec_set_priorities(rAppTasks.m_tasks, {}, m_execContext);
+    m_schedule.valid        = false; // Tasks may have changed
 }
 
 void SingleThreadedExecutor::run(TestAppTasks& rAppTasks, osp::PipelineId pipeline)
@@ -173,23 +232,74 @@ void SingleThreadedExecutor::signal(TestAppTasks& rAppTasks, osp::PipelineId pip
 
 void SingleThreadedExecutor::wait(TestAppTasks& rAppTasks)
 {
+    std::lock_guard<std::mutex> profilerLock{rAppTasks.m_profilerMutex};
+
+    osp::TaskProfiler *pProfiler = rAppTasks.m_profiler.capturing ? &rAppTasks.m_profiler : nullptr;
+
+    // Nothing from the previous frame's tasks is still in use
+    m_frameArena.reset();
+    osp::WorkerContext const worker{ .m_pFrameMem = &m_frameArena };
+
+    // Continue tasks suspended until the next frame
+    osp::top_coroutines_next_frame(m_coroutines, m_execContext);
+
+    // Records left from signals or run requests since the last wait
+    drain_exec_log(m_execContext, m_logRecords, nullptr);
+
     if (m_log != nullptr)
     {
         m_log->info("\n>>>>>>>>>> Previous State Changes\n{}\n>>>>>>>>>> Current State\n{}\n",
-                    osp::TopExecWriteLog  {rAppTasks.m_tasks, rAppTasks.m_taskData, rAppTasks.m_graph, m_execContext},
+                    osp::TopExecWriteLog  {rAppTasks.m_tasks, rAppTasks.m_taskData, rAppTasks.m_graph, m_logRecords},
                     osp::TopExecWriteState{rAppTasks.m_tasks, rAppTasks.m_taskData, rAppTasks.m_graph, m_execContext} );
-        m_execContext.logMsg.clear();
+    }
+    m_logRecords.clear();
+
+    // Replays don't go through the ExecLog, so only use them if nothing needs to read it
+    bool const useSchedule = m_staticSchedule && (m_log == nullptr) && (pProfiler == nullptr);
+
+    if (useSchedule && osp::exec_schedule_matches(m_execContext, m_schedule))
+    {
+        m_execContext.doLogging = false;
+
+        if ( ! osp::top_run_schedule(rAppTasks.m_tasks, rAppTasks.m_graph, m_argBinding, m_execContext, m_schedule, worker, &m_coroutines) )
+        {
+            m_schedule.valid = false; // Diverged, record again on the next run
+        }
+        return;
+    }
+
+    // Only record if something can start, so waits with nothing to do don't replace a recording
+    bool const recording =    useSchedule
+                           && osp::exec_is_settled(m_execContext)
+                           && (m_execContext.hasRequestRun || m_execContext.hasPlAdvanceOrLoop);
+
+    // Stage changes and completed tasks are read from the ExecLog
+    m_execContext.doLogging = (m_log != nullptr) || (pProfiler != nullptr) || recording;
+
+    if (recording)
+    {
+        osp::exec_schedule_record_start(m_execContext, m_schedule);
     }
 
     osp::exec_update(rAppTasks.m_tasks, rAppTasks.m_graph, m_execContext);
-    osp::top_run_blocking(rAppTasks.m_tasks, rAppTasks.m_graph, rAppTasks.m_taskData, rAppTasks.m_topData, m_execContext);
+
+    drain_exec_log(m_execContext, m_logRecords, pProfiler);
+
+    osp::top_run_blocking(rAppTasks.m_tasks, rAppTasks.m_graph, m_argBinding, m_execContext, worker, pProfiler, &m_logRecords, &m_coroutines);
+
+    if (recording)
+    {
+        osp::exec_schedule_record(m_schedule, m_logRecords);
+        osp::exec_schedule_record_finish(m_execContext, m_schedule);
+    }
 
     if (m_log != nullptr)
     {
         m_log->info("\n>>>>>>>>>> New State Changes\n{}",
-                    osp::TopExecWriteLog{rAppTasks.m_tasks, rAppTasks.m_taskData, rAppTasks.m_graph, m_execContext} );
-        m_execContext.logMsg.clear();
+                    osp::TopExecWriteLog{rAppTasks.m_tasks, rAppTasks.m_taskData, rAppTasks.m_graph, m_logRecords} );
     }
+
+    m_logRecords.clear();
 }
 
 bool SingleThreadedExecutor::is_running(TestAppTasks const& appTasks)
@@ -197,5 +307,387 @@ bool SingleThreadedExecutor::is_running(TestAppTasks const& appTasks)
     return m_execContext.hasRequestRun || (m_execContext.pipelinesRunning != 0);
 }
 
+//-----------------------------------------------------------------------------
+
+ThreadPoolExecutor::ThreadPoolExecutor(int const workerCount)
+ : m_workerCount{workerCount}
+ , m_deques{std::make_unique<WorkerDeque[]>(std::size_t(workerCount))}
+ , m_frameArenas{std::make_unique<osp::FrameArena[]>(std::size_t(workerCount))}
+{
+    LGRN_ASSERTMV(workerCount >= 1, "ThreadPoolExecutor needs at least one worker", workerCount);
+
+    // Worker 0 is the scheduler thread that calls wait(), so only start the rest
+    m_threads.reserve(std::size_t(workerCount - 1));
+    for (int i = 1; i < workerCount; ++i)
+    {
+        m_threads.emplace_back([this, i] { worker_loop(i); });
+    }
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock{m_sleepMutex};
+        m_stop = true;
+    }
+    m_sleepCv.notify_all();
+
+    for (std::thread &rThread : m_threads)
+    {
+        rThread.join();
+    }
+}
+
+void ThreadPoolExecutor::load(TestAppTasks& rAppTasks)
+{
+    osp::exec_conform(rAppTasks.m_tasks, m_execContext);
+    osp::top_bind_args(rAppTasks.m_tasks, rAppTasks.m_taskData, rAppTasks.m_topData, m_argBinding);
+    m_execContext.doLogging = m_log != nullptr;
+
+    osp::bitvector_resize(m_dispatched, rAppTasks.m_tasks.m_taskIds.capacity());
+    osp::bitvector_resize(m_dataWriting, rAppTasks.m_topData.size());
+    m_dataReaders.resize(rAppTasks.m_topData.size(), 0);
+    osp::top_coroutines_conform(rAppTasks.m_tasks, m_coroutines);
+
+    std::lock_guard<std::mutex> profilerLock{rAppTasks.m_profilerMutex};
+    update_task_priorities(rAppTasks, m_execContext);
+    m_prioritiesStale = false;
+}
+
+void ThreadPoolExecutor::run(TestAppTasks& rAppTasks, osp::PipelineId pipeline)
+{
+    osp::exec_request_run(m_execContext, pipeline);
+}
+
+void ThreadPoolExecutor::signal(TestAppTasks& rAppTasks, osp::PipelineId pipeline)
+{
+    osp::exec_signal(m_execContext, pipeline);
+}
+
+void ThreadPoolExecutor::wait(TestAppTasks& rAppTasks)
+{
+    std::lock_guard<std::mutex> profilerLock{rAppTasks.m_profilerMutex};
+
+    osp::TaskProfiler *pProfiler = rAppTasks.m_profiler.capturing ? &rAppTasks.m_profiler : nullptr;
+
+    // Use task times measured during a capture once it stops
+    if (pProfiler != nullptr)
+    {
+        m_prioritiesStale = true;
+    }
+    else if (m_prioritiesStale)
+    {
+        update_task_priorities(rAppTasks, m_execContext);
+        m_prioritiesStale = false;
+    }
+
+    // No tasks are running, and nothing from the previous frame's tasks is still in use
+    for (int i = 0; i < m_workerCount; ++i)
+    {
+        m_frameArenas[std::size_t(i)].reset();
+    }
+
+    // Continue tasks suspended until the next frame
+    osp::top_coroutines_next_frame(m_coroutines, m_execContext);
+
+    // Records left from signals or run requests since the last wait
+    drain_exec_log(m_execContext, m_logRecords, nullptr);
+
+    if (m_log != nullptr)
+    {
+        m_log->info("\n>>>>>>>>>> Previous State Changes\n{}\n>>>>>>>>>> Current State\n{}\n",
+                    osp::TopExecWriteLog  {rAppTasks.m_tasks, rAppTasks.m_taskData, rAppTasks.m_graph, m_logRecords},
+                    osp::TopExecWriteState{rAppTasks.m_tasks, rAppTasks.m_taskData, rAppTasks.m_graph, m_execContext} );
+    }
+    m_logRecords.clear();
+
+    m_taskLogger = osp::t_currentLogger;
+    m_profiling  = pProfiler != nullptr;
+
+    // Stage changes are read from the ExecLog
+    m_execContext.doLogging = (m_log != nullptr) || m_profiling;
+
+    osp::exec_update(rAppTasks.m_tasks, rAppTasks.m_graph, m_execContext);
+
+    drain_exec_log(m_execContext, m_logRecords, pProfiler);
+
+    while (true)
+    {
+        dispatch_ready(rAppTasks);
+
+        if (m_inFlight == 0)
+        {
+            break; // No tasks left to run
+        }
+
+        // Help run tasks while waiting for other workers
+        if ( ! try_run_one(0) )
+        {
+            std::unique_lock<std::mutex> lock{m_doneMutex};
+            m_doneCv.wait(lock, [this] { return ! m_done.empty(); });
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{m_doneMutex};
+            std::swap(m_done, m_doneSwap);
+        }
+
+        for (auto const [task, actions, worker, start, end] : m_doneSwap)
+        {
+            if (pProfiler != nullptr)
+            {
+                osp::profiler_record_task(*pProfiler, task, worker, start, end);
+            }
+
+            release_data(rAppTasks.m_taskData[task]);
+            m_dispatched.reset(std::size_t(task));
+            -- m_inFlight;
+
+            // Suspended coroutines release their data, and acquire it again once they continue
+            if ( ! osp::top_coroutine_park(m_coroutines, m_execContext, task) )
+            {
+                osp::complete_task(rAppTasks.m_tasks, rAppTasks.m_graph, m_execContext, task, actions);
+            }
+        }
+        m_doneSwap.clear();
+
+        osp::exec_update(rAppTasks.m_tasks, rAppTasks.m_graph, m_execContext);
+
+        drain_exec_log(m_execContext, m_logRecords, pProfiler);
+    }
+
+    if (m_log != nullptr)
+    {
+        m_log->info("\n>>>>>>>>>> New State Changes\n{}",
+                    osp::TopExecWriteLog{rAppTasks.m_tasks, rAppTasks.m_taskData, rAppTasks.m_graph, m_logRecords} );
+    }
+
+    m_logRecords.clear();
+}
+
+bool ThreadPoolExecutor::is_running(TestAppTasks const& rAppTasks)
+{
+    return m_execContext.hasRequestRun || (m_execContext.pipelinesRunning != 0);
+}
+
+void ThreadPoolExecutor::dispatch_ready(TestAppTasks const& rAppTasks)
+{
+    int dispatchedCount = 0;
+
+    // Highest priority first, so long chains of tasks start early while workers are busy
+    for (osp::TaskId task = osp::exec_pop_ready(m_execContext);
+         task != lgrn::id_null<osp::TaskId>();
+         task = osp::exec_pop_ready(m_execContext))
+    {
+        LGRN_ASSERTMV( ! m_dispatched.test(std::size_t(task)), "Task taken twice", std::size_t(task));
+
+        if ( ! try_acquire_data(rAppTasks.m_taskData[task]) )
+        {
+            // Conflicts with a running task. Try again once something completes
+            m_conflicting.push_back(task);
+            continue;
+        }
+
+        m_dispatched.set(std::size_t(task));
+        ++ m_inFlight;
+        ++ dispatchedCount;
+
+        uint32_t const worker = osp::top_task_queue(rAppTasks.m_taskData[task], uint32_t(m_workerCount));
+        if (worker != lgrn::id_null<uint32_t>())
+        {
+            // Only the bound worker pumps its pinned queue
+            WorkerDeque &rDeque = m_deques[std::size_t(worker)];
+            {
+                std::lock_guard<std::mutex> lock{rDeque.mutex};
+                rDeque.pinned.push_back(task);
+            }
+            rDeque.pinnedCount.fetch_add(1);
+            continue;
+        }
+
+        WorkerDeque &rDeque = m_deques[std::size_t(m_nextDeque)];
+        m_nextDeque = (m_nextDeque + 1) % m_workerCount;
+        {
+            std::lock_guard<std::mutex> lock{rDeque.mutex};
+            rDeque.tasks.push_back(task);
+        }
+        m_queuedCount.fetch_add(1);
+    }
+
+    for (osp::TaskId const task : m_conflicting)
+    {
+        osp::exec_push_ready(m_execContext, task);
+    }
+    m_conflicting.clear();
+
+    if (dispatchedCount != 0)
+    {
+        // Lock to prevent a lost wakeup from workers that are just about to sleep
+        {
+            std::lock_guard<std::mutex> lock{m_sleepMutex};
+        }
+        m_sleepCv.notify_all();
+    }
+}
+
+bool ThreadPoolExecutor::try_acquire_data(osp::TopTask const& task)
+{
+    using osp::DataAccess;
+    using osp::TopDataId;
+
+    for (std::size_t i = 0; i < task.m_dataUsed.size(); ++i)
+    {
+        TopDataId const data = task.m_dataUsed[i];
+        if (data == lgrn::id_null<TopDataId>())
+        {
+            continue;
+        }
+
+        bool const writes = osp::top_data_access(task, i) == DataAccess::Write;
+
+        if (m_dataWriting.test(data) || (writes && m_dataReaders[data] != 0))
+        {
+            return false;
+        }
+    }
+
+    for (std::size_t i = 0; i < task.m_dataUsed.size(); ++i)
+    {
+        TopDataId const data = task.m_dataUsed[i];
+        if (data == lgrn::id_null<TopDataId>())
+        {
+            continue;
+        }
+
+        if (osp::top_data_access(task, i) == DataAccess::Write)
+        {
+            m_dataWriting.set(data);
+        }
+        else
+        {
+            ++ m_dataReaders[data];
+        }
+    }
+
+    return true;
+}
+
+void ThreadPoolExecutor::release_data(osp::TopTask const& task)
+{
+    for (std::size_t i = 0; i < task.m_dataUsed.size(); ++i)
+    {
+        osp::TopDataId const data = task.m_dataUsed[i];
+        if (data == lgrn::id_null<osp::TopDataId>())
+        {
+            continue;
+        }
+
+        if (osp::top_data_access(task, i) == osp::DataAccess::Write)
+        {
+            m_dataWriting.reset(data);
+        }
+        else
+        {
+            -- m_dataReaders[data];
+        }
+    }
+}
+
+bool ThreadPoolExecutor::try_run_one(int const workerIndex)
+{
+    osp::TaskId task    = lgrn::id_null<osp::TaskId>();
+    bool        found   = false;
+
+    WorkerDeque &rOwn = m_deques[std::size_t(workerIndex)];
+
+    // Tasks pinned to this worker first, since no one else can run them
+    if (rOwn.pinnedCount.load() != 0)
+    {
+        std::lock_guard<std::mutex> lock{rOwn.mutex};
+        task  = rOwn.pinned.front();
+        found = true;
+        rOwn.pinned.pop_front();
+        rOwn.pinnedCount.fetch_sub(1);
+    }
+
+    // Pop from the back of own deque
+    if ( ! found )
+    {
+        std::lock_guard<std::mutex> lock{rOwn.mutex};
+        if ( ! rOwn.tasks.empty() )
+        {
+            task  = rOwn.tasks.back();
+            found = true;
+            rOwn.tasks.pop_back();
+            m_queuedCount.fetch_sub(1);
+        }
+    }
+
+    // Steal from the front of other workers' deques
+    for (int i = 1; ! found && i < m_workerCount; ++i)
+    {
+        WorkerDeque &rVictim = m_deques[std::size_t((workerIndex + i) % m_workerCount)];
+        std::lock_guard<std::mutex> lock{rVictim.mutex};
+        if ( ! rVictim.tasks.empty() )
+        {
+            task  = rVictim.tasks.front();
+            found = true;
+            rVictim.tasks.pop_front();
+            m_queuedCount.fetch_sub(1);
+        }
+    }
+
+    if ( ! found )
+    {
+        return false;
+    }
+
+    if (osp::t_currentLogger != m_taskLogger)
+    {
+        osp::set_thread_logger(m_taskLogger);
+    }
+
+    auto const start = m_profiling ? osp::ProfileClock_t::now() : osp::ProfileClock_t::time_point{};
+
+    osp::TaskActions const actions = osp::top_run_task(
+            m_argBinding, task,
+            osp::WorkerContext{ .m_workerIndex  = uint32_t(workerIndex),
+                                .m_pFrameMem    = &m_frameArenas[std::size_t(workerIndex)] },
+            m_coroutines);
+
+    auto const end = m_profiling ? osp::ProfileClock_t::now() : osp::ProfileClock_t::time_point{};
+
+    {
+        std::lock_guard<std::mutex> lock{m_doneMutex};
+        m_done.push_back({task, actions, uint32_t(workerIndex), start, end});
+    }
+    m_doneCv.notify_one();
+
+    return true;
+}
+
+void ThreadPoolExecutor::worker_loop(int const workerIndex)
+{
+    while (true)
+    {
+        if (try_run_one(workerIndex))
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock{m_sleepMutex};
+        WorkerDeque const &rOwn = m_deques[std::size_t(workerIndex)];
+        m_sleepCv.wait(lock, [this, &rOwn]
+        {
+            return m_stop || m_queuedCount.load() != 0 || rOwn.pinnedCount.load() != 0;
+        });
+
+        if (m_stop)
+        {
+            return;
+        }
+    }
+}
+
 
 } // namespace testapp
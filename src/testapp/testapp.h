@@ -24,8 +24,11 @@
  */
 #pragma once
 
+#include <osp/core/bitvector.h>
+#include <osp/core/frame_arena.h>
 #include <osp/core/keyed_vector.h>
 #include <osp/core/resourcetypes.h>
+#include <osp/tasks/profiler.h>
 #include <osp/tasks/tasks.h>
 #include <osp/tasks/top_execute.h>
 #include <osp/tasks/top_session.h>
@@ -33,7 +36,14 @@
 
 #include <entt/core/any.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <thread>
+#include <vector>
 
 namespace testapp
 {
@@ -50,6 +60,10 @@ struct TestAppTasks
     osp::Tasks                      m_tasks;
     osp::TopTaskDataVec_t           m_taskData;
     osp::TaskGraph                  m_graph;
+
+    /// Held by executors for the duration of IExecutor::wait, lock to start or stop captures
+    std::mutex                      m_profilerMutex;
+    osp::TaskProfiler               m_profiler;
 };
 
 struct TestApp : TestAppTasks
@@ -74,6 +88,9 @@ struct TestApp : TestAppTasks
 
     RendererSetupFunc_t             m_rendererSetup { nullptr };
 
+    /// Off by default, toggled by the debug CLI's compact_ents command from its own thread
+    std::atomic<bool>               m_compactActiveEnts { false };
+
     IExecutor                       *m_pExecutor { nullptr };
 
     osp::PkgId                      m_defaultPkg    { lgrn::id_null<osp::PkgId>() };
@@ -111,6 +128,142 @@ public:
 
     osp::ExecContext                m_execContext;
     std::shared_ptr<spdlog::logger> m_log;
+
+    /// Record runs and replay them when starting from the same state again, see ExecSchedule
+    bool                            m_staticSchedule {false};
+
+private:
+    osp::TopTaskArgBinding          m_argBinding;
+    osp::TopCoroutines              m_coroutines;
+    osp::FrameArena                 m_frameArena;
+    std::vector<osp::ExecLogRecord> m_logRecords;
+    osp::ExecSchedule               m_schedule;
+};
+
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Runs ready tasks in parallel on a pool of worker threads
+ *
+ * The thread calling wait() is the scheduler, and is the only thread that touches ExecContext.
+ * Ready tasks are handed out round-robin to per-worker deques. Workers pop tasks from the back
+ * of their own deque, and steal from the front of others when they run out. The scheduler
+ * thread is worker 0, and runs tasks too while waiting for others to complete.
+ *
+ * Tasks with an osp::ETaskAffinity other than Any go to a separate queue of the worker they're
+ * bound to, which only that worker pumps. ETaskAffinity::Main tasks run on the scheduler thread,
+ * which owns the OpenGL context. See osp::top_task_queue.
+ *
+ * Suspended TaskCoroutines release their TopData and go back to ExecContext to be dispatched
+ * again, see osp::top_coroutine_park.
+ *
+ * Tasks are only handed out if they don't conflict with TopData accessed by tasks already
+ * running; any number of DataAccess::Read tasks can share data, but DataAccess::Write is
+ * exclusive. This keeps unordered tasks (see osp::top_find_data_conflicts) from racing.
+ */
+class ThreadPoolExecutor final : public IExecutor
+{
+public:
+    /**
+     * @param workerCount [in] Total number of workers, including the scheduler thread
+     */
+    explicit ThreadPoolExecutor(int workerCount);
+    ~ThreadPoolExecutor();
+
+    ThreadPoolExecutor(ThreadPoolExecutor const& copy) = delete;
+    ThreadPoolExecutor(ThreadPoolExecutor&& move) = delete;
+    ThreadPoolExecutor& operator=(ThreadPoolExecutor const& copy) = delete;
+    ThreadPoolExecutor& operator=(ThreadPoolExecutor&& move) = delete;
+
+    void load(TestAppTasks& rAppTasks) override;
+
+    void run(TestAppTasks& rAppTasks, osp::PipelineId pipeline) override;
+
+    void signal(TestAppTasks& rAppTasks, osp::PipelineId pipeline) override;
+
+    void wait(TestAppTasks& rAppTasks) override;
+
+    bool is_running(TestAppTasks const& rAppTasks) override;
+
+    osp::ExecContext                m_execContext;
+    std::shared_ptr<spdlog::logger> m_log;
+
+private:
+
+    struct WorkerDeque
+    {
+        std::mutex              mutex;
+        std::deque<osp::TaskId> tasks;
+
+        /// Tasks with an osp::ETaskAffinity that can only run on this worker, never stolen
+        std::deque<osp::TaskId> pinned;
+        std::atomic<int>        pinnedCount {0};
+    };
+
+    struct TaskDone
+    {
+        osp::TaskId                     task;
+        osp::TaskActions                actions;
+        uint32_t                        worker;
+        osp::ProfileClock_t::time_point start;
+        osp::ProfileClock_t::time_point end;
+    };
+
+    void worker_loop(int workerIndex);
+
+    /**
+     * @brief Pop a task pinned to this worker, from own deque, or steal one from another
+     *        worker, then run it
+     *
+     * @return true if a task was run
+     */
+    bool try_run_one(int workerIndex);
+
+    /**
+     * @brief Hand out ready tasks from ExecContext in order of priority, see osp::exec_pop_ready
+     */
+    void dispatch_ready(TestAppTasks const& rAppTasks);
+
+    /**
+     * @brief Mark a task's TopData as in use if no running task conflicts with it
+     *
+     * @return false if the task can't run yet
+     */
+    bool try_acquire_data(osp::TopTask const& task);
+
+    void release_data(osp::TopTask const& task);
+
+    // Only accessed by the scheduler thread
+    osp::BitVector_t                    m_dispatched;
+    osp::BitVector_t                    m_dataWriting;
+    std::vector<int>                    m_dataReaders;
+    std::vector<TaskDone>               m_doneSwap;
+    std::vector<osp::ExecLogRecord>     m_logRecords;
+    std::vector<osp::TaskId>            m_conflicting;
+    int                                 m_inFlight      {0};
+    int                                 m_nextDeque     {0};
+    bool                                m_prioritiesStale {false};
+
+    // Written by the scheduler before handing out tasks, read by workers
+    osp::TopTaskArgBinding              m_argBinding;
+    osp::TopCoroutines                  m_coroutines;   ///< Workers only touch the task they run
+    osp::logger_t                       m_taskLogger;
+    bool                                m_profiling     {false};
+
+    int                                 m_workerCount;
+    std::unique_ptr<WorkerDeque[]>      m_deques;
+    std::unique_ptr<osp::FrameArena[]>  m_frameArenas;  ///< Per-worker, see WorkerContext::m_pFrameMem
+    std::vector<std::thread>            m_threads;
+
+    std::atomic<int>                    m_queuedCount   {0};
+
+    std::mutex                          m_doneMutex;
+    std::condition_variable             m_doneCv;
+    std::vector<TaskDone>               m_done;
+
+    std::mutex                          m_sleepMutex;
+    std::condition_variable             m_sleepCv;
+    bool                                m_stop          {false};
 };
 
 } // namespace testapp
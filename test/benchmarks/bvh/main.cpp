@@ -0,0 +1,130 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/activescene/bvh_fn.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace osp;
+using namespace osp::active;
+
+// Entities are small boxes scattered over a volume that grows with the entity count, so
+// density stays the same.
+
+namespace
+{
+
+struct BenchWorld
+{
+    explicit BenchWorld(uint32_t const count)
+     : entCount{count}
+     , extent{std::cbrt(float(count)) * 4.0f}
+    {
+        bvh.resize_active(entCount);
+        velocity.resize(entCount);
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> posDist(0.0f, extent);
+        std::uniform_real_distribution<float> velDist(-0.05f, 0.05f);
+
+        for (uint32_t i = 0; i < entCount; ++i)
+        {
+            Vector3 const pos{posDist(gen), posDist(gen), posDist(gen)};
+            velocity[i] = {velDist(gen), velDist(gen), velDist(gen)};
+            SysBvh::insert(bvh, ActiveEnt(i), {pos - Vector3{0.5f}, pos + Vector3{0.5f}});
+        }
+    }
+
+    ACtxBvh                 bvh;
+    std::vector<Vector3>    velocity;
+    uint32_t                entCount;
+    float                   extent;
+};
+
+// Every entity moves each update; most stay within their padded leaf bounds
+void bm_bvh_update_moving(benchmark::State& rBench)
+{
+    BenchWorld world(uint32_t(rBench.range(0)));
+
+    for (auto _ : rBench)
+    {
+        for (uint32_t i = 0; i < world.entCount; ++i)
+        {
+            ActiveEnt const ent     = ActiveEnt(i);
+            Range3D const&  bounds  = world.bvh.m_entBounds[ent];
+            Vector3 const&  vel     = world.velocity[i];
+            SysBvh::update(world.bvh, ent, {bounds.min() + vel, bounds.max() + vel});
+        }
+    }
+
+    rBench.SetItemsProcessed(int64_t(rBench.iterations()) * world.entCount);
+}
+
+void bm_bvh_query_box(benchmark::State& rBench)
+{
+    BenchWorld world(uint32_t(rBench.range(0)));
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> posDist(0.0f, world.extent);
+
+    std::size_t found = 0;
+    for (auto _ : rBench)
+    {
+        Vector3 const pos{posDist(gen), posDist(gen), posDist(gen)};
+        SysBvh::query_box(world.bvh, {pos - Vector3{8.0f}, pos + Vector3{8.0f}}, [&found] (ActiveEnt) { ++ found; });
+    }
+    benchmark::DoNotOptimize(found);
+
+    rBench.SetItemsProcessed(int64_t(rBench.iterations()));
+}
+
+void bm_bvh_query_ray(benchmark::State& rBench)
+{
+    BenchWorld world(uint32_t(rBench.range(0)));
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> posDist(0.0f, world.extent);
+
+    std::size_t found = 0;
+    for (auto _ : rBench)
+    {
+        Vector3 const origin{posDist(gen), posDist(gen), posDist(gen)};
+        Vector3 const target{posDist(gen), posDist(gen), posDist(gen)};
+        SysBvh::query_ray(world.bvh, origin, (target - origin).normalized(), world.extent,
+                          [&found] (ActiveEnt, float) { ++ found; });
+    }
+    benchmark::DoNotOptimize(found);
+
+    rBench.SetItemsProcessed(int64_t(rBench.iterations()));
+}
+
+} // namespace
+
+BENCHMARK(bm_bvh_update_moving) ->RangeMultiplier(10)->Range(1000, 100000);
+BENCHMARK(bm_bvh_query_box)     ->RangeMultiplier(10)->Range(1000, 100000);
+BENCHMARK(bm_bvh_query_ray)     ->RangeMultiplier(10)->Range(1000, 100000);
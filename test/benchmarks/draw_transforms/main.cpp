@@ -0,0 +1,183 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/drawing/drawing_fn.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+using namespace osp;
+using namespace osp::active;
+using namespace osp::draw;
+
+// Scene graphs shaped like many vehicles: each is a root with welds, each weld has parts.
+// Every entity is drawn.
+
+namespace
+{
+
+constexpr uint32_t gc_weldsPerVehicle   = 9;
+constexpr uint32_t gc_partsPerWeld      = 10;
+constexpr uint32_t gc_entsPerVehicle    = 1 + gc_weldsPerVehicle * (1 + gc_partsPerWeld);
+
+struct BenchScene
+{
+    explicit BenchScene(uint32_t const vehicleCount)
+     : entCount{vehicleCount * gc_entsPerVehicle}
+    {
+        basic.m_scnGraph.resize(entCount);
+        bitvector_resize(needDrawTf, entCount);
+        activeToDraw.resize(entCount);
+        drawTf.resize(entCount);
+
+        uint32_t nextEnt = 0;
+        auto const add_ent = [this, &nextEnt] (Matrix4 const& tf)
+        {
+            ActiveEnt const ent = ActiveEnt(nextEnt ++);
+            basic.m_transform.emplace(ent, ACompTransform{tf});
+            needDrawTf.set(ent.value);
+            activeToDraw[ent] = DrawEnt(ent.value);
+            return ent;
+        };
+
+        SubtreeBuilder bldRoot = SysSceneGraph::add_descendants(basic.m_scnGraph, entCount);
+        for (uint32_t v = 0; v < vehicleCount; ++v)
+        {
+            ActiveEnt const vehicle = add_ent(Matrix4::translation({float(v), 0.0f, 0.0f}));
+            SubtreeBuilder bldVehicle = bldRoot.add_child(vehicle, gc_entsPerVehicle - 1);
+
+            for (uint32_t w = 0; w < gc_weldsPerVehicle; ++w)
+            {
+                ActiveEnt const weld = add_ent(Matrix4::translation({0.0f, float(w), 0.0f}) * Matrix4::rotationZ(Rad(0.1f * float(w))));
+                SubtreeBuilder bldWeld = bldVehicle.add_child(weld, gc_partsPerWeld);
+
+                for (uint32_t p = 0; p < gc_partsPerWeld; ++p)
+                {
+                    bldWeld.add_child(add_ent(Matrix4::translation({0.0f, 0.0f, float(p)})));
+                }
+            }
+        }
+    }
+
+    SysRender::ArgsForUpdDrawTransform args() noexcept
+    {
+        return {
+            .scnGraph     = basic.m_scnGraph,
+            .transforms   = basic.m_transform,
+            .activeToDraw = activeToDraw,
+            .needDrawTf   = needDrawTf,
+            .rDrawTf      = drawTf
+        };
+    }
+
+    uint32_t                        entCount;
+    ACtxBasic                       basic;
+    ActiveEntSet_t                  needDrawTf;
+    KeyedVec<ActiveEnt, DrawEnt>    activeToDraw;
+    DrawTransforms_t                drawTf;
+    KeyedVec<TreePos_t, Matrix4>    treeWorldTf;
+};
+
+void bm_draw_transforms_recursive(benchmark::State& rBench)
+{
+    BenchScene scene(uint32_t(rBench.range(0)) / gc_entsPerVehicle);
+
+    for (auto _ : rBench)
+    {
+        auto rootChildren = SysSceneGraph::children(scene.basic.m_scnGraph);
+        SysRender::update_draw_transforms(scene.args(), rootChildren.begin(), rootChildren.end());
+        benchmark::DoNotOptimize(scene.drawTf.data());
+    }
+
+    rBench.SetItemsProcessed(int64_t(rBench.iterations()) * scene.entCount);
+}
+
+void bm_draw_transforms_linear(benchmark::State& rBench)
+{
+    BenchScene scene(uint32_t(rBench.range(0)) / gc_entsPerVehicle);
+
+    for (auto _ : rBench)
+    {
+        SysRender::update_draw_transforms_linear(scene.args(), scene.treeWorldTf);
+        benchmark::DoNotOptimize(scene.drawTf.data());
+    }
+
+    rBench.SetItemsProcessed(int64_t(rBench.iterations()) * scene.entCount);
+}
+
+void bm_draw_transforms_linear_trs(benchmark::State& rBench)
+{
+    BenchScene scene(uint32_t(rBench.range(0)) / gc_entsPerVehicle);
+
+    ACtxTransformTRS trs;
+    trs.resize(scene.entCount);
+    for (auto const& [ent, tf] : scene.basic.m_transform.each())
+    {
+        trs.set_matrix(ent, tf.m_transform);
+    }
+
+    SysRender::ArgsForUpdDrawTransform args = scene.args();
+    args.pTRS = &trs;
+
+    for (auto _ : rBench)
+    {
+        SysRender::update_draw_transforms_linear(args, scene.treeWorldTf);
+        benchmark::DoNotOptimize(scene.drawTf.data());
+    }
+
+    rBench.SetItemsProcessed(int64_t(rBench.iterations()) * scene.entCount);
+}
+
+// One in 20 vehicles moves each update, the rest sit still
+void bm_draw_transforms_dirty(benchmark::State& rBench)
+{
+    BenchScene scene(uint32_t(rBench.range(0)) / gc_entsPerVehicle);
+    DrawTfCache     cache;
+    DrawEntVec_t    changed;
+
+    SysRender::update_draw_transforms_dirty(scene.args(), scene.basic.m_transformDirty, cache, changed);
+
+    for (auto _ : rBench)
+    {
+        for (uint32_t ent = 0; ent < scene.entCount; ent += 20 * gc_entsPerVehicle)
+        {
+            mark_transform_dirty(scene.basic.m_transformDirty, ActiveEnt(ent));
+        }
+
+        changed.clear();
+        SysRender::update_draw_transforms_dirty(scene.args(), scene.basic.m_transformDirty, cache, changed);
+        scene.basic.m_transformDirty.reset();
+        benchmark::DoNotOptimize(scene.drawTf.data());
+    }
+
+    rBench.SetItemsProcessed(int64_t(rBench.iterations()) * scene.entCount);
+}
+
+} // namespace
+
+BENCHMARK(bm_draw_transforms_recursive) ->RangeMultiplier(10)->Range(1000, 100000);
+BENCHMARK(bm_draw_transforms_linear)    ->RangeMultiplier(10)->Range(1000, 100000);
+BENCHMARK(bm_draw_transforms_linear_trs)->RangeMultiplier(10)->Range(1000, 100000);
+BENCHMARK(bm_draw_transforms_dirty)     ->RangeMultiplier(10)->Range(1000, 100000);
@@ -0,0 +1,536 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/tasks/builder.h>
+#include <osp/tasks/exec_schedule.h>
+#include <osp/tasks/execute.h>
+#include <osp/tasks/tasks.h>
+#include <osp/tasks/top_execute.h>
+
+#include <benchmark/benchmark.h>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <entt/core/any.hpp>
+
+#include <memory>
+#include <vector>
+
+using namespace osp;
+
+// Synthetic task graphs for measuring executor overhead. Tasks barely do any work, so
+// measurements are mostly time spent scheduling.
+
+namespace
+{
+
+enum class Stages { Signal, Schedule, Run, Done };
+
+struct BenchState
+{
+    uint64_t    tasksRun        { 0 };
+    int         loopsLeft       { 0 };
+};
+
+using BasicTraits_t     = BasicBuilderTraits<TopTaskFunc_t>;
+using Builder_t         = BasicTraits_t::Builder;
+using TaskFuncVec_t     = BasicTraits_t::FuncVec_t;
+
+struct BenchGraph
+{
+    Tasks                   tasks;
+    TaskEdges               edges;
+    TaskFuncVec_t           functions;
+    Builder_t               builder{tasks, edges, functions};
+
+    TopTaskDataVec_t        taskData;
+    std::vector<entt::any>  topData;
+
+    /// Requested every frame
+    std::vector<PipelineId> runEachFrame;
+
+    /// Requested once before the first frame, for loops that run forever
+    std::vector<PipelineId> runOnce;
+
+    /// Signaled every frame
+    std::vector<PipelineId> signalEachFrame;
+
+    int                     loopsPerFrame   { 0 };
+    int                     taskCount       { 0 };
+};
+
+BenchState& state_of(ArrayView<void* const> args) noexcept
+{
+    return *static_cast<BenchState*>(args[0]);
+}
+
+TaskActions task_plain(WorkerContext /*ctx*/, ArrayView<void* const> args) noexcept
+{
+    ++ state_of(args).tasksRun;
+    return {};
+}
+
+TaskActions task_loop_schedule(WorkerContext /*ctx*/, ArrayView<void* const> args) noexcept
+{
+    BenchState &rState = state_of(args);
+    ++ rState.tasksRun;
+
+    if (rState.loopsLeft == 0)
+    {
+        return TaskAction::Cancel;
+    }
+
+    -- rState.loopsLeft;
+    return {};
+}
+
+PipelineDef<Stages> create_pipeline(Builder_t &rBuilder)
+{
+    struct One
+    {
+        PipelineDef<Stages> pl{"pl"};
+    };
+    return rBuilder.create_pipelines<One>().pl;
+}
+
+/**
+ * @brief Give every task the same BenchState argument, and create TopTasks from functions
+ */
+void finish_graph(BenchGraph &rGraph)
+{
+    rGraph.topData.clear();
+    rGraph.topData.emplace_back(std::in_place_type<BenchState>);
+
+    rGraph.taskData.resize(rGraph.tasks.m_taskIds.capacity());
+    for (TaskInt const taskInt : rGraph.tasks.m_taskIds.bitview().zeros())
+    {
+        auto const task = TaskId(taskInt);
+        rGraph.taskData[task].m_dataUsed    = {TopDataId(0)};
+        rGraph.taskData[task].m_func        = rGraph.functions[task];
+        ++ rGraph.taskCount;
+    }
+}
+
+/**
+ * @brief One root pipeline, and many pipelines with tasks that all sync with the root
+ *
+ * @param taskCount [in] Total number of tasks in the fan-out
+ */
+void make_wide(BenchGraph &rOut, int const taskCount)
+{
+    using enum Stages;
+
+    constexpr int sc_fanPipelines = 64;
+
+    Builder_t &rBuilder = rOut.builder;
+
+    auto const root = create_pipeline(rBuilder);
+
+    rBuilder.task().run_on({root(Schedule)}).func(task_plain);
+    rBuilder.task().run_on({root(Done)})    .func(task_plain);
+
+    std::vector<PipelineDef<Stages>> fan;
+    for (int i = 0; i < sc_fanPipelines; ++i)
+    {
+        fan.push_back(create_pipeline(rBuilder));
+        rBuilder.pipeline(fan.back()).parent(root);
+    }
+
+    for (int i = 0; i < taskCount; ++i)
+    {
+        rBuilder.task()
+            .run_on   ({fan[i % sc_fanPipelines](Run)})
+            .sync_with({root(Run)})
+            .func(task_plain);
+    }
+
+    rOut.runEachFrame = {root};
+    finish_graph(rOut);
+}
+
+/**
+ * @brief Chain of pipelines each parented to the previous, with tasks syncing with the parent
+ */
+void make_deep(BenchGraph &rOut, int const depth)
+{
+    using enum Stages;
+
+    Builder_t &rBuilder = rOut.builder;
+
+    auto const root = create_pipeline(rBuilder);
+    auto parent = root;
+
+    rBuilder.task().run_on({root(Run)}).func(task_plain);
+
+    for (int i = 1; i < depth; ++i)
+    {
+        auto const child = create_pipeline(rBuilder);
+        rBuilder.pipeline(child).parent(parent);
+
+        rBuilder.task().run_on({child(Schedule)}).sync_with({parent(Schedule)}).func(task_plain);
+        rBuilder.task().run_on({child(Run)})     .sync_with({parent(Run)})     .func(task_plain);
+        rBuilder.task().run_on({child(Done)})    .sync_with({parent(Done)})    .func(task_plain);
+
+        parent = child;
+    }
+
+    rOut.runEachFrame = {root};
+    finish_graph(rOut);
+}
+
+/**
+ * @brief Looping outer pipeline waiting for a signal each frame, with a nested inner loop.
+ *        Same layout as the BasicSingleThreadedNestedLoop test.
+ *
+ * @param innerTasks [in] Number of tasks run each inner loop iteration
+ */
+void make_nested_loop(BenchGraph &rOut, int const innerTasks)
+{
+    using enum Stages;
+
+    Builder_t &rBuilder = rOut.builder;
+
+    auto const outer = create_pipeline(rBuilder);
+    auto const inner = create_pipeline(rBuilder);
+
+    rBuilder.pipeline(outer).loops(true).wait_for_signal(Signal);
+    rBuilder.pipeline(inner).loops(true).parent(outer);
+
+    rBuilder.task()
+        .run_on   ({inner(Schedule)})
+        .sync_with({outer(Run)})
+        .func(task_loop_schedule);
+
+    for (int i = 0; i < innerTasks; ++i)
+    {
+        rBuilder.task()
+            .run_on   ({inner(Run)})
+            .sync_with({outer(Run)})
+            .func(task_plain);
+    }
+
+    rBuilder.task().run_on({outer(Done)}).func(task_plain);
+
+    rOut.runOnce            = {outer};
+    rOut.signalEachFrame    = {outer};
+    rOut.loopsPerFrame      = 8;
+    finish_graph(rOut);
+}
+
+using MakeGraphFunc_t = void(*)(BenchGraph&, int);
+
+/**
+ * @brief Everything needed to run frames of a BenchGraph
+ */
+struct BenchRun
+{
+    BenchRun(MakeGraphFunc_t const makeGraph, int const arg)
+     : pGraph{std::make_unique<BenchGraph>()}
+    {
+        makeGraph(*pGraph, arg);
+        graph = make_exec_graph(pGraph->tasks, {&pGraph->edges});
+        top_bind_args(pGraph->tasks, pGraph->taskData, pGraph->topData, binding);
+
+        exec_conform(pGraph->tasks, exec);
+        exec.doLogging = false;
+
+        for (PipelineId const pipeline : pGraph->runOnce)
+        {
+            exec_request_run(exec, pipeline);
+        }
+    }
+
+    BenchState& state() { return entt::any_cast<BenchState&>(pGraph->topData[0]); }
+
+    /// Request and signal pipelines for the next frame
+    void start_frame()
+    {
+        state().loopsLeft = pGraph->loopsPerFrame;
+
+        for (PipelineId const pipeline : pGraph->runEachFrame)
+        {
+            exec_request_run(exec, pipeline);
+        }
+    }
+
+    void signal()
+    {
+        for (PipelineId const pipeline : pGraph->signalEachFrame)
+        {
+            exec_signal(exec, pipeline);
+        }
+    }
+
+    std::unique_ptr<BenchGraph> pGraph;
+    TaskGraph                   graph;
+    TopTaskArgBinding           binding;
+    ExecContext                 exec;
+};
+
+void report(benchmark::State &rBench, BenchRun &rRun)
+{
+    rBench.SetItemsProcessed(int64_t(rRun.state().tasksRun));
+    rBench.counters["tasks"] = double(rRun.pGraph->taskCount);
+}
+
+/**
+ * @brief A small session opened and closed on top of a BenchGraph, like switching scenarios in
+ *        testapp. See TestApp::close_sessions
+ */
+struct BenchSession
+{
+    static constexpr int sc_taskCount = 32;
+
+    TaskEdges               edges;
+    std::vector<TaskId>     tasks;
+    std::vector<PipelineId> pipelines;
+};
+
+void open_session(BenchGraph &rGraph, BenchSession &rSession)
+{
+    using enum Stages;
+
+    Builder_t builder{rGraph.tasks, rSession.edges, rGraph.functions};
+
+    auto const work  = create_pipeline(builder);
+    auto const child = create_pipeline(builder);
+    builder.pipeline(child).parent(work);
+    rSession.pipelines = {work, child};
+
+    for (int i = 0; i < BenchSession::sc_taskCount; ++i)
+    {
+        rSession.tasks.push_back(builder.task()
+            .run_on   ({child(Run)})
+            .sync_with({work(Run)})
+            .func(task_plain));
+    }
+}
+
+void close_session(BenchGraph &rGraph, BenchSession &rSession)
+{
+    Tasks &rTasks = rGraph.tasks;
+
+    for (TaskId const task : rSession.tasks)
+    {
+        rTasks.m_taskIds.remove(task);
+    }
+    for (PipelineId const pipeline : rSession.pipelines)
+    {
+        rTasks.m_pipelineIds.remove(pipeline);
+        rTasks.m_pipelineParents[pipeline] = lgrn::id_null<PipelineId>();
+        rTasks.m_pipelineInfo[pipeline]    = {};
+        rTasks.m_pipelineControl[pipeline] = {};
+    }
+    rSession.tasks.clear();
+    rSession.pipelines.clear();
+    rSession.edges.m_syncWith.clear();
+    rSession.edges.m_semaphoreEdges.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+template <MakeGraphFunc_t MAKE_T>
+void bm_make_exec_graph(benchmark::State &rBench)
+{
+    BenchGraph graph;
+    MAKE_T(graph, int(rBench.range(0)));
+
+    for ([[maybe_unused]] auto _ : rBench)
+    {
+        TaskGraph const out = make_exec_graph(graph.tasks, {&graph.edges});
+        benchmark::DoNotOptimize(out.pipelineToFirstAnystg.data());
+    }
+
+    rBench.counters["tasks"] = double(graph.taskCount);
+}
+
+/**
+ * @brief Close and reopen a small session on a large graph, remaking the whole TaskGraph
+ */
+template <MakeGraphFunc_t MAKE_T>
+void bm_switch_make_exec_graph(benchmark::State &rBench)
+{
+    BenchGraph      graph;
+    BenchSession    session;
+    MAKE_T(graph, int(rBench.range(0)));
+    open_session(graph, session);
+
+    for ([[maybe_unused]] auto _ : rBench)
+    {
+        close_session(graph, session);
+        open_session(graph, session);
+
+        TaskGraph const out = make_exec_graph(graph.tasks, {&graph.edges, &session.edges});
+        benchmark::DoNotOptimize(out.pipelineToFirstAnystg.data());
+    }
+
+    rBench.counters["tasks"] = double(graph.taskCount);
+}
+
+/**
+ * @brief Same as bm_switch_make_exec_graph, but updating the TaskGraph with update_exec_graph
+ */
+template <MakeGraphFunc_t MAKE_T>
+void bm_switch_update_exec_graph(benchmark::State &rBench)
+{
+    BenchGraph      graph;
+    BenchSession    session;
+    MAKE_T(graph, int(rBench.range(0)));
+    open_session(graph, session);
+
+    TaskGraph out = make_exec_graph(graph.tasks, {&graph.edges, &session.edges});
+
+    for ([[maybe_unused]] auto _ : rBench)
+    {
+        close_session(graph, session);
+        update_exec_graph(graph.tasks, out, {});
+        open_session(graph, session);
+        update_exec_graph(graph.tasks, out, {&session.edges});
+
+        benchmark::DoNotOptimize(out.pipelineToFirstAnystg.data());
+    }
+
+    rBench.counters["tasks"] = double(graph.taskCount);
+}
+
+/**
+ * @brief Run frames with exec_update and complete_task directly, same as the unit tests
+ */
+template <MakeGraphFunc_t MAKE_T>
+void bm_exec_update_complete(benchmark::State &rBench)
+{
+    BenchRun run{MAKE_T, int(rBench.range(0))};
+
+    for ([[maybe_unused]] auto _ : rBench)
+    {
+        run.start_frame();
+        exec_update(run.pGraph->tasks, run.graph, run.exec);
+        run.signal();
+
+        while ( ! run.exec.tasksQueuedRun.empty() )
+        {
+            TaskId const task = run.exec.tasksQueuedRun[0];
+            complete_task(run.pGraph->tasks, run.graph, run.exec, task, top_run_task(run.binding, task, {}));
+            exec_update(run.pGraph->tasks, run.graph, run.exec);
+        }
+    }
+
+    report(rBench, run);
+}
+
+template <MakeGraphFunc_t MAKE_T>
+void bm_top_run_blocking(benchmark::State &rBench)
+{
+    BenchRun run{MAKE_T, int(rBench.range(0))};
+
+    for ([[maybe_unused]] auto _ : rBench)
+    {
+        run.start_frame();
+        exec_update(run.pGraph->tasks, run.graph, run.exec);
+        run.signal();
+        top_run_blocking(run.pGraph->tasks, run.graph, run.binding, run.exec);
+    }
+
+    report(rBench, run);
+}
+
+/**
+ * @brief Replay a recorded ExecSchedule each frame
+ *
+ * Signals are sent before each frame starts, as runs that are signaled partway through can't be
+ * recorded.
+ */
+template <MakeGraphFunc_t MAKE_T>
+void bm_top_run_schedule(benchmark::State &rBench)
+{
+    BenchRun run{MAKE_T, int(rBench.range(0))};
+
+    // Run one frame normally, as pipelines that never ran may start in a different state, then
+    // record the second frame
+    run.start_frame();
+    run.signal();
+    exec_update(run.pGraph->tasks, run.graph, run.exec);
+    top_run_blocking(run.pGraph->tasks, run.graph, run.binding, run.exec);
+
+    std::vector<ExecLogRecord> records;
+    ExecSchedule sched;
+
+    run.exec.doLogging = true;
+    exec_log_ring_drain(run.exec.logRing, records); // discard
+    records.clear();
+    run.start_frame();
+    run.signal();
+    exec_schedule_record_start(run.exec, sched);
+    exec_update(run.pGraph->tasks, run.graph, run.exec);
+    top_run_blocking(run.pGraph->tasks, run.graph, run.binding, run.exec, {}, nullptr, &records);
+    exec_schedule_record(sched, records);
+    exec_schedule_record_finish(run.exec, sched);
+    run.exec.doLogging = false;
+
+    if ( ! sched.valid )
+    {
+        rBench.SkipWithError("Graph can't be recorded");
+        return;
+    }
+
+    for ([[maybe_unused]] auto _ : rBench)
+    {
+        run.start_frame();
+        run.signal();
+
+        // Same check the executor does before replaying
+        if ( ! exec_schedule_matches(run.exec, sched) )
+        {
+            rBench.SkipWithError("Schedule doesn't match");
+            break;
+        }
+
+        top_run_schedule(run.pGraph->tasks, run.graph, run.binding, run.exec, sched);
+    }
+
+    report(rBench, run);
+}
+
+} // namespace
+
+BENCHMARK(bm_make_exec_graph<make_wide>)            ->RangeMultiplier(4)->Range(256, 16384);
+BENCHMARK(bm_make_exec_graph<make_deep>)            ->RangeMultiplier(4)->Range(4, 1024);
+BENCHMARK(bm_make_exec_graph<make_nested_loop>)     ->RangeMultiplier(4)->Range(4, 4096);
+
+BENCHMARK(bm_switch_make_exec_graph<make_wide>)     ->RangeMultiplier(4)->Range(256, 16384);
+BENCHMARK(bm_switch_update_exec_graph<make_wide>)   ->RangeMultiplier(4)->Range(256, 16384);
+BENCHMARK(bm_switch_make_exec_graph<make_deep>)     ->RangeMultiplier(4)->Range(4, 1024);
+BENCHMARK(bm_switch_update_exec_graph<make_deep>)   ->RangeMultiplier(4)->Range(4, 1024);
+
+BENCHMARK(bm_exec_update_complete<make_wide>)       ->RangeMultiplier(4)->Range(256, 16384);
+BENCHMARK(bm_exec_update_complete<make_deep>)       ->RangeMultiplier(4)->Range(4, 1024);
+BENCHMARK(bm_exec_update_complete<make_nested_loop>)->RangeMultiplier(4)->Range(4, 4096);
+
+BENCHMARK(bm_top_run_blocking<make_wide>)           ->RangeMultiplier(4)->Range(256, 16384);
+BENCHMARK(bm_top_run_blocking<make_deep>)           ->RangeMultiplier(4)->Range(4, 1024);
+BENCHMARK(bm_top_run_blocking<make_nested_loop>)    ->RangeMultiplier(4)->Range(4, 4096);
+
+BENCHMARK(bm_top_run_schedule<make_wide>)           ->RangeMultiplier(4)->Range(256, 16384);
+BENCHMARK(bm_top_run_schedule<make_deep>)           ->RangeMultiplier(4)->Range(4, 1024);
+BENCHMARK(bm_top_run_schedule<make_nested_loop>)    ->RangeMultiplier(4)->Range(4, 4096);
@@ -0,0 +1,320 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/activescene/bvh_fn.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace osp;
+using namespace osp::active;
+
+namespace
+{
+
+Range3D random_bounds(std::mt19937 &rGen)
+{
+    std::uniform_real_distribution<float> posDist(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> sizeDist(0.1f, 4.0f);
+
+    Vector3 const min{posDist(rGen), posDist(rGen), posDist(rGen)};
+    return {min, min + Vector3{sizeDist(rGen), sizeDist(rGen), sizeDist(rGen)}};
+}
+
+// Check parent links, heights, and that every node's bounds contain its children
+int expect_valid(ACtxBvh const& bvh, BvhNodeId const node, BvhNodeId const parent, std::size_t &rLeafCount)
+{
+    BvhNode const& rNode = bvh.m_nodes[node];
+    EXPECT_EQ(rNode.parent, parent);
+
+    if (rNode.ent != lgrn::id_null<ActiveEnt>())
+    {
+        EXPECT_EQ(bvh.m_entToLeaf[rNode.ent], node);
+        EXPECT_TRUE(rNode.bounds.contains(bvh.m_entBounds[rNode.ent]));
+        EXPECT_EQ(rNode.height, 0);
+        ++ rLeafCount;
+        return 0;
+    }
+
+    EXPECT_TRUE(rNode.bounds.contains(bvh.m_nodes[rNode.childA].bounds));
+    EXPECT_TRUE(rNode.bounds.contains(bvh.m_nodes[rNode.childB].bounds));
+
+    int const heightA = expect_valid(bvh, rNode.childA, node, rLeafCount);
+    int const heightB = expect_valid(bvh, rNode.childB, node, rLeafCount);
+    EXPECT_EQ(rNode.height, 1 + std::max(heightA, heightB));
+
+    return rNode.height;
+}
+
+void expect_valid(ACtxBvh const& bvh, std::size_t const leafCount)
+{
+    std::size_t leavesFound = 0;
+    if (bvh.m_root != lgrn::id_null<BvhNodeId>())
+    {
+        expect_valid(bvh, bvh.m_root, lgrn::id_null<BvhNodeId>(), leavesFound);
+    }
+    EXPECT_EQ(leavesFound, leafCount);
+}
+
+template <typename TEST_T>
+void expect_query_matches(ACtxBvh const& bvh, std::vector<ActiveEnt> const& inTree, std::vector<ActiveEnt> found, TEST_T&& test)
+{
+    std::vector<ActiveEnt> expected;
+    for (ActiveEnt const ent : inTree)
+    {
+        if (test(bvh.m_entBounds[ent]))
+        {
+            expected.push_back(ent);
+        }
+    }
+
+    std::sort(found.begin(), found.end());
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(found, expected);
+}
+
+} // namespace
+
+// Randomly insert, move, and remove entities, checking that queries match a brute force search
+TEST(Bvh, RandomQueriesMatchBruteForce)
+{
+    constexpr uint32_t sc_entCount = 1000;
+
+    std::mt19937 gen(123);
+
+    ACtxBvh bvh;
+    bvh.resize_active(sc_entCount);
+
+    std::vector<ActiveEnt> inTree;
+
+    for (int iteration = 0; iteration < 20; ++iteration)
+    {
+        // Insert
+        for (uint32_t i = 0; i < sc_entCount; ++i)
+        {
+            ActiveEnt const ent = ActiveEnt(i);
+            if ( ! SysBvh::contains(bvh, ent) && gen() % 2 == 0 )
+            {
+                SysBvh::insert(bvh, ent, random_bounds(gen));
+                inTree.push_back(ent);
+            }
+        }
+
+        // Move, some by a small amount that fits in the padding
+        for (ActiveEnt const ent : inTree)
+        {
+            if (gen() % 2 == 0)
+            {
+                SysBvh::update(bvh, ent, random_bounds(gen));
+            }
+            else
+            {
+                Range3D const old = bvh.m_entBounds[ent];
+                Vector3 const nudge{0.05f, -0.05f, 0.0f};
+                SysBvh::update(bvh, ent, {old.min() + nudge, old.max() + nudge});
+            }
+        }
+
+        // Remove
+        std::shuffle(inTree.begin(), inTree.end(), gen);
+        for (std::size_t i = 0; i < inTree.size() / 3; ++i)
+        {
+            SysBvh::remove(bvh, inTree.back());
+            inTree.pop_back();
+        }
+
+        expect_valid(bvh, inTree.size());
+
+        std::vector<ActiveEnt> found;
+
+        Range3D const box = random_bounds(gen).padded(Vector3{10.0f});
+        SysBvh::query_box(bvh, box, [&found] (ActiveEnt ent) { found.push_back(ent); });
+        expect_query_matches(bvh, inTree, std::exchange(found, {}), [&box] (Range3D const& bounds)
+        {
+            return Magnum::Math::intersects(bounds, box);
+        });
+
+        Vector3 const center = random_bounds(gen).center();
+        SysBvh::query_sphere(bvh, center, 15.0f, [&found] (ActiveEnt ent) { found.push_back(ent); });
+        expect_query_matches(bvh, inTree, std::exchange(found, {}), [&center] (Range3D const& bounds)
+        {
+            return math::range_sphere(bounds, center, 15.0f);
+        });
+
+        Vector3 const origin    = random_bounds(gen).center();
+        Vector3 const direction = (random_bounds(gen).center() - origin).normalized();
+        SysBvh::query_ray(bvh, origin, direction, 60.0f, [&found] (ActiveEnt ent, float)
+        {
+            found.push_back(ent);
+        });
+        Vector3 const invDirection{1.0f / direction.x(), 1.0f / direction.y(), 1.0f / direction.z()};
+        expect_query_matches(bvh, inTree, std::exchange(found, {}), [&] (Range3D const& bounds)
+        {
+            float distance;
+            return math::range_ray(bounds, origin, invDirection, 60.0f, distance);
+        });
+    }
+
+    // Tree should stay reasonably balanced
+    if (bvh.m_root != lgrn::id_null<BvhNodeId>())
+    {
+        EXPECT_LT(bvh.m_nodes[bvh.m_root].height, 32);
+    }
+
+    for (ActiveEnt const ent : inTree)
+    {
+        SysBvh::remove(bvh, ent);
+    }
+    EXPECT_EQ(bvh.m_root, lgrn::id_null<BvhNodeId>());
+}
+
+TEST(Bvh, FrustumAndTransform)
+{
+    ACtxBvh bvh;
+    bvh.resize_active(3);
+
+    Range3D const unitBox{Vector3{-1.0f}, Vector3{1.0f}};
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        bvh.m_localBounds[ActiveEnt(i)] = unitBox;
+        bvh.m_hasLocalBounds.set(i);
+    }
+
+    // Camera at origin looking down -Z
+    Frustum const frustum = Frustum::fromMatrix(Matrix4::perspectiveProjection(Rad(1.0f), 1.0f, 0.5f, 100.0f));
+
+    SysBvh::update_transform(bvh, Matrix4::translation({0.0f, 0.0f, -10.0f}),  ActiveEnt(0)); // In front
+    SysBvh::update_transform(bvh, Matrix4::translation({0.0f, 0.0f,  10.0f}),  ActiveEnt(1)); // Behind
+    SysBvh::update_transform(bvh, Matrix4::translation({50.0f, 0.0f, -10.0f}), ActiveEnt(2)); // Off to the side
+
+    expect_valid(bvh, 3);
+
+    std::vector<ActiveEnt> found;
+    SysBvh::query_frustum(bvh, frustum, [&found] (ActiveEnt ent) { found.push_back(ent); });
+    EXPECT_EQ(found, std::vector<ActiveEnt>{ActiveEnt(0)});
+
+    // Rotate entity 1 around the camera to be in front
+    SysBvh::update_transform(bvh, Matrix4::rotationY(Rad(3.14159f)) * Matrix4::translation({0.0f, 0.0f, 10.0f}), ActiveEnt(1));
+
+    found.clear();
+    SysBvh::query_frustum(bvh, frustum, [&found] (ActiveEnt ent) { found.push_back(ent); });
+    std::sort(found.begin(), found.end());
+    EXPECT_EQ(found, (std::vector<ActiveEnt>{ActiveEnt(0), ActiveEnt(1)}));
+
+    // Ray straight down -Z hits entity 0 one unit before its center
+    SysBvh::query_ray(bvh, Vector3{0.0f}, Vector3{0.0f, 0.0f, -1.0f}, 100.0f, [] (ActiveEnt ent, float distance)
+    {
+        EXPECT_NEAR(distance, 9.0f, 1e-4f);
+    });
+}
+
+TEST(Bvh, Remap)
+{
+    std::mt19937 gen(321);
+
+    ACtxBvh bvh;
+    bvh.resize_active(64);
+
+    // Even entities are in the tree, odd ones were deleted
+    ActiveEntRemap remap;
+    remap.oldToNew.resize(64, lgrn::id_null<ActiveEnt>());
+    remap.newCapacity = 32;
+
+    std::vector<ActiveEnt> inTree;
+    for (uint32_t i = 0; i < 64; i += 2)
+    {
+        SysBvh::insert(bvh, ActiveEnt(i), random_bounds(gen));
+        remap.oldToNew[ActiveEnt(i)] = ActiveEnt(31 - i / 2);
+        inTree.push_back(ActiveEnt(31 - i / 2));
+    }
+
+    Range3D const box{Vector3{-20.0f}, Vector3{20.0f}};
+    std::vector<ActiveEnt> foundBefore;
+    SysBvh::query_box(bvh, box, [&foundBefore, &remap] (ActiveEnt ent) { foundBefore.push_back(remap(ent)); });
+
+    SysBvh::update_remap(bvh, remap);
+
+    EXPECT_EQ(bvh.m_entToLeaf.size(), 32);
+    expect_valid(bvh, inTree.size());
+
+    std::vector<ActiveEnt> found;
+    SysBvh::query_box(bvh, box, [&found] (ActiveEnt ent) { found.push_back(ent); });
+    std::sort(found.begin(), found.end());
+    std::sort(foundBefore.begin(), foundBefore.end());
+    EXPECT_EQ(found, foundBefore);
+    expect_query_matches(bvh, inTree, found, [&box] (Range3D const& bounds)
+    {
+        return Magnum::Math::intersects(bounds, box);
+    });
+}
+
+// Queries still find everything in a tree far deeper than a balanced one would be
+TEST(Bvh, QueryDeepTree)
+{
+    constexpr uint32_t sc_leafCount = 200;
+
+    ACtxBvh bvh;
+    bvh.resize_active(sc_leafCount);
+
+    Range3D const box{Vector3{-1.0f}, Vector3{1.0f}};
+
+    auto const add_node = [&bvh, &box] (BvhNode node) -> BvhNodeId
+    {
+        BvhNodeId const id = bvh.m_nodeIds.create();
+        bvh.m_nodes.resize(bvh.m_nodeIds.capacity());
+        node.bounds = box;
+        bvh.m_nodes[id] = node;
+        return id;
+    };
+
+    auto const add_leaf = [&bvh, &box, &add_node] (uint32_t const entInt) -> BvhNodeId
+    {
+        ActiveEnt const ent = ActiveEnt(entInt);
+        BvhNodeId const leaf = add_node({.ent = ent});
+        bvh.m_entToLeaf[ent] = leaf;
+        bvh.m_entBounds[ent] = box;
+        return leaf;
+    };
+
+    // Every internal node has a leaf and the rest of the chain as children
+    BvhNodeId root = add_leaf(sc_leafCount - 1);
+    for (uint32_t i = sc_leafCount - 1; i-- != 0; )
+    {
+        root = add_node({.childA = add_leaf(i), .childB = root});
+    }
+    bvh.m_root = root;
+
+    std::vector<ActiveEnt> found;
+    SysBvh::query_box(bvh, box, [&found] (ActiveEnt ent) { found.push_back(ent); });
+
+    ASSERT_EQ(found.size(), sc_leafCount);
+    std::sort(found.begin(), found.end());
+    for (uint32_t i = 0; i < sc_leafCount; ++i)
+    {
+        EXPECT_EQ(found[i], ActiveEnt(i));
+    }
+}
@@ -0,0 +1,241 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/drawing/drawing_fn.h>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+using namespace osp;
+using namespace osp::draw;
+
+// Test packing and unpacking keys, and that more significant fields take priority
+TEST(DrawCommands, KeyPacking)
+{
+    DrawKey const key{.pass = 3, .shader = 200, .material = 17, .texture = 4000, .mesh = 60000, .depth = 1234};
+    DrawKey const unpacked = DrawKey::unpack(key.pack());
+
+    EXPECT_EQ(unpacked.pass,        3);
+    EXPECT_EQ(unpacked.shader,      200);
+    EXPECT_EQ(unpacked.material,    17);
+    EXPECT_EQ(unpacked.texture,     4000);
+    EXPECT_EQ(unpacked.mesh,        60000);
+    EXPECT_EQ(unpacked.depth,       1234);
+    EXPECT_FALSE(unpacked.transparent);
+
+    DrawKey const transparent{.pass = 3, .shader = 200, .material = 17, .texture = 4000, .mesh = 60000, .depth = 1234, .transparent = true};
+    DrawKey const unpackedTransparent = DrawKey::unpack(transparent.pack());
+
+    EXPECT_EQ(unpackedTransparent.pass,     3);
+    EXPECT_EQ(unpackedTransparent.shader,   200);
+    EXPECT_EQ(unpackedTransparent.material, 17);
+    EXPECT_EQ(unpackedTransparent.texture,  4000);
+    EXPECT_EQ(unpackedTransparent.mesh,     60000);
+    EXPECT_EQ(unpackedTransparent.depth,    1234);
+    EXPECT_TRUE(unpackedTransparent.transparent);
+
+    // Values too large for their field don't spill into other fields
+    EXPECT_EQ(DrawKey::unpack(DrawKey{.shader = 0x1FF}.pack()).material, 0);
+
+    EXPECT_LT((DrawKey{.pass = 0, .shader = 255, .depth = 65535}.pack()),
+              (DrawKey{.pass = 1}.pack()));
+    EXPECT_LT((DrawKey{.shader = 1, .mesh = 65535}.pack()),
+              (DrawKey{.shader = 2}.pack()));
+
+    // Opaque before transparent within a pass, and transparent sorts by depth first
+    EXPECT_LT((DrawKey{.shader = 255, .depth = 65535}.pack()),
+              (DrawKey{.transparent = true}.pack()));
+    EXPECT_LT((DrawKey{.shader = 255, .mesh = 65535, .depth = 1, .transparent = true}.pack()),
+              (DrawKey{.depth = 2, .transparent = true}.pack()));
+
+    EXPECT_LT(DrawKey::quantize_depth(1.0f, 100.0f, false), DrawKey::quantize_depth(2.0f, 100.0f, false));
+    EXPECT_GT(DrawKey::quantize_depth(1.0f, 100.0f, true),  DrawKey::quantize_depth(2.0f, 100.0f, true));
+    EXPECT_EQ(DrawKey::quantize_depth(500.0f, 100.0f, false), DrawKey::sc_depthMask);
+}
+
+// Test that radix sorting gives the same order as a stable sort, including for keys where
+// some bytes are all the same
+TEST(DrawCommands, SortMatchesStableSort)
+{
+    std::mt19937 gen(17);
+    std::uniform_int_distribution<uint32_t> fieldDist(0, 7);
+    std::uniform_int_distribution<uint32_t> depthDist(0, 0xFFFF);
+
+    for (std::size_t const count : {0, 1, 2, 100, 5000})
+    {
+        DrawCommandList list;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            DrawKey const key{.shader = fieldDist(gen), .mesh = fieldDist(gen), .depth = depthDist(gen) & 0xF0F};
+            list.m_commands.push_back({key.pack(), DrawEnt(i)});
+        }
+
+        std::vector<DrawCommand> expected = list.m_commands;
+        std::stable_sort(expected.begin(), expected.end(), [] (DrawCommand const& lhs, DrawCommand const& rhs)
+        {
+            return lhs.key < rhs.key;
+        });
+
+        SysRender::sort_draw_commands(list);
+
+        ASSERT_EQ(list.m_commands.size(), expected.size());
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            ASSERT_EQ(list.m_commands[i].key, expected[i].key);
+            ASSERT_EQ(list.m_commands[i].ent, expected[i].ent);
+        }
+    }
+}
+
+// Test building commands from a RenderGroup, and that sorting groups draws that share state
+TEST(DrawCommands, SortedStateChanges)
+{
+    constexpr std::size_t   sc_drawEntCount = 1000;
+    constexpr uint32_t      sc_shaders      = 3;
+    constexpr uint32_t      sc_materials    = 4;
+    constexpr uint32_t      sc_meshes       = 10;
+
+    std::mt19937 gen(76);
+    std::uniform_int_distribution<uint32_t> shaderDist(0, sc_shaders - 1);
+    std::uniform_int_distribution<uint32_t> materialDist(0, sc_materials - 1);
+    std::uniform_int_distribution<uint32_t> meshDist(0, sc_meshes - 1);
+    std::uniform_int_distribution<uint32_t> depthDist(0, 0xFFFF);
+
+    RenderGroup             group;
+    DrawEntSet_t            visible;
+    KeyedVec<DrawEnt, DrawKey> keys;
+    bitvector_resize(visible, sc_drawEntCount);
+    keys.resize(sc_drawEntCount);
+
+    for (std::size_t i = 0; i < sc_drawEntCount; ++i)
+    {
+        auto const drawEnt = DrawEnt(i);
+        group.entities.emplace(drawEnt, EntityToDraw{});
+        keys[drawEnt] = {.shader = shaderDist(gen), .material = materialDist(gen), .mesh = meshDist(gen), .depth = depthDist(gen)};
+
+        // Every third entity is not visible
+        if (i % 3 != 0)
+        {
+            visible.set(i);
+        }
+    }
+
+    DrawCommandList list;
+    SysRender::build_draw_commands(group, visible, list, [&keys] (DrawEnt const drawEnt, EntityToDraw const&)
+    {
+        return keys[drawEnt];
+    });
+
+    ASSERT_EQ(list.m_commands.size(), visible.count());
+    for (DrawCommand const& cmd : list.m_commands)
+    {
+        ASSERT_TRUE(visible.test(std::size_t(cmd.ent)));
+        ASSERT_EQ(cmd.key, keys[cmd.ent].pack());
+    }
+
+    DrawStateChanges const unsorted = SysRender::count_state_changes(list.m_commands);
+    SysRender::sort_draw_commands(list);
+    DrawStateChanges const sorted   = SysRender::count_state_changes(list.m_commands);
+
+    EXPECT_EQ(sorted.draws,     list.m_commands.size());
+    EXPECT_EQ(sorted.passes,    1);
+    EXPECT_EQ(sorted.shaders,   sc_shaders);
+
+    // Each shader switches through its materials once, and each material through its meshes
+    EXPECT_LE(sorted.materials, sc_shaders * sc_materials);
+    EXPECT_LE(sorted.meshes,    sc_shaders * sc_materials * sc_meshes);
+
+    EXPECT_LT(sorted.shaders,   unsorted.shaders);
+    EXPECT_LT(sorted.meshes,    unsorted.meshes);
+
+    // Depth is nearest first within draws that share all other state
+    for (std::size_t i = 1; i < list.m_commands.size(); ++i)
+    {
+        DrawKey const prev = DrawKey::unpack(list.m_commands[i - 1].key);
+        DrawKey const curr = DrawKey::unpack(list.m_commands[i].key);
+        if (prev.shader == curr.shader && prev.material == curr.material && prev.mesh == curr.mesh)
+        {
+            ASSERT_LE(prev.depth, curr.depth);
+        }
+    }
+}
+
+// Test that transparent draws are sorted back-to-front even if they use different meshes
+TEST(DrawCommands, TransparentBackToFront)
+{
+    constexpr float sc_maxDepth = 100.0f;
+
+    struct Draw
+    {
+        uint32_t    mesh;
+        float       distance;
+    };
+
+    // Nearest is mesh 0, then mesh 1, then mesh 0 again furthest away
+    std::array<Draw, 4> const draws
+    {{
+        {.mesh = 0, .distance = 10.0f},
+        {.mesh = 1, .distance = 50.0f},
+        {.mesh = 0, .distance = 90.0f},
+        {.mesh = 1, .distance = 30.0f}
+    }};
+
+    RenderGroup     group;
+    DrawEntSet_t    visible;
+    bitvector_resize(visible, draws.size());
+
+    for (std::size_t i = 0; i < draws.size(); ++i)
+    {
+        group.entities.emplace(DrawEnt(i), EntityToDraw{});
+        visible.set(i);
+    }
+
+    DrawCommandList list;
+    SysRender::build_draw_commands(group, visible, list, [&draws] (DrawEnt const drawEnt, EntityToDraw const&)
+    {
+        Draw const& draw = draws[std::size_t(drawEnt)];
+        return DrawKey{ .mesh           = draw.mesh,
+                        .depth          = DrawKey::quantize_depth(draw.distance, sc_maxDepth, true),
+                        .transparent    = true };
+    });
+
+    SysRender::sort_draw_commands(list);
+
+    ASSERT_EQ(list.m_commands.size(), draws.size());
+    EXPECT_EQ(list.m_commands[0].ent, DrawEnt(2));
+    EXPECT_EQ(list.m_commands[1].ent, DrawEnt(1));
+    EXPECT_EQ(list.m_commands[2].ent, DrawEnt(3));
+    EXPECT_EQ(list.m_commands[3].ent, DrawEnt(0));
+
+    for (std::size_t i = 1; i < list.m_commands.size(); ++i)
+    {
+        EXPECT_GT(draws[std::size_t(list.m_commands[i - 1].ent)].distance,
+                  draws[std::size_t(list.m_commands[i].ent)].distance);
+    }
+}
@@ -0,0 +1,486 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/core/math_mat4.h>
+#include <osp/drawing/drawing_fn.h>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using namespace osp;
+using namespace osp::active;
+using namespace osp::draw;
+
+static Matrix4 random_transform(std::mt19937 &rGen)
+{
+    std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+    return Matrix4::translation({dist(rGen), dist(rGen), dist(rGen)})
+         * Matrix4::rotationX(Rad(dist(rGen)))
+         * Matrix4::rotationZ(Rad(dist(rGen)))
+         * Matrix4::scaling({1.0f + 0.1f * dist(rGen), 1.0f, 1.0f});
+}
+
+TEST(DrawTransforms, MulMat4)
+{
+    std::mt19937 gen(42);
+
+    for (int i = 0; i < 64; ++i)
+    {
+        Matrix4 const a = random_transform(gen);
+        Matrix4 const b = random_transform(gen);
+
+        Matrix4 out;
+        math::mul_mat4(a, b, out);
+        EXPECT_EQ(out, a * b);
+
+        // Aliasing output with either input
+        Matrix4 aliasA = a;
+        math::mul_mat4(aliasA, b, aliasA);
+        EXPECT_EQ(aliasA, a * b);
+
+        Matrix4 aliasB = b;
+        math::mul_mat4(a, aliasB, aliasB);
+        EXPECT_EQ(aliasB, a * b);
+    }
+}
+
+/**
+ * @brief Random scene graph where every third entity is drawn
+ */
+struct RandomScene
+{
+    RandomScene(uint32_t const entCount, std::mt19937 &rGen)
+    {
+        basic.m_scnGraph.resize(entCount);
+
+        // Build a random tree by adding each entity under a random existing one
+        for (uint32_t i = 0; i < entCount; ++i)
+        {
+            ActiveEnt const parent = (i == 0) ? lgrn::id_null<ActiveEnt>()
+                                   : ActiveEnt(std::uniform_int_distribution<uint32_t>(0, i - 1)(rGen));
+            if (i % 5 == 0)
+            {
+                // Some at root
+                SysSceneGraph::add_descendants(basic.m_scnGraph, 1).add_child(ActiveEnt(i));
+            }
+            else
+            {
+                SysSceneGraph::add_descendants(basic.m_scnGraph, 1, parent).add_child(ActiveEnt(i));
+            }
+            basic.m_transform.emplace(ActiveEnt(i), ACompTransform{random_transform(rGen)});
+        }
+
+        bitvector_resize(needDrawTf, entCount);
+        activeToDraw.resize(entCount, lgrn::id_null<DrawEnt>());
+        for (uint32_t i = 0; i < entCount; i += 3)
+        {
+            activeToDraw[ActiveEnt(i)] = DrawEnt(i);
+            SysRender::needs_draw_transforms(basic.m_scnGraph, needDrawTf, ActiveEnt(i));
+        }
+    }
+
+    SysRender::ArgsForUpdDrawTransform args(DrawTransforms_t &rDrawTf)
+    {
+        return {
+            .scnGraph     = basic.m_scnGraph,
+            .transforms   = basic.m_transform,
+            .activeToDraw = activeToDraw,
+            .needDrawTf   = needDrawTf,
+            .rDrawTf      = rDrawTf
+        };
+    }
+
+    ACtxBasic                       basic;
+    ActiveEntSet_t                  needDrawTf;
+    KeyedVec<ActiveEnt, DrawEnt>    activeToDraw;
+};
+
+// Linear pass must give the same draw transforms and observer calls as the recursive one
+TEST(DrawTransforms, LinearMatchesRecursive)
+{
+    constexpr uint32_t sc_entCount = 2048;
+
+    std::mt19937 gen(1337);
+
+    RandomScene scene(sc_entCount, gen);
+    ACtxBasic &basic = scene.basic;
+
+    using ObserverCall_t = std::tuple<ActiveEnt, int>;
+
+    DrawTransforms_t                drawTfRecursive;
+    DrawTransforms_t                drawTfLinear;
+    std::vector<ObserverCall_t>     callsRecursive;
+    std::vector<ObserverCall_t>     callsLinear;
+    drawTfRecursive .resize(sc_entCount);
+    drawTfLinear    .resize(sc_entCount);
+
+    auto rootChildren = SysSceneGraph::children(basic.m_scnGraph);
+    SysRender::update_draw_transforms(
+            scene.args(drawTfRecursive),
+            rootChildren.begin(),
+            rootChildren.end(),
+            [&callsRecursive] (Matrix4 const&, ActiveEnt ent, int depth)
+    {
+        callsRecursive.emplace_back(ent, depth);
+    });
+
+    KeyedVec<TreePos_t, Matrix4> treeWorldTf;
+    SysRender::update_draw_transforms_linear(
+            scene.args(drawTfLinear),
+            treeWorldTf,
+            [&callsLinear] (Matrix4 const&, ActiveEnt ent, int depth)
+    {
+        callsLinear.emplace_back(ent, depth);
+    });
+
+    EXPECT_EQ(callsLinear, callsRecursive);
+
+    for (uint32_t i = 0; i < sc_entCount; i += 3)
+    {
+        EXPECT_EQ(drawTfLinear[DrawEnt(i)], drawTfRecursive[DrawEnt(i)]);
+        EXPECT_EQ(treeWorldTf[basic.m_scnGraph.m_entToTreePos[ActiveEnt(i)]], drawTfRecursive[DrawEnt(i)]);
+    }
+}
+
+// Dirty pass must match a full pass, and only touch subtrees of modified entities
+TEST(DrawTransforms, DirtyMatchesFull)
+{
+    constexpr uint32_t sc_entCount = 1024;
+
+    std::mt19937 gen(7);
+
+    RandomScene scene(sc_entCount, gen);
+    ACtxBasic &basic = scene.basic;
+
+    DrawTransforms_t    drawTf;
+    DrawTransforms_t    drawTfFull;
+    DrawTfCache         cache;
+    DrawEntVec_t        changed;
+    drawTf      .resize(sc_entCount);
+    drawTfFull  .resize(sc_entCount);
+
+    auto const expect_matches_full = [&] ()
+    {
+        KeyedVec<TreePos_t, Matrix4> treeWorldTf;
+        SysRender::update_draw_transforms_linear(scene.args(drawTfFull), treeWorldTf);
+
+        for (uint32_t i = 0; i < sc_entCount; i += 3)
+        {
+            if (basic.m_scnGraph.m_entToTreePos[ActiveEnt(i)] != lgrn::id_null<TreePos_t>())
+            {
+                ASSERT_EQ(drawTf[DrawEnt(i)], drawTfFull[DrawEnt(i)]);
+            }
+        }
+    };
+
+    // First call calculates everything
+    SysRender::update_draw_transforms_dirty(scene.args(drawTf), basic.m_transformDirty, cache, changed);
+    EXPECT_EQ(changed.size(), (sc_entCount + 2) / 3);
+    expect_matches_full();
+
+    // Nothing changed
+    changed.clear();
+    SysRender::update_draw_transforms_dirty(scene.args(drawTf), basic.m_transformDirty, cache, changed);
+    EXPECT_TRUE(changed.empty());
+
+    for (int iteration = 0; iteration < 16; ++iteration)
+    {
+        // Modify a few transforms, including some that are ancestors of others
+        std::vector<DrawEnt> expectChanged;
+        for (int i = 0; i < 4; ++i)
+        {
+            ActiveEnt const ent = ActiveEnt(std::uniform_int_distribution<uint32_t>(0, sc_entCount - 1)(gen));
+            basic.m_transform.get(ent).m_transform = random_transform(gen);
+            mark_transform_dirty(basic.m_transformDirty, ent);
+
+            auto const add_expected = [&] (ActiveEnt const drawn)
+            {
+                DrawEnt const drawEnt = scene.activeToDraw[drawn];
+                if (drawEnt != lgrn::id_null<DrawEnt>())
+                {
+                    expectChanged.push_back(drawEnt);
+                }
+            };
+            add_expected(ent);
+            for (ActiveEnt const descendant : SysSceneGraph::descendants(basic.m_scnGraph, ent))
+            {
+                add_expected(descendant);
+            }
+        }
+
+        changed.clear();
+        SysRender::update_draw_transforms_dirty(scene.args(drawTf), basic.m_transformDirty, cache, changed);
+        basic.m_transformDirty.reset();
+
+        std::sort(expectChanged.begin(), expectChanged.end());
+        expectChanged.erase(std::unique(expectChanged.begin(), expectChanged.end()), expectChanged.end());
+        std::sort(changed.begin(), changed.end());
+        EXPECT_EQ(changed, expectChanged);
+
+        expect_matches_full();
+    }
+
+    // Changing the scene graph recalculates everything
+    ActiveEnt const cutEnt = ActiveEnt(2);
+    std::size_t const cutDrawn = std::count_if(
+            SysSceneGraph::descendants(basic.m_scnGraph, cutEnt).begin(),
+            SysSceneGraph::descendants(basic.m_scnGraph, cutEnt).end(),
+            [&scene] (ActiveEnt const ent) { return scene.activeToDraw[ent] != lgrn::id_null<DrawEnt>(); });
+    ASSERT_EQ(scene.activeToDraw[cutEnt], lgrn::id_null<DrawEnt>());
+
+    SysSceneGraph::cut(basic.m_scnGraph, &cutEnt, &cutEnt + 1);
+
+    changed.clear();
+    SysRender::update_draw_transforms_dirty(scene.args(drawTf), basic.m_transformDirty, cache, changed);
+    EXPECT_EQ(changed.size(), (sc_entCount + 2) / 3 - cutDrawn);
+    expect_matches_full();
+}
+
+TEST(DrawTransforms, ComposeDecomposeTRS)
+{
+    std::mt19937 gen(3);
+
+    for (int i = 0; i < 64; ++i)
+    {
+        Matrix4 const tf = random_transform(gen);
+
+        Vector3     translation;
+        Quaternion  rotation;
+        Vector3     scale;
+        math::decompose_trs(tf, translation, rotation, scale);
+
+        Matrix4 const composed = math::compose_trs(translation, rotation, scale);
+        for (int j = 0; j < 16; ++j)
+        {
+            EXPECT_NEAR(composed.data()[j], tf.data()[j], 1e-5f);
+        }
+    }
+}
+
+// Local transforms read from ACtxTransformTRS must give the same results as from ACompTransform
+TEST(DrawTransforms, LinearFromTRS)
+{
+    constexpr uint32_t sc_entCount = 512;
+
+    std::mt19937 gen(99);
+
+    RandomScene scene(sc_entCount, gen);
+
+    ACtxTransformTRS trs;
+    trs.resize(sc_entCount);
+    for (auto const& [ent, tf] : scene.basic.m_transform.each())
+    {
+        trs.set_matrix(ent, tf.m_transform);
+    }
+
+    DrawTransforms_t drawTf;
+    DrawTransforms_t drawTfTRS;
+    drawTf      .resize(sc_entCount);
+    drawTfTRS   .resize(sc_entCount);
+
+    KeyedVec<TreePos_t, Matrix4> treeWorldTf;
+    SysRender::update_draw_transforms_linear(scene.args(drawTf), treeWorldTf);
+
+    SysRender::ArgsForUpdDrawTransform argsTRS = scene.args(drawTfTRS);
+    argsTRS.pTRS = &trs;
+    SysRender::update_draw_transforms_linear(argsTRS, treeWorldTf);
+
+    for (uint32_t i = 0; i < sc_entCount; i += 3)
+    {
+        for (int j = 0; j < 16; ++j)
+        {
+            EXPECT_NEAR(drawTfTRS[DrawEnt(i)].data()[j], drawTf[DrawEnt(i)].data()[j], 1e-3f);
+        }
+    }
+}
+
+// Test that modified transforms are drawn once, including from scene updates that weren't drawn
+TEST(DrawTransforms, TakeTransformDirty)
+{
+    constexpr uint32_t sc_entCount = 200;
+
+    ActiveEntSet_t  sceneDirty;
+    ACtxSceneRender scnRender;
+    bitvector_resize(sceneDirty, sc_entCount);
+    scnRender.resize_active(sc_entCount);
+
+    auto const scene_clear = [&] ()
+    {
+        SysRender::clear_transform_dirty(sceneDirty, scnRender);
+    };
+
+    auto const draw = [&] () -> std::vector<std::size_t>
+    {
+        SysRender::take_transform_dirty(sceneDirty, scnRender);
+        auto const ones = scnRender.m_transformDirty.ones();
+        std::vector<std::size_t> out(ones.begin(), ones.end());
+        scnRender.m_transformDirty.reset();
+        return out;
+    };
+
+    // Scene update, then drawn twice
+    sceneDirty.set(3);
+    sceneDirty.set(150);
+    EXPECT_EQ(draw(), (std::vector<std::size_t>{3, 150}));
+    EXPECT_TRUE(draw().empty());
+
+    // Drawn changes aren't handed over again by the next scene update
+    scene_clear();
+    EXPECT_TRUE(draw().empty());
+
+    // Two scene updates without drawing in between
+    sceneDirty.set(10);
+    scene_clear();
+    sceneDirty.set(199);
+    EXPECT_EQ(draw(), (std::vector<std::size_t>{10, 199}));
+
+    // Only newly modified entities are drawn before the scene clears
+    sceneDirty.set(10);
+    EXPECT_EQ(draw(), (std::vector<std::size_t>{10}));
+}
+
+// Interpolation must read local transforms the same way as the draw transform pass, or
+// unmoved entities are seen as moving when using TRS storage
+TEST(DrawTransforms, InterpolateFromTRS)
+{
+    constexpr uint32_t sc_entCount = 512;
+
+    std::mt19937 gen(99);
+
+    RandomScene scene(sc_entCount, gen);
+
+    // Different from the matrices, so reading from the wrong one shows up
+    ACtxTransformTRS trs;
+    trs.resize(sc_entCount);
+    for (auto const& [ent, tf] : scene.basic.m_transform.each())
+    {
+        trs.set_matrix(ent, Matrix4::translation({1.0f, 0.0f, 0.0f}) * tf.m_transform);
+    }
+
+    DrawTfInterp interp;
+    interp.resize(sc_entCount);
+    SysRender::save_interp_transforms(scene.basic.m_transform, interp, &trs);
+    SysRender::save_interp_transforms(scene.basic.m_transform, interp, &trs);
+
+    EXPECT_TRUE(interp.m_moving.ones().begin() == interp.m_moving.ones().end());
+
+    DrawTransforms_t drawTf;
+    DrawTransforms_t drawTfInterp;
+    drawTf      .resize(sc_entCount);
+    drawTfInterp.resize(sc_entCount);
+
+    SysRender::ArgsForUpdDrawTransform args = scene.args(drawTf);
+    args.pTRS = &trs;
+    KeyedVec<TreePos_t, Matrix4> treeWorldTf;
+    SysRender::update_draw_transforms_linear(args, treeWorldTf);
+
+    SysRender::ArgsForUpdDrawTransform argsInterp = scene.args(drawTfInterp);
+    argsInterp.pTRS         = &trs;
+    argsInterp.pInterp      = &interp;
+    argsInterp.interpAlpha  = 0.25f;
+    SysRender::update_draw_transforms_linear(argsInterp, treeWorldTf);
+
+    for (uint32_t i = 0; i < sc_entCount; i += 3)
+    {
+        EXPECT_EQ(drawTfInterp[DrawEnt(i)], drawTf[DrawEnt(i)]);
+    }
+}
+
+// Entities with only a TRS transform and no ACompTransform are still saved for interpolation
+TEST(DrawTransforms, InterpolateTRSOnly)
+{
+    constexpr uint32_t sc_entCount = 8;
+
+    ACompTransformStorage_t transforms; // Empty
+
+    ACtxTransformTRS trs;
+    trs.resize(sc_entCount);
+    trs.set_matrix(ActiveEnt(1), Matrix4::translation({1.0f, 0.0f, 0.0f}));
+    trs.set_matrix(ActiveEnt(3), Matrix4::translation({3.0f, 0.0f, 0.0f}));
+    trs.set_matrix(ActiveEnt(5), Matrix4::translation({5.0f, 0.0f, 0.0f}));
+
+    DrawTfInterp interp;
+    interp.resize(sc_entCount);
+    SysRender::save_interp_transforms(transforms, interp, &trs);
+
+    auto const ones = [] (BitVector_t const& bits)
+    {
+        auto const range = bits.ones();
+        return std::vector<std::size_t>(range.begin(), range.end());
+    };
+
+    EXPECT_EQ(ones(interp.m_hasLast), (std::vector<std::size_t>{1, 3, 5}));
+    EXPECT_EQ(interp.m_last[ActiveEnt(3)], Matrix4::translation({3.0f, 0.0f, 0.0f}));
+
+    trs.set_matrix(ActiveEnt(3), Matrix4::translation({3.0f, 1.0f, 0.0f}));
+    trs.remove(ActiveEnt(5));
+    SysRender::save_interp_transforms(transforms, interp, &trs);
+
+    EXPECT_EQ(ones(interp.m_hasLast), (std::vector<std::size_t>{1, 3}));
+    EXPECT_EQ(ones(interp.m_moving),  (std::vector<std::size_t>{3}));
+}
+
+TEST(DrawTransforms, InterpolateEndpoints)
+{
+    std::mt19937 gen(7);
+
+    for (int i = 0; i < 64; ++i)
+    {
+        Matrix4 const a = random_transform(gen);
+        Matrix4 const b = random_transform(gen);
+
+        EXPECT_EQ(SysRender::interpolate_transform(a, b, 0.0f), a);
+        EXPECT_EQ(SysRender::interpolate_transform(a, b, 1.0f), b);
+        EXPECT_EQ(SysRender::interpolate_transform(a, a, 0.5f), a);
+    }
+}
+
+TEST(DrawTransforms, InterpolateMidpoint)
+{
+    Matrix4 const a = Matrix4::translation({-1.0f, 0.0f, 2.0f});
+    Matrix4 const b = Matrix4::translation({3.0f, 4.0f, 2.0f})
+                    * Matrix4::rotationZ(Deg(90.0f))
+                    * Matrix4::scaling({3.0f, 1.0f, 5.0f});
+
+    // Translation and scale are lerped, rotation is slerped
+    EXPECT_EQ(SysRender::interpolate_transform(a, b, 0.5f),
+              Matrix4::translation({1.0f, 2.0f, 2.0f})
+            * Matrix4::rotationZ(Deg(45.0f))
+            * Matrix4::scaling({2.0f, 1.0f, 3.0f}));
+
+    EXPECT_EQ(SysRender::interpolate_transform(a, b, 0.25f),
+              Matrix4::translation({0.0f, 1.0f, 2.0f})
+            * Matrix4::rotationZ(Deg(22.5f))
+            * Matrix4::scaling({1.5f, 1.0f, 2.0f}));
+
+    // Rotation takes the shortest path through 180 degrees, not the long way through 0
+    EXPECT_EQ(SysRender::interpolate_transform(Matrix4::rotationZ(Deg(170.0f)), Matrix4::rotationZ(Deg(-170.0f)), 0.5f),
+              Matrix4::rotationZ(Deg(180.0f)));
+}
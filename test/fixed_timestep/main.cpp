@@ -0,0 +1,76 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/core/fixed_timestep.h>
+
+#include <gtest/gtest.h>
+
+using osp::FixedTimestep;
+
+// Step sizes here are powers of two, so accumulated time is exact
+
+TEST(FixedTimestep, StepCount)
+{
+    FixedTimestep step{ .m_stepDelta = 0.25f };
+
+    // Less than a step runs nothing, and is left to interpolate with
+    EXPECT_EQ(step.accumulate(0.125f), 0);
+    EXPECT_EQ(step.alpha(), 0.5f);
+
+    EXPECT_EQ(step.accumulate(0.125f), 1);
+    EXPECT_EQ(step.alpha(), 0.0f);
+
+    EXPECT_EQ(step.accumulate(0.5f), 2);
+    EXPECT_EQ(step.alpha(), 0.0f);
+
+    EXPECT_EQ(step.accumulate(0.375f), 1);
+    EXPECT_EQ(step.alpha(), 0.5f);
+
+    EXPECT_EQ(step.accumulate(0.125f), 1);
+    EXPECT_EQ(step.alpha(), 0.0f);
+}
+
+TEST(FixedTimestep, MaxStepsDropsTime)
+{
+    FixedTimestep step{ .m_stepDelta = 0.25f, .m_maxSteps = 4 };
+
+    // 40 steps worth of time, but only 4 run. All but one more step is dropped
+    EXPECT_EQ(step.accumulate(10.0f), 4);
+    EXPECT_EQ(step.alpha(), 1.0f);
+
+    EXPECT_EQ(step.accumulate(0.0f), 1);
+    EXPECT_EQ(step.alpha(), 0.0f);
+
+    EXPECT_EQ(step.accumulate(0.0f), 0);
+}
+
+TEST(FixedTimestep, Disabled)
+{
+    FixedTimestep step{ .m_stepDelta = 0.25f, .m_enabled = false };
+
+    // Exactly one update per frame, drawn at the latest update
+    EXPECT_EQ(step.accumulate(10.0f), 1);
+    EXPECT_EQ(step.accumulate(0.0f), 1);
+    EXPECT_EQ(step.alpha(), 1.0f);
+}
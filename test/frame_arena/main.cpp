@@ -0,0 +1,138 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/core/frame_arena.h>
+#include <osp/core/keyed_vector.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+using osp::FrameArena;
+
+// Counts calls to the upstream resource
+class CountingResource final : public std::pmr::memory_resource
+{
+public:
+    int allocations     {0};
+    int deallocations   {0};
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++ allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) override
+    {
+        ++ deallocations;
+        std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+    }
+
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+// Allocations that don't fit go upstream, and the block grows to fit them after reset
+TEST(FrameArena, GrowsToFitFrame)
+{
+    CountingResource upstream;
+
+    {
+        FrameArena arena{64, &upstream};
+        ASSERT_EQ(upstream.allocations, 1);
+
+        auto const frame = [&arena] ()
+        {
+            std::pmr::vector<int> a{&arena};
+            std::pmr::vector<int> b{&arena};
+            for (int i = 0; i < 100; ++i)
+            {
+                a.push_back(i);
+                b.push_back(-i);
+            }
+            EXPECT_EQ(a[99], 99);
+            EXPECT_EQ(b[99], -99);
+        };
+
+        frame();
+        EXPECT_GT(upstream.allocations, 1);
+        EXPECT_GE(arena.used(), 2 * 100 * sizeof(int));
+
+        arena.reset();
+        EXPECT_EQ(arena.used(), 0);
+        EXPECT_GE(arena.capacity(), 2 * 100 * sizeof(int));
+
+        // Same workload fits in the block now
+        int const allocationsBefore = upstream.allocations;
+        frame();
+        arena.reset();
+        frame();
+        EXPECT_EQ(upstream.allocations, allocationsBefore);
+    }
+
+    EXPECT_EQ(upstream.allocations, upstream.deallocations);
+}
+
+// Allocations respect alignment, and freeing the latest allocation rewinds
+TEST(FrameArena, AlignmentAndRewind)
+{
+    FrameArena arena{1024};
+
+    void *const pByte = arena.allocate(1, 1);
+    void *const pWide = arena.allocate(64, 64);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(pWide) % 64, 0);
+    EXPECT_NE(pByte, pWide);
+
+    std::size_t const usedBefore = arena.used();
+    void *const pLast = arena.allocate(32, 8);
+    arena.deallocate(pLast, 32, 8);
+    EXPECT_EQ(arena.used(), usedBefore);
+    EXPECT_EQ(arena.allocate(32, 8), pLast);
+
+    // Not the latest allocation, freed on reset instead
+    arena.deallocate(pByte, 1, 1);
+    EXPECT_GT(arena.used(), usedBefore);
+}
+
+// pmr::KeyedVec allocates from the given resource
+TEST(FrameArena, KeyedVec)
+{
+    enum class Id : uint32_t { };
+
+    FrameArena arena{4096};
+
+    auto vec = osp::make_pmr_keyed_vec<Id, float>(&arena);
+    vec.resize(16, 1.0f);
+    vec[Id(3)] = 4.0f;
+
+    EXPECT_EQ(vec.get_allocator().resource(), &arena);
+    EXPECT_EQ(vec[Id(3)], 4.0f);
+    EXPECT_GE(arena.used(), 16 * sizeof(float));
+}
@@ -0,0 +1,150 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/drawing/drawing_fn.h>
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace osp;
+using namespace osp::draw;
+
+namespace
+{
+
+struct CullScene
+{
+    explicit CullScene(std::size_t const drawEntCount)
+    {
+        drawEnts.resize(drawEntCount);
+        scnRender.m_drawIds.create(drawEnts.begin(), drawEnts.end());
+        scnRender.resize_draw();
+
+        cube = drawing.m_meshIds.create();
+        SysRender::set_mesh_bounds(drawing, cube, {Vector3{-1.0f}, Vector3{1.0f}});
+
+        noBounds = drawing.m_meshIds.create();
+    }
+
+    ~CullScene()
+    {
+        SysRender::clear_owners(scnRender, drawing);
+    }
+
+    void add(DrawEnt const drawEnt, MeshId const mesh, Matrix4 const& transform)
+    {
+        scnRender.m_mesh[drawEnt]           = drawing.m_meshRefCounts.ref_add(mesh);
+        scnRender.m_drawTransform[drawEnt]  = transform;
+        scnRender.m_visible.set(std::size_t(drawEnt));
+    }
+
+    ACtxDrawing             drawing;
+    ACtxSceneRender         scnRender;
+    std::vector<DrawEnt>    drawEnts;
+    MeshId                  cube;
+    MeshId                  noBounds;
+};
+
+// Camera at the origin looking down -Z
+ViewProjMatrix const gc_viewProj{Matrix4{}, Matrix4::perspectiveProjection(Deg(90.0f), 1.0f, 1.0f, 100.0f)};
+
+} // namespace
+
+TEST(FrustumCulling, KnownPositions)
+{
+    CullScene scene(8);
+    std::vector<DrawEnt> const &ents = scene.drawEnts;
+
+    scene.add(ents[0], scene.cube, Matrix4::translation({0.0f, 0.0f, -10.0f}));   // In front
+    scene.add(ents[1], scene.cube, Matrix4::translation({0.0f, 0.0f, 10.0f}));    // Behind
+    scene.add(ents[2], scene.cube, Matrix4::translation({30.0f, 0.0f, -10.0f}));  // Off to the right
+    scene.add(ents[3], scene.cube, Matrix4::translation({11.0f, 0.0f, -10.0f}));  // Crossing the right plane
+    scene.add(ents[4], scene.cube, Matrix4::translation({0.0f, 0.0f, -150.0f}));  // Past the far plane
+    scene.add(ents[5], scene.cube, Matrix4::translation({30.0f, 0.0f, -10.0f})
+                                 * Matrix4::scaling({25.0f, 1.0f, 1.0f}));        // Scaled into view
+    scene.add(ents[6], scene.noBounds, Matrix4::translation({0.0f, 0.0f, 10.0f})); // No bounds, never culled
+    scene.scnRender.m_mesh[ents[7]] = {};                                        // Not visible
+
+    DrawEntSet_t inView;
+    SysRender::cull_frustum(scene.scnRender, scene.drawing, scene.scnRender.m_visible, gc_viewProj, inView);
+
+    EXPECT_TRUE (inView.test(std::size_t(ents[0])));
+    EXPECT_FALSE(inView.test(std::size_t(ents[1])));
+    EXPECT_FALSE(inView.test(std::size_t(ents[2])));
+    EXPECT_TRUE (inView.test(std::size_t(ents[3])));
+    EXPECT_FALSE(inView.test(std::size_t(ents[4])));
+    EXPECT_TRUE (inView.test(std::size_t(ents[5])));
+    EXPECT_TRUE (inView.test(std::size_t(ents[6])));
+    EXPECT_FALSE(inView.test(std::size_t(ents[7])));
+}
+
+// Enough entities to span several batches, checked one at a time against the frustum
+TEST(FrustumCulling, MatchesPerEntityTest)
+{
+    constexpr std::size_t sc_count = 1000;
+
+    CullScene scene(sc_count);
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> posDist(-60.0f, 60.0f);
+    std::uniform_real_distribution<float> scaleDist(0.5f, 3.0f);
+
+    for (DrawEnt const drawEnt : scene.drawEnts)
+    {
+        if (gen() % 5 != 0)
+        {
+            scene.add(drawEnt, (gen() % 10 == 0) ? scene.noBounds : scene.cube,
+                      Matrix4::translation({posDist(gen), posDist(gen), posDist(gen)})
+                    * Matrix4::scaling(Vector3{scaleDist(gen)}));
+        }
+    }
+
+    DrawEntSet_t inView;
+    SysRender::cull_frustum(scene.scnRender, scene.drawing, scene.scnRender.m_visible, gc_viewProj, inView);
+
+    Frustum const frustum = Frustum::fromMatrix(gc_viewProj.m_viewProj);
+
+    std::size_t culled = 0;
+    for (DrawEnt const drawEnt : scene.drawEnts)
+    {
+        bool expected = scene.scnRender.m_visible.test(std::size_t(drawEnt));
+        if (expected && scene.scnRender.m_mesh[drawEnt].value() == scene.cube)
+        {
+            Matrix4 const& tf       = scene.scnRender.m_drawTransform[drawEnt];
+            float const radius      = Vector3{1.0f}.length() * tf.scaling().max();
+            for (Vector4 const& plane : frustum)
+            {
+                float const distance = Magnum::Math::dot(plane.xyz(), tf.translation()) + plane.w();
+                expected = expected && (distance / plane.xyz().length() >= -radius);
+            }
+            culled += ! expected;
+        }
+
+        EXPECT_EQ(inView.test(std::size_t(drawEnt)), expected);
+    }
+
+    // Most of the volume is outside the 90 degree view
+    EXPECT_GT(culled, sc_count / 4);
+}
@@ -0,0 +1,380 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2023 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/activescene/basic_fn.h>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace osp;
+using namespace osp::active;
+
+// Check that tree positions, parents, and descendant counts all agree with each other
+static void expect_consistent(ACtxSceneGraph const& scnGraph)
+{
+    TreePos_t const treeSize = scnGraph.m_treeDescendants[0] + 1;
+    ASSERT_EQ(scnGraph.m_treeToEnt.size(),       treeSize);
+    ASSERT_EQ(scnGraph.m_treeDescendants.size(), treeSize);
+
+    for (TreePos_t pos = 1; pos < treeSize; ++pos)
+    {
+        ActiveEnt const ent = scnGraph.m_treeToEnt[pos];
+        EXPECT_EQ(scnGraph.m_entToTreePos[ent], pos);
+
+        // Descendant count must equal the sum of each child's subtree
+        uint32_t childTotal = 0;
+        for (ActiveEnt const child : SysSceneGraph::children(scnGraph, ent))
+        {
+            EXPECT_EQ(scnGraph.m_entParent[child], ent);
+            childTotal += 1 + scnGraph.m_treeDescendants[scnGraph.m_entToTreePos[child]];
+        }
+        EXPECT_EQ(childTotal, scnGraph.m_treeDescendants[pos]);
+    }
+}
+
+// Fill a subtree of n entities: a root with n-1 children
+static void fill_subtree(SubtreeBuilder &rBuilder, uint32_t const n, uint32_t &rNextEnt)
+{
+    SubtreeBuilder bldRoot = rBuilder.add_child(ActiveEnt(rNextEnt ++), n - 1);
+    for (uint32_t i = 1; i < n; ++i)
+    {
+        bldRoot.add_child(ActiveEnt(rNextEnt ++));
+    }
+}
+
+// Batch inserts must give the exact same tree as inserting one by one
+TEST(SceneGraph, BatchInsertMatchesSequential)
+{
+    constexpr uint32_t sc_entCount  = 4096;
+    constexpr int      sc_rounds    = 8;
+
+    std::mt19937 gen(69);
+
+    ACtxSceneGraph sequential;
+    ACtxSceneGraph batched;
+    sequential  .resize(sc_entCount);
+    batched     .resize(sc_entCount);
+
+    uint32_t nextEnt = 0;
+
+    for (int round = 0; round < sc_rounds; ++round)
+    {
+        // Pick random existing parents, including root and repeated parents
+        std::vector<SubtreeInsert> inserts;
+        std::vector<ActiveEnt> const existing{sequential.m_treeToEnt.begin(), sequential.m_treeToEnt.end()};
+        std::uniform_int_distribution<std::size_t> pickParent(0, existing.size() - 1);
+        std::uniform_int_distribution<uint32_t> pickSize(1, 6);
+
+        for (int i = 0; i < 40; ++i)
+        {
+            inserts.push_back({ .parent = existing[pickParent(gen)], .descendantCount = pickSize(gen) });
+        }
+
+        uint32_t const firstEnt = nextEnt;
+        for (SubtreeInsert const& insert : inserts)
+        {
+            SubtreeBuilder bld = SysSceneGraph::add_descendants(sequential, insert.descendantCount, insert.parent);
+            fill_subtree(bld, insert.descendantCount, nextEnt);
+        }
+
+        nextEnt = firstEnt;
+        std::vector<SubtreeBuilder> builders = SysSceneGraph::add_descendants_batch(batched, inserts);
+        ASSERT_EQ(builders.size(), inserts.size());
+        for (std::size_t i = 0; i < inserts.size(); ++i)
+        {
+            fill_subtree(builders[i], inserts[i].descendantCount, nextEnt);
+        }
+
+        expect_consistent(batched);
+
+        ASSERT_EQ(batched.m_treeToEnt,         sequential.m_treeToEnt);
+        ASSERT_EQ(batched.m_treeDescendants,   sequential.m_treeDescendants);
+        ASSERT_EQ(batched.m_entParent,         sequential.m_entParent);
+        ASSERT_EQ(batched.m_entToTreePos,      sequential.m_entToTreePos);
+    }
+}
+
+// Cutting after a batch insert must leave a consistent tree without the cut subtrees
+TEST(SceneGraph, BatchInsertThenCut)
+{
+    ACtxSceneGraph scnGraph;
+    scnGraph.resize(64);
+
+    uint32_t nextEnt = 0;
+    {
+        std::vector<SubtreeInsert> const inserts{
+            { .parent = lgrn::id_null<ActiveEnt>(), .descendantCount = 3 },
+            { .parent = lgrn::id_null<ActiveEnt>(), .descendantCount = 4 } };
+        std::vector<SubtreeBuilder> builders = SysSceneGraph::add_descendants_batch(scnGraph, inserts);
+        fill_subtree(builders[0], 3, nextEnt); // ents 0..2
+        fill_subtree(builders[1], 4, nextEnt); // ents 3..6
+    }
+    {
+        // Add under children of both subtrees, and under root
+        std::vector<SubtreeInsert> const inserts{
+            { .parent = ActiveEnt(4),                .descendantCount = 2 },
+            { .parent = ActiveEnt(1),                .descendantCount = 2 },
+            { .parent = lgrn::id_null<ActiveEnt>(), .descendantCount = 1 },
+            { .parent = ActiveEnt(1),                .descendantCount = 1 } };
+        std::vector<SubtreeBuilder> builders = SysSceneGraph::add_descendants_batch(scnGraph, inserts);
+        fill_subtree(builders[0], 2, nextEnt); // ents 7..8
+        fill_subtree(builders[1], 2, nextEnt); // ents 9..10
+        fill_subtree(builders[2], 1, nextEnt); // ent  11
+        fill_subtree(builders[3], 1, nextEnt); // ent  12
+    }
+
+    expect_consistent(scnGraph);
+
+    // Children of ent 1 in insertion order
+    std::vector<ActiveEnt> children;
+    for (ActiveEnt const child : SysSceneGraph::children(scnGraph, ActiveEnt(1)))
+    {
+        children.push_back(child);
+    }
+    EXPECT_EQ(children, (std::vector<ActiveEnt>{ActiveEnt(9), ActiveEnt(12)}));
+    EXPECT_EQ(scnGraph.m_treeDescendants[0], 13);
+
+    std::vector<ActiveEnt> const cut{ActiveEnt(9), ActiveEnt(3)};
+    SysSceneGraph::cut(scnGraph, cut.begin(), cut.end());
+
+    expect_consistent(scnGraph);
+    EXPECT_EQ(scnGraph.m_treeDescendants[0], 13 - 2 - 6);
+    EXPECT_EQ(scnGraph.m_entToTreePos[ActiveEnt(7)], lgrn::id_null<TreePos_t>());
+    EXPECT_EQ(scnGraph.m_entToTreePos[ActiveEnt(10)], lgrn::id_null<TreePos_t>());
+    EXPECT_NE(scnGraph.m_entToTreePos[ActiveEnt(12)], lgrn::id_null<TreePos_t>());
+}
+
+// Random reparents must keep the tree consistent, and keep each subtree's entities together
+TEST(SceneGraph, Reparent)
+{
+    constexpr uint32_t sc_entCount = 256;
+
+    std::mt19937 gen(420);
+
+    ACtxSceneGraph scnGraph;
+    scnGraph.resize(sc_entCount);
+
+    uint32_t nextEnt = 0;
+    {
+        std::vector<SubtreeInsert> inserts(sc_entCount / 4, { .parent = lgrn::id_null<ActiveEnt>(), .descendantCount = 4 });
+        std::vector<SubtreeBuilder> builders = SysSceneGraph::add_descendants_batch(scnGraph, inserts);
+        for (SubtreeBuilder &rBuilder : builders)
+        {
+            fill_subtree(rBuilder, 4, nextEnt);
+        }
+    }
+
+    std::uniform_int_distribution<uint32_t> pickEnt(0, sc_entCount - 1);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        ActiveEnt const root    = ActiveEnt(pickEnt(gen));
+        ActiveEnt const parent  = (i % 8 == 0) ? lgrn::id_null<ActiveEnt>() : ActiveEnt(pickEnt(gen));
+
+        if (parent == root || scnGraph.m_entParent[root] == parent)
+        {
+            continue;
+        }
+
+        // Skip if parent is a descendant of root
+        std::vector<ActiveEnt> subtree{root};
+        for (ActiveEnt const ent : SysSceneGraph::descendants(scnGraph, root))
+        {
+            subtree.push_back(ent);
+        }
+        if (std::find(subtree.begin(), subtree.end(), parent) != subtree.end())
+        {
+            continue;
+        }
+
+        SysSceneGraph::reparent(scnGraph, root, parent);
+
+        ASSERT_EQ(scnGraph.m_entParent[root], parent);
+        ASSERT_EQ(scnGraph.m_treeDescendants[0], sc_entCount);
+
+        // Subtree is moved as-is, in the same order
+        TreePos_t const rootPos = scnGraph.m_entToTreePos[root];
+        for (std::size_t j = 0; j < subtree.size(); ++j)
+        {
+            ASSERT_EQ(scnGraph.m_treeToEnt[rootPos + j], subtree[j]);
+        }
+
+        // Placed as the last child of the new parent
+        ActiveEnt lastChild = lgrn::id_null<ActiveEnt>();
+        for (ActiveEnt const child : SysSceneGraph::children(scnGraph, parent))
+        {
+            lastChild = child;
+        }
+        ASSERT_EQ(lastChild, root);
+    }
+
+    expect_consistent(scnGraph);
+}
+
+// Moving with EKeepTransform::World must not change where the entity is in the world
+TEST(SceneGraph, ReparentKeepWorldTransform)
+{
+    ACtxBasic basic;
+    basic.m_scnGraph.resize(8);
+
+    ActiveEnt const parentA = ActiveEnt(0);
+    ActiveEnt const childA  = ActiveEnt(1);
+    ActiveEnt const parentB = ActiveEnt(2);
+    {
+        SubtreeBuilder bld = SysSceneGraph::add_descendants(basic.m_scnGraph, 3);
+        SubtreeBuilder bldA = bld.add_child(parentA, 1);
+        bldA.add_child(childA);
+        bld.add_child(parentB);
+    }
+
+    basic.m_transform.emplace(parentA, ACompTransform{Matrix4::translation({1.0f, 2.0f, 3.0f})});
+    basic.m_transform.emplace(childA,  ACompTransform{Matrix4::translation({0.0f, 5.0f, 0.0f})});
+    basic.m_transform.emplace(parentB, ACompTransform{Matrix4::translation({-4.0f, 0.0f, 0.0f}) * Matrix4::scaling({2.0f, 2.0f, 2.0f})});
+
+    Matrix4 const worldBefore = SysSceneGraph::world_transform(basic.m_scnGraph, basic.m_transform, childA);
+    EXPECT_EQ(worldBefore.translation(), Vector3(1.0f, 7.0f, 3.0f));
+
+    SysSceneGraph::reparent(basic, childA, parentB, EKeepTransform::World);
+
+    EXPECT_EQ(basic.m_scnGraph.m_entParent[childA], parentB);
+    EXPECT_EQ(SysSceneGraph::world_transform(basic.m_scnGraph, basic.m_transform, childA), worldBefore);
+    expect_consistent(basic.m_scnGraph);
+
+    // Local keeps the same offset from the new parent
+    Matrix4 const localBefore = basic.m_transform.get(childA).m_transform;
+    SysSceneGraph::reparent(basic, childA, parentA, EKeepTransform::Local);
+
+    EXPECT_EQ(basic.m_transform.get(childA).m_transform, localBefore);
+    expect_consistent(basic.m_scnGraph);
+}
+
+// Compacting after deleting entities gives dense IDs in tree order, and keeps the same tree
+TEST(SceneGraph, CompactActiveEnts)
+{
+    constexpr uint32_t sc_vehicles      = 30;
+    constexpr uint32_t sc_partsPerVeh   = 5;
+
+    ACtxBasic basic;
+
+    // Take some IDs up front that are never added to the tree
+    std::vector<ActiveEnt> loose(10);
+    basic.m_activeIds.create(loose.begin(), loose.end());
+
+    std::vector<ActiveEnt> vehicles(sc_vehicles);
+    std::vector<ActiveEnt> parts(sc_vehicles * sc_partsPerVeh);
+    basic.m_activeIds.create(vehicles.begin(), vehicles.end());
+    basic.m_activeIds.create(parts.begin(), parts.end());
+    basic.m_scnGraph.resize(basic.m_activeIds.capacity());
+
+    {
+        SubtreeBuilder bld = SysSceneGraph::add_descendants(basic.m_scnGraph, uint32_t(vehicles.size() + parts.size()));
+        for (uint32_t v = 0; v < sc_vehicles; ++v)
+        {
+            SubtreeBuilder bldVeh = bld.add_child(vehicles[v], sc_partsPerVeh);
+            for (uint32_t p = 0; p < sc_partsPerVeh; ++p)
+            {
+                bldVeh.add_child(parts[v * sc_partsPerVeh + p]);
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < basic.m_activeIds.capacity(); ++i)
+    {
+        if (basic.m_activeIds.exists(ActiveEnt(i)))
+        {
+            basic.m_transform.emplace(ActiveEnt(i), ACompTransform{Matrix4::translation({float(i), 0.0f, 0.0f})});
+        }
+    }
+
+    // Delete every third vehicle and a loose entity
+    std::vector<ActiveEnt> cut;
+    for (uint32_t v = 0; v < sc_vehicles; v += 3)
+    {
+        cut.push_back(vehicles[v]);
+    }
+    std::vector<ActiveEnt> deleted{loose[4]};
+    SysSceneGraph::queue_delete_entities(basic.m_scnGraph, deleted, cut.begin(), cut.end());
+    for (ActiveEnt const ent : deleted)
+    {
+        basic.m_activeIds.remove(ent);
+    }
+    update_delete_basic(basic, deleted.begin(), deleted.end());
+    mark_transform_dirty(basic.m_transformDirty, parts.back());
+
+    std::size_t const oldCapacity = basic.m_activeIds.capacity();
+    ACtxSceneGraph const oldScnGraph = basic.m_scnGraph;
+    uint32_t const oldVersion = basic.m_scnGraph.m_version;
+
+    ActiveEntRemap const remap = compact_active_ents(basic);
+
+    std::size_t const count = loose.size() + vehicles.size() + parts.size() - deleted.size();
+    EXPECT_EQ(basic.m_activeIds.size(), count);
+    EXPECT_NE(basic.m_scnGraph.m_version, oldVersion);
+    expect_consistent(basic.m_scnGraph);
+
+    // Entities in the tree are numbered in tree order, loose entities come after
+    for (TreePos_t pos = 1; pos < basic.m_scnGraph.m_treeToEnt.size(); ++pos)
+    {
+        EXPECT_EQ(basic.m_scnGraph.m_treeToEnt[pos], ActiveEnt(pos - 1));
+    }
+    for (ActiveEnt const ent : loose)
+    {
+        ActiveEnt const newEnt = remap(ent);
+        if (ent == loose[4])
+        {
+            EXPECT_EQ(newEnt, lgrn::id_null<ActiveEnt>());
+            continue;
+        }
+        EXPECT_GE(newEnt.value, basic.m_scnGraph.m_treeToEnt.size() - 1);
+        EXPECT_EQ(basic.m_scnGraph.m_entToTreePos[newEnt], lgrn::id_null<TreePos_t>());
+    }
+
+    // Remaining entities keep their parents and transforms
+    for (uint32_t i = 0; i < oldCapacity; ++i)
+    {
+        ActiveEnt const oldEnt = ActiveEnt(i);
+        ActiveEnt const newEnt = remap(oldEnt);
+        if (std::find(deleted.begin(), deleted.end(), oldEnt) != deleted.end())
+        {
+            EXPECT_EQ(newEnt, lgrn::id_null<ActiveEnt>());
+            continue;
+        }
+        if (newEnt == lgrn::id_null<ActiveEnt>())
+        {
+            continue; // ID was never created
+        }
+
+        ASSERT_LT(newEnt.value, count);
+        EXPECT_EQ(basic.m_scnGraph.m_entParent[newEnt], remap(oldScnGraph.m_entParent[oldEnt]));
+        EXPECT_EQ(basic.m_transform.get(newEnt).m_transform.translation().x(), float(i));
+    }
+
+    EXPECT_EQ(basic.m_transformDirty.count(), 1);
+    EXPECT_TRUE(basic.m_transformDirty.test(remap(parts.back()).value));
+}
@@ -24,14 +24,25 @@
  */
 #include <osp/tasks/tasks.h>
 #include <osp/tasks/builder.h>
+#include <osp/tasks/exec_schedule.h>
 #include <osp/tasks/execute.h>
+#include <osp/tasks/profiler.h>
+#include <osp/tasks/top_coroutine.h>
+#include <osp/tasks/top_execute.h>
+#include <osp/tasks/top_utils.h>
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
 #include <functional>
 #include <numeric>
 #include <random>
 #include <set>
+#include <tuple>
+#include <type_traits>
 
 using namespace osp;
 
@@ -591,6 +602,51 @@ TEST(Tasks, BasicSingleThreadedNestedLoop)
     ASSERT_EQ(world.checks, sc_repetitions);
 }
 
+// Check that make_exec_graph precomputes the loop scope each pipeline is in
+TEST(Tasks, LoopScopeRanges)
+{
+    using namespace test_d;
+    using enum Stages;
+
+    using BasicTraits_t     = BasicBuilderTraits<TaskActions(*)()>;
+    using Builder_t         = BasicTraits_t::Builder;
+    using TaskFuncVec_t     = BasicTraits_t::FuncVec_t;
+
+    Tasks           tasks;
+    TaskEdges       edges;
+    TaskFuncVec_t   functions;
+    Builder_t       builder{tasks, edges, functions};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    // Tree: loopOuter( loopInner, aux )
+    builder.pipeline(pl.loopOuter).loops(true);
+    builder.pipeline(pl.loopInner).loops(true).parent(pl.loopOuter);
+    builder.pipeline(pl.aux).parent(pl.loopOuter);
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    PipelineTreePos_t const outerPos = graph.pipelineToPltree[pl.loopOuter];
+    PipelineTreePos_t const innerPos = graph.pipelineToPltree[pl.loopInner];
+
+    LoopScopeRange const& outer = graph.pipelineToLoopScopeRange[pl.loopOuter];
+    LoopScopeRange const& inner = graph.pipelineToLoopScopeRange[pl.loopInner];
+    LoopScopeRange const& aux   = graph.pipelineToLoopScopeRange[pl.aux];
+
+    EXPECT_EQ(outer.first,      outerPos);
+    EXPECT_EQ(outer.last,       outerPos + 3);
+    EXPECT_EQ(outer.pipeline,   pl.loopOuter);
+
+    EXPECT_EQ(inner.first,      innerPos);
+    EXPECT_EQ(inner.last,       innerPos + 1);
+    EXPECT_EQ(inner.pipeline,   pl.loopInner);
+
+    // aux doesn't loop, and is in its parent's loop scope
+    EXPECT_EQ(aux.first,        outerPos);
+    EXPECT_EQ(aux.last,         outerPos + 3);
+    EXPECT_EQ(aux.pipeline,     pl.loopOuter);
+}
+
 //-----------------------------------------------------------------------------
 
 namespace test_gameworld
@@ -730,5 +786,1378 @@ TEST(Tasks, BasicSingleThreadedGameWorld)
 }
 
 
+//-----------------------------------------------------------------------------
+
+namespace test_overlap
+{
+
+enum class Stages { Recalc, Use };
+
+struct Pipelines
+{
+    osp::PipelineDef<Stages> sim;
+    osp::PipelineDef<Stages> render;    /// Independent of sim, can overlap with it
+    osp::PipelineDef<Stages> other;     /// Syncs with sim, must wait for sim to finish
+};
+
+} // namespace test_overlap
+
+// Request pipelines to run while others are still running
+TEST(Tasks, OverlappingRunRequests)
+{
+    using namespace test_overlap;
+    using enum Stages;
+
+    using BasicTraits_t     = BasicBuilderTraits<TaskActions(*)()>;
+    using Builder_t         = BasicTraits_t::Builder;
+    using TaskFuncVec_t     = BasicTraits_t::FuncVec_t;
+
+    Tasks           tasks;
+    TaskEdges       edges;
+    TaskFuncVec_t   functions;
+    Builder_t       builder{tasks, edges, functions};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    TaskId const tSim    = builder.task().run_on({pl.sim(Recalc)});
+    TaskId const tRender = builder.task().run_on({pl.render(Recalc)});
+    TaskId const tOther  = builder.task().run_on({pl.other(Recalc)}).sync_with({pl.sim(Use)});
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+
+    exec_request_run(exec, pl.sim);
+    exec_update(tasks, graph, exec);
+    ASSERT_TRUE(exec.tasksQueuedRun.contains(tSim));
+
+    // Independent pipeline starts right away
+    exec_request_run(exec, pl.render);
+    exec_update(tasks, graph, exec);
+    ASSERT_TRUE(exec.tasksQueuedRun.contains(tRender));
+    ASSERT_EQ(exec.pipelinesRunning, 2);
+
+    // Dependent and already-running pipelines are deferred
+    exec_request_run(exec, pl.other);
+    exec_request_run(exec, pl.sim);
+    exec_update(tasks, graph, exec);
+    ASSERT_TRUE(exec.hasRequestRun);
+    ASSERT_FALSE(exec.plData[pl.other].running);
+    ASSERT_FALSE(exec.tasksQueuedBlocked.contains(tOther));
+
+    // Finishing sim lets both deferred requests start together
+    complete_task(tasks, graph, exec, tSim, {});
+    exec_update(tasks, graph, exec);
+    ASSERT_FALSE(exec.hasRequestRun);
+    ASSERT_TRUE(exec.plData[pl.other].running);
+    ASSERT_TRUE(exec.tasksQueuedRun.contains(tSim));
+    ASSERT_TRUE(exec.tasksQueuedBlocked.contains(tOther));
+    ASSERT_TRUE(exec.tasksQueuedRun.contains(tRender));
+
+    while (exec.tasksQueuedRun.size() != 0)
+    {
+        complete_task(tasks, graph, exec, exec.tasksQueuedRun[0], {});
+        exec_update(tasks, graph, exec);
+    }
+
+    EXPECT_EQ(exec.pipelinesRunning, 0);
+    EXPECT_EQ(exec.tasksQueuedBlocked.size(), 0);
+}
+
+
+//-----------------------------------------------------------------------------
+
+namespace test_sema
+{
+
+enum class Stages { Run };
+
+struct Pipelines
+{
+    osp::PipelineDef<Stages> work;
+};
+
+} // namespace test_sema
+
+// Tasks sharing a semaphore can't all be queued to run at the same time
+TEST(Tasks, SemaphoreLimitsConcurrentTasks)
+{
+    using namespace test_sema;
+    using enum Stages;
+
+    using BasicTraits_t     = BasicBuilderTraits<TaskActions(*)()>;
+    using Builder_t         = BasicTraits_t::Builder;
+    using TaskFuncVec_t     = BasicTraits_t::FuncVec_t;
+
+    constexpr int sc_repetitions = 32;
+    constexpr int sc_taskCount   = 8;
+    std::mt19937 randGen(69);
+
+    Tasks           tasks;
+    TaskEdges       edges;
+    TaskFuncVec_t   functions;
+    Builder_t       builder{tasks, edges, functions};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    SemaphoreId const sema = builder.create_semaphore(3);
+
+    std::vector<TaskId> allTasks;
+    for (int i = 0; i < sc_taskCount; ++i)
+    {
+        allTasks.push_back(builder.task().run_on({pl.work(Run)}).acquire(sema, 1));
+    }
+
+    // Takes 2 of 3 units, can only run alongside one other task
+    allTasks.push_back(builder.task().run_on({pl.work(Run)}).acquire(sema, 2));
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+
+    for (int i = 0; i < sc_repetitions; ++i)
+    {
+        exec_request_run(exec, pl.work);
+        exec_update(tasks, graph, exec);
+
+        std::set<TaskId> done;
+
+        while (exec.tasksQueuedRun.size() != 0)
+        {
+            unsigned int unitsUsed = 0;
+            for (TaskId const task : exec.tasksQueuedRun)
+            {
+                unitsUsed += (task == allTasks.back()) ? 2 : 1;
+            }
+            ASSERT_LE(unitsUsed, 3u);
+            ASSERT_EQ(exec.semaUnitsUsed[sema], unitsUsed);
+
+            TaskId const task = exec.tasksQueuedRun[randGen() % exec.tasksQueuedRun.size()];
+            complete_task(tasks, graph, exec, task, {});
+            exec_update(tasks, graph, exec);
+            done.insert(task);
+        }
+
+        ASSERT_EQ(done.size(), allTasks.size());
+        ASSERT_EQ(exec.semaUnitsUsed[sema], 0u);
+        ASSERT_EQ(exec.pipelinesRunning, 0);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+
+// Rolling histogram only keeps the most recent samples
+TEST(Tasks, ProfilerRollingHistogram)
+{
+    RollingHistogram hist;
+
+    for (std::size_t i = 0; i < RollingHistogram::smc_window; ++i)
+    {
+        histogram_add(hist, 1000000); // 1ms
+    }
+    EXPECT_EQ(histogram_mean_ns(hist), 1000000);
+    EXPECT_GE(histogram_percentile_ns(hist, 0.5f), 1000000);
+    EXPECT_LT(histogram_percentile_ns(hist, 0.5f), 2000000);
+
+    // Replace all old samples
+    for (std::size_t i = 0; i < RollingHistogram::smc_window; ++i)
+    {
+        histogram_add(hist, 1000); // 1us
+    }
+    EXPECT_EQ(hist.count, RollingHistogram::smc_window);
+    EXPECT_EQ(histogram_mean_ns(hist), 1000);
+    EXPECT_LT(histogram_percentile_ns(hist, 0.95f), 2000);
+}
+
+// Profiler sees each stage of a pipeline through the ExecLog
+TEST(Tasks, ProfilerRecordsStages)
+{
+    using namespace test_a;
+    using enum Stages;
+
+    using BasicTraits_t     = BasicBuilderTraits<TaskActions(*)()>;
+    using Builder_t         = BasicTraits_t::Builder;
+    using TaskFuncVec_t     = BasicTraits_t::FuncVec_t;
+
+    Tasks           tasks;
+    TaskEdges       edges;
+    TaskFuncVec_t   functions;
+    Builder_t       builder{tasks, edges, functions};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    TaskId const tUse = builder.task().run_on({pl.vec(Use)});
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+    exec.doLogging = true;
+
+    TaskProfiler prof;
+    profiler_start_capture(tasks, prof);
+
+    std::vector<ExecLogRecord> records;
+    auto const read_log = [&] ()
+    {
+        records.clear();
+        exec_log_ring_drain(exec.logRing, records);
+        profiler_read_log(prof, arrayView(records.data(), records.size()), ProfileClock_t::now());
+    };
+
+    exec_request_run(exec, pl.vec);
+    exec_update(tasks, graph, exec);
+    read_log();
+
+    ASSERT_TRUE(exec.tasksQueuedRun.contains(tUse));
+
+    auto const start = ProfileClock_t::now();
+    profiler_record_task(prof, tUse, 0, start, start + std::chrono::microseconds(5));
+    complete_task(tasks, graph, exec, tUse, {});
+    exec_update(tasks, graph, exec);
+    read_log();
+
+    profiler_stop_capture(prof);
+
+    ASSERT_EQ(exec.pipelinesRunning, 0);
+    ASSERT_EQ(prof.taskRuns.size(), 1);
+    EXPECT_EQ(prof.taskRuns[0].task, tUse);
+    EXPECT_EQ(prof.taskTimes[tUse].count, 1);
+
+    // Fill and Use each started and ended once, in order. No tasks use Clear, so the pipeline
+    // only has 2 stages.
+    ASSERT_EQ(prof.stageRuns.size(), 2);
+    for (int i = 0; i < 2; ++i)
+    {
+        EXPECT_EQ(prof.stageRuns[i].pipeline, pl.vec);
+        EXPECT_EQ(prof.stageRuns[i].stage, StageId(i));
+        EXPECT_LE(prof.stageRuns[i].start, prof.stageRuns[i].end);
+    }
+}
+
+
+// Check that ExecLog records decode back to the same messages, and that the ring buffer drops
+// records instead of allocating once full
+TEST(Tasks, ExecLogRingBuffer)
+{
+    using Msg_t = ExecLog::LogMsg_t;
+
+    std::vector<Msg_t> const msgs
+    {
+        ExecLog::UpdateStart{},
+        ExecLog::PipelineRun{PipelineId(7)},
+        ExecLog::PipelineCancel{PipelineId(3), StageId(2)},
+        ExecLog::StageChange{PipelineId(1), lgrn::id_null<StageId>(), StageId(0)},
+        ExecLog::EnqueueTask{PipelineId(4), StageId(1), TaskId(42), true},
+        ExecLog::EnqueueTaskReq{PipelineId(5), StageId(3), false},
+        ExecLog::CompleteTask{TaskId(9), TaskAction::Cancel},
+        ExecLog::ExternalSignal{PipelineId(2), true},
+        ExecLog::UpdateEnd{}
+    };
+
+    // ExecLogRecord has no padding, so compare messages by their encoding
+    auto const same = [] (Msg_t const& a, Msg_t const& b) -> bool
+    {
+        ExecLogRecord const recA = exec_log_encode(a);
+        ExecLogRecord const recB = exec_log_encode(b);
+        return a.index() == b.index() && std::memcmp(&recA, &recB, sizeof(ExecLogRecord)) == 0;
+    };
+
+    ExecLogRing ring;
+    exec_log_ring_alloc(ring, 5); // rounded up to 8
+
+    ASSERT_EQ(ring.capacity, 8);
+
+    std::vector<ExecLogRecord> records;
+
+    // Push and drain a few times so records wrap around the end of the ring
+    for (int rep = 0; rep < 3; ++rep)
+    {
+        for (std::size_t i = 0; i < 6; ++i)
+        {
+            EXPECT_TRUE(exec_log_ring_push(ring, exec_log_encode(msgs[i])));
+        }
+
+        records.clear();
+        ASSERT_EQ(exec_log_ring_drain(ring, records), 6);
+
+        for (std::size_t i = 0; i < 6; ++i)
+        {
+            EXPECT_TRUE(same(exec_log_decode(records[i]), msgs[i]));
+        }
+
+        auto const enqueue = std::get<ExecLog::EnqueueTask>(exec_log_decode(records[4]));
+        EXPECT_EQ(enqueue.pipeline, PipelineId(4));
+        EXPECT_EQ(enqueue.stage,    StageId(1));
+        EXPECT_EQ(enqueue.task,     TaskId(42));
+        EXPECT_TRUE(enqueue.blocked);
+    }
+
+    // Fill past capacity, extra records are dropped
+    for (std::size_t i = 0; i < 10; ++i)
+    {
+        exec_log_ring_push(ring, exec_log_encode(msgs[i % msgs.size()]));
+    }
+
+    EXPECT_EQ(ring.dropped.load(), 2);
+
+    records.clear();
+    ASSERT_EQ(exec_log_ring_drain(ring, records), 8);
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+        EXPECT_TRUE(same(exec_log_decode(records[i]), msgs[i % msgs.size()]));
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+
+namespace test_schedule
+{
+
+struct TestState
+{
+    int     runs        { 0 };
+    int     otherRuns   { 0 };
+    bool    cancel      { false };
+};
+
+enum class Stages { Schedule, Run };
+
+struct Pipelines
+{
+    osp::PipelineDef<Stages> p;
+    osp::PipelineDef<Stages> pChild;
+    osp::PipelineDef<Stages> q;
+};
+
+} // namespace test_schedule
+
+// Record a run, replay it, then check that a cancel falls back to dynamic execution
+TEST(Tasks, StaticScheduleReplay)
+{
+    using namespace test_schedule;
+    using enum Stages;
+
+    using BasicTraits_t     = BasicBuilderTraits<TaskActions(*)(TestState&)>;
+    using Builder_t         = BasicTraits_t::Builder;
+    using TaskFuncVec_t     = BasicTraits_t::FuncVec_t;
+
+    Tasks           tasks;
+    TaskEdges       edges;
+    TaskFuncVec_t   functions;
+    Builder_t       builder{tasks, edges, functions};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    // Only pipelines in the pipeline tree can be canceled
+    builder.pipeline(pl.pChild).parent(pl.p);
+
+    builder.task()
+        .run_on({pl.p(Schedule)})
+        .func( [] (TestState& rState) -> TaskActions
+    {
+        return rState.cancel ? TaskActions{TaskAction::Cancel} : TaskActions{};
+    });
+
+    builder.task()
+        .run_on({pl.p(Run)})
+        .func( [] (TestState& rState) -> TaskActions
+    {
+        ++ rState.runs;
+        return {};
+    });
+
+    builder.task()
+        .run_on({pl.q(Run)})
+        .func( [] (TestState& rState) -> TaskActions
+    {
+        ++ rState.otherRuns;
+        return {};
+    });
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+    exec.doLogging = true;
+
+    TestState                   state;
+    ExecSchedule                sched;
+    std::vector<ExecLogRecord>  records;
+
+    auto const run_dynamic = [&] ()
+    {
+        exec_update(tasks, graph, exec);
+        while ( ! exec.tasksQueuedRun.empty() )
+        {
+            TaskId const task = exec.tasksQueuedRun[0];
+            complete_task(tasks, graph, exec, task, functions[task](state));
+            exec_update(tasks, graph, exec);
+        }
+    };
+
+    auto const request_both = [&] ()
+    {
+        exec_request_run(exec, pl.p);
+        exec_request_run(exec, pl.q);
+    };
+
+    // Record
+    request_both();
+    exec_schedule_record_start(exec, sched);
+    run_dynamic();
+    records.clear();
+    exec_log_ring_drain(exec.logRing, records);
+    exec_schedule_record(sched, arrayView(records.data(), records.size()));
+    exec_schedule_record_finish(exec, sched);
+
+    ASSERT_TRUE(sched.valid);
+    ASSERT_EQ(sched.tasks.size(), 3);
+    ASSERT_EQ(state.runs, 1);
+
+    // Replay
+    request_both();
+    ASSERT_TRUE(exec_schedule_matches(exec, sched));
+    for (TaskId const task : sched.tasks)
+    {
+        ASSERT_EQ(functions[task](state), TaskActions{});
+    }
+    exec_schedule_replay_done(exec, sched);
+
+    EXPECT_TRUE(exec_is_idle(exec));
+    EXPECT_FALSE(exec.hasRequestRun);
+    EXPECT_EQ(exec.plData, sched.end.plData);
+    EXPECT_EQ(state.runs, 2);
+    EXPECT_EQ(state.otherRuns, 2);
+
+    // Different pipelines requested
+    exec_request_run(exec, pl.q);
+    EXPECT_FALSE(exec_schedule_matches(exec, sched));
+    run_dynamic();
+    EXPECT_EQ(state.otherRuns, 3);
+
+    // Replay diverges, as p's first task cancels
+    state.cancel = true;
+    request_both();
+    ASSERT_TRUE(exec_schedule_matches(exec, sched));
+
+    bool diverged = false;
+    for (std::size_t i = 0; i < sched.tasks.size(); ++i)
+    {
+        TaskId const        task    = sched.tasks[i];
+        TaskActions const   status  = functions[task](state);
+        if (status != sched.actions[i])
+        {
+            exec_schedule_catch_up(tasks, graph, exec, sched, i);
+            complete_task(tasks, graph, exec, task, status);
+            run_dynamic();
+            diverged = true;
+            break;
+        }
+    }
+
+    ASSERT_TRUE(diverged);
+    EXPECT_TRUE(exec_is_idle(exec));
+    EXPECT_FALSE(exec.hasRequestRun);
+    EXPECT_EQ(state.runs, 2);
+    EXPECT_EQ(state.otherRuns, 4);
+
+    // Runs that cancel are recorded along with what each task returned
+    request_both();
+    exec_log_ring_drain(exec.logRing, records);
+    exec_schedule_record_start(exec, sched);
+    run_dynamic();
+    records.clear();
+    exec_log_ring_drain(exec.logRing, records);
+    exec_schedule_record(sched, arrayView(records.data(), records.size()));
+    exec_schedule_record_finish(exec, sched);
+
+    ASSERT_TRUE(sched.valid);
+    ASSERT_EQ(sched.tasks.size(), 2);
+    EXPECT_EQ(state.runs, 2);
+    EXPECT_EQ(state.otherRuns, 5);
+
+    request_both();
+    ASSERT_TRUE(exec_schedule_matches(exec, sched));
+    for (std::size_t i = 0; i < sched.tasks.size(); ++i)
+    {
+        ASSERT_EQ(functions[sched.tasks[i]](state), sched.actions[i]);
+    }
+    exec_schedule_replay_done(exec, sched);
+
+    EXPECT_TRUE(exec_is_idle(exec));
+    EXPECT_EQ(state.runs, 2);
+    EXPECT_EQ(state.otherRuns, 6);
+}
+
+// Record and replay runs of a looping pipeline that stays running while waiting for a signal
+TEST(Tasks, StaticScheduleSignaledLoop)
+{
+    using namespace test_d;
+    using enum Stages;
+
+    using BasicTraits_t     = BasicBuilderTraits<TaskActions(*)(TestState&)>;
+    using Builder_t         = BasicTraits_t::Builder;
+    using TaskFuncVec_t     = BasicTraits_t::FuncVec_t;
+
+    Tasks           tasks;
+    TaskEdges       edges;
+    TaskFuncVec_t   functions;
+    Builder_t       builder{tasks, edges, functions};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    builder.pipeline(pl.loopOuter).loops(true).wait_for_signal(Signal);
+    builder.pipeline(pl.loopInner).loops(true).parent(pl.loopOuter);
+
+    builder.task()
+        .run_on   ({pl.loopInner(Schedule)})
+        .sync_with({pl.loopOuter(Process)})
+        .func( [] (TestState& rState) -> TaskActions
+    {
+        return (rState.countIn == 0) ? TaskActions{TaskAction::Cancel} : TaskActions{};
+    });
+
+    builder.task()
+        .run_on   ({pl.loopInner(Process)})
+        .sync_with({pl.loopOuter(Process)})
+        .func( [] (TestState& rState) -> TaskActions
+    {
+        -- rState.countIn;
+        ++ rState.countOut;
+        return {};
+    });
+
+    builder.task()
+        .run_on   ({pl.loopOuter(Done)})
+        .func( [] (TestState& rState) -> TaskActions
+    {
+        ++ rState.checks;
+        EXPECT_EQ(rState.countOut, rState.countOutExpected);
+        rState.countOut = 0;
+        return {};
+    });
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+    exec.doLogging = true;
+
+    TestState                   state;
+    ExecSchedule                sched;
+    std::vector<ExecLogRecord>  records;
+
+    auto const run_dynamic = [&] ()
+    {
+        exec_update(tasks, graph, exec);
+        while ( ! exec.tasksQueuedRun.empty() )
+        {
+            TaskId const task = exec.tasksQueuedRun[0];
+            complete_task(tasks, graph, exec, task, functions[task](state));
+            exec_update(tasks, graph, exec);
+        }
+    };
+
+    auto const start_frame = [&] ()
+    {
+        state.countIn           = 3;
+        state.countOutExpected  = 3;
+        exec_signal(exec, pl.loopOuter);
+    };
+
+    exec_request_run(exec, pl.loopOuter);
+    exec_update(tasks, graph, exec);
+
+    // First frame may start from a different state, record the second
+    start_frame();
+    run_dynamic();
+
+    start_frame();
+    records.clear();
+    exec_log_ring_drain(exec.logRing, records); // discard
+    exec_schedule_record_start(exec, sched);
+    run_dynamic();
+    records.clear();
+    exec_log_ring_drain(exec.logRing, records);
+    exec_schedule_record(sched, arrayView(records.data(), records.size()));
+    exec_schedule_record_finish(exec, sched);
+
+    ASSERT_TRUE(sched.valid);
+    ASSERT_EQ(state.checks, 2);
+    EXPECT_FALSE(exec_is_idle(exec));
+
+    // Nothing signaled, so there's nothing to replay
+    EXPECT_FALSE(exec_schedule_matches(exec, sched));
+
+    for (int i = 0; i < 3; ++i)
+    {
+        start_frame();
+        ASSERT_TRUE(exec_schedule_matches(exec, sched));
+        for (std::size_t j = 0; j < sched.tasks.size(); ++j)
+        {
+            ASSERT_EQ(functions[sched.tasks[j]](state), sched.actions[j]);
+        }
+        exec_schedule_replay_done(exec, sched);
+        EXPECT_EQ(exec.plData, sched.end.plData);
+    }
+
+    ASSERT_EQ(state.checks, 5);
+
+    // A different number of loop iterations diverges, and runs dynamically from the same state
+    start_frame();
+    state.countIn           = 1;
+    state.countOutExpected  = 1;
+    ASSERT_TRUE(exec_schedule_matches(exec, sched));
+
+    bool diverged = false;
+    for (std::size_t i = 0; i < sched.tasks.size(); ++i)
+    {
+        TaskId const        task    = sched.tasks[i];
+        TaskActions const   status  = functions[task](state);
+        if (status != sched.actions[i])
+        {
+            exec_schedule_catch_up(tasks, graph, exec, sched, i);
+            complete_task(tasks, graph, exec, task, status);
+            run_dynamic();
+            diverged = true;
+            break;
+        }
+    }
+
+    ASSERT_TRUE(diverged);
+    EXPECT_EQ(state.checks, 6);
+
+    start_frame();
+    ASSERT_TRUE(exec_schedule_matches(exec, sched));
+}
+
+//-----------------------------------------------------------------------------
+
+namespace test_order
+{
+
+enum class Stages { A, B, C };
+
+struct Pipelines
+{
+    osp::PipelineDef<Stages> p;
+    osp::PipelineDef<Stages> q;
+};
+
+} // namespace test_order
+
+// Check which tasks are known to run after others
+TEST(Tasks, FindTasksAfter)
+{
+    using namespace test_order;
+    using enum Stages;
+
+    using BasicTraits_t     = BasicBuilderTraits<TaskActions(*)()>;
+    using Builder_t         = BasicTraits_t::Builder;
+    using TaskFuncVec_t     = BasicTraits_t::FuncVec_t;
+
+    Tasks           tasks;
+    TaskEdges       edges;
+    TaskFuncVec_t   functions;
+    Builder_t       builder{tasks, edges, functions};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    TaskId const t0 = builder.task().run_on({pl.p(A)});
+    TaskId const t1 = builder.task().run_on({pl.p(B)});
+    TaskId const t2 = builder.task().run_on({pl.q(A)});
+    TaskId const t3 = builder.task().run_on({pl.q(B)}).sync_with({pl.p(C)});
+    TaskId const t4 = builder.task().run_on({pl.q(A)}).sync_with({pl.p(B)});
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    auto const after = [&tasks, &graph] (TaskId const task)
+    {
+        BitVector_t bits;
+        find_tasks_after(tasks, graph, task, bits);
+
+        std::set<TaskId> out;
+        for (std::size_t const taskInt : bits.ones())
+        {
+            out.insert(TaskId(taskInt));
+        }
+        return out;
+    };
+
+    EXPECT_EQ(after(t0), (std::set<TaskId>{t1, t3, t4}));
+    EXPECT_EQ(after(t1), (std::set<TaskId>{t3}));
+    EXPECT_EQ(after(t2), (std::set<TaskId>{t3}));
+    EXPECT_EQ(after(t3), (std::set<TaskId>{}));
+    EXPECT_EQ(after(t4), (std::set<TaskId>{t3}));
+}
+
+// Critical path is a task's own duration plus the longest chain of tasks ordered after it
+TEST(Tasks, CriticalPaths)
+{
+    using namespace test_order;
+    using enum Stages;
+
+    using BasicTraits_t     = BasicBuilderTraits<TaskActions(*)()>;
+    using Builder_t         = BasicTraits_t::Builder;
+    using TaskFuncVec_t     = BasicTraits_t::FuncVec_t;
+
+    Tasks           tasks;
+    TaskEdges       edges;
+    TaskFuncVec_t   functions;
+    Builder_t       builder{tasks, edges, functions};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    // Same as FindTasksAfter
+    TaskId const t0 = builder.task().run_on({pl.p(A)});
+    TaskId const t1 = builder.task().run_on({pl.p(B)});
+    TaskId const t2 = builder.task().run_on({pl.q(A)});
+    TaskId const t3 = builder.task().run_on({pl.q(B)}).sync_with({pl.p(C)});
+    TaskId const t4 = builder.task().run_on({pl.q(A)}).sync_with({pl.p(B)});
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    KeyedVec<TaskId, uint64_t> critPath;
+
+    // Without durations, each task counts as 1ns
+    task_critical_paths(tasks, graph, {}, critPath);
+
+    EXPECT_EQ(critPath[t0], 3u); // t0 -> t1 -> t3
+    EXPECT_EQ(critPath[t1], 2u);
+    EXPECT_EQ(critPath[t2], 2u);
+    EXPECT_EQ(critPath[t3], 1u);
+    EXPECT_EQ(critPath[t4], 2u);
+
+    std::vector<uint64_t> durations(tasks.m_taskIds.capacity(), 1);
+    durations[std::size_t(t3)] = 10;
+
+    task_critical_paths(tasks, graph, arrayView(durations.data(), durations.size()), critPath);
+
+    EXPECT_EQ(critPath[t0], 12u);
+    EXPECT_EQ(critPath[t1], 11u);
+    EXPECT_EQ(critPath[t2], 11u);
+    EXPECT_EQ(critPath[t3], 10u);
+    EXPECT_EQ(critPath[t4], 11u);
+}
+
+// Critical paths of very long chains are found without recursing along the chain
+TEST(Tasks, CriticalPathsDeepChain)
+{
+    using namespace test_order;
+    using enum Stages;
+
+    using BasicTraits_t     = BasicBuilderTraits<TaskActions(*)()>;
+    using Builder_t         = BasicTraits_t::Builder;
+    using TaskFuncVec_t     = BasicTraits_t::FuncVec_t;
+
+    constexpr int sc_links = 50000;
+
+    Tasks           tasks;
+    TaskEdges       edges;
+    TaskFuncVec_t   functions;
+    Builder_t       builder{tasks, edges, functions};
+
+    struct One
+    {
+        osp::PipelineDef<Stages> p{"p"};
+    };
+
+    // first runs on pl[0](A). Each link runs on pl[i](B) and syncs with pl[i+1](A), so it's
+    // ordered after the previous link: first -> link[0] -> link[1] -> ...
+    std::vector<osp::PipelineDef<Stages>> pl;
+    for (int i = 0; i <= sc_links; ++i)
+    {
+        pl.push_back(builder.create_pipelines<One>().p);
+    }
+
+    TaskId const first = builder.task().run_on({pl[0](A)});
+
+    std::vector<TaskId> links;
+    for (int i = 0; i < sc_links; ++i)
+    {
+        links.push_back(builder.task().run_on({pl[i](B)}).sync_with({pl[i + 1](A)}));
+    }
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    KeyedVec<TaskId, uint64_t> critPath;
+    task_critical_paths(tasks, graph, {}, critPath);
+
+    EXPECT_EQ(critPath[first],          uint64_t(sc_links) + 1);
+    EXPECT_EQ(critPath[links.front()],  uint64_t(sc_links));
+    EXPECT_EQ(critPath[links.back()],   1u);
+}
+
+// Ready tasks are taken by explicit priority, then critical path, then lowest ID
+TEST(Tasks, ReadyQueuePriority)
+{
+    using namespace test_sema;
+    using enum Stages;
+
+    using BasicTraits_t     = BasicBuilderTraits<TaskActions(*)()>;
+    using Builder_t         = BasicTraits_t::Builder;
+    using TaskFuncVec_t     = BasicTraits_t::FuncVec_t;
+
+    Tasks           tasks;
+    TaskEdges       edges;
+    TaskFuncVec_t   functions;
+    Builder_t       builder{tasks, edges, functions};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    TaskId const t0 = builder.task().run_on({pl.work(Run)});
+    TaskId const t1 = builder.task().run_on({pl.work(Run)}).priority(5);
+    TaskId const t2 = builder.task().run_on({pl.work(Run)}).priority(-3);
+    TaskId const t3 = builder.task().run_on({pl.work(Run)}).priority(5);
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+
+    auto const pop_all = [&exec] ()
+    {
+        std::vector<TaskId> out;
+        for (TaskId task = exec_pop_ready(exec); task != lgrn::id_null<TaskId>(); task = exec_pop_ready(exec))
+        {
+            out.push_back(task);
+        }
+        return out;
+    };
+
+    auto const complete_all = [&] ()
+    {
+        while ( ! exec.tasksQueuedRun.empty() )
+        {
+            complete_task(tasks, graph, exec, exec.tasksQueuedRun[0], {});
+        }
+        exec_update(tasks, graph, exec);
+        ASSERT_EQ(exec.pipelinesRunning, 0);
+    };
+
+    // Without priorities set in ExecContext, lowest ID first
+    exec_request_run(exec, pl.work);
+    exec_update(tasks, graph, exec);
+    EXPECT_EQ(pop_all(), (std::vector<TaskId>{t0, t1, t2, t3}));
+    complete_all();
+
+    exec_set_priorities(tasks, {}, exec);
+
+    exec_request_run(exec, pl.work);
+    exec_update(tasks, graph, exec);
+    EXPECT_EQ(pop_all(), (std::vector<TaskId>{t1, t3, t0, t2}));
+
+    // Tasks that can't run yet can be given back
+    exec_push_ready(exec, t2);
+    exec_push_ready(exec, t3);
+    EXPECT_EQ(pop_all(), (std::vector<TaskId>{t3, t2}));
+    complete_all();
+
+    // Tasks completed without being taken are skipped, and not taken twice once queued again
+    exec_request_run(exec, pl.work);
+    exec_update(tasks, graph, exec);
+    complete_all();
+    exec_request_run(exec, pl.work);
+    exec_update(tasks, graph, exec);
+    EXPECT_EQ(pop_all(), (std::vector<TaskId>{t1, t3, t0, t2}));
+    EXPECT_TRUE(exec.readyHeap.empty());
+    complete_all();
+
+    // Critical path breaks ties between equal explicit priorities
+    std::vector<uint64_t> critPath(tasks.m_taskIds.capacity(), 0);
+    critPath[std::size_t(t3)] = 100;
+    critPath[std::size_t(t2)] = 100;
+    exec_set_priorities(tasks, arrayView(critPath.data(), critPath.size()), exec);
+
+    exec_request_run(exec, pl.work);
+    exec_update(tasks, graph, exec);
+    EXPECT_EQ(pop_all(), (std::vector<TaskId>{t3, t1, t0, t2}));
+    complete_all();
+}
+
+
+//-----------------------------------------------------------------------------
+
+namespace test_update
+{
+
+enum class Stages { A, B, C, D };
+
+struct BasePipelines
+{
+    osp::PipelineDef<Stages> loop;
+    osp::PipelineDef<Stages> inner;
+    osp::PipelineDef<Stages> other;
+};
+
+struct SessionPipelines
+{
+    osp::PipelineDef<Stages> work;
+    osp::PipelineDef<Stages> child;
+};
+
+template <typename KEY_T, typename VALUE_T, typename DATA_T, typename PROJ_T>
+void expect_same_fanout(
+        KeyedVec<KEY_T, VALUE_T> const& firstA, KeyedVec<VALUE_T, DATA_T> const& dataA,
+        KeyedVec<KEY_T, VALUE_T> const& firstB, KeyedVec<VALUE_T, DATA_T> const& dataB,
+        PROJ_T&& proj)
+{
+    using proj_t = std::invoke_result_t<PROJ_T&, DATA_T const&>;
+
+    ASSERT_EQ(firstA.size(), firstB.size());
+    ASSERT_EQ(dataA.size(),  dataB.size());
+
+    auto const sorted = [&proj] (auto const& first, auto const& data, KEY_T const key)
+    {
+        std::vector<proj_t> out;
+        for (DATA_T const& value : fanout_view(first, data, key))
+        {
+            out.push_back(proj(value));
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    };
+
+    for (std::size_t i = 0; i + 1 < firstA.size(); ++i)
+    {
+        EXPECT_EQ(sorted(firstA, dataA, KEY_T(i)), sorted(firstB, dataB, KEY_T(i)));
+    }
+}
+
+// Items connected to each ID may be in a different order depending on how the graph was made
+void expect_same_graph(TaskGraph const& a, TaskGraph const& b)
+{
+    auto const same      = [] (auto const& value) { return value; };
+    auto const stgreq    = [] (StageRequiresTask const& req) { return std::tuple(req.ownStage, req.reqTask, req.reqPipeline, req.reqStage); };
+    auto const taskreq   = [] (TaskRequiresStage const& req) { return std::tuple(req.ownTask, req.reqPipeline, req.reqStage); };
+    auto const acquire   = [] (TaskAcquire const& acq)       { return std::tuple(acq.semaphore, acq.units); };
+
+    EXPECT_EQ(a.pipelineToFirstAnystg,  b.pipelineToFirstAnystg);
+    EXPECT_EQ(a.anystgToPipeline,       b.anystgToPipeline);
+
+    expect_same_fanout(a.anystgToFirstRuntask,       a.runtaskToTask,        b.anystgToFirstRuntask,       b.runtaskToTask,        same);
+    expect_same_fanout(a.anystgToFirstStgreqtask,    a.stgreqtaskData,       b.anystgToFirstStgreqtask,    b.stgreqtaskData,       stgreq);
+    expect_same_fanout(a.taskToFirstRevStgreqtask,   a.revStgreqtaskToStage, b.taskToFirstRevStgreqtask,   b.revStgreqtaskToStage, same);
+    expect_same_fanout(a.taskToFirstTaskreqstg,      a.taskreqstgData,       b.taskToFirstTaskreqstg,      b.taskreqstgData,       taskreq);
+    expect_same_fanout(a.anystgToFirstRevTaskreqstg, a.revTaskreqstgToTask,  b.anystgToFirstRevTaskreqstg, b.revTaskreqstgToTask,  same);
+    expect_same_fanout(a.taskToFirstAcquire,         a.taskAcquire,          b.taskToFirstAcquire,         b.taskAcquire,          acquire);
+    expect_same_fanout(a.semaToFirstAcquiredBy,      a.semaAcquiredBy,       b.semaToFirstAcquiredBy,      b.semaAcquiredBy,       same);
+
+    EXPECT_EQ(a.pltreeDescendantCounts, b.pltreeDescendantCounts);
+    EXPECT_EQ(a.pltreeToPipeline,       b.pltreeToPipeline);
+    EXPECT_EQ(a.pipelineToPltree,       b.pipelineToPltree);
+    EXPECT_EQ(a.pipelineToLoopScope,    b.pipelineToLoopScope);
+
+    ASSERT_EQ(a.pipelineToLoopScopeRange.size(), b.pipelineToLoopScopeRange.size());
+    for (std::size_t i = 0; i < a.pipelineToLoopScopeRange.size(); ++i)
+    {
+        LoopScopeRange const& rangeA = a.pipelineToLoopScopeRange[PipelineId(i)];
+        LoopScopeRange const& rangeB = b.pipelineToLoopScopeRange[PipelineId(i)];
+        EXPECT_EQ(std::tuple(rangeA.first, rangeA.last, rangeA.pipeline),
+                  std::tuple(rangeB.first, rangeB.last, rangeB.pipeline));
+    }
+}
+
+} // namespace test_update
+
+// Incrementally updated graph must match one made from scratch as sessions close and open
+TEST(Tasks, UpdateExecGraph)
+{
+    using namespace test_update;
+    using enum Stages;
+
+    using BasicTraits_t     = BasicBuilderTraits<TaskActions(*)()>;
+    using Builder_t         = BasicTraits_t::Builder;
+    using TaskFuncVec_t     = BasicTraits_t::FuncVec_t;
+
+    Tasks           tasks;
+    TaskEdges       baseEdges;
+    TaskEdges       sessionEdges;
+    TaskFuncVec_t   functions;
+    Builder_t       baseBuilder{tasks, baseEdges, functions};
+    Builder_t       sessionBuilder{tasks, sessionEdges, functions};
+
+    // Stays open throughout the test
+    auto const base = baseBuilder.create_pipelines<BasePipelines>();
+    baseBuilder.pipeline(base.loop).loops(true);
+    baseBuilder.pipeline(base.inner).parent(base.loop);
+
+    SemaphoreId const baseSema = baseBuilder.create_semaphore(2);
+
+    baseBuilder.task().run_on({base.loop(A)});
+    baseBuilder.task().run_on({base.inner(A)}).sync_with({base.loop(B)});
+    baseBuilder.task().run_on({base.other(A)}).acquire(baseSema, 1);
+
+    // Mimics opening and closing a session; see testapp's TestApp::close_sessions
+    std::vector<TaskId>      sessionTasks;
+    std::vector<PipelineId>  sessionPipelines;
+    std::vector<SemaphoreId> sessionSemas;
+
+    auto const open_session = [&] (Stages const lastStage)
+    {
+        auto const pl = sessionBuilder.create_pipelines<SessionPipelines>();
+        sessionPipelines = {pl.work, pl.child};
+        sessionBuilder.pipeline(pl.child).loops(true).parent(pl.work);
+
+        SemaphoreId const sema = sessionBuilder.create_semaphore(3);
+        sessionSemas = {sema};
+
+        sessionTasks = {
+            sessionBuilder.task().run_on({pl.work(A)}).sync_with({base.other(lastStage)}).acquire(baseSema, 2),
+            sessionBuilder.task().run_on({pl.work(lastStage)}).sync_with({base.loop(A), pl.child(B)}).acquire(sema, 3),
+            sessionBuilder.task().run_on({pl.child(A)}).acquire(sema, 1).acquire(baseSema, 1) };
+    };
+
+    auto const close_session = [&] ()
+    {
+        for (TaskId const task : std::exchange(sessionTasks, {}))
+        {
+            tasks.m_taskIds.remove(task);
+        }
+        for (PipelineId const pipeline : std::exchange(sessionPipelines, {}))
+        {
+            tasks.m_pipelineIds.remove(pipeline);
+            tasks.m_pipelineParents[pipeline] = lgrn::id_null<PipelineId>();
+            tasks.m_pipelineControl[pipeline] = {};
+        }
+        for (SemaphoreId const sema : std::exchange(sessionSemas, {}))
+        {
+            tasks.m_semaIds.remove(sema);
+            tasks.m_semaLimits[sema] = 0;
+        }
+        sessionEdges.m_syncWith.clear();
+        sessionEdges.m_semaphoreEdges.clear();
+    };
+
+    // Start from an empty graph, adding everything at once
+    TaskGraph graph;
+    open_session(D);
+    update_exec_graph(tasks, graph, {&baseEdges, &sessionEdges});
+    expect_same_graph(graph, make_exec_graph(tasks, {&baseEdges, &sessionEdges}));
+
+    // Closing shrinks base.other back to a single stage
+    close_session();
+    update_exec_graph(tasks, graph, {});
+    expect_same_graph(graph, make_exec_graph(tasks, {&baseEdges, &sessionEdges}));
+    EXPECT_EQ(fanout_size(graph.pipelineToFirstAnystg, PipelineId(base.other)), 1u);
+
+    // Reuses the IDs of the closed session
+    open_session(C);
+    update_exec_graph(tasks, graph, {&sessionEdges});
+    expect_same_graph(graph, make_exec_graph(tasks, {&baseEdges, &sessionEdges}));
+
+    // Base tasks and edges are added after the graph was made
+    baseBuilder.task().run_on({base.other(B)}).sync_with({base.inner(C)});
+    TaskEdges addedEdges;
+    addedEdges.m_syncWith = {baseEdges.m_syncWith.back()};
+    update_exec_graph(tasks, graph, {&addedEdges});
+    expect_same_graph(graph, make_exec_graph(tasks, {&baseEdges, &sessionEdges}));
+
+    close_session();
+    update_exec_graph(tasks, graph, {});
+    expect_same_graph(graph, make_exec_graph(tasks, {&baseEdges, &sessionEdges}));
+}
+
+
+//-----------------------------------------------------------------------------
+
+namespace test_coroutine
+{
+
+enum class Stages { Load, Use };
+
+struct Pipelines
+{
+    osp::PipelineDef<Stages> chunks;
+};
+
+TaskCoroutine load_chunks(int &rSteps, uint32_t &rWorker, WorkerContext ctx)
+{
+    WorkerContext const &rCurrent = co_await current_worker();
+    EXPECT_EQ(rCurrent.m_workerIndex, ctx.m_workerIndex);
+
+    rWorker = rCurrent.m_workerIndex;
+    ++ rSteps;
+    co_await next_frame();
+    rWorker = rCurrent.m_workerIndex;
+    ++ rSteps;
+    co_await any_worker();
+    rWorker = rCurrent.m_workerIndex;
+    ++ rSteps;
+    co_return {};
+}
+
+} // namespace test_coroutine
+
+// Suspended coroutine tasks keep their pipeline's stage open across frames, and see the worker
+// they continue on
+TEST(Tasks, CoroutineKeepsStageOpen)
+{
+    using namespace test_coroutine;
+    using enum Stages;
+
+    using BasicTraits_t     = BasicBuilderTraits<TaskActions(*)()>;
+    using Builder_t         = BasicTraits_t::Builder;
+    using TaskFuncVec_t     = BasicTraits_t::FuncVec_t;
+
+    Tasks           tasks;
+    TaskEdges       edges;
+    TaskFuncVec_t   functions;
+    Builder_t       builder{tasks, edges, functions};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    TaskId const tLoad = builder.task().run_on({pl.chunks(Load)});
+    TaskId const tUse  = builder.task().run_on({pl.chunks(Use)});
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+
+    TopCoroutines coroutines;
+    top_coroutines_conform(tasks, coroutines);
+
+    int         steps   = 0;
+    uint32_t    worker  = 0;
+
+    // Frame 1: Runs until next_frame
+    exec_request_run(exec, pl.chunks);
+    exec_update(tasks, graph, exec);
+    ASSERT_EQ(exec_pop_ready(exec), tLoad);
+
+    coroutines.running[tLoad] = load_chunks(steps, worker, WorkerContext{ .m_workerIndex = 1 });
+    EXPECT_EQ(steps, 1);
+    EXPECT_EQ(worker, 1);
+    ASSERT_TRUE(top_coroutine_park(coroutines, exec, tLoad));
+    EXPECT_EQ(exec_pop_ready(exec), lgrn::id_null<TaskId>());
+
+    exec_update(tasks, graph, exec);
+    EXPECT_EQ(exec.plData[pl.chunks].stage, StageId(Load));
+    EXPECT_FALSE(exec.tasksQueuedRun.contains(tUse));
+
+    // Frame 2: any_worker is taken again right away, then finishes
+    top_coroutines_next_frame(coroutines, exec);
+    ASSERT_EQ(exec_pop_ready(exec), tLoad);
+    coroutines.running[tLoad].resume(WorkerContext{ .m_workerIndex = 2 });
+    EXPECT_EQ(steps, 2);
+    EXPECT_EQ(worker, 2);
+    ASSERT_TRUE(top_coroutine_park(coroutines, exec, tLoad));
+    EXPECT_FALSE(top_coroutine_waiting(coroutines, tLoad));
+
+    ASSERT_EQ(exec_pop_ready(exec), tLoad);
+    coroutines.running[tLoad].resume(WorkerContext{ .m_workerIndex = 3 });
+    EXPECT_EQ(steps, 3);
+    EXPECT_EQ(worker, 3);
+    ASSERT_FALSE(top_coroutine_park(coroutines, exec, tLoad));
+
+    complete_task(tasks, graph, exec, tLoad, coroutines.running[tLoad].take_result());
+    exec_update(tasks, graph, exec);
+    EXPECT_TRUE(exec.tasksQueuedRun.contains(tUse));
+
+    EXPECT_TRUE (TaskTimeBudget{std::chrono::nanoseconds{0}}.exceeded());
+    EXPECT_FALSE(TaskTimeBudget{std::chrono::hours{1}}.exceeded());
+}
+
+
+// Coroutine TopTasks registered with TopTaskBuilder suspend and continue through
+// top_run_blocking, and only close their stage once they co_return
+TEST(Tasks, CoroutineTopTaskAcrossFrames)
+{
+    using namespace test_coroutine;
+    using enum Stages;
+
+    Tasks               tasks;
+    TaskEdges           edges;
+    TopTaskDataVec_t    taskData;
+    TopTaskBuilder      builder{tasks, edges, taskData};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    TaskId const tLoad = builder.task()
+        .run_on({pl.chunks(Load)})
+        .args({0})
+        .func([] (int& rSteps) noexcept -> TaskCoroutine
+    {
+        ++ rSteps;
+        co_await next_frame();
+        ++ rSteps;
+        co_await next_frame();
+        ++ rSteps;
+        co_return {};
+    });
+
+    builder.task()
+        .run_on({pl.chunks(Use)})
+        .args({0, 1})
+        .func([] (int const& rSteps, int& rUsedAt) noexcept
+    {
+        rUsedAt = rSteps;
+    });
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    std::vector<entt::any> topData(2);
+    int const   &rSteps     = topData[0].emplace<int>(0);
+    int const   &rUsedAt    = topData[1].emplace<int>(-1);
+
+    TopTaskArgBinding binding;
+    top_bind_args(tasks, taskData, topData, binding);
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+
+    TopCoroutines coroutines;
+    top_coroutines_conform(tasks, coroutines);
+
+    exec_request_run(exec, pl.chunks);
+    exec_update(tasks, graph, exec);
+
+    for (int frame = 1; frame <= 3; ++frame)
+    {
+        top_coroutines_next_frame(coroutines, exec);
+        top_run_blocking(tasks, graph, binding, exec, {}, nullptr, nullptr, &coroutines);
+
+        EXPECT_EQ(rSteps, frame);
+
+        if (frame < 3)
+        {
+            // Still suspended, Load stays open and Use waits
+            EXPECT_TRUE(top_coroutine_waiting(coroutines, tLoad));
+            EXPECT_EQ(exec.plData[pl.chunks].stage, StageId(Load));
+            EXPECT_EQ(rUsedAt, -1);
+        }
+    }
+
+    EXPECT_FALSE(coroutines.running[tLoad].suspended());
+    EXPECT_EQ(rUsedAt, 3);
+    EXPECT_TRUE(exec_is_idle(exec));
+}
+
+//-----------------------------------------------------------------------------
+
+namespace test_affinity
+{
+
+enum class Stages { Run };
+
+struct Pipelines
+{
+    osp::PipelineDef<Stages> work;
+};
+
+// Workers each task ran on, one vector for each task
+using RanOn_t = std::array<std::vector<uint32_t>, 4>;
+
+} // namespace test_affinity
+
+// Tasks marked with main_thread() or affinity() only run on the worker they're bound to, even if
+// other workers try to take them first
+TEST(Tasks, AffinityPinsTasksToWorkers)
+{
+    using namespace test_affinity;
+    using enum Stages;
+
+    constexpr uint32_t sc_workerCount = 3;
+
+    Tasks               tasks;
+    TaskEdges           edges;
+    TopTaskDataVec_t    taskData;
+    TopTaskBuilder      builder{tasks, edges, taskData};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    TaskId const tAny = builder.task()
+        .run_on({pl.work(Run)})
+        .args({0})
+        .func([] (RanOn_t& rRanOn, WorkerContext ctx) noexcept { rRanOn[0].push_back(ctx.m_workerIndex); });
+
+    TaskId const tMain = builder.task()
+        .run_on({pl.work(Run)})
+        .args({0})
+        .main_thread()
+        .func([] (RanOn_t& rRanOn, WorkerContext ctx) noexcept { rRanOn[1].push_back(ctx.m_workerIndex); });
+
+    TaskId const tWorker = builder.task()
+        .run_on({pl.work(Run)})
+        .args({0})
+        .affinity(ETaskAffinity::Worker, 2)
+        .func([] (RanOn_t& rRanOn, WorkerContext ctx) noexcept { rRanOn[2].push_back(ctx.m_workerIndex); });
+
+    // Past the worker count, wraps around to worker 2
+    TaskId const tWrapped = builder.task()
+        .run_on({pl.work(Run)})
+        .args({0})
+        .affinity(ETaskAffinity::Worker, 5)
+        .func([] (RanOn_t& rRanOn, WorkerContext ctx) noexcept { rRanOn[3].push_back(ctx.m_workerIndex); });
+
+    EXPECT_EQ(taskData[tAny]    .m_affinity,        ETaskAffinity::Any);
+    EXPECT_EQ(taskData[tMain]   .m_affinity,        ETaskAffinity::Main);
+    EXPECT_EQ(taskData[tWorker] .m_affinity,        ETaskAffinity::Worker);
+    EXPECT_EQ(taskData[tWorker] .m_affinityWorker,  2u);
+    EXPECT_EQ(taskData[tWrapped].m_affinityWorker,  5u);
+
+    EXPECT_EQ(top_task_worker(taskData[tAny]),      lgrn::id_null<uint32_t>());
+    EXPECT_EQ(top_task_worker(taskData[tMain]),     0u);
+    EXPECT_EQ(top_task_worker(taskData[tWorker]),   2u);
+    EXPECT_EQ(top_task_worker(taskData[tWrapped]),  5u);
+
+    EXPECT_EQ(top_task_queue(taskData[tAny],     sc_workerCount), lgrn::id_null<uint32_t>());
+    EXPECT_EQ(top_task_queue(taskData[tMain],    sc_workerCount), 0u);
+    EXPECT_EQ(top_task_queue(taskData[tWorker],  sc_workerCount), 2u);
+    EXPECT_EQ(top_task_queue(taskData[tWrapped], sc_workerCount), 2u);
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    std::vector<entt::any> topData(1);
+    RanOn_t &rRanOn = topData[0].emplace<RanOn_t>();
+
+    TopTaskArgBinding binding;
+    top_bind_args(tasks, taskData, topData, binding);
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+
+    // Each frame, a different worker is first to try taking each ready task, and takes it unless
+    // it's pinned to another worker
+    for (uint32_t frame = 0; frame < sc_workerCount; ++frame)
+    {
+        exec_request_run(exec, pl.work);
+        exec_update(tasks, graph, exec);
+
+        for (TaskId task = exec_pop_ready(exec);
+             task != lgrn::id_null<TaskId>();
+             task = exec_pop_ready(exec))
+        {
+            uint32_t const queue = top_task_queue(taskData[task], sc_workerCount);
+
+            for (uint32_t i = 0; i < sc_workerCount; ++i)
+            {
+                uint32_t const worker = (frame + i) % sc_workerCount;
+                if (queue == lgrn::id_null<uint32_t>() || queue == worker)
+                {
+                    complete_task(tasks, graph, exec, task,
+                                  top_run_task(binding, task, WorkerContext{ .m_workerIndex = worker }));
+                    break;
+                }
+            }
+        }
+
+        exec_update(tasks, graph, exec);
+        EXPECT_TRUE(exec_is_idle(exec));
+    }
+
+    EXPECT_EQ(rRanOn[0], (std::vector<uint32_t>{0, 1, 2}));
+    EXPECT_EQ(rRanOn[1], (std::vector<uint32_t>{0, 0, 0}));
+    EXPECT_EQ(rRanOn[2], (std::vector<uint32_t>{2, 2, 2}));
+    EXPECT_EQ(rRanOn[3], (std::vector<uint32_t>{2, 2, 2}));
+}
+
+
 // TODO: Multi-threaded test with limits. Actual multithreading isn't needed;
 //       as long as task_start/finish are called at the right times